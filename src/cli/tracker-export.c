@@ -51,7 +51,7 @@ static GOptionEntry entries[] = {
 	  N_("DBus service name")
 	},
 	{ "output", 'o', 0, G_OPTION_ARG_STRING, &output_format,
-	  N_("Output results format: “turtle”, “trig” or “json-ld”"),
+	  N_("Output results format: “turtle”, “trig”, “json-ld”, “n-triples” or “n-quads”"),
 	  N_("RDF_FORMAT")
 	},
 	{ "remote-service", 'r', 0, G_OPTION_ARG_STRING, &remote_service,
@@ -166,6 +166,8 @@ export_run_default (void)
 			"turtle",
 			"trig",
 			"json-ld",
+			"n-triples",
+			"n-quads",
 		};
 		guint i;
 		gboolean found = FALSE;
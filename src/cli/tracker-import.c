@@ -120,6 +120,7 @@ import_run (void)
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GMainLoop) main_loop = NULL;
 	g_autoptr(GInputStream) stream = NULL;
+	TrackerRdfFormat format;
 	gchar **p;
 
 	connection = create_connection (&error);
@@ -148,11 +149,18 @@ import_run (void)
 			return EXIT_FAILURE;
 		}
 
+		if (g_str_has_suffix (*p, ".nt"))
+			format = TRACKER_RDF_FORMAT_N_TRIPLES;
+		else if (g_str_has_suffix (*p, ".nq"))
+			format = TRACKER_RDF_FORMAT_N_QUADS;
+		else if (trig)
+			format = TRACKER_RDF_FORMAT_TRIG;
+		else
+			format = TRACKER_RDF_FORMAT_TURTLE;
+
 		tracker_sparql_connection_deserialize_async (connection,
 		                                             TRACKER_DESERIALIZE_FLAGS_NONE,
-		                                             trig ?
-		                                             TRACKER_RDF_FORMAT_TRIG :
-		                                             TRACKER_RDF_FORMAT_TURTLE,
+		                                             format,
 		                                             NULL,
 		                                             stream,
 		                                             NULL,
@@ -31,6 +31,7 @@
 #include <unicode/uchar.h>
 #include <unicode/unorm.h>
 #include <unicode/ucol.h>
+#include <unicode/uloc.h>
 
 #include "tracker-language.h"
 #include "tracker-debug.h"
@@ -64,17 +65,32 @@ struct TrackerParser {
 	gboolean               enable_unaccent;
 	gboolean               ignore_numbers;
 	gboolean               enable_forced_wordbreaks;
+	gboolean               enable_ascii_fast_path;
 
 	/* Private members */
 	gchar                  word[WORD_BUFFER_LENGTH_UTF8];
 	gint                   word_length;
 	guint                  word_position;
 
-	/* Text as UChars */
+	/* Segment of txt being parsed, as byte offsets. Pure ASCII
+	 * segments are parsed directly, others go through ICU.
+	 */
+	gsize                  segment_start;
+	gsize                  segment_end;
+	gboolean               segment_is_ascii;
+
+	/* Cursor in the ASCII segment, and end of the current word
+	 * being split at forced wordbreaks.
+	 */
+	gsize                  ascii_cursor;
+	gsize                  ascii_word_end;
+
+	/* Segment as UChars */
 	UConverter *converter;
 	UChar                 *utxt;
 	gsize                  utxt_size;
-	/* Original offset of each UChar in the input txt string */
+	gsize                  utxt_alloc;
+	/* Original offset of each UChar in the segment */
 	gint32                *offsets;
 
 	/* The word-break iterator */
@@ -405,19 +421,14 @@ parser_check_forced_wordbreaks (const UChar *buffer,
 }
 
 static gboolean
-parser_next (TrackerParser *parser,
-             gint          *byte_offset_start,
-             gint          *byte_offset_end)
+parser_next_icu (TrackerParser *parser,
+                 gint          *byte_offset_start,
+                 gint          *byte_offset_end)
 {
 	gsize word_length_uchar = 0;
 	gsize word_length_utf8 = 0;
 	gsize current_word_offset_utf8 = 0;
 
-	*byte_offset_start = 0;
-	*byte_offset_end = 0;
-
-	g_return_val_if_fail (parser, FALSE);
-
 	/* Loop to look for next valid word */
 	while (parser->cursor < parser->utxt_size) {
 		TrackerParserWordType type;
@@ -447,7 +458,7 @@ parser_next (TrackerParser *parser,
 		if (next_word_offset_uchar >= parser->utxt_size) {
 			/* Last word support... */
 			next_word_offset_uchar = parser->utxt_size;
-			next_word_offset_utf8 = parser->txt_size;
+			next_word_offset_utf8 = parser->segment_end - parser->segment_start;
 		} else {
 			next_word_offset_utf8 = parser->offsets[next_word_offset_uchar];
 		}
@@ -505,8 +516,8 @@ parser_next (TrackerParser *parser,
 		                        truncated_length,
 		                        type)) {
 			/* Set outputs */
-			*byte_offset_start = current_word_offset_utf8;
-			*byte_offset_end = current_word_offset_utf8 + word_length_utf8;
+			*byte_offset_start = parser->segment_start + current_word_offset_utf8;
+			*byte_offset_end = parser->segment_start + current_word_offset_utf8 + word_length_utf8;
 
 			/* Update cursor */
 			parser->cursor += word_length_uchar;
@@ -522,71 +533,162 @@ parser_next (TrackerParser *parser,
 	return FALSE;
 }
 
-TrackerParser *
-tracker_parser_new (void)
+static inline gboolean
+is_ascii_word_char (gchar c)
 {
-	TrackerParser *parser;
+	return g_ascii_isalnum (c) || c == '_';
+}
 
-	parser = g_new0 (TrackerParser, 1);
-	parser->language = tracker_language_new (NULL);
+/* Whether the character at pos must be handled by ICU. Besides
+ * non-ASCII characters, this is the case of colons between letters,
+ * as these may or may not join words depending on the locale.
+ */
+static inline gboolean
+ascii_needs_icu (const gchar *txt,
+                 gsize        txt_size,
+                 gsize        pos)
+{
+	if ((guchar) txt[pos] >= 0x80)
+		return TRUE;
 
-	return parser;
+	return (txt[pos] == ':' && pos > 0 && pos + 1 < txt_size &&
+	        g_ascii_isalpha (txt[pos - 1]) &&
+	        g_ascii_isalpha (txt[pos + 1]));
 }
 
-void
-tracker_parser_free (TrackerParser *parser)
+/* Whether pos is a word boundary regardless of the surrounding text,
+ * so segments split there can be parsed independently. This is the
+ * case between ASCII whitespace and a following ASCII character.
+ */
+static inline gboolean
+is_segment_boundary (const gchar *txt,
+                     gsize        pos)
 {
-	g_return_if_fail (parser != NULL);
+	return (pos > 0 &&
+	        g_ascii_isspace (txt[pos - 1]) &&
+	        (guchar) txt[pos] < 0x80);
+}
 
-	g_clear_object (&parser->language);
-	g_clear_pointer (&parser->converter, ucnv_close);
-	g_clear_pointer (&parser->bi, ubrk_close);
+/* Finds the end of the ASCII word starting at pos, following the
+ * Unicode word boundary rules (UAX #29) as they apply to ASCII:
+ * letters, digits and underscores join together, apostrophes and
+ * dots join letters (WB6, WB7), and apostrophes, dots, commas and
+ * semicolons join digits (WB11, WB12).
+ */
+static gsize
+ascii_word_end (const gchar *txt,
+                gsize        pos,
+                gsize        end)
+{
+	pos++;
 
-	g_free (parser->utxt);
-	g_free (parser->offsets);
+	while (pos < end) {
+		gchar c = txt[pos];
 
-	g_free (parser);
+		if (is_ascii_word_char (c)) {
+			pos++;
+			continue;
+		}
+
+		if (pos + 1 < end) {
+			gchar prev = txt[pos - 1], next = txt[pos + 1];
+
+			if ((c == '\'' || c == '.') &&
+			    g_ascii_isalpha (prev) && g_ascii_isalpha (next)) {
+				pos += 2;
+				continue;
+			}
+
+			if ((c == '\'' || c == '.' || c == ',' || c == ';') &&
+			    g_ascii_isdigit (prev) && g_ascii_isdigit (next)) {
+				pos += 2;
+				continue;
+			}
+		}
+
+		break;
+	}
+
+	return pos;
 }
 
-void
-tracker_parser_reset (TrackerParser *parser,
-                      const gchar   *txt,
-                      gint           txt_size,
-                      guint          max_word_length,
-                      gboolean       enable_stemmer,
-                      gboolean       enable_unaccent,
-                      gboolean       ignore_numbers)
+static gboolean
+parser_next_ascii (TrackerParser *parser,
+                   gint          *byte_offset_start,
+                   gint          *byte_offset_end)
 {
-	UErrorCode error = U_ZERO_ERROR;
-	UChar *last_uchar;
-	const gchar *last_utf8;
+	const gchar *txt = parser->txt;
 
-	g_return_if_fail (parser != NULL);
-	g_return_if_fail (txt != NULL);
+	while (TRUE) {
+		gsize start, end, length, i;
 
-	parser->max_word_length = max_word_length;
-	parser->enable_stemmer = enable_stemmer;
-	parser->enable_unaccent = enable_unaccent;
-	parser->ignore_numbers = ignore_numbers;
+		if (parser->ascii_cursor >= parser->ascii_word_end) {
+			/* Look for the next word start */
+			while (parser->ascii_cursor < parser->segment_end &&
+			       !is_ascii_word_char (txt[parser->ascii_cursor]))
+				parser->ascii_cursor++;
 
-	/* Note: We're forcing some unicode characters to behave
-	 * as wordbreakers: e.g, the '.' The main reason for this
-	 * is to enable FTS searches matching file extension. */
-	parser->enable_forced_wordbreaks = TRUE;
+			if (parser->ascii_cursor >= parser->segment_end)
+				return FALSE;
 
-	parser->txt_size = txt_size;
-	parser->txt = txt;
+			parser->ascii_word_end = ascii_word_end (txt,
+			                                         parser->ascii_cursor,
+			                                         parser->segment_end);
+		}
 
-	parser->word[0] = '\0';
-	parser->word_length = 0;
-	g_clear_pointer (&parser->utxt, g_free);
-	g_clear_pointer (&parser->offsets, g_free);
+		/* Split the word at forced wordbreaks */
+		start = end = parser->ascii_cursor;
+		while (end < parser->ascii_word_end &&
+		       !(parser->enable_forced_wordbreaks &&
+		         IS_FORCED_WORDBREAK_UCS4 ((guint32) txt[end])))
+			end++;
 
-	parser->word_position = 0;
+		parser->ascii_cursor = end < parser->ascii_word_end ? end + 1 : end;
+		length = end - start;
+
+		/* Same checks as in the ICU path, for words that are too
+		 * long, start with a number, or do not fit in the buffer.
+		 */
+		if (length == 0 ||
+		    length >= parser->max_word_length ||
+		    length > WORD_BUFFER_LENGTH ||
+		    (parser->ignore_numbers && g_ascii_isdigit (txt[start])))
+			continue;
+
+		for (i = 0; i < length; i++)
+			parser->word[i] = g_ascii_tolower (txt[start + i]);
+
+		parser->word[length] = '\0';
+		parser->word_length = length;
+
+		if (parser->enable_stemmer) {
+			tracker_language_stem_word (parser->language,
+			                            (gchar *) &parser->word,
+			                            &parser->word_length,
+			                            WORD_BUFFER_LENGTH_UTF8);
+		}
+
+		*byte_offset_start = start;
+		*byte_offset_end = end;
+
+		return TRUE;
+	}
+}
+
+static void
+parser_set_icu_segment (TrackerParser *parser)
+{
+	UErrorCode error = U_ZERO_ERROR;
+	const gchar *segment;
+	gsize segment_size;
+	UChar *last_uchar;
+	const gchar *last_utf8;
+
+	parser->utxt_size = 0;
 	parser->cursor = 0;
 
-	if (parser->txt_size == 0)
-		return;
+	segment = &parser->txt[parser->segment_start];
+	segment_size = parser->segment_end - parser->segment_start;
 
 	/* Open converter UTF-8 to UChar */
 	if (!parser->converter) {
@@ -596,23 +698,29 @@ tracker_parser_reset (TrackerParser *parser,
 			           U_FAILURE (error) ? u_errorName (error) : "none");
 			return;
 		}
+	} else {
+		ucnv_reset (parser->converter);
 	}
 
-	/* Allocate UChars and offsets buffers */
-	parser->utxt_size = txt_size + 1;
-	parser->utxt = g_malloc (parser->utxt_size * sizeof (UChar));
-	parser->offsets = g_malloc (parser->utxt_size * sizeof (gint32));
+	/* Grow UChars and offsets buffers, these are reused across
+	 * segments and resets.
+	 */
+	if (parser->utxt_alloc < segment_size + 1) {
+		parser->utxt_alloc = segment_size + 1;
+		parser->utxt = g_renew (UChar, parser->utxt, parser->utxt_alloc);
+		parser->offsets = g_renew (gint32, parser->offsets, parser->utxt_alloc);
+	}
 
 	/* last_uchar and last_utf8 will be also an output parameter! */
 	last_uchar = parser->utxt;
-	last_utf8 = parser->txt;
+	last_utf8 = segment;
 
 	/* Convert to UChars storing offsets */
 	ucnv_toUnicode (parser->converter,
 	                &last_uchar,
-	                &parser->utxt[txt_size],
+	                &parser->utxt[segment_size],
 	                &last_utf8,
-	                &parser->txt[txt_size],
+	                &segment[segment_size],
 	                parser->offsets,
 	                FALSE,
 	                &error);
@@ -641,18 +749,180 @@ tracker_parser_reset (TrackerParser *parser,
 		}
 	}
 
-	/* If any error happened, reset buffers */
+	/* If any error happened, skip this segment */
 	if (U_FAILURE (error)) {
 		g_warning ("Error initializing libicu support: '%s'",
 		           u_errorName (error));
-		/* Reset buffers */
-		g_clear_pointer (&parser->utxt, g_free);
-		g_clear_pointer (&parser->offsets, g_free);
 		g_clear_pointer (&parser->bi, ubrk_close);
 		parser->utxt_size = 0;
+		parser->cursor = 0;
+	}
+}
+
+/* Splits the text in segments, so that runs of ASCII text are parsed
+ * without going through ICU. Segments are only split at positions
+ * where the ICU word-break iterator would find a boundary anyway, so
+ * words are the same as if parsing the full text through ICU.
+ */
+static gboolean
+parser_next_segment (TrackerParser *parser)
+{
+	const gchar *txt = parser->txt;
+	gsize txt_size = parser->txt_size;
+	gsize start, pos, end;
+
+	start = parser->segment_end;
+	if (start >= txt_size)
+		return FALSE;
+
+	pos = start;
+
+	if (parser->enable_ascii_fast_path) {
+		/* Find the first character that needs ICU */
+		while (pos < txt_size && !ascii_needs_icu (txt, txt_size, pos))
+			pos++;
+
+		/* And the last boundary before it */
+		end = pos;
+		if (end < txt_size) {
+			while (end > start && !is_segment_boundary (txt, end))
+				end--;
+		}
+
+		if (end > start) {
+			parser->segment_start = start;
+			parser->segment_end = end;
+			parser->segment_is_ascii = TRUE;
+			parser->ascii_cursor = start;
+			parser->ascii_word_end = start;
+			return TRUE;
+		}
+	}
+
+	/* The ICU segment extends up to the next boundary */
+	end = pos + 1;
+	while (end < txt_size &&
+	       (!parser->enable_ascii_fast_path ||
+	        !is_segment_boundary (txt, end)))
+		end++;
+
+	parser->segment_start = start;
+	parser->segment_end = end;
+	parser->segment_is_ascii = FALSE;
+	parser_set_icu_segment (parser);
+
+	return TRUE;
+}
+
+static gboolean
+parser_next (TrackerParser *parser,
+             gint          *byte_offset_start,
+             gint          *byte_offset_end)
+{
+	*byte_offset_start = 0;
+	*byte_offset_end = 0;
+
+	g_return_val_if_fail (parser, FALSE);
+
+	while (TRUE) {
+		if (parser->segment_is_ascii) {
+			if (parser_next_ascii (parser, byte_offset_start, byte_offset_end))
+				return TRUE;
+		} else {
+			if (parser_next_icu (parser, byte_offset_start, byte_offset_end))
+				return TRUE;
+		}
+
+		/* No more words... */
+		if (!parser_next_segment (parser))
+			return FALSE;
 	}
 }
 
+/* ICU lowercases ASCII characters as plain ASCII, except for the
+ * Turkic languages, where 'I' becomes a dotless 'ı'.
+ */
+static gboolean
+locale_has_ascii_casing (void)
+{
+	UErrorCode error = U_ZERO_ERROR;
+	gchar language[ULOC_LANG_CAPACITY];
+
+	uloc_getLanguage (uloc_getDefault (), language, sizeof (language), &error);
+	if (U_FAILURE (error))
+		return FALSE;
+
+	return (strcmp (language, "tr") != 0 &&
+	        strcmp (language, "az") != 0);
+}
+
+TrackerParser *
+tracker_parser_new (void)
+{
+	TrackerParser *parser;
+
+	parser = g_new0 (TrackerParser, 1);
+	parser->language = tracker_language_new (NULL);
+	parser->enable_ascii_fast_path = locale_has_ascii_casing ();
+
+	return parser;
+}
+
+void
+tracker_parser_free (TrackerParser *parser)
+{
+	g_return_if_fail (parser != NULL);
+
+	g_clear_object (&parser->language);
+	g_clear_pointer (&parser->converter, ucnv_close);
+	g_clear_pointer (&parser->bi, ubrk_close);
+
+	g_free (parser->utxt);
+	g_free (parser->offsets);
+
+	g_free (parser);
+}
+
+void
+tracker_parser_reset (TrackerParser *parser,
+                      const gchar   *txt,
+                      gint           txt_size,
+                      guint          max_word_length,
+                      gboolean       enable_stemmer,
+                      gboolean       enable_unaccent,
+                      gboolean       ignore_numbers)
+{
+	g_return_if_fail (parser != NULL);
+	g_return_if_fail (txt != NULL);
+
+	parser->max_word_length = max_word_length;
+	parser->enable_stemmer = enable_stemmer;
+	parser->enable_unaccent = enable_unaccent;
+	parser->ignore_numbers = ignore_numbers;
+
+	/* Note: We're forcing some unicode characters to behave
+	 * as wordbreakers: e.g, the '.' The main reason for this
+	 * is to enable FTS searches matching file extension. */
+	parser->enable_forced_wordbreaks = TRUE;
+
+	parser->txt_size = txt_size;
+	parser->txt = txt;
+
+	parser->word[0] = '\0';
+	parser->word_length = 0;
+
+	parser->word_position = 0;
+	parser->cursor = 0;
+	parser->utxt_size = 0;
+
+	/* Segments are set up as words are requested */
+	parser->segment_start = 0;
+	parser->segment_end = 0;
+	parser->segment_is_ascii = TRUE;
+	parser->ascii_cursor = 0;
+	parser->ascii_word_end = 0;
+}
+
 const gchar *
 tracker_parser_next (TrackerParser *parser,
                      gint          *position,
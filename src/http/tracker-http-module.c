@@ -92,6 +92,9 @@ static const gchar *mimetypes[] = {
 	"text/turtle",
 	"application/trig",
 	"application/ld+json",
+	"application/x-tinysparql-results",
+	"application/n-triples",
+	"application/n-quads",
 };
 
 G_STATIC_ASSERT (G_N_ELEMENTS (mimetypes) == TRACKER_N_SERIALIZER_FORMATS);
@@ -110,6 +113,12 @@ struct _TrackerHttpRequest
 	gchar *path;
 	GHashTable *params;
 	GCancellable *cancellable;
+
+	/* Response compression */
+	GZlibCompressorFormat compression_format;
+	guint compression_min_size;
+	GByteArray *pending;
+	GConverter *compressor;
 };
 
 struct _TrackerHttpServerSoup
@@ -162,6 +171,8 @@ request_free (TrackerHttpRequest *request)
 	g_signal_handlers_disconnect_by_data (request->message, request);
 
 	g_clear_object (&request->istream);
+	g_clear_object (&request->compressor);
+	g_clear_pointer (&request->pending, g_byte_array_unref);
 	g_clear_object (&request->message);
 	g_clear_object (&request->remote_address);
 	g_object_unref (request->cancellable);
@@ -170,26 +181,108 @@ request_free (TrackerHttpRequest *request)
 	g_free (request);
 }
 
-/* Read the "Accept" header of the request, and return the possible
- * serialization formats as a bitmask of TrackerSerializerFormat values.
+/* Read the "Accept" header of the request, and return the serialization
+ * formats preferred by the client as a bitmask of TrackerSerializerFormat
+ * values. Only the formats with the highest quality value are returned,
+ * so it is up to the caller to break ties.
  */
 static guint
 get_supported_formats (TrackerHttpRequest *request)
 {
 	SoupMessageHeaders *request_headers;
-	TrackerSerializerFormat i;
+	const gchar *header;
+	GSList *items, *l;
+	gdouble best_quality = 0;
 	guint formats = 0;
 
 	request_headers = soup_server_message_get_request_headers (request->message);
+	header = soup_message_headers_get_list (request_headers, "Accept");
+	if (!header)
+		return 0;
 
-	for (i = 0; i < TRACKER_N_SERIALIZER_FORMATS; i++) {
-		if (soup_message_headers_header_contains (request_headers, "Accept", mimetypes[i]))
-			formats |= 1 << i;
+	items = soup_header_parse_list (header);
+
+	for (l = items; l; l = l->next) {
+		TrackerSerializerFormat i;
+		gdouble quality = 1;
+		gchar **params;
+		guint j;
+
+		params = g_strsplit (l->data, ";", -1);
+
+		for (j = 1; params[j]; j++) {
+			const gchar *param = g_strstrip (params[j]);
+
+			if (g_ascii_strncasecmp (param, "q=", 2) == 0)
+				quality = g_ascii_strtod (&param[2], NULL);
+		}
+
+		for (i = 0; i < TRACKER_N_SERIALIZER_FORMATS; i++) {
+			if (g_ascii_strcasecmp (g_strstrip (params[0]), mimetypes[i]) != 0)
+				continue;
+
+			if (quality <= 0)
+				break;
+
+			if (quality > best_quality) {
+				best_quality = quality;
+				formats = 1 << i;
+			} else if (quality == best_quality) {
+				formats |= 1 << i;
+			}
+
+			break;
+		}
+
+		g_strfreev (params);
 	}
 
+	soup_header_free_list (items);
+
 	return formats;
 }
 
+/* Read the "Accept-Encoding" header of the request, and return whether
+ * the response may be compressed, and the compression format to use.
+ */
+static gboolean
+get_accepted_encoding (TrackerHttpRequest    *request,
+                       GZlibCompressorFormat *format)
+{
+	SoupMessageHeaders *request_headers;
+	const gchar *header;
+	GSList *encodings, *l;
+	gboolean found = FALSE;
+
+	request_headers = soup_server_message_get_request_headers (request->message);
+	header = soup_message_headers_get_list (request_headers, "Accept-Encoding");
+	if (!header)
+		return FALSE;
+
+	/* Sorted by preference, unacceptable encodings left out */
+	encodings = soup_header_parse_quality_list (header, NULL);
+
+	for (l = encodings; l; l = l->next) {
+		const gchar *encoding = l->data;
+
+		if (g_ascii_strcasecmp (encoding, "gzip") == 0 ||
+		    g_ascii_strcasecmp (encoding, "x-gzip") == 0 ||
+		    g_strcmp0 (encoding, "*") == 0) {
+			*format = G_ZLIB_COMPRESSOR_FORMAT_GZIP;
+			found = TRUE;
+			break;
+		} else if (g_ascii_strcasecmp (encoding, "deflate") == 0) {
+			*format = G_ZLIB_COMPRESSOR_FORMAT_ZLIB;
+			found = TRUE;
+			break;
+		}
+	}
+
+	soup_header_free_list (encodings);
+
+	return found;
+}
+
 static void
 set_message_format (TrackerHttpRequest      *request,
                     const gchar*             mimetype)
@@ -665,6 +758,57 @@ tracker_http_server_soup_error (TrackerHttpServer       *server,
 	request_free (request);
 }
 
+static void next_write (TrackerHttpRequest *request);
+
+static void
+start_compression (TrackerHttpRequest *request)
+{
+	SoupMessageHeaders *response_headers;
+
+	request->compressor =
+		G_CONVERTER (g_zlib_compressor_new (request->compression_format, -1));
+
+	response_headers = soup_server_message_get_response_headers (request->message);
+	soup_message_headers_append (response_headers, "Content-Encoding",
+	                             request->compression_format == G_ZLIB_COMPRESSOR_FORMAT_GZIP ?
+	                             "gzip" : "deflate");
+}
+
+static GBytes *
+compress_bytes (GConverter  *compressor,
+                GBytes      *bytes,
+                gboolean     at_end,
+                GError     **error)
+{
+	GConverterResult result;
+	GByteArray *output;
+	const guint8 *data;
+	guint8 buffer[BUFFER_SIZE];
+	gsize size, bytes_read, bytes_written;
+
+	data = g_bytes_get_data (bytes, &size);
+	output = g_byte_array_new ();
+
+	do {
+		result = g_converter_convert (compressor,
+		                              data, size,
+		                              buffer, sizeof (buffer),
+		                              at_end ? G_CONVERTER_INPUT_AT_END : G_CONVERTER_NO_FLAGS,
+		                              &bytes_read, &bytes_written,
+		                              error);
+		if (result == G_CONVERTER_ERROR) {
+			g_byte_array_unref (output);
+			return NULL;
+		}
+
+		g_byte_array_append (output, buffer, bytes_written);
+		data += bytes_read;
+		size -= bytes_read;
+	} while (size > 0 || (at_end && result != G_CONVERTER_FINISHED));
+
+	return g_byte_array_free_to_bytes (output);
+}
+
 static void
 on_bytes_read (GObject      *source,
                GAsyncResult *res,
@@ -674,6 +818,7 @@ on_bytes_read (GObject      *source,
 	SoupMessageBody *message_body;
 	GBytes *bytes;
 	GError *error = NULL;
+	gboolean at_end;
 
 	bytes = g_input_stream_read_bytes_finish (G_INPUT_STREAM (source),
 	                                          res, &error);
@@ -689,11 +834,59 @@ on_bytes_read (GObject      *source,
 		return;
 	}
 
+	at_end = g_bytes_get_size (bytes) == 0;
+
+	if (request->pending) {
+		/* Compression was negotiated, buffer the response until
+		 * it is known to be over the size threshold.
+		 */
+		g_byte_array_append (request->pending,
+		                     g_bytes_get_data (bytes, NULL),
+		                     g_bytes_get_size (bytes));
+		g_bytes_unref (bytes);
+
+		if (!at_end && request->pending->len < request->compression_min_size) {
+			next_write (request);
+			return;
+		}
+
+		if (request->pending->len >= request->compression_min_size)
+			start_compression (request);
+
+		bytes = g_byte_array_free_to_bytes (g_steal_pointer (&request->pending));
+	}
+
+	if (request->compressor) {
+		GBytes *compressed;
+
+		compressed = compress_bytes (request->compressor, bytes, at_end, &error);
+		g_bytes_unref (bytes);
+
+		if (!compressed) {
+			tracker_http_server_soup_error (request->server,
+			                                request,
+			                                500,
+			                                error->message);
+			g_error_free (error);
+			return;
+		}
+
+		bytes = compressed;
+
+		/* The compressor may be holding all data so far */
+		if (!at_end && g_bytes_get_size (bytes) == 0) {
+			g_bytes_unref (bytes);
+			next_write (request);
+			return;
+		}
+	}
+
 	message_body = soup_server_message_get_response_body (request->message);
 
-	if (g_bytes_get_size (bytes) > 0) {
+	if (g_bytes_get_size (bytes) > 0)
 		soup_message_body_append_bytes (message_body, bytes);
 
+	if (!at_end) {
 #if SOUP_CHECK_VERSION (3, 1, 3)
 		soup_server_message_unpause (request->message);
 #else
@@ -747,6 +940,9 @@ tracker_http_server_soup_response (TrackerHttpServer       *server,
                                    const gchar*             mimetype,
                                    GInputStream            *content)
 {
+	SoupMessageHeaders *response_headers;
+	guint compression_min_size;
+
 	g_assert (request->server == server);
 
 	TRACKER_NOTE (HTTP, debug_http_reponse_response ());
@@ -755,6 +951,20 @@ tracker_http_server_soup_response (TrackerHttpServer       *server,
 	soup_server_message_set_status (request->message, 200, NULL);
 	request->istream = content;
 
+	g_object_get (server,
+	              "compression-min-size", &compression_min_size,
+	              NULL);
+
+	if (compression_min_size != G_MAXUINT) {
+		response_headers = soup_server_message_get_response_headers (request->message);
+		soup_message_headers_append (response_headers, "Vary", "Accept-Encoding");
+
+		if (get_accepted_encoding (request, &request->compression_format)) {
+			request->compression_min_size = compression_min_size;
+			request->pending = g_byte_array_new ();
+		}
+	}
+
 	g_signal_connect (request->message, "finished", G_CALLBACK (on_message_finished), request);
 	g_signal_connect (request->message, "wrote-chunk", G_CALLBACK (on_chunk_written), request);
 	next_write (request);
@@ -778,6 +988,59 @@ tracker_http_server_soup_error_content (TrackerHttpServer       *server,
 	next_write (request);
 }
 
+static const gchar *
+tracker_http_server_soup_get_request_header (TrackerHttpServer  *server,
+                                             TrackerHttpRequest *request,
+                                             const gchar        *name)
+{
+	SoupMessageHeaders *request_headers;
+
+	g_assert (request->server == server);
+
+	request_headers = soup_server_message_get_request_headers (request->message);
+
+	return soup_message_headers_get_list (request_headers, name);
+}
+
+static void
+tracker_http_server_soup_set_response_header (TrackerHttpServer  *server,
+                                              TrackerHttpRequest *request,
+                                              const gchar        *name,
+                                              const gchar        *value)
+{
+	SoupMessageHeaders *response_headers;
+
+	g_assert (request->server == server);
+
+	response_headers = soup_server_message_get_response_headers (request->message);
+	soup_message_headers_replace (response_headers, name, value);
+}
+
+static void
+tracker_http_server_soup_not_modified (TrackerHttpServer  *server,
+                                       TrackerHttpRequest *request)
+{
+	G_GNUC_UNUSED TrackerHttpServerSoup *server_soup =
+		TRACKER_HTTP_SERVER_SOUP (server);
+	SoupMessageHeaders *response_headers;
+
+	g_assert (request->server == server);
+
+	TRACKER_NOTE (HTTP, debug_http_reponse_response ());
+
+	/* 304 responses carry no body */
+	response_headers = soup_server_message_get_response_headers (request->message);
+	soup_message_headers_set_encoding (response_headers, SOUP_ENCODING_NONE);
+	soup_server_message_set_status (request->message, 304, NULL);
+
+#if SOUP_CHECK_VERSION (3, 1, 3)
+	soup_server_message_unpause (request->message);
+#else
+	soup_server_unpause_message (server_soup->server, request->message);
+#endif
+	request_free (request);
+}
+
 static void
 tracker_http_server_soup_finalize (GObject *object)
 {
@@ -809,6 +1072,9 @@ tracker_http_server_soup_class_init (TrackerHttpServerSoupClass *klass)
 	server_class->response = tracker_http_server_soup_response;
 	server_class->error = tracker_http_server_soup_error;
 	server_class->error_content = tracker_http_server_soup_error_content;
+	server_class->get_request_header = tracker_http_server_soup_get_request_header;
+	server_class->set_response_header = tracker_http_server_soup_set_response_header;
+	server_class->not_modified = tracker_http_server_soup_not_modified;
 }
 
 static void
@@ -1031,6 +1297,10 @@ static void
 tracker_http_client_soup_init (TrackerHttpClientSoup *client)
 {
 	client->session = soup_session_new ();
+
+	/* Advertise and transparently decode compressed responses */
+	if (!soup_session_has_feature (client->session, SOUP_TYPE_CONTENT_DECODER))
+		soup_session_add_feature_by_type (client->session, SOUP_TYPE_CONTENT_DECODER);
 }
 
 void
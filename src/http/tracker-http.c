@@ -110,6 +110,7 @@ enum {
 	PROP_HTTP_PORT,
 	PROP_HTTP_CERTIFICATE,
 	PROP_SERVER_MODE,
+	PROP_COMPRESSION_MIN_SIZE,
 	N_SERVER_PROPS
 };
 
@@ -123,6 +124,7 @@ typedef struct
 	guint port;
 	GTlsCertificate *certificate;
 	TrackerHttpServerMode server_mode;
+	guint compression_min_size;
 } TrackerHttpServerPrivate;
 
 static GParamSpec *server_props[N_SERVER_PROPS] = { 0 };
@@ -152,6 +154,9 @@ tracker_http_server_set_property (GObject      *object,
 	case PROP_SERVER_MODE:
 		priv->server_mode = g_value_get_uint (value);
 		break;
+	case PROP_COMPRESSION_MIN_SIZE:
+		priv->compression_min_size = g_value_get_uint (value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 	}
@@ -177,6 +182,9 @@ tracker_http_server_get_property (GObject    *object,
 	case PROP_SERVER_MODE:
 		g_value_set_uint (value, priv->server_mode);
 		break;
+	case PROP_COMPRESSION_MIN_SIZE:
+		g_value_set_uint (value, priv->compression_min_size);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 	}
@@ -223,6 +231,13 @@ tracker_http_server_class_init (TrackerHttpServerClass *klass)
 		                   TRACKER_N_HTTP_SERVER_MODES,
 		                   TRACKER_HTTP_SERVER_MODE_SPARQL_ENDPOINT,
 		                   G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+	server_props[PROP_COMPRESSION_MIN_SIZE] =
+		g_param_spec_uint ("compression-min-size",
+		                   "Compression minimum size",
+		                   "Compression minimum size",
+		                   0, G_MAXUINT,
+		                   TRACKER_HTTP_DEFAULT_COMPRESSION_MIN_SIZE,
+		                   G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
 	g_object_class_install_properties (object_class,
 	                                   N_SERVER_PROPS,
 	                                   server_props);
@@ -288,6 +303,36 @@ tracker_http_server_error_content (TrackerHttpServer  *server,
 	                                                       content);
 }
 
+const gchar *
+tracker_http_server_get_request_header (TrackerHttpServer  *server,
+                                        TrackerHttpRequest *request,
+                                        const gchar        *name)
+{
+	return TRACKER_HTTP_SERVER_GET_CLASS (server)->get_request_header (server,
+	                                                                   request,
+	                                                                   name);
+}
+
+void
+tracker_http_server_set_response_header (TrackerHttpServer  *server,
+                                         TrackerHttpRequest *request,
+                                         const gchar        *name,
+                                         const gchar        *value)
+{
+	TRACKER_HTTP_SERVER_GET_CLASS (server)->set_response_header (server,
+	                                                             request,
+	                                                             name,
+	                                                             value);
+}
+
+void
+tracker_http_server_not_modified (TrackerHttpServer  *server,
+                                  TrackerHttpRequest *request)
+{
+	TRACKER_HTTP_SERVER_GET_CLASS (server)->not_modified (server,
+	                                                      request);
+}
+
 /* HTTP client */
 G_DEFINE_ABSTRACT_TYPE (TrackerHttpClient, tracker_http_client, G_TYPE_OBJECT)
 
@@ -34,6 +34,9 @@ typedef enum
 	TRACKER_N_HTTP_SERVER_MODES
 } TrackerHttpServerMode;
 
+/* Responses smaller than this are not worth compressing */
+#define TRACKER_HTTP_DEFAULT_COMPRESSION_MIN_SIZE 1024
+
 typedef struct _TrackerHttpRequest TrackerHttpRequest;
 
 #define TRACKER_TYPE_HTTP_SERVER (tracker_http_server_get_type ())
@@ -58,6 +61,15 @@ struct _TrackerHttpServerClass {
 	                        gint                     code,
 	                        const gchar*             mimetype,
 	                        GInputStream            *content);
+	const gchar * (* get_request_header) (TrackerHttpServer  *server,
+	                                      TrackerHttpRequest *request,
+	                                      const gchar        *name);
+	void (* set_response_header) (TrackerHttpServer  *server,
+	                              TrackerHttpRequest *request,
+	                              const gchar        *name,
+	                              const gchar        *value);
+	void (* not_modified) (TrackerHttpServer  *server,
+	                       TrackerHttpRequest *request);
 };
 
 TrackerHttpServer * tracker_http_server_new (guint                   port,
@@ -82,6 +94,18 @@ void tracker_http_server_error_content (TrackerHttpServer   *server,
                                         const gchar*         mimetype,
                                         GInputStream        *content);
 
+const gchar * tracker_http_server_get_request_header (TrackerHttpServer  *server,
+                                                     TrackerHttpRequest *request,
+                                                     const gchar        *name);
+
+void tracker_http_server_set_response_header (TrackerHttpServer  *server,
+                                              TrackerHttpRequest *request,
+                                              const gchar        *name,
+                                              const gchar        *value);
+
+void tracker_http_server_not_modified (TrackerHttpServer  *server,
+                                       TrackerHttpRequest *request);
+
 #define TRACKER_TYPE_HTTP_CLIENT (tracker_http_client_get_type ())
 G_DECLARE_DERIVABLE_TYPE (TrackerHttpClient,
                           tracker_http_client,
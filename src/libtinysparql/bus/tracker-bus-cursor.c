@@ -21,6 +21,14 @@
 
 #include "tracker-bus-cursor.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include <gio/gunixinputstream.h>
+
 struct _TrackerBusCursor
 {
 	TrackerDeserializer parent_instance;
@@ -28,16 +36,55 @@ struct _TrackerBusCursor
 	GVariant *variables;
 	const gchar **variable_names;
 	gint n_columns;
+	TrackerBusCursorFormat format;
+	gboolean finished;
+
+	/* TRACKER_BUS_CURSOR_FORMAT_ROWS, buffers are reused across rows */
 	TrackerSparqlValueType *types;
 	gchar *row_data;
 	gint32 *offsets;
 	const gchar **values;
-	gboolean finished;
+	gint32 row_columns;
+	gsize row_data_size;
+
+	/* TRACKER_BUS_CURSOR_FORMAT_FRAMES */
+	struct {
+		gchar *buffer;
+		gsize buffer_size;
+		const guint32 *offsets;
+		const guint8 *types;
+		const gchar *data;
+		guint32 n_rows;
+		guint32 row;
+	} frame;
+
+	/* Next frame, read ahead in a thread while the current one is iterated */
+	struct {
+		GMutex mutex;
+		GCond cond;
+		GCancellable *cancellable;
+		TrackerBusFrameHeader header;
+		gchar *buffer;
+		gsize buffer_size;
+		GError *error;
+		gboolean started;
+		gboolean pending;
+		gboolean eof;
+	} read_ahead;
+
+	/* TRACKER_BUS_CURSOR_FORMAT_MEMFD_FRAMES */
+	struct {
+		gchar *map;
+		gsize size;
+		gsize pos;
+		gboolean received;
+	} chunk;
 };
 
 enum {
 	PROP_0,
 	PROP_VARIABLES,
+	PROP_FORMAT,
 	N_PROPS
 };
 
@@ -47,12 +94,21 @@ enum {
  */
 #define MAX_ROW_SIZE (2 * 1000 * 1000 * 1000)
 
+/* Size of the buffer used to read from the pipe, so that small
+ * reads (e.g. row headers) do not go each to the file descriptor.
+ */
+#define READ_BUFFER_SIZE (64 * 1024)
+
 static GParamSpec *props[N_PROPS] = { 0, };
 
 G_DEFINE_TYPE (TrackerBusCursor,
                tracker_bus_cursor,
                TRACKER_TYPE_DESERIALIZER)
 
+#ifdef HAVE_MEMFD_CREATE
+static void unmap_chunk (TrackerBusCursor *bus_cursor);
+#endif
+
 static void
 tracker_bus_cursor_finalize (GObject *object)
 {
@@ -65,6 +121,15 @@ tracker_bus_cursor_finalize (GObject *object)
 	g_clear_pointer (&bus_cursor->values, g_free);
 	g_clear_pointer (&bus_cursor->variable_names, g_free);
 	g_clear_pointer (&bus_cursor->offsets, g_free);
+	g_clear_pointer (&bus_cursor->frame.buffer, g_free);
+	g_clear_pointer (&bus_cursor->read_ahead.buffer, g_free);
+	g_clear_error (&bus_cursor->read_ahead.error);
+	g_clear_object (&bus_cursor->read_ahead.cancellable);
+	g_mutex_clear (&bus_cursor->read_ahead.mutex);
+	g_cond_clear (&bus_cursor->read_ahead.cond);
+#ifdef HAVE_MEMFD_CREATE
+	unmap_chunk (bus_cursor);
+#endif
 
 	G_OBJECT_CLASS (tracker_bus_cursor_parent_class)->finalize (object);
 }
@@ -83,6 +148,8 @@ tracker_bus_cursor_constructed (GObject *object)
 		g_data_input_stream_new (tracker_deserializer_get_stream (deserializer));
 	g_data_input_stream_set_byte_order (cursor->data_stream,
 					    G_DATA_STREAM_BYTE_ORDER_HOST_ENDIAN);
+	g_buffered_input_stream_set_buffer_size (G_BUFFERED_INPUT_STREAM (cursor->data_stream),
+	                                         READ_BUFFER_SIZE);
 }
 
 static void
@@ -97,6 +164,9 @@ tracker_bus_cursor_set_property (GObject      *object,
 	case PROP_VARIABLES:
 		cursor->variables = g_value_dup_variant (value);
 		break;
+	case PROP_FORMAT:
+		cursor->format = g_value_get_uint (value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -121,6 +191,15 @@ tracker_bus_cursor_get_value_type (TrackerSparqlCursor *cursor,
 		return TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
 	if (column < 0 || column >= bus_cursor->n_columns)
 		return TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
+
+	if (bus_cursor->format != TRACKER_BUS_CURSOR_FORMAT_ROWS) {
+		if (!bus_cursor->frame.types)
+			return TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
+
+		return bus_cursor->frame.types[column * bus_cursor->frame.n_rows +
+		                               bus_cursor->frame.row];
+	}
+
 	if (!bus_cursor->types)
 		return TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
 
@@ -157,13 +236,33 @@ tracker_bus_cursor_get_string (TrackerSparqlCursor  *cursor,
 		return NULL;
 	if (column < 0 || column >= bus_cursor->n_columns)
 		return NULL;
-	if (!bus_cursor->types)
-		return NULL;
 
 	/* Return null instead of empty string for unbound values */
-	if (bus_cursor->types[column] == TRACKER_SPARQL_VALUE_TYPE_UNBOUND)
+	if (tracker_bus_cursor_get_value_type (cursor, column) ==
+	    TRACKER_SPARQL_VALUE_TYPE_UNBOUND)
 		return NULL;
 
+	if (bus_cursor->format != TRACKER_BUS_CURSOR_FORMAT_ROWS) {
+		guint32 cell, start;
+
+		cell = bus_cursor->frame.row * bus_cursor->n_columns + column;
+		start = cell > 0 ? bus_cursor->frame.offsets[cell - 1] : 0;
+		str = &bus_cursor->frame.data[start];
+
+		if (len || langtag) {
+			gsize str_len;
+
+			str_len = strlen (str);
+			if (len)
+				*len = str_len;
+
+			if (langtag && bus_cursor->frame.offsets[cell] - start - str_len > 1)
+				*langtag = &str[str_len + 1];
+		}
+
+		return str;
+	}
+
 	str = bus_cursor->values[column];
 
 	if (len || langtag) {
@@ -183,6 +282,510 @@ tracker_bus_cursor_get_string (TrackerSparqlCursor  *cursor,
 	return str;
 }
 
+static void
+clear_frame (TrackerBusCursor *bus_cursor)
+{
+	bus_cursor->frame.offsets = NULL;
+	bus_cursor->frame.types = NULL;
+	bus_cursor->frame.data = NULL;
+	bus_cursor->frame.n_rows = 0;
+	bus_cursor->frame.row = 0;
+}
+
+static gboolean
+set_frame_corrupted_error (TrackerBusCursor  *bus_cursor,
+                           GError           **error)
+{
+	clear_frame (bus_cursor);
+	g_set_error (error,
+	             G_IO_ERROR,
+	             G_IO_ERROR_INVALID_DATA,
+	             "Corrupted cursor data");
+	return FALSE;
+}
+
+static guint64
+get_frame_size (TrackerBusCursor            *bus_cursor,
+                const TrackerBusFrameHeader *header)
+{
+	guint64 n_cells;
+
+	n_cells = (guint64) header->n_rows * bus_cursor->n_columns;
+
+	return n_cells * (sizeof (guint32) + sizeof (guint8)) + header->data_size;
+}
+
+static gboolean
+set_frame (TrackerBusCursor             *bus_cursor,
+           const TrackerBusFrameHeader  *header,
+           const gchar                  *payload,
+           GError                      **error)
+{
+	const guint32 *offsets;
+	const gchar *data;
+	guint32 i, n_cells, prev = 0;
+
+	n_cells = header->n_rows * bus_cursor->n_columns;
+	offsets = (const guint32 *) payload;
+	data = &payload[n_cells * (sizeof (guint32) + sizeof (guint8))];
+
+	/* Every cell must hold at least a nul-terminated string */
+	for (i = 0; i < n_cells; i++) {
+		guint32 cur = offsets[i];
+
+		if (cur <= prev || cur > header->data_size || data[cur - 1] != '\0')
+			return set_frame_corrupted_error (bus_cursor, error);
+
+		prev = cur;
+	}
+
+	if (prev != header->data_size)
+		return set_frame_corrupted_error (bus_cursor, error);
+
+	bus_cursor->frame.offsets = offsets;
+	bus_cursor->frame.types = (const guint8 *) &offsets[n_cells];
+	bus_cursor->frame.data = data;
+	bus_cursor->frame.n_rows = header->n_rows;
+	bus_cursor->frame.row = 0;
+
+	return TRUE;
+}
+
+/* Buffers are reused across frames and rows, so short reads must
+ * not be mistaken for complete ones.
+ */
+static gboolean
+read_exact (TrackerBusCursor  *bus_cursor,
+            gpointer           buffer,
+            gsize              size,
+            GCancellable      *cancellable,
+            GError           **error)
+{
+	gsize bytes_read;
+
+	if (!g_input_stream_read_all (G_INPUT_STREAM (bus_cursor->data_stream),
+	                              buffer, size,
+	                              &bytes_read, cancellable, error))
+		return FALSE;
+
+	if (bytes_read != size) {
+		g_set_error (error,
+		             G_IO_ERROR,
+		             G_IO_ERROR_INVALID_DATA,
+		             "Corrupted cursor data");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+read_frame_data (TrackerBusCursor       *bus_cursor,
+                 TrackerBusFrameHeader  *header,
+                 gchar                 **buffer,
+                 gsize                  *buffer_size,
+                 gboolean               *eof,
+                 GCancellable           *cancellable,
+                 GError                **error)
+{
+	gsize bytes_read;
+	guint64 size;
+
+	*eof = FALSE;
+
+	if (!g_input_stream_read_all (G_INPUT_STREAM (bus_cursor->data_stream),
+	                              header, sizeof (TrackerBusFrameHeader),
+	                              &bytes_read, cancellable, error))
+		return FALSE;
+
+	if (bytes_read < sizeof (TrackerBusFrameHeader) || header->n_rows == 0) {
+		*eof = TRUE;
+		return TRUE;
+	}
+
+	size = get_frame_size (bus_cursor, header);
+	if (size > MAX_ROW_SIZE) {
+		g_set_error (error,
+		             G_IO_ERROR,
+		             G_IO_ERROR_INVALID_DATA,
+		             "Corrupted cursor data");
+		return FALSE;
+	}
+
+	/* Frame buffers are reused, only grow them if necessary */
+	if (size > *buffer_size) {
+		g_free (*buffer);
+		*buffer = g_malloc (size);
+		*buffer_size = size;
+	}
+
+	return read_exact (bus_cursor, *buffer, size, cancellable, error);
+}
+
+static void
+read_ahead_func (gpointer data,
+                 gpointer user_data)
+{
+	TrackerBusCursor *bus_cursor = data;
+	TrackerBusFrameHeader header = { 0, };
+	GError *error = NULL;
+	gboolean eof;
+
+	/* The consumer thread does not touch the stream nor the
+	 * read ahead buffer until the pending flag is unset.
+	 */
+	read_frame_data (bus_cursor, &header,
+	                 &bus_cursor->read_ahead.buffer,
+	                 &bus_cursor->read_ahead.buffer_size,
+	                 &eof,
+	                 bus_cursor->read_ahead.cancellable,
+	                 &error);
+
+	g_mutex_lock (&bus_cursor->read_ahead.mutex);
+	bus_cursor->read_ahead.header = header;
+	bus_cursor->read_ahead.error = error;
+	bus_cursor->read_ahead.eof = eof;
+	bus_cursor->read_ahead.pending = FALSE;
+	g_cond_signal (&bus_cursor->read_ahead.cond);
+	g_mutex_unlock (&bus_cursor->read_ahead.mutex);
+
+	g_object_unref (bus_cursor);
+}
+
+static void
+start_read_ahead (TrackerBusCursor *bus_cursor)
+{
+	static GThreadPool *read_ahead_pool = NULL;
+
+	if (g_once_init_enter (&read_ahead_pool)) {
+		GThreadPool *pool;
+
+		pool = g_thread_pool_new (read_ahead_func, NULL,
+		                          -1, FALSE, NULL);
+		g_once_init_leave (&read_ahead_pool, pool);
+	}
+
+	/* A previous wait may have been cancelled after the read finished */
+	if (!bus_cursor->read_ahead.cancellable ||
+	    g_cancellable_is_cancelled (bus_cursor->read_ahead.cancellable)) {
+		g_clear_object (&bus_cursor->read_ahead.cancellable);
+		bus_cursor->read_ahead.cancellable = g_cancellable_new ();
+	}
+
+	bus_cursor->read_ahead.started = TRUE;
+	bus_cursor->read_ahead.pending = TRUE;
+	g_thread_pool_push (read_ahead_pool, g_object_ref (bus_cursor), NULL);
+}
+
+static void
+cancel_read_ahead (GCancellable *cancellable,
+                   GCancellable *read_ahead_cancellable)
+{
+	g_cancellable_cancel (read_ahead_cancellable);
+}
+
+static void
+wait_read_ahead (TrackerBusCursor *bus_cursor,
+                 GCancellable     *cancellable)
+{
+	gulong handler_id = 0;
+
+	/* Cancelling the caller must still interrupt the reader thread */
+	if (cancellable) {
+		handler_id = g_cancellable_connect (cancellable,
+		                                    G_CALLBACK (cancel_read_ahead),
+		                                    bus_cursor->read_ahead.cancellable,
+		                                    NULL);
+	}
+
+	g_mutex_lock (&bus_cursor->read_ahead.mutex);
+	while (bus_cursor->read_ahead.pending)
+		g_cond_wait (&bus_cursor->read_ahead.cond, &bus_cursor->read_ahead.mutex);
+	g_mutex_unlock (&bus_cursor->read_ahead.mutex);
+
+	if (cancellable)
+		g_cancellable_disconnect (cancellable, handler_id);
+}
+
+/* Only safe to call while no read ahead is pending */
+static gboolean
+peek_end_of_frames (TrackerBusCursor *bus_cursor)
+{
+	TrackerBusFrameHeader header;
+	gconstpointer buffer;
+	gsize available;
+
+	buffer = g_buffered_input_stream_peek_buffer (G_BUFFERED_INPUT_STREAM (bus_cursor->data_stream),
+	                                              &available);
+	if (available < sizeof (header))
+		return FALSE;
+
+	memcpy (&header, buffer, sizeof (header));
+
+	return header.n_rows == 0;
+}
+
+static gboolean
+read_frame (TrackerBusCursor  *bus_cursor,
+            GCancellable      *cancellable,
+            GError           **error)
+{
+	TrackerBusFrameHeader header;
+	gboolean eof;
+
+	clear_frame (bus_cursor);
+
+	if (bus_cursor->read_ahead.started) {
+		gchar *buffer;
+		gsize buffer_size;
+
+		wait_read_ahead (bus_cursor, cancellable);
+		bus_cursor->read_ahead.started = FALSE;
+
+		if (bus_cursor->read_ahead.error) {
+			g_propagate_error (error, g_steal_pointer (&bus_cursor->read_ahead.error));
+			return FALSE;
+		}
+
+		eof = bus_cursor->read_ahead.eof;
+		header = bus_cursor->read_ahead.header;
+
+		/* Swap buffers, the current frame one gets reused for the next read ahead */
+		buffer = bus_cursor->read_ahead.buffer;
+		buffer_size = bus_cursor->read_ahead.buffer_size;
+		bus_cursor->read_ahead.buffer = bus_cursor->frame.buffer;
+		bus_cursor->read_ahead.buffer_size = bus_cursor->frame.buffer_size;
+		bus_cursor->frame.buffer = buffer;
+		bus_cursor->frame.buffer_size = buffer_size;
+	} else if (!read_frame_data (bus_cursor, &header,
+	                             &bus_cursor->frame.buffer,
+	                             &bus_cursor->frame.buffer_size,
+	                             &eof, cancellable, error)) {
+		return FALSE;
+	}
+
+	if (eof) {
+		bus_cursor->finished = TRUE;
+		return FALSE;
+	}
+
+	if (!set_frame (bus_cursor, &header, bus_cursor->frame.buffer, error))
+		return FALSE;
+
+	/* Read the next frame while this one is being iterated, unless
+	 * the end of the results is already buffered.
+	 */
+	if (!peek_end_of_frames (bus_cursor))
+		start_read_ahead (bus_cursor);
+
+	return TRUE;
+}
+
+#ifdef HAVE_MEMFD_CREATE
+static void
+unmap_chunk (TrackerBusCursor *bus_cursor)
+{
+	if (bus_cursor->chunk.map)
+		munmap (bus_cursor->chunk.map, bus_cursor->chunk.size);
+
+	bus_cursor->chunk.map = NULL;
+	bus_cursor->chunk.size = 0;
+	bus_cursor->chunk.pos = 0;
+}
+
+static gboolean
+receive_fd (TrackerBusCursor  *bus_cursor,
+            GCancellable      *cancellable,
+            int               *fd_out,
+            GError           **error)
+{
+	union {
+		struct cmsghdr align;
+		gchar buf[CMSG_SPACE (sizeof (int))];
+	} control;
+	struct msghdr msg = { 0, };
+	struct cmsghdr *cmsg;
+	struct iovec iov;
+	GPollFD fds[2] = { 0, };
+	GInputStream *stream;
+	gchar byte;
+	gssize res;
+	int socket_fd;
+
+	*fd_out = -1;
+	stream = tracker_deserializer_get_stream (TRACKER_DESERIALIZER (bus_cursor));
+	socket_fd = g_unix_input_stream_get_fd (G_UNIX_INPUT_STREAM (stream));
+
+	if (cancellable && g_cancellable_make_pollfd (cancellable, &fds[1])) {
+		fds[0].fd = socket_fd;
+		fds[0].events = G_IO_IN | G_IO_HUP | G_IO_ERR;
+
+		while (g_poll (fds, 2, -1) < 0 && errno == EINTR)
+			;
+
+		g_cancellable_release_fd (cancellable);
+	}
+
+	if (g_cancellable_set_error_if_cancelled (cancellable, error))
+		return FALSE;
+
+	memset (&control, 0, sizeof (control));
+	iov.iov_base = &byte;
+	iov.iov_len = 1;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof (control.buf);
+
+	do {
+		res = recvmsg (socket_fd, &msg, MSG_CMSG_CLOEXEC);
+	} while (res < 0 && errno == EINTR);
+
+	if (res < 0) {
+		g_set_error (error,
+		             G_IO_ERROR,
+		             g_io_error_from_errno (errno),
+		             "Could not receive file descriptor: %m");
+		return FALSE;
+	}
+
+	/* End of stream */
+	if (res == 0)
+		return TRUE;
+
+	for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+		if (cmsg->cmsg_level == SOL_SOCKET &&
+		    cmsg->cmsg_type == SCM_RIGHTS &&
+		    cmsg->cmsg_len == CMSG_LEN (sizeof (int)))
+			memcpy (fd_out, CMSG_DATA (cmsg), sizeof (int));
+	}
+
+	if (*fd_out < 0 || (msg.msg_flags & MSG_CTRUNC) != 0) {
+		if (*fd_out >= 0)
+			close (*fd_out);
+		*fd_out = -1;
+		return set_frame_corrupted_error (bus_cursor, error);
+	}
+
+	return TRUE;
+}
+
+static gboolean
+map_next_chunk (TrackerBusCursor  *bus_cursor,
+                GCancellable      *cancellable,
+                GError           **error)
+{
+	struct stat st;
+	gpointer map;
+	int fd, seals;
+
+	unmap_chunk (bus_cursor);
+
+	if (bus_cursor->chunk.received) {
+		GInputStream *stream;
+
+		/* Let the endpoint know it can send more memfds. Errors
+		 * will be noticed when receiving the next one.
+		 */
+		stream = tracker_deserializer_get_stream (TRACKER_DESERIALIZER (bus_cursor));
+		send (g_unix_input_stream_get_fd (G_UNIX_INPUT_STREAM (stream)),
+		      "", 1, MSG_NOSIGNAL);
+		bus_cursor->chunk.received = FALSE;
+	}
+
+	if (!receive_fd (bus_cursor, cancellable, &fd, error))
+		return FALSE;
+
+	if (fd >= 0)
+		bus_cursor->chunk.received = TRUE;
+
+	if (fd < 0) {
+		bus_cursor->finished = TRUE;
+		return TRUE;
+	}
+
+	/* Only map memfds that cannot be changed or shrunk anymore */
+	seals = fcntl (fd, F_GET_SEALS);
+
+	if (seals < 0 ||
+	    (seals & (F_SEAL_SHRINK | F_SEAL_WRITE)) != (F_SEAL_SHRINK | F_SEAL_WRITE) ||
+	    fstat (fd, &st) < 0 ||
+	    st.st_size > G_MAXSSIZE) {
+		close (fd);
+		return set_frame_corrupted_error (bus_cursor, error);
+	}
+
+	if (st.st_size == 0) {
+		close (fd);
+		return TRUE;
+	}
+
+	map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+
+	if (map == MAP_FAILED) {
+		g_set_error (error,
+		             G_IO_ERROR,
+		             g_io_error_from_errno (errno),
+		             "Could not map cursor data: %m");
+		return FALSE;
+	}
+
+	bus_cursor->chunk.map = map;
+	bus_cursor->chunk.size = st.st_size;
+	bus_cursor->chunk.pos = 0;
+
+	return TRUE;
+}
+
+static gboolean
+read_mapped_frame (TrackerBusCursor  *bus_cursor,
+                   GCancellable      *cancellable,
+                   GError           **error)
+{
+	TrackerBusFrameHeader header;
+	const gchar *payload;
+	gsize pos;
+	guint64 size;
+
+	/* Frame data may be about to be unmapped */
+	clear_frame (bus_cursor);
+
+	while (bus_cursor->chunk.pos >= bus_cursor->chunk.size) {
+		if (!map_next_chunk (bus_cursor, cancellable, error))
+			return FALSE;
+		if (bus_cursor->finished)
+			return FALSE;
+	}
+
+	pos = bus_cursor->chunk.pos;
+
+	if (bus_cursor->chunk.size - pos < sizeof (header))
+		return set_frame_corrupted_error (bus_cursor, error);
+
+	memcpy (&header, &bus_cursor->chunk.map[pos], sizeof (header));
+	pos += sizeof (header);
+
+	if (header.n_rows == 0) {
+		bus_cursor->finished = TRUE;
+		return FALSE;
+	}
+
+	size = get_frame_size (bus_cursor, &header);
+	if (size > bus_cursor->chunk.size - pos)
+		return set_frame_corrupted_error (bus_cursor, error);
+
+	payload = &bus_cursor->chunk.map[pos];
+	pos += size;
+
+	/* Frames in memfds start at aligned offsets */
+	bus_cursor->chunk.pos = (pos + TRACKER_BUS_FRAME_ALIGNMENT - 1) &
+		~((gsize) TRACKER_BUS_FRAME_ALIGNMENT - 1);
+
+	return set_frame (bus_cursor, &header, payload, error);
+}
+#endif
+
 static gboolean
 tracker_bus_cursor_next (TrackerSparqlCursor  *cursor,
                          GCancellable         *cancellable,
@@ -197,6 +800,20 @@ tracker_bus_cursor_next (TrackerSparqlCursor  *cursor,
 	if (g_cancellable_set_error_if_cancelled (cancellable, error))
 		return FALSE;
 
+	if (bus_cursor->format != TRACKER_BUS_CURSOR_FORMAT_ROWS) {
+		if (bus_cursor->frame.row + 1 < bus_cursor->frame.n_rows) {
+			bus_cursor->frame.row++;
+			return TRUE;
+		}
+
+#ifdef HAVE_MEMFD_CREATE
+		if (bus_cursor->format == TRACKER_BUS_CURSOR_FORMAT_MEMFD_FRAMES)
+			return read_mapped_frame (bus_cursor, cancellable, error);
+#endif
+
+		return read_frame (bus_cursor, cancellable, error);
+	}
+
 	/* So, the make up on each cursor segment is:
 	 *
 	 * iteration = [4 bytes for number of columns,
@@ -211,21 +828,33 @@ tracker_bus_cursor_next (TrackerSparqlCursor  *cursor,
 		return FALSE;
 	}
 
-	g_clear_pointer (&bus_cursor->types, g_free);
-	bus_cursor->types = g_new0 (TrackerSparqlValueType, n_columns);
+	if (n_columns < 0) {
+		g_set_error (error,
+		             G_IO_ERROR,
+		             G_IO_ERROR_INVALID_DATA,
+		             "Corrupted cursor data");
+		return FALSE;
+	}
 
-	if (!g_input_stream_read_all (G_INPUT_STREAM (bus_cursor->data_stream),
-	                              bus_cursor->types,
-	                              n_columns * sizeof (gint32),
-	                              NULL, cancellable, error))
+	/* Per-row buffers are reused, only grow them if necessary */
+	if (n_columns > bus_cursor->row_columns) {
+		g_free (bus_cursor->types);
+		g_free (bus_cursor->offsets);
+		g_free (bus_cursor->values);
+		bus_cursor->types = g_new0 (TrackerSparqlValueType, n_columns);
+		bus_cursor->offsets = g_new0 (gint32, n_columns);
+		bus_cursor->values = g_new0 (const gchar *, n_columns);
+		bus_cursor->row_columns = n_columns;
+	}
+
+	if (!read_exact (bus_cursor, bus_cursor->types,
+	                 n_columns * sizeof (gint32),
+	                 cancellable, error))
 		return FALSE;
 
-	g_clear_pointer (&bus_cursor->offsets, g_free);
-	bus_cursor->offsets = g_new0 (gint32, n_columns);
-	if (!g_input_stream_read_all (G_INPUT_STREAM (bus_cursor->data_stream),
-	                              bus_cursor->offsets,
-	                              n_columns * sizeof (gint32),
-	                              NULL, cancellable, error))
+	if (!read_exact (bus_cursor, bus_cursor->offsets,
+	                 n_columns * sizeof (gint32),
+	                 cancellable, error))
 		return FALSE;
 
 	for (i = 0; i < n_columns - 1; i++) {
@@ -245,19 +874,19 @@ tracker_bus_cursor_next (TrackerSparqlCursor  *cursor,
 	/* The last offset says how long we have to go to read
 	 * the whole row data.
 	 */
-	g_clear_pointer (&bus_cursor->row_data, g_free);
 	data_size = bus_cursor->offsets[n_columns - 1] + 1;
 	g_assert (data_size >= 0 && data_size <= MAX_ROW_SIZE);
-	bus_cursor->row_data = g_new0 (gchar, data_size);
 
-	if (!g_input_stream_read_all (G_INPUT_STREAM (bus_cursor->data_stream),
-	                              bus_cursor->row_data,
-	                              bus_cursor->offsets[n_columns - 1] + 1,
-	                              NULL, cancellable, error))
-		return FALSE;
+	if ((gsize) data_size > bus_cursor->row_data_size) {
+		g_free (bus_cursor->row_data);
+		bus_cursor->row_data = g_new0 (gchar, data_size);
+		bus_cursor->row_data_size = data_size;
+	}
 
-	g_clear_pointer (&bus_cursor->values, g_free);
-	bus_cursor->values = g_new0 (const gchar *, n_columns);
+	if (!read_exact (bus_cursor, bus_cursor->row_data,
+	                 bus_cursor->offsets[n_columns - 1] + 1,
+	                 cancellable, error))
+		return FALSE;
 
 	for (i = 0; i < n_columns; i++) {
 		gint32 offset;
@@ -293,10 +922,22 @@ tracker_bus_cursor_next_async (TrackerSparqlCursor  *cursor,
                                GAsyncReadyCallback   cb,
                                gpointer              user_data)
 {
+	TrackerBusCursor *bus_cursor = TRACKER_BUS_CURSOR (cursor);
 	GTask *task;
 
 	task = g_task_new (cursor, cancellable, cb, user_data);
-	g_task_run_in_thread (task, next_in_thread);
+
+	/* Rows already in the current frame need no I/O, avoid a thread hop */
+	if (bus_cursor->format != TRACKER_BUS_CURSOR_FORMAT_ROWS &&
+	    !bus_cursor->finished &&
+	    bus_cursor->frame.row + 1 < bus_cursor->frame.n_rows &&
+	    !g_cancellable_is_cancelled (cancellable)) {
+		bus_cursor->frame.row++;
+		g_task_return_boolean (task, TRUE);
+	} else {
+		g_task_run_in_thread (task, next_in_thread);
+	}
+
 	g_object_unref (task);
 }
 
@@ -308,11 +949,71 @@ tracker_bus_cursor_next_finish (TrackerSparqlCursor  *cursor,
 	return g_task_propagate_boolean (G_TASK (res), error);
 }
 
+static gint
+tracker_bus_cursor_fetch_rows (TrackerSparqlCursor  *cursor,
+                               TrackerCursorFetch   *fetch,
+                               GCancellable         *cancellable,
+                               GError              **error)
+{
+	TrackerBusCursor *bus_cursor = TRACKER_BUS_CURSOR (cursor);
+	gint row, column, n_columns;
+
+	n_columns = MIN (fetch->n_columns, bus_cursor->n_columns);
+
+	for (row = 0; row < fetch->max_rows; row++) {
+		GError *inner_error = NULL;
+
+		if (!tracker_bus_cursor_next (cursor, cancellable, &inner_error)) {
+			if (inner_error) {
+				g_propagate_error (error, inner_error);
+				return -1;
+			}
+
+			break;
+		}
+
+		for (column = 0; column < fetch->n_columns; column++) {
+			TrackerSparqlValueType type = TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
+			const gchar *str = NULL;
+			gint64 integer = 0;
+			gdouble number = 0;
+			glong length = 0;
+
+			if (column < n_columns)
+				type = tracker_bus_cursor_get_value_type (cursor, column);
+
+			if (type != TRACKER_SPARQL_VALUE_TYPE_UNBOUND) {
+				str = tracker_bus_cursor_get_string (cursor, column, NULL, &length);
+
+				if (type == TRACKER_SPARQL_VALUE_TYPE_INTEGER)
+					integer = g_ascii_strtoll (str, NULL, 10);
+				else if (type == TRACKER_SPARQL_VALUE_TYPE_BOOLEAN)
+					integer = g_ascii_strcasecmp (str, "true") == 0;
+				else if (type == TRACKER_SPARQL_VALUE_TYPE_DOUBLE)
+					number = g_ascii_strtod (str, NULL);
+			}
+
+			tracker_sparql_cursor_fetch_set_cell (cursor, fetch, row, column,
+			                                      type, integer, number,
+			                                      fetch->strings ? str : NULL,
+			                                      length);
+		}
+	}
+
+	return row;
+}
+
 static void
 tracker_bus_cursor_close (TrackerSparqlCursor *cursor)
 {
 	TrackerBusCursor *bus_cursor = TRACKER_BUS_CURSOR (cursor);
 
+	if (bus_cursor->read_ahead.started) {
+		g_cancellable_cancel (bus_cursor->read_ahead.cancellable);
+		wait_read_ahead (bus_cursor, NULL);
+		bus_cursor->read_ahead.started = FALSE;
+	}
+
 	g_input_stream_close (G_INPUT_STREAM (bus_cursor->data_stream),
 			      NULL, NULL);
 
@@ -338,6 +1039,7 @@ tracker_bus_cursor_class_init (TrackerBusCursorClass *klass)
 	cursor_class->next_async = tracker_bus_cursor_next_async;
 	cursor_class->next_finish = tracker_bus_cursor_next_finish;
 	cursor_class->close = tracker_bus_cursor_close;
+	cursor_class->fetch_rows = tracker_bus_cursor_fetch_rows;
 
 	props[PROP_VARIABLES] =
 		g_param_spec_variant ("variables",
@@ -348,6 +1050,15 @@ tracker_bus_cursor_class_init (TrackerBusCursorClass *klass)
 		                      G_PARAM_WRITABLE |
 		                      G_PARAM_STATIC_STRINGS |
 		                      G_PARAM_CONSTRUCT_ONLY);
+	props[PROP_FORMAT] =
+		g_param_spec_uint ("format",
+		                   "Format",
+		                   "Format",
+		                   0, G_MAXUINT,
+		                   TRACKER_BUS_CURSOR_FORMAT_ROWS,
+		                   G_PARAM_WRITABLE |
+		                   G_PARAM_STATIC_STRINGS |
+		                   G_PARAM_CONSTRUCT_ONLY);
 
 	g_object_class_install_properties (object_class, N_PROPS, props);
 
@@ -356,15 +1067,19 @@ tracker_bus_cursor_class_init (TrackerBusCursorClass *klass)
 static void
 tracker_bus_cursor_init (TrackerBusCursor *cursor)
 {
+	g_mutex_init (&cursor->read_ahead.mutex);
+	g_cond_init (&cursor->read_ahead.cond);
 }
 
 TrackerSparqlCursor *
-tracker_bus_cursor_new (GInputStream *stream,
-			GVariant     *variables)
+tracker_bus_cursor_new (GInputStream           *stream,
+			GVariant               *variables,
+			TrackerBusCursorFormat  format)
 
 {
 	return g_object_new (TRACKER_TYPE_BUS_CURSOR,
 	                     "stream", stream,
 	                     "variables", variables,
+	                     "format", format,
 	                     NULL);
 }
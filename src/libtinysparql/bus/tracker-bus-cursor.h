@@ -27,5 +27,8 @@ G_DECLARE_FINAL_TYPE (TrackerBusCursor,
                       TRACKER, BUS_CURSOR,
                       TrackerDeserializer);
 
-TrackerSparqlCursor *tracker_bus_cursor_new (GInputStream *stream,
-					     GVariant     *variables);
+#include "tracker-bus.h"
+
+TrackerSparqlCursor *tracker_bus_cursor_new (GInputStream           *stream,
+					     GVariant               *variables,
+					     TrackerBusCursorFormat  format);
@@ -31,6 +31,9 @@ struct _TrackerBusStatement
 {
 	TrackerSparqlStatement parent_instance;
 	GHashTable *arguments;
+	/* Handle of the statement prepared in the endpoint */
+	guint32 handle;
+	gboolean prepare_failed;
 };
 
 typedef struct {
@@ -39,6 +42,12 @@ typedef struct {
 	GError *error;
 } UpdateAsyncData;
 
+typedef struct {
+	GVariant *arguments;
+	/* Handle the statement is being executed with */
+	guint32 handle;
+} ExecuteTaskData;
+
 G_DEFINE_TYPE (TrackerBusStatement,
                tracker_bus_statement,
 	       TRACKER_TYPE_SPARQL_STATEMENT)
@@ -47,6 +56,15 @@ static void
 tracker_bus_statement_finalize (GObject *object)
 {
 	TrackerBusStatement *bus_stmt = TRACKER_BUS_STATEMENT (object);
+	TrackerSparqlConnection *conn;
+
+	conn = tracker_sparql_statement_get_connection (TRACKER_SPARQL_STATEMENT (object));
+
+	if (bus_stmt->handle != 0) {
+		tracker_bus_connection_release_statement (TRACKER_BUS_CONNECTION (conn),
+		                                          tracker_sparql_statement_get_sparql (TRACKER_SPARQL_STATEMENT (object)),
+		                                          bus_stmt->handle);
+	}
 
 	g_hash_table_unref (bus_stmt->arguments);
 
@@ -165,6 +183,58 @@ get_arguments (TrackerBusStatement *bus_stmt)
 	return g_variant_builder_end (&builder);
 }
 
+static gboolean
+needs_prepare (TrackerBusStatement *bus_stmt)
+{
+	return bus_stmt->handle == 0 && !bus_stmt->prepare_failed;
+}
+
+static void
+set_handle (TrackerBusStatement *bus_stmt,
+            guint32              handle,
+            GError              *error)
+{
+	TrackerSparqlConnection *conn;
+
+	conn = tracker_sparql_statement_get_connection (TRACKER_SPARQL_STATEMENT (bus_stmt));
+
+	if (handle != 0 && bus_stmt->handle == 0) {
+		bus_stmt->handle = handle;
+	} else if (handle != 0) {
+		/* Prepared twice by concurrent executions */
+		tracker_bus_connection_release_statement (TRACKER_BUS_CONNECTION (conn),
+		                                          tracker_sparql_statement_get_sparql (TRACKER_SPARQL_STATEMENT (bus_stmt)),
+		                                          handle);
+	} else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		/* Keep sending the query text, errors in the query
+		 * itself will be reported from there.
+		 */
+		bus_stmt->prepare_failed = TRUE;
+	}
+}
+
+/* Returns TRUE if the execution failed because the endpoint does
+ * not know the handle, the statement is then prepared again on its
+ * next execution.
+ */
+static gboolean
+forget_stale_handle (TrackerBusStatement *bus_stmt,
+                     guint32              handle,
+                     const GError        *error)
+{
+	if (handle == 0 ||
+	    !g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_OBJECT))
+		return FALSE;
+
+	/* The endpoint might have been restarted, in which case the
+	 * handle is not ours to release.
+	 */
+	if (bus_stmt->handle == handle)
+		bus_stmt->handle = 0;
+
+	return TRUE;
+}
+
 static TrackerSparqlCursor *
 tracker_bus_statement_execute (TrackerSparqlStatement  *stmt,
                                GCancellable            *cancellable,
@@ -172,26 +242,78 @@ tracker_bus_statement_execute (TrackerSparqlStatement  *stmt,
 {
 	TrackerBusStatement *bus_stmt = TRACKER_BUS_STATEMENT (stmt);
 	TrackerSparqlConnection *conn;
+	TrackerSparqlCursor *cursor;
+	GError *inner_error = NULL;
+	guint32 handle;
 
 	conn = tracker_sparql_statement_get_connection (stmt);
 
-	return tracker_bus_connection_perform_query (TRACKER_BUS_CONNECTION (conn),
-						     tracker_sparql_statement_get_sparql (stmt),
-						     get_arguments (bus_stmt),
-						     cancellable, error);
+	if (needs_prepare (bus_stmt)) {
+		handle = tracker_bus_connection_perform_prepare (TRACKER_BUS_CONNECTION (conn),
+		                                                 tracker_sparql_statement_get_sparql (stmt),
+		                                                 cancellable,
+		                                                 &inner_error);
+		set_handle (bus_stmt, handle, inner_error);
+		g_clear_error (&inner_error);
+	}
+
+	handle = bus_stmt->handle;
+	cursor = tracker_bus_connection_perform_query (TRACKER_BUS_CONNECTION (conn),
+						       tracker_sparql_statement_get_sparql (stmt),
+						       handle,
+						       get_arguments (bus_stmt),
+						       cancellable, &inner_error);
+
+	if (!cursor && forget_stale_handle (bus_stmt, handle, inner_error)) {
+		/* Send the query text this time */
+		g_clear_error (&inner_error);
+		cursor = tracker_bus_connection_perform_query (TRACKER_BUS_CONNECTION (conn),
+							       tracker_sparql_statement_get_sparql (stmt),
+							       0,
+							       get_arguments (bus_stmt),
+							       cancellable, &inner_error);
+	}
+
+	if (inner_error)
+		g_propagate_error (error, inner_error);
+
+	return cursor;
 }
 
+static void
+execute_task_data_free (gpointer data)
+{
+	ExecuteTaskData *task_data = data;
+
+	g_clear_pointer (&task_data->arguments, g_variant_unref);
+	g_free (task_data);
+}
+
+static void send_execute (GTask   *task,
+                          guint32  handle);
+
 static void
 execute_cb (GObject      *source,
 	    GAsyncResult *res,
 	    gpointer      user_data)
 {
 	TrackerSparqlCursor *cursor;
+	ExecuteTaskData *data;
 	GError *error = NULL;
 	GTask *task = user_data;
 
+	data = g_task_get_task_data (task);
 	cursor = tracker_bus_connection_perform_query_finish (TRACKER_BUS_CONNECTION (source),
 							      res, &error);
+
+	if (!cursor &&
+	    forget_stale_handle (g_task_get_source_object (task), data->handle, error)) {
+		/* Send the query text this time */
+		g_clear_error (&error);
+		send_execute (task, 0);
+		return;
+	}
+
 	if (cursor)
 		g_task_return_pointer (task, cursor, g_object_unref);
 	else
@@ -200,6 +322,52 @@ execute_cb (GObject      *source,
 	g_object_unref (task);
 }
 
+static void
+send_execute (GTask   *task,
+              guint32  handle)
+{
+	TrackerSparqlStatement *stmt = g_task_get_source_object (task);
+	TrackerSparqlConnection *conn;
+	ExecuteTaskData *data;
+
+	conn = tracker_sparql_statement_get_connection (stmt);
+	data = g_task_get_task_data (task);
+	data->handle = handle;
+
+	tracker_bus_connection_perform_query_async (TRACKER_BUS_CONNECTION (conn),
+						    tracker_sparql_statement_get_sparql (stmt),
+						    handle,
+						    data->arguments ? g_variant_ref (data->arguments) : NULL,
+						    g_task_get_cancellable (task),
+						    execute_cb,
+						    task);
+}
+
+static void
+execute_prepared (GTask *task)
+{
+	TrackerBusStatement *bus_stmt = g_task_get_source_object (task);
+
+	send_execute (task, bus_stmt->handle);
+}
+
+static void
+prepare_cb (GObject      *source,
+            GAsyncResult *res,
+            gpointer      user_data)
+{
+	GTask *task = user_data;
+	GError *error = NULL;
+	guint32 handle;
+
+	handle = tracker_bus_connection_perform_prepare_finish (TRACKER_BUS_CONNECTION (source),
+	                                                        res, &error);
+	set_handle (g_task_get_source_object (task), handle, error);
+	g_clear_error (&error);
+
+	execute_prepared (task);
+}
+
 static void
 tracker_bus_statement_execute_async (TrackerSparqlStatement *stmt,
                                      GCancellable           *cancellable,
@@ -208,16 +376,29 @@ tracker_bus_statement_execute_async (TrackerSparqlStatement *stmt,
 {
 	TrackerBusStatement *bus_stmt = TRACKER_BUS_STATEMENT (stmt);
 	TrackerSparqlConnection *conn;
+	ExecuteTaskData *data;
+	GVariant *arguments;
 	GTask *task;
 
 	task = g_task_new (stmt, cancellable, callback, user_data);
 	conn = tracker_sparql_statement_get_connection (stmt);
-	tracker_bus_connection_perform_query_async (TRACKER_BUS_CONNECTION (conn),
-						    tracker_sparql_statement_get_sparql (stmt),
-						    get_arguments (bus_stmt),
-						    cancellable,
-						    execute_cb,
-						    task);
+
+	/* Bindings may change while the statement is being prepared */
+	data = g_new0 (ExecuteTaskData, 1);
+	arguments = get_arguments (bus_stmt);
+	if (arguments)
+		data->arguments = g_variant_ref_sink (arguments);
+	g_task_set_task_data (task, data, execute_task_data_free);
+
+	if (needs_prepare (bus_stmt)) {
+		tracker_bus_connection_perform_prepare_async (TRACKER_BUS_CONNECTION (conn),
+		                                              tracker_sparql_statement_get_sparql (stmt),
+		                                              cancellable,
+		                                              prepare_cb,
+		                                              task);
+	} else {
+		execute_prepared (task);
+	}
 }
 
 static TrackerSparqlCursor *
@@ -444,6 +625,18 @@ tracker_bus_statement_new (TrackerBusConnection *conn,
 	                     NULL);
 }
 
+GVariant *
+tracker_bus_statement_get_arguments (TrackerBusStatement *bus_stmt)
+{
+	return get_arguments (bus_stmt);
+}
+
+guint32
+tracker_bus_statement_get_handle (TrackerBusStatement *bus_stmt)
+{
+	return bus_stmt->handle;
+}
+
 TrackerSparqlStatement *
 tracker_bus_statement_new_update (TrackerBusConnection *conn,
                                   const gchar          *query)
@@ -36,3 +36,7 @@ TrackerSparqlStatement * tracker_bus_statement_new (TrackerBusConnection *conn,
 
 TrackerSparqlStatement * tracker_bus_statement_new_update (TrackerBusConnection *conn,
                                                            const gchar          *query);
+
+GVariant * tracker_bus_statement_get_arguments (TrackerBusStatement *bus_stmt);
+
+guint32 tracker_bus_statement_get_handle (TrackerBusStatement *bus_stmt);
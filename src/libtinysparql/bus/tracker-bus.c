@@ -22,6 +22,7 @@
 #include "tracker-bus.h"
 
 #include <errno.h>
+#include <sys/socket.h>
 
 #include <gio/gunixfdlist.h>
 #include <gio/gunixinputstream.h>
@@ -47,11 +48,18 @@ struct _TrackerBusConnection {
 	TrackerSparqlConnection parent_instance;
 
 	GDBusConnection *dbus_conn;
+	/* Private connection to the endpoint, if it offers one */
+	GDBusConnection *peer_conn;
+	/* Peer connections that were closed, other threads may still use these */
+	GList *closed_peer_conns;
+	GMutex peer_mutex;
 	TrackerNamespaceManager *namespaces;
 	GList *notifiers;
 	gchar *dbus_name;
 	gchar *object_path;
 	gboolean sandboxed;
+	/* Set if the endpoint lacks the QueryCursor method */
+	gint legacy_query;
 };
 
 enum {
@@ -85,6 +93,19 @@ typedef struct {
 	GVariant *retval;
 } UpdateTaskData;
 
+typedef struct {
+	GPtrArray *statements;
+	GPtrArray *istreams;
+} QueryBatchTaskData;
+
+typedef struct {
+	GInputStream *istream;
+	gchar *sparql;
+	guint32 stmt_handle;
+	GVariant *arguments;
+	gboolean legacy;
+} QueryTaskData;
+
 static void tracker_bus_connection_async_initable_iface_init (GAsyncInitableIface *iface);
 
 G_DEFINE_TYPE_WITH_CODE (TrackerBusConnection, tracker_bus_connection,
@@ -92,6 +113,173 @@ G_DEFINE_TYPE_WITH_CODE (TrackerBusConnection, tracker_bus_connection,
                          G_IMPLEMENT_INTERFACE (G_TYPE_ASYNC_INITABLE,
                                                 tracker_bus_connection_async_initable_iface_init))
 
+static void peer_connection_closed_cb (GDBusConnection *peer_conn,
+                                       gboolean         remote_peer_vanished,
+                                       GError          *error,
+                                       gpointer         user_data);
+
+static void
+drop_peer_connection (TrackerBusConnection *conn,
+                      GDBusConnection      *peer_conn)
+{
+	g_mutex_lock (&conn->peer_mutex);
+
+	if (conn->peer_conn == peer_conn) {
+		g_signal_handlers_disconnect_by_func (peer_conn,
+		                                      peer_connection_closed_cb,
+		                                      conn);
+		conn->closed_peer_conns = g_list_prepend (conn->closed_peer_conns,
+		                                          g_steal_pointer (&conn->peer_conn));
+	}
+
+	g_mutex_unlock (&conn->peer_mutex);
+}
+
+static void
+peer_connection_closed_cb (GDBusConnection *peer_conn,
+                           gboolean         remote_peer_vanished,
+                           GError          *error,
+                           gpointer         user_data)
+{
+	drop_peer_connection (user_data, peer_conn);
+}
+
+static GDBusConnection *
+get_endpoint_connection (TrackerBusConnection *conn)
+{
+	GDBusConnection *peer_conn;
+
+	g_mutex_lock (&conn->peer_mutex);
+	peer_conn = conn->peer_conn;
+	g_mutex_unlock (&conn->peer_mutex);
+
+	/* The "closed" signal is not dispatched if the connection was
+	 * created from a sync call, check here too. The endpoint is
+	 * reached through the message bus from then on.
+	 */
+	if (peer_conn && g_dbus_connection_is_closed (peer_conn)) {
+		drop_peer_connection (conn, peer_conn);
+		peer_conn = NULL;
+	}
+
+	return peer_conn ? peer_conn : conn->dbus_conn;
+}
+
+typedef struct {
+	GDBusMessage *message;
+	gint timeout;
+} SendMessageData;
+
+static void
+send_message_data_free (gpointer data)
+{
+	SendMessageData *send_data = data;
+
+	g_object_unref (send_data->message);
+	g_free (send_data);
+}
+
+static void
+send_endpoint_message_cb (GObject      *source,
+                          GAsyncResult *res,
+                          gpointer      user_data)
+{
+	TrackerBusConnection *bus;
+	GTask *task = user_data;
+	SendMessageData *data;
+	GDBusMessage *reply;
+	GError *error = NULL;
+
+	bus = g_task_get_source_object (task);
+	data = g_task_get_task_data (task);
+	reply = g_dbus_connection_send_message_with_reply_finish (G_DBUS_CONNECTION (source),
+	                                                          res, &error);
+
+	/* The endpoint may close the peer connection before we
+	 * notice, send the message again through the message bus.
+	 */
+	if (!reply &&
+	    G_DBUS_CONNECTION (source) != bus->dbus_conn &&
+	    (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CLOSED) ||
+	     g_error_matches (error, G_IO_ERROR, G_IO_ERROR_BROKEN_PIPE) ||
+	     g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CONNECTION_CLOSED) ||
+	     g_dbus_connection_is_closed (G_DBUS_CONNECTION (source)))) {
+		GDBusMessage *copy;
+
+		drop_peer_connection (bus, G_DBUS_CONNECTION (source));
+		g_clear_error (&error);
+
+		/* Sent messages are locked and have a serial, use a copy */
+		copy = g_dbus_message_copy (data->message, &error);
+
+		if (copy) {
+			g_dbus_connection_send_message_with_reply (bus->dbus_conn,
+			                                           copy,
+			                                           G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+			                                           data->timeout,
+			                                           NULL,
+			                                           g_task_get_cancellable (task),
+			                                           send_endpoint_message_cb,
+			                                           task);
+			g_object_unref (copy);
+			return;
+		}
+	}
+
+	if (reply)
+		g_task_return_pointer (task, reply, g_object_unref);
+	else
+		g_task_return_error (task, error);
+
+	g_object_unref (task);
+}
+
+static void
+send_endpoint_message (TrackerBusConnection *bus,
+                       GDBusMessage         *message,
+                       gint                  timeout,
+                       GCancellable         *cancellable,
+                       GAsyncReadyCallback   callback,
+                       gpointer              user_data)
+{
+	SendMessageData *data;
+	GTask *task;
+
+	task = g_task_new (bus, cancellable, callback, user_data);
+
+	data = g_new0 (SendMessageData, 1);
+	data->message = g_object_ref (message);
+	data->timeout = timeout;
+	g_task_set_task_data (task, data, send_message_data_free);
+
+	g_dbus_connection_send_message_with_reply (get_endpoint_connection (bus),
+	                                           message,
+	                                           G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+	                                           timeout,
+	                                           NULL,
+	                                           cancellable,
+	                                           send_endpoint_message_cb,
+	                                           task);
+}
+
+static GDBusMessage *
+send_endpoint_message_finish (TrackerBusConnection  *bus,
+                              GAsyncResult          *res,
+                              GError               **error)
+{
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+static const gchar *
+get_endpoint_name (TrackerBusConnection *conn)
+{
+	/* The destination is ignored in peer-to-peer connections, it
+	 * is always set so messages may be sent through the message
+	 * bus if the peer connection is closed meanwhile.
+	 */
+	return conn->dbus_name;
+}
+
 static GDBusMessage *
 create_portal_create_session_message (TrackerBusConnection *conn)
 {
@@ -134,7 +322,9 @@ create_portal_close_session_message (TrackerBusConnection *bus)
 static GDBusMessage *
 create_query_message (TrackerBusConnection *conn,
 		      const gchar          *sparql,
+		      guint32               stmt_handle,
 		      GVariant             *arguments,
+		      gboolean              legacy,
 		      GUnixFDList          *fd_list,
 		      int                   fd_idx)
 {
@@ -144,11 +334,28 @@ create_query_message (TrackerBusConnection *conn,
 	if (!arguments)
 		arguments = g_variant_new ("a{sv}", NULL);
 
-	message = g_dbus_message_new_method_call (conn->dbus_name,
+	message = g_dbus_message_new_method_call (get_endpoint_name (conn),
 						  conn->object_path,
 						  ENDPOINT_IFACE,
-						  "Query");
-	body = g_variant_new ("(sh@a{sv})", sparql, fd_idx, arguments);
+						  legacy ? "Query" :
+						  stmt_handle != 0 ? "Execute" :
+						  "QueryCursor");
+
+	if (legacy) {
+		body = g_variant_new ("(sh@a{sv})", sparql, fd_idx, arguments);
+	} else if (stmt_handle != 0) {
+		gchar *checksum;
+
+		checksum = tracker_bus_compute_statement_checksum (sparql);
+		body = g_variant_new ("(ush@a{sv}u)", stmt_handle, checksum,
+		                      fd_idx, arguments,
+		                      TRACKER_BUS_CURSOR_FORMAT_LATEST);
+		g_free (checksum);
+	} else {
+		body = g_variant_new ("(sh@a{sv}u)", sparql, fd_idx, arguments,
+		                      TRACKER_BUS_CURSOR_FORMAT_LATEST);
+	}
+
 	g_dbus_message_set_body (message, body);
 	g_dbus_message_set_unix_fd_list (message, fd_list);
 
@@ -170,7 +377,7 @@ create_serialize_message (TrackerBusConnection  *conn,
 	if (!arguments)
 		arguments = g_variant_new ("a{sv}", NULL);
 
-	message = g_dbus_message_new_method_call (conn->dbus_name,
+	message = g_dbus_message_new_method_call (get_endpoint_name (conn),
 						  conn->object_path,
 						  ENDPOINT_IFACE,
 						  "Serialize");
@@ -192,7 +399,7 @@ create_update_message (TrackerBusConnection *conn,
 	GDBusMessage *message;
 	GVariant *body;
 
-	message = g_dbus_message_new_method_call (conn->dbus_name,
+	message = g_dbus_message_new_method_call (get_endpoint_name (conn),
 						  conn->object_path,
 						  ENDPOINT_IFACE,
 						  request);
@@ -214,7 +421,7 @@ create_deserialize_message (TrackerBusConnection    *conn,
 	GDBusMessage *message;
 	GVariant *body;
 
-	message = g_dbus_message_new_method_call (conn->dbus_name,
+	message = g_dbus_message_new_method_call (get_endpoint_name (conn),
 						  conn->object_path,
 						  ENDPOINT_IFACE,
 						  "Deserialize");
@@ -513,6 +720,133 @@ init_namespaces (TrackerBusConnection *conn,
 	                                       task);
 }
 
+static void
+authorize_peer_cb (GObject      *source,
+                   GAsyncResult *res,
+                   gpointer      user_data)
+{
+	GDBusConnection *peer_conn = G_DBUS_CONNECTION (source);
+	TrackerBusConnection *bus;
+	GTask *task = user_data;
+	GDBusMessage *reply;
+
+	bus = g_task_get_source_object (task);
+	reply = g_dbus_connection_send_message_with_reply_finish (peer_conn,
+	                                                          res, NULL);
+
+	/* Not being authorized is not fatal either, the endpoint
+	 * may still allow the calls through the message bus.
+	 */
+	if (reply &&
+	    g_dbus_message_get_message_type (reply) == G_DBUS_MESSAGE_TYPE_METHOD_RETURN) {
+		bus->peer_conn = g_object_ref (peer_conn);
+		g_signal_connect (bus->peer_conn, "closed",
+		                  G_CALLBACK (peer_connection_closed_cb), bus);
+	} else {
+		g_dbus_connection_close (peer_conn, NULL, NULL, NULL);
+	}
+
+	g_clear_object (&reply);
+	g_object_unref (peer_conn);
+	init_namespaces (bus, task);
+}
+
+static void
+new_peer_connection_cb (GObject      *source,
+                        GAsyncResult *res,
+                        gpointer      user_data)
+{
+	TrackerBusConnection *bus;
+	GTask *task = user_data;
+	GDBusConnection *peer_conn;
+	GDBusMessage *message;
+
+	bus = g_task_get_source_object (task);
+
+	/* Failing to connect is not fatal, the message bus
+	 * will be used instead.
+	 */
+	peer_conn = g_dbus_connection_new_for_address_finish (res, NULL);
+
+	if (!peer_conn) {
+		init_namespaces (bus, task);
+		return;
+	}
+
+	/* The endpoint only takes calls from peers that present the
+	 * token handed through the message bus.
+	 */
+	message = g_dbus_message_new_method_call (NULL,
+	                                          bus->object_path,
+	                                          ENDPOINT_IFACE,
+	                                          "AuthorizePeer");
+	g_dbus_message_set_body (message,
+	                         g_variant_new ("(s)", g_task_get_task_data (task)));
+	g_dbus_connection_send_message_with_reply (peer_conn,
+	                                           message,
+	                                           G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+	                                           DBUS_TIMEOUT,
+	                                           NULL,
+	                                           g_task_get_cancellable (task),
+	                                           authorize_peer_cb,
+	                                           task);
+	g_object_unref (message);
+}
+
+static void
+get_peer_address_cb (GObject      *source,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+	GTask *task = user_data;
+	GDBusMessage *reply;
+	const gchar *address = NULL, *token = NULL;
+
+	reply = g_dbus_connection_send_message_with_reply_finish (G_DBUS_CONNECTION (source),
+	                                                          res, NULL);
+
+	/* Older endpoints do not implement this method */
+	if (reply &&
+	    g_dbus_message_get_message_type (reply) == G_DBUS_MESSAGE_TYPE_METHOD_RETURN &&
+	    g_variant_is_of_type (g_dbus_message_get_body (reply), G_VARIANT_TYPE ("(ss)")))
+		g_variant_get (g_dbus_message_get_body (reply), "(&s&s)", &address, &token);
+
+	if (address && *address) {
+		g_task_set_task_data (task, g_strdup (token), g_free);
+		g_dbus_connection_new_for_address (address,
+		                                   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+		                                   NULL,
+		                                   g_task_get_cancellable (task),
+		                                   new_peer_connection_cb,
+		                                   task);
+	} else {
+		init_namespaces (g_task_get_source_object (task), task);
+	}
+
+	g_clear_object (&reply);
+}
+
+static void
+init_peer_connection (TrackerBusConnection *conn,
+                      GTask                *task)
+{
+	GDBusMessage *message;
+
+	message = g_dbus_message_new_method_call (conn->dbus_name,
+	                                          conn->object_path,
+	                                          ENDPOINT_IFACE,
+	                                          "GetPeerAddress");
+	g_dbus_connection_send_message_with_reply (conn->dbus_conn,
+	                                           message,
+	                                           G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+	                                           DBUS_TIMEOUT,
+	                                           NULL,
+	                                           g_task_get_cancellable (task),
+	                                           get_peer_address_cb,
+	                                           task);
+	g_object_unref (message);
+}
+
 static void
 create_portal_session_cb (GObject      *source,
                           GAsyncResult *res,
@@ -594,7 +928,7 @@ ping_peer_cb (GObject      *source,
 			g_object_unref (task);
 		}
 	} else {
-		init_namespaces (bus, task);
+		init_peer_connection (bus, task);
 	}
 
 	g_clear_object (&reply);
@@ -711,6 +1045,17 @@ tracker_bus_connection_finalize (GObject *object)
 
 	clear_notifiers (bus);
 
+	if (bus->peer_conn) {
+		g_signal_handlers_disconnect_by_func (bus->peer_conn,
+		                                      peer_connection_closed_cb,
+		                                      bus);
+		g_dbus_connection_close (bus->peer_conn, NULL, NULL, NULL);
+		g_clear_object (&bus->peer_conn);
+	}
+
+	g_list_free_full (bus->closed_peer_conns, g_object_unref);
+	g_mutex_clear (&bus->peer_mutex);
+
 	g_clear_object (&bus->dbus_conn);
 	g_clear_pointer (&bus->dbus_name, g_free);
 	g_clear_pointer (&bus->object_path, g_free);
@@ -787,6 +1132,43 @@ create_pipe (int     *input,
 	return TRUE;
 }
 
+/* If *fd_list is set, the socket is appended to it */
+static gboolean
+create_socket_for_read (GInputStream **istream,
+                        GUnixFDList   **fd_list,
+                        int            *fd_idx,
+                        GError        **error)
+{
+	int fds[2], idx;
+	GUnixFDList *list;
+
+	/* Sockets allow the endpoint to pass memfds along */
+	if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+		g_set_error (error,
+		             G_IO_ERROR,
+		             g_io_error_from_errno (errno),
+		             "Socket creation failed: %m");
+		return FALSE;
+	}
+
+	list = *fd_list ? g_object_ref (*fd_list) : g_unix_fd_list_new ();
+	idx = g_unix_fd_list_append (list, fds[1], error);
+	close (fds[1]);
+
+	if (idx < 0) {
+		g_object_unref (list);
+		close (fds[0]);
+		return FALSE;
+	}
+
+	g_clear_object (fd_list);
+	*fd_list = list;
+	*fd_idx = idx;
+	*istream = g_unix_input_stream_new (fds[0], TRUE);
+
+	return TRUE;
+}
+
 static gboolean
 create_pipe_for_write (GOutputStream **ostream,
 		       GUnixFDList   **fd_list,
@@ -852,7 +1234,7 @@ tracker_bus_connection_query (TrackerSparqlConnection  *self,
                               GError                  **error)
 {
 	return tracker_bus_connection_perform_query (TRACKER_BUS_CONNECTION (self),
-						     sparql, NULL,
+						     sparql, 0, NULL,
 						     cancellable, error);
 }
 
@@ -888,6 +1270,7 @@ tracker_bus_connection_query_async (TrackerSparqlConnection *self,
 	task = g_task_new (self, cancellable, callback, user_data);
 	tracker_bus_connection_perform_query_async (TRACKER_BUS_CONNECTION (self),
 						    sparql,
+						    0,
 						    NULL,
 						    cancellable,
 						    query_async_cb,
@@ -929,8 +1312,8 @@ update_dbus_call_cb (GObject      *source,
 	GDBusMessage *reply;
 	GError *error = NULL;
 
-	reply = g_dbus_connection_send_message_with_reply_finish (G_DBUS_CONNECTION (source),
-	                                                          res, &error);
+	reply = send_endpoint_message_finish (TRACKER_BUS_CONNECTION (source),
+	                                      res, &error);
 	if (reply && !g_dbus_message_to_gerror (reply, &error)) {
 		GVariant *body;
 
@@ -961,14 +1344,10 @@ perform_update_async (TrackerBusConnection *bus,
 
 	task = g_task_new (bus, cancellable, callback, user_data);
 	message = create_update_message (bus, request, fd_list, fd_idx);
-	g_dbus_connection_send_message_with_reply (bus->dbus_conn,
-	                                           message,
-	                                           G_DBUS_SEND_MESSAGE_FLAGS_NONE,
-						   G_MAXINT,
-	                                           NULL,
-	                                           cancellable,
-	                                           update_dbus_call_cb,
-	                                           task);
+	send_endpoint_message (bus, message, G_MAXINT,
+	                       cancellable,
+	                       update_dbus_call_cb,
+	                       task);
 	g_object_unref (message);
 }
 
@@ -1302,6 +1681,7 @@ tracker_bus_connection_create_notifier (TrackerSparqlConnection *self)
 	                         "connection", self,
 	                         NULL);
 
+	/* Signals are always received through the message bus */
 	tracker_notifier_signal_subscribe (notifier,
 	                                   bus->dbus_conn,
 	                                   bus->dbus_name,
@@ -1529,8 +1909,8 @@ deserialize_cb (GObject      *source,
 
 	data = g_task_get_task_data (task);
 
-	reply = g_dbus_connection_send_message_with_reply_finish (G_DBUS_CONNECTION (source),
-	                                                          res, &error);
+	reply = send_endpoint_message_finish (TRACKER_BUS_CONNECTION (source),
+	                                      res, &error);
 	if (!reply || g_dbus_message_to_gerror (reply, &error))
 		data->dbus.error = error;
 
@@ -1602,14 +1982,10 @@ tracker_bus_connection_deserialize_async (TrackerSparqlConnection *self,
 					      default_graph,
 					      fd_list, fd_idx);
 
-	g_dbus_connection_send_message_with_reply (bus->dbus_conn,
-	                                           message,
-	                                           G_DBUS_SEND_MESSAGE_FLAGS_NONE,
-						   G_MAXINT,
-	                                           NULL,
-	                                           cancellable,
-	                                           deserialize_cb,
-	                                           task);
+	send_endpoint_message (bus, message, G_MAXINT,
+	                       cancellable,
+	                       deserialize_cb,
+	                       task);
 	g_output_stream_splice_async (ostream, istream,
 				      G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE |
 				      G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
@@ -1631,6 +2007,189 @@ tracker_bus_connection_deserialize_finish (TrackerSparqlConnection  *connection,
 	return g_task_propagate_boolean (G_TASK (res), error);
 }
 
+static void
+query_batch_task_data_free (gpointer data)
+{
+	QueryBatchTaskData *task_data = data;
+
+	g_ptr_array_unref (task_data->statements);
+	g_ptr_array_unref (task_data->istreams);
+	g_free (task_data);
+}
+
+static void
+query_batch_fallback_cb (GObject      *source,
+                         GAsyncResult *res,
+                         gpointer      user_data)
+{
+	GTask *task = user_data;
+	GPtrArray *cursors;
+	GError *error = NULL;
+
+	cursors = TRACKER_SPARQL_CONNECTION_CLASS (tracker_bus_connection_parent_class)->query_batch_finish (TRACKER_SPARQL_CONNECTION (source),
+	                                                                                                     res, &error);
+	if (cursors)
+		g_task_return_pointer (task, cursors, (GDestroyNotify) g_ptr_array_unref);
+	else
+		g_task_return_error (task, error);
+
+	g_object_unref (task);
+}
+
+static void
+query_batch_dbus_call_cb (GObject      *source,
+                          GAsyncResult *res,
+                          gpointer      user_data)
+{
+	GTask *task = user_data;
+	QueryBatchTaskData *data;
+	GDBusMessage *reply;
+	GError *error = NULL;
+
+	data = g_task_get_task_data (task);
+	reply = send_endpoint_message_finish (TRACKER_BUS_CONNECTION (source),
+	                                      res, &error);
+	if (reply && !g_dbus_message_to_gerror (reply, &error)) {
+		GVariant *results;
+
+		results = g_variant_get_child_value (g_dbus_message_get_body (reply), 0);
+
+		if (g_variant_n_children (results) != data->istreams->len) {
+			g_task_return_new_error (task,
+			                         G_IO_ERROR,
+			                         G_IO_ERROR_INVALID_DATA,
+			                         "Unexpected number of results");
+		} else {
+			GPtrArray *cursors;
+			guint i;
+
+			cursors = g_ptr_array_new_with_free_func (g_object_unref);
+
+			for (i = 0; i < data->istreams->len; i++) {
+				GVariant *variables;
+				guint32 format;
+
+				g_variant_get_child (results, i, "(@asu)", &variables, &format);
+				g_ptr_array_add (cursors,
+				                 tracker_bus_cursor_new (g_ptr_array_index (data->istreams, i),
+				                                         variables, format));
+				g_variant_unref (variables);
+			}
+
+			g_task_return_pointer (task, cursors,
+			                       (GDestroyNotify) g_ptr_array_unref);
+		}
+
+		g_variant_unref (results);
+	} else if (g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+		/* Older endpoint, execute the statements separately */
+		g_clear_error (&error);
+		g_clear_object (&reply);
+		TRACKER_SPARQL_CONNECTION_CLASS (tracker_bus_connection_parent_class)->query_batch_async (g_task_get_source_object (task),
+		                                                                                          (TrackerSparqlStatement **) data->statements->pdata,
+		                                                                                          data->statements->len,
+		                                                                                          g_task_get_cancellable (task),
+		                                                                                          query_batch_fallback_cb,
+		                                                                                          task);
+		return;
+	} else {
+		g_dbus_error_strip_remote_error (error);
+		g_task_return_error (task, error);
+	}
+
+	g_object_unref (task);
+	g_clear_object (&reply);
+}
+
+static void
+tracker_bus_connection_query_batch_async (TrackerSparqlConnection  *self,
+                                          TrackerSparqlStatement  **statements,
+                                          guint                     n_statements,
+                                          GCancellable             *cancellable,
+                                          GAsyncReadyCallback       callback,
+                                          gpointer                  user_data)
+{
+	TrackerBusConnection *bus = TRACKER_BUS_CONNECTION (self);
+	QueryBatchTaskData *data;
+	GDBusMessage *message;
+	GVariantBuilder builder;
+	GUnixFDList *fd_list = NULL;
+	GError *error = NULL;
+	GTask *task;
+	guint i;
+
+	if (g_atomic_int_get (&bus->legacy_query) || n_statements == 0) {
+		TRACKER_SPARQL_CONNECTION_CLASS (tracker_bus_connection_parent_class)->query_batch_async (self,
+		                                                                                          statements,
+		                                                                                          n_statements,
+		                                                                                          cancellable,
+		                                                                                          callback,
+		                                                                                          user_data);
+		return;
+	}
+
+	task = g_task_new (self, cancellable, callback, user_data);
+
+	data = g_new0 (QueryBatchTaskData, 1);
+	data->statements = g_ptr_array_new_full (n_statements, g_object_unref);
+	data->istreams = g_ptr_array_new_full (n_statements, g_object_unref);
+	g_task_set_task_data (task, data, query_batch_task_data_free);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sua{sv}h)"));
+
+	for (i = 0; i < n_statements; i++) {
+		TrackerBusStatement *bus_stmt = TRACKER_BUS_STATEMENT (statements[i]);
+		GInputStream *istream;
+		GVariant *arguments;
+		int fd_idx;
+
+		if (!create_socket_for_read (&istream, &fd_list, &fd_idx, &error)) {
+			g_variant_builder_clear (&builder);
+			g_clear_object (&fd_list);
+			g_task_return_error (task, error);
+			g_object_unref (task);
+			return;
+		}
+
+		g_ptr_array_add (data->statements, g_object_ref (statements[i]));
+		g_ptr_array_add (data->istreams, istream);
+
+		arguments = tracker_bus_statement_get_arguments (bus_stmt);
+		if (!arguments)
+			arguments = g_variant_new ("a{sv}", NULL);
+
+		g_variant_builder_add (&builder, "(su@a{sv}h)",
+		                       tracker_sparql_statement_get_sparql (statements[i]),
+		                       tracker_bus_statement_get_handle (bus_stmt),
+		                       arguments,
+		                       fd_idx);
+	}
+
+	message = g_dbus_message_new_method_call (get_endpoint_name (bus),
+	                                          bus->object_path,
+	                                          ENDPOINT_IFACE,
+	                                          "QueryBatch");
+	g_dbus_message_set_body (message,
+	                         g_variant_new ("(a(sua{sv}h)u)", &builder,
+	                                        TRACKER_BUS_CURSOR_FORMAT_LATEST));
+	g_dbus_message_set_unix_fd_list (message, fd_list);
+
+	send_endpoint_message (bus, message, G_MAXINT,
+	                       cancellable,
+	                       query_batch_dbus_call_cb,
+	                       task);
+	g_object_unref (message);
+	g_object_unref (fd_list);
+}
+
+static GPtrArray *
+tracker_bus_connection_query_batch_finish (TrackerSparqlConnection  *self,
+                                           GAsyncResult             *res,
+                                           GError                  **error)
+{
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
 static void
 tracker_bus_connection_class_init (TrackerBusConnectionClass *klass)
 {
@@ -1670,6 +2229,8 @@ tracker_bus_connection_class_init (TrackerBusConnectionClass *klass)
 	sparql_connection_class->serialize_finish = tracker_bus_connection_serialize_finish;
 	sparql_connection_class->deserialize_async = tracker_bus_connection_deserialize_async;
 	sparql_connection_class->deserialize_finish = tracker_bus_connection_deserialize_finish;
+	sparql_connection_class->query_batch_async = tracker_bus_connection_query_batch_async;
+	sparql_connection_class->query_batch_finish = tracker_bus_connection_query_batch_finish;
 
 	props[PROP_BUS_NAME] =
 		g_param_spec_string ("bus-name",
@@ -1702,6 +2263,7 @@ tracker_bus_connection_class_init (TrackerBusConnectionClass *klass)
 static void
 tracker_bus_connection_init (TrackerBusConnection *conn)
 {
+	g_mutex_init (&conn->peer_mutex);
 }
 
 static void
@@ -1782,28 +2344,57 @@ tracker_bus_connection_new_finish (GAsyncResult  *res,
 	                                                               error));
 }
 
+static void
+query_task_data_free (gpointer data)
+{
+	QueryTaskData *task_data = data;
+
+	g_clear_object (&task_data->istream);
+	g_clear_pointer (&task_data->arguments, g_variant_unref);
+	g_free (task_data->sparql);
+	g_free (task_data);
+}
+
+static void send_query_message (GTask *task);
+
 static void
 query_dbus_call_cb (GObject      *source,
                     GAsyncResult *res,
                     gpointer      user_data)
 {
 	GTask *task = user_data;
+	QueryTaskData *data;
 	GDBusMessage *reply;
 	GError *error = NULL;
 
-	reply = g_dbus_connection_send_message_with_reply_finish (G_DBUS_CONNECTION (source),
-	                                                          res, &error);
+	data = g_task_get_task_data (task);
+	reply = send_endpoint_message_finish (TRACKER_BUS_CONNECTION (source),
+	                                      res, &error);
 	if (reply && !g_dbus_message_to_gerror (reply, &error)) {
+		guint32 format = TRACKER_BUS_CURSOR_FORMAT_ROWS;
 		TrackerSparqlCursor *cursor;
 		GVariant *body, *child;
-		GInputStream *istream;
 
 		body = g_dbus_message_get_body (reply);
-		istream = g_task_get_task_data (task);
 		child = g_variant_get_child_value (body, 0);
-		cursor = tracker_bus_cursor_new (istream, child);
+
+		if (!data->legacy)
+			g_variant_get_child (body, 1, "u", &format);
+
+		cursor = tracker_bus_cursor_new (data->istream, child, format);
 		g_task_return_pointer (task, cursor, g_object_unref);
 		g_variant_unref (child);
+	} else if (!data->legacy &&
+	           g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+		TrackerBusConnection *bus = g_task_get_source_object (task);
+
+		/* Older endpoint, fall back to the row based format */
+		g_atomic_int_set (&bus->legacy_query, TRUE);
+		g_clear_error (&error);
+		g_clear_object (&reply);
+		data->legacy = TRUE;
+		send_query_message (task);
+		return;
 	} else {
 		g_dbus_error_strip_remote_error (error);
 		g_task_return_error (task, error);
@@ -1813,45 +2404,62 @@ query_dbus_call_cb (GObject      *source,
 	g_clear_object (&reply);
 }
 
-void
-tracker_bus_connection_perform_query_async (TrackerBusConnection *bus,
-					    const gchar          *sparql,
-					    GVariant             *arguments,
-					    GCancellable         *cancellable,
-					    GAsyncReadyCallback   callback,
-					    gpointer              user_data)
+static void
+send_query_message (GTask *task)
 {
+	TrackerBusConnection *bus = g_task_get_source_object (task);
+	QueryTaskData *data = g_task_get_task_data (task);
 	GDBusMessage *message;
-	GUnixFDList *fd_list;
-	GInputStream *istream;
+	GUnixFDList *fd_list = NULL;
 	GError *error = NULL;
-	GTask *task;
 	int fd_idx;
 
-	task = g_task_new (bus, cancellable, callback, user_data);
+	g_clear_object (&data->istream);
 
-	if (!create_pipe_for_read (&istream, &fd_list, &fd_idx, &error)) {
+	if (data->legacy ?
+	    !create_pipe_for_read (&data->istream, &fd_list, &fd_idx, &error) :
+	    !create_socket_for_read (&data->istream, &fd_list, &fd_idx, &error)) {
 		g_task_return_error (task, error);
 		g_object_unref (task);
 		return;
 	}
 
-	g_task_set_task_data (task, istream, g_object_unref);
-
-	message = create_query_message (bus, sparql, arguments,
-					fd_list, fd_idx);
-	g_dbus_connection_send_message_with_reply (bus->dbus_conn,
-	                                           message,
-	                                           G_DBUS_SEND_MESSAGE_FLAGS_NONE,
-						   G_MAXINT,
-	                                           NULL,
-	                                           cancellable,
-	                                           query_dbus_call_cb,
-	                                           task);
+	message = create_query_message (bus, data->sparql, data->stmt_handle,
+	                                data->arguments, data->legacy,
+	                                fd_list, fd_idx);
+	send_endpoint_message (bus, message, G_MAXINT,
+	                       g_task_get_cancellable (task),
+	                       query_dbus_call_cb,
+	                       task);
 	g_object_unref (message);
 	g_object_unref (fd_list);
 }
 
+void
+tracker_bus_connection_perform_query_async (TrackerBusConnection *bus,
+					    const gchar          *sparql,
+					    guint32               stmt_handle,
+					    GVariant             *arguments,
+					    GCancellable         *cancellable,
+					    GAsyncReadyCallback   callback,
+					    gpointer              user_data)
+{
+	QueryTaskData *data;
+	GTask *task;
+
+	task = g_task_new (bus, cancellable, callback, user_data);
+
+	data = g_new0 (QueryTaskData, 1);
+	data->sparql = g_strdup (sparql);
+	data->arguments = arguments ? g_variant_ref_sink (arguments) : NULL;
+	data->legacy = g_atomic_int_get (&bus->legacy_query);
+	/* Statements can only be prepared on endpoints with QueryCursor */
+	data->stmt_handle = data->legacy ? 0 : stmt_handle;
+	g_task_set_task_data (task, data, query_task_data_free);
+
+	send_query_message (task);
+}
+
 TrackerSparqlCursor *
 tracker_bus_connection_perform_query_finish (TrackerBusConnection  *conn,
 					     GAsyncResult          *res,
@@ -1875,6 +2483,7 @@ perform_query_call_cb (GObject      *source,
 TrackerSparqlCursor *
 tracker_bus_connection_perform_query (TrackerBusConnection  *conn,
 				      const gchar           *sparql,
+				      guint32                stmt_handle,
 				      GVariant              *arguments,
 				      GCancellable          *cancellable,
 				      GError               **error)
@@ -1888,6 +2497,7 @@ tracker_bus_connection_perform_query (TrackerBusConnection  *conn,
 
 	tracker_bus_connection_perform_query_async (conn,
 						    sparql,
+						    stmt_handle,
 						    arguments,
 						    cancellable,
 						    perform_query_call_cb,
@@ -1907,6 +2517,157 @@ tracker_bus_connection_perform_query (TrackerBusConnection  *conn,
 	return TRACKER_SPARQL_CURSOR (data.retval);
 }
 
+static void
+prepare_call_cb (GObject      *source,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+	GTask *task = user_data;
+	GDBusMessage *reply;
+	GError *error = NULL;
+
+	reply = send_endpoint_message_finish (TRACKER_BUS_CONNECTION (source),
+	                                      res, &error);
+	if (reply && !g_dbus_message_to_gerror (reply, &error)) {
+		guint32 stmt_handle;
+
+		g_variant_get_child (g_dbus_message_get_body (reply), 0, "u", &stmt_handle);
+		g_task_return_int (task, stmt_handle);
+	} else {
+		g_dbus_error_strip_remote_error (error);
+		g_task_return_error (task, error);
+	}
+
+	g_object_unref (task);
+	g_clear_object (&reply);
+}
+
+void
+tracker_bus_connection_perform_prepare_async (TrackerBusConnection *bus,
+                                              const gchar          *sparql,
+                                              GCancellable         *cancellable,
+                                              GAsyncReadyCallback   callback,
+                                              gpointer              user_data)
+{
+	GDBusMessage *message;
+	GTask *task;
+
+	task = g_task_new (bus, cancellable, callback, user_data);
+
+	if (g_atomic_int_get (&bus->legacy_query)) {
+		g_task_return_new_error (task,
+		                         G_IO_ERROR,
+		                         G_IO_ERROR_NOT_SUPPORTED,
+		                         "Endpoint does not support prepared statements");
+		g_object_unref (task);
+		return;
+	}
+
+	message = g_dbus_message_new_method_call (get_endpoint_name (bus),
+	                                          bus->object_path,
+	                                          ENDPOINT_IFACE,
+	                                          "Prepare");
+	g_dbus_message_set_body (message, g_variant_new ("(s)", sparql));
+	send_endpoint_message (bus, message, DBUS_TIMEOUT,
+	                       cancellable,
+	                       prepare_call_cb,
+	                       task);
+	g_object_unref (message);
+}
+
+guint32
+tracker_bus_connection_perform_prepare_finish (TrackerBusConnection  *conn,
+                                               GAsyncResult          *res,
+                                               GError               **error)
+{
+	gssize stmt_handle;
+
+	stmt_handle = g_task_propagate_int (G_TASK (res), error);
+
+	return stmt_handle < 0 ? 0 : (guint32) stmt_handle;
+}
+
+static void
+perform_prepare_call_cb (GObject      *source,
+                         GAsyncResult *res,
+                         gpointer      user_data)
+{
+	AsyncData *data = user_data;
+	guint32 stmt_handle;
+
+	stmt_handle = tracker_bus_connection_perform_prepare_finish (TRACKER_BUS_CONNECTION (source),
+	                                                             res, &data->error);
+	data->retval = GUINT_TO_POINTER (stmt_handle);
+	g_main_loop_quit (data->loop);
+}
+
+guint32
+tracker_bus_connection_perform_prepare (TrackerBusConnection  *conn,
+                                        const gchar           *sparql,
+                                        GCancellable          *cancellable,
+                                        GError               **error)
+{
+	GMainContext *context;
+	AsyncData data = { 0, };
+
+	context = g_main_context_new ();
+	data.loop = g_main_loop_new (context, FALSE);
+	g_main_context_push_thread_default (context);
+
+	tracker_bus_connection_perform_prepare_async (conn,
+	                                              sparql,
+	                                              cancellable,
+	                                              perform_prepare_call_cb,
+	                                              &data);
+	g_main_loop_run (data.loop);
+
+	g_main_context_pop_thread_default (context);
+
+	g_main_loop_unref (data.loop);
+	g_main_context_unref (context);
+
+	if (data.error) {
+		g_propagate_error (error, data.error);
+		return 0;
+	}
+
+	return GPOINTER_TO_UINT (data.retval);
+}
+
+void
+tracker_bus_connection_release_statement (TrackerBusConnection *bus,
+                                          const gchar          *sparql,
+                                          guint32               stmt_handle)
+{
+	GDBusMessage *message;
+	gchar *checksum;
+
+	checksum = tracker_bus_compute_statement_checksum (sparql);
+	message = g_dbus_message_new_method_call (get_endpoint_name (bus),
+	                                          bus->object_path,
+	                                          ENDPOINT_IFACE,
+	                                          "Release");
+	g_dbus_message_set_body (message, g_variant_new ("(us)", stmt_handle, checksum));
+	g_free (checksum);
+	g_dbus_message_set_flags (message, G_DBUS_MESSAGE_FLAGS_NO_REPLY_EXPECTED);
+	g_dbus_connection_send_message (get_endpoint_connection (bus),
+	                                message,
+	                                G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+	                                NULL, NULL);
+	g_object_unref (message);
+}
+
+/* Handles are only unique within an endpoint instance, the
+ * checksum of the query text is sent along, so handles from
+ * a previous instance of the endpoint are not mistaken for
+ * other statements.
+ */
+gchar *
+tracker_bus_compute_statement_checksum (const gchar *sparql)
+{
+	return g_compute_checksum_for_string (G_CHECKSUM_SHA256, sparql, -1);
+}
+
 static void
 serialize_call_cb (GObject      *source,
 		   GAsyncResult *res,
@@ -1916,8 +2677,8 @@ serialize_call_cb (GObject      *source,
 	GDBusMessage *reply;
 	GError *error = NULL;
 
-	reply = g_dbus_connection_send_message_with_reply_finish (G_DBUS_CONNECTION (source),
-	                                                          res, &error);
+	reply = send_endpoint_message_finish (TRACKER_BUS_CONNECTION (source),
+	                                      res, &error);
 	if (reply && !g_dbus_message_to_gerror (reply, &error)) {
 		GInputStream *istream;
 
@@ -1961,14 +2722,10 @@ tracker_bus_connection_perform_serialize_async (TrackerBusConnection  *bus,
 	g_task_set_task_data (task, istream, g_object_unref);
 	message = create_serialize_message (bus, query, flags, format,
 					    arguments, fd_list, fd_idx);
-	g_dbus_connection_send_message_with_reply (bus->dbus_conn,
-	                                           message,
-	                                           G_DBUS_SEND_MESSAGE_FLAGS_NONE,
-						   G_MAXINT,
-	                                           NULL,
-	                                           cancellable,
-	                                           serialize_call_cb,
-	                                           task);
+	send_endpoint_message (bus, message, G_MAXINT,
+	                       cancellable,
+	                       serialize_call_cb,
+	                       task);
 	g_object_unref (message);
 	g_object_unref (fd_list);
 }
@@ -32,6 +32,47 @@ typedef enum
 
 typedef struct _TrackerBusOp TrackerBusOp;
 
+/* Formats to transfer cursor contents, as negotiated by the
+ * QueryCursor D-Bus method.
+ */
+typedef enum
+{
+	/* Per row, int32 column count, int32 types and offsets for
+	 * each column, and the row strings. Used by the Query method.
+	 */
+	TRACKER_BUS_CURSOR_FORMAT_ROWS,
+	/* Frames holding a number of rows each. A frame has a
+	 * TrackerBusFrameHeader, followed by:
+	 * - An uint32 offset per cell, pointing to the end of the cell
+	 *   in the string data. Cells are stored row after row.
+	 * - An uint8 type per cell. Types are stored column after column.
+	 * - The string data. Each cell is a nul-terminated string,
+	 *   optionally followed by a nul-terminated language tag.
+	 * The results end with a frame with no rows.
+	 */
+	TRACKER_BUS_CURSOR_FORMAT_FRAMES,
+	/* The same frames, written to sealed memfds. These are passed
+	 * one at a time through the output stream, which must be an
+	 * unix socket. Each memfd holds a whole number of frames, every
+	 * frame starts at an offset aligned to TRACKER_BUS_FRAME_ALIGNMENT.
+	 */
+	TRACKER_BUS_CURSOR_FORMAT_MEMFD_FRAMES,
+} TrackerBusCursorFormat;
+
+#ifdef HAVE_MEMFD_CREATE
+#define TRACKER_BUS_CURSOR_FORMAT_LATEST TRACKER_BUS_CURSOR_FORMAT_MEMFD_FRAMES
+#else
+#define TRACKER_BUS_CURSOR_FORMAT_LATEST TRACKER_BUS_CURSOR_FORMAT_FRAMES
+#endif
+
+#define TRACKER_BUS_FRAME_ALIGNMENT 8
+
+typedef struct
+{
+	guint32 n_rows;
+	guint32 data_size;
+} TrackerBusFrameHeader;
+
 struct _TrackerBusOp
 {
 	TrackerBusOpType type;
@@ -79,6 +120,7 @@ TrackerSparqlConnection * tracker_bus_connection_new_finish (GAsyncResult  *res,
 
 void tracker_bus_connection_perform_query_async (TrackerBusConnection *conn,
 						 const gchar          *sparql,
+						 guint32               stmt_handle,
 						 GVariant             *arguments,
 						 GCancellable         *cancellable,
 						 GAsyncReadyCallback   callback,
@@ -90,10 +132,32 @@ TrackerSparqlCursor * tracker_bus_connection_perform_query_finish (TrackerBusCon
 
 TrackerSparqlCursor * tracker_bus_connection_perform_query (TrackerBusConnection  *conn,
 							    const gchar           *sparql,
+							    guint32                stmt_handle,
 							    GVariant              *arguments,
 							    GCancellable          *cancellable,
 							    GError               **error);
 
+void tracker_bus_connection_perform_prepare_async (TrackerBusConnection *conn,
+                                                   const gchar          *sparql,
+                                                   GCancellable         *cancellable,
+                                                   GAsyncReadyCallback   callback,
+                                                   gpointer              user_data);
+
+guint32 tracker_bus_connection_perform_prepare_finish (TrackerBusConnection  *conn,
+                                                       GAsyncResult          *res,
+                                                       GError               **error);
+
+guint32 tracker_bus_connection_perform_prepare (TrackerBusConnection  *conn,
+                                                const gchar           *sparql,
+                                                GCancellable          *cancellable,
+                                                GError               **error);
+
+void tracker_bus_connection_release_statement (TrackerBusConnection *conn,
+                                               const gchar          *sparql,
+                                               guint32               stmt_handle);
+
+gchar * tracker_bus_compute_statement_checksum (const gchar *sparql);
+
 void tracker_bus_connection_perform_serialize_async (TrackerBusConnection  *conn,
 						     TrackerSerializeFlags  flags,
 						     TrackerRdfFormat       format,
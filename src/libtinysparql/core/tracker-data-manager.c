@@ -43,9 +43,14 @@
 #include "core/tracker-property.h"
 #include "core/tracker-data-query.h"
 #include "core/tracker-sparql-parser.h"
+#include "core/tracker-service-cache.h"
 
 #define MAX_HTTP_URI_LEN 16000 /* De-facto limit in browsers is 8KB, double that for good measure */
 
+/* Defaults, see tracker_sparql_connection_set_service_cache_limits() */
+#define SERVICE_CACHE_TTL (60 * G_USEC_PER_SEC)
+#define SERVICE_CACHE_MAX_SIZE (16 * 1024 * 1024)
+
 struct _TrackerDataManager {
 	GObject parent_instance;
 
@@ -57,6 +62,8 @@ struct _TrackerDataManager {
 	gint select_cache_size;
 	guint transaction_generation;
 	guint generation;
+	gint modification_count;
+	guint32 instance_id;
 
 	TrackerDBManager *db_manager;
 	TrackerOntologies *ontologies;
@@ -70,6 +77,7 @@ struct _TrackerDataManager {
 	/* Cached remote connections */
 	GMutex connections_lock;
 	GHashTable *cached_connections;
+	TrackerServiceCache *service_cache;
 };
 
 struct _TrackerDataManagerClass {
@@ -115,6 +123,7 @@ static void
 tracker_data_manager_init (TrackerDataManager *manager)
 {
 	manager->generation = 1;
+	manager->instance_id = g_random_int ();
 	manager->cached_connections =
 		g_hash_table_new_full (g_str_hash, g_str_equal,
 		                       g_free, g_object_unref);
@@ -1144,12 +1153,24 @@ tracker_data_manager_fts_rebuild (TrackerDataManager  *data_manager,
                                   const gchar         *graph,
                                   GError             **error)
 {
-	return tracker_db_interface_execute_query (iface, error,
-	                                           "INSERT INTO \"%s%sfts5\" (\"%s%sfts5\") VALUES('rebuild')",
-	                                           graph ? graph : "",
-	                                           graph ? "_" : "",
-	                                           graph ? graph : "",
-	                                           graph ? "_" : "");
+	gchar *fts_table, *content_table;
+	gboolean retval;
+
+	fts_table = g_strdup_printf ("%s%sfts5",
+	                             graph ? graph : "",
+	                             graph ? "_" : "");
+	content_table = g_strdup_printf ("%s%sfts_view",
+	                                 graph ? graph : "",
+	                                 graph ? "_" : "");
+
+	retval = tracker_db_interface_sqlite_fts_rebuild (iface,
+	                                                  fts_table,
+	                                                  content_table,
+	                                                  error);
+	g_free (fts_table);
+	g_free (content_table);
+
+	return retval;
 }
 
 gboolean
@@ -1165,34 +1186,6 @@ tracker_data_manager_fts_integrity_check (TrackerDataManager  *data_manager,
 	                                           graph ? "_" : "");
 }
 
-static gboolean
-rebuild_fts_tokens (TrackerDataManager  *manager,
-                    TrackerDBInterface  *iface,
-                    GError             **error)
-{
-	GHashTableIter iter;
-	gchar *graph;
-
-	if (has_fts_properties (manager->ontologies)) {
-		g_debug ("Rebuilding FTS tokens, this may take a moment...");
-		g_hash_table_iter_init (&iter, manager->graphs);
-		while (g_hash_table_iter_next (&iter, (gpointer*) &graph, NULL)) {
-			if (g_strcmp0 (graph, TRACKER_DEFAULT_GRAPH) == 0)
-				graph = NULL;
-
-			if (!tracker_data_manager_fts_rebuild (manager, iface, graph, error))
-				return FALSE;
-		}
-
-		g_debug ("FTS tokens rebuilt");
-	}
-
-	/* Update the stamp file */
-	tracker_db_manager_tokenizer_update (manager->db_manager);
-
-	return TRUE;
-}
-
 static gboolean
 tracker_data_manager_init_fts (TrackerDataManager  *manager,
                                TrackerDBInterface  *iface,
@@ -1289,6 +1282,10 @@ tracker_data_manager_init_fts (TrackerDataManager  *manager,
 	g_string_free (from, TRUE);
 
 	g_string_append (fts, column_names->str);
+
+	if ((manager->flags & TRACKER_DB_MANAGER_FTS_ENABLE_PREFIX_INDEX) != 0)
+		g_string_append (fts, "prefix='2 3 4', ");
+
 	g_string_append (fts, "tokenize=TrackerTokenizer)");
 	g_string_free (column_names, TRUE);
 
@@ -1372,6 +1369,38 @@ tracker_data_manager_delete_fts (TrackerDataManager  *manager,
 	return TRUE;
 }
 
+static gboolean
+rebuild_fts_tokens (TrackerDataManager  *manager,
+                    TrackerDBInterface  *iface,
+                    GError             **error)
+{
+	GHashTableIter iter;
+	gchar *graph;
+
+	if (has_fts_properties (manager->ontologies)) {
+		g_debug ("Rebuilding FTS tokens, this may take a moment...");
+		g_hash_table_iter_init (&iter, manager->graphs);
+		while (g_hash_table_iter_next (&iter, (gpointer*) &graph, NULL)) {
+			if (g_strcmp0 (graph, TRACKER_DEFAULT_GRAPH) == 0)
+				graph = NULL;
+
+			/* Recreate the table, as FTS5 options might have changed */
+			if (!tracker_data_manager_delete_fts (manager, iface, graph, error) ||
+			    !tracker_data_manager_init_fts (manager, iface, graph,
+			                                    manager->ontologies, error) ||
+			    !tracker_data_manager_fts_rebuild (manager, iface, graph, error))
+				return FALSE;
+		}
+
+		g_debug ("FTS tokens rebuilt");
+	}
+
+	/* Update the stamp file */
+	tracker_db_manager_tokenizer_update (manager->db_manager);
+
+	return TRUE;
+}
+
 TrackerDataManager *
 tracker_data_manager_new (TrackerDBManagerFlags  flags,
                           GFile                 *cache_location,
@@ -1393,6 +1422,12 @@ tracker_data_manager_new (TrackerDBManagerFlags  flags,
 	manager->flags = flags;
 	manager->select_cache_size = select_cache_size;
 
+	if ((flags & TRACKER_DB_MANAGER_CACHE_SERVICE_RESULTS) != 0) {
+		manager->service_cache =
+			tracker_service_cache_new (SERVICE_CACHE_TTL,
+			                           SERVICE_CACHE_MAX_SIZE);
+	}
+
 	return manager;
 }
 
@@ -2552,6 +2587,7 @@ tracker_data_manager_dispose (GObject *object)
 	}
 
 	g_clear_pointer (&manager->cached_connections, g_hash_table_unref);
+	g_clear_pointer (&manager->service_cache, tracker_service_cache_free);
 
 	G_OBJECT_CLASS (tracker_data_manager_parent_class)->dispose (object);
 }
@@ -3010,6 +3046,26 @@ tracker_data_manager_get_generation (TrackerDataManager *manager,
 	return manager->generation;
 }
 
+void
+tracker_data_manager_increment_modification_count (TrackerDataManager *manager)
+{
+	g_atomic_int_inc (&manager->modification_count);
+}
+
+/* Returns a value that changes whenever data is committed to this
+ * data manager, and is unique across data manager instances. This
+ * may be read from any thread.
+ */
+guint64
+tracker_data_manager_get_modification_count (TrackerDataManager *manager)
+{
+	guint count;
+
+	count = (guint) g_atomic_int_get (&manager->modification_count);
+
+	return ((guint64) manager->instance_id << 32) | count;
+}
+
 void
 tracker_data_manager_commit_graphs (TrackerDataManager *manager)
 {
@@ -3191,6 +3247,12 @@ fail:
 	return connection;
 }
 
+TrackerServiceCache *
+tracker_data_manager_get_service_cache (TrackerDataManager *data_manager)
+{
+	return data_manager->service_cache;
+}
+
 void
 tracker_data_manager_map_connection (TrackerDataManager      *data_manager,
                                      const gchar             *handle_name,
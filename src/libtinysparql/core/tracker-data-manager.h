@@ -35,6 +35,7 @@ typedef struct _TrackerDataManagerClass TrackerDataManagerClass;
 #include "core/tracker-data-update.h"
 #include "core/tracker-db-interface.h"
 #include "core/tracker-db-manager.h"
+#include "core/tracker-service-cache.h"
 
 #define TRACKER_DEFAULT_GRAPH TRACKER_PREFIX_NRL "DefaultGraph"
 
@@ -99,6 +100,8 @@ gboolean             tracker_data_manager_find_graph       (TrackerDataManager *
 
 guint                tracker_data_manager_get_generation   (TrackerDataManager *manager,
                                                             gboolean            in_transaction);
+void                 tracker_data_manager_increment_modification_count (TrackerDataManager *manager);
+guint64              tracker_data_manager_get_modification_count (TrackerDataManager *manager);
 void                 tracker_data_manager_rollback_graphs (TrackerDataManager *manager);
 void                 tracker_data_manager_commit_graphs (TrackerDataManager *manager);
 
@@ -112,6 +115,8 @@ const char * tracker_data_manager_expand_prefix (TrackerDataManager  *manager,
 TrackerSparqlConnection * tracker_data_manager_get_remote_connection (TrackerDataManager  *data_manager,
                                                                       const gchar         *uri,
                                                                       GError             **error);
+TrackerServiceCache * tracker_data_manager_get_service_cache (TrackerDataManager *data_manager);
+
 void tracker_data_manager_map_connection (TrackerDataManager      *data_manager,
                                           const gchar             *handle_name,
                                           TrackerSparqlConnection *connection);
@@ -3018,6 +3018,8 @@ tracker_data_commit_transaction (TrackerData  *data,
 		data->transaction_modseq++;
 	}
 
+	tracker_data_manager_increment_modification_count (data->manager);
+
 	data->resource_time = 0;
 	data->in_transaction = FALSE;
 	data->in_ontology_transaction = FALSE;
@@ -3341,6 +3343,10 @@ convert_format (TrackerRdfFormat format)
 		return TRACKER_SERIALIZER_FORMAT_TRIG;
 	case TRACKER_RDF_FORMAT_JSON_LD:
 		return TRACKER_SERIALIZER_FORMAT_JSON_LD;
+	case TRACKER_RDF_FORMAT_N_TRIPLES:
+		return TRACKER_SERIALIZER_FORMAT_NTRIPLES;
+	case TRACKER_RDF_FORMAT_N_QUADS:
+		return TRACKER_SERIALIZER_FORMAT_NQUADS;
 	default:
 		g_assert_not_reached ();
 	}
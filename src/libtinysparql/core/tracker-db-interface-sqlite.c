@@ -43,6 +43,15 @@
 /* Avoid casts everywhere. */
 #define sqlite3_value_text(x) ((const gchar *) sqlite3_value_text(x))
 
+/* Rows read ahead by next_async(). There is no setting for
+ * this, the block size adapts to the consumer instead: it starts
+ * small so the first rows are delivered early, and doubles on
+ * every read that is fully consumed. The upper bound caps the
+ * memory of rows held by a cursor.
+ */
+#define MIN_PREFETCH_ROWS 16
+#define MAX_PREFETCH_ROWS 1024
+
 typedef struct {
 	GRegex *syntax_check;
 	GRegex *replacement;
@@ -69,6 +78,9 @@ struct TrackerDBInterface {
 
 	GMutex mutex;
 
+	/* SERVICE virtual table */
+	TrackerServiceModule *service_module;
+
 	/* User data */
 	GObject *user_data;
 };
@@ -83,6 +95,22 @@ struct TrackerDBCursor {
 	TrackerDBStatement *ref_stmt;
 	gboolean finished;
 	guint n_columns;
+
+	/* Rows stepped ahead of the consumer, as sqlite3_value arrays */
+	GQueue prefetched;
+	sqlite3_value **row;
+	guint row_len;
+	guint prefetch_size;
+	GError *prefetch_error;
+
+	/* Time spent in sqlite3_step(), reported on close */
+	gint64 step_time;
+	TrackerDBCursorCostFunc cost_func;
+	gpointer cost_data;
+	GDestroyNotify cost_destroy;
+
+	/* SERVICE subqueries fetched ahead of the first step */
+	TrackerServicePrefetches *service_prefetches;
 };
 
 struct TrackerDBCursorClass {
@@ -115,6 +143,10 @@ static gboolean            tracker_db_cursor_get_boolean            (TrackerSpar
 static gboolean            db_cursor_iter_next                      (TrackerDBCursor       *cursor,
                                                                      GCancellable          *cancellable,
                                                                      GError               **error);
+static gint                tracker_db_cursor_fetch_rows             (TrackerSparqlCursor   *cursor,
+                                                                     TrackerCursorFetch    *fetch,
+                                                                     GCancellable          *cancellable,
+                                                                     GError               **error);
 
 void tracker_db_cursor_rewind (TrackerSparqlCursor *cursor);
 
@@ -2007,6 +2039,24 @@ tracker_db_interface_sqlite_fts_init (TrackerDBInterface     *db_interface,
 	                                     error);
 }
 
+gboolean
+tracker_db_interface_sqlite_fts_rebuild (TrackerDBInterface  *db_interface,
+                                         const gchar         *fts_table,
+                                         const gchar         *content_table,
+                                         GError             **error)
+{
+	gboolean retval;
+
+	tracker_db_interface_lock (db_interface);
+	retval = tracker_tokenizer_rebuild (db_interface->db,
+	                                    fts_table,
+	                                    content_table,
+	                                    error);
+	tracker_db_interface_unlock (db_interface);
+
+	return retval;
+}
+
 void
 tracker_db_interface_sqlite_reset_collator (TrackerDBInterface *db_interface)
 {
@@ -2619,6 +2669,97 @@ tracker_db_statement_sqlite_release (TrackerDBStatement *stmt)
 	stmt->stmt_is_used = FALSE;
 }
 
+static void
+db_cursor_free_row (TrackerDBCursor  *cursor,
+                    sqlite3_value   **row)
+{
+	guint i;
+
+	for (i = 0; i < cursor->row_len; i++)
+		sqlite3_value_free (row[i]);
+
+	g_free (row);
+}
+
+static void
+db_cursor_clear_prefetched (TrackerDBCursor *cursor)
+{
+	sqlite3_value **row;
+
+	if (cursor->row) {
+		db_cursor_free_row (cursor, cursor->row);
+		cursor->row = NULL;
+	}
+
+	while ((row = g_queue_pop_head (&cursor->prefetched)) != NULL)
+		db_cursor_free_row (cursor, row);
+
+	g_clear_error (&cursor->prefetch_error);
+	cursor->prefetch_size = MIN_PREFETCH_ROWS;
+}
+
+static sqlite3_value **
+db_cursor_copy_row (TrackerDBCursor *cursor)
+{
+	TrackerDBInterface *iface = cursor->ref_stmt->db_interface;
+	sqlite3_value **row;
+	guint i;
+
+	tracker_db_interface_lock (iface);
+
+	if (cursor->row_len == 0)
+		cursor->row_len = sqlite3_column_count (cursor->stmt);
+
+	row = g_new (sqlite3_value *, cursor->row_len);
+
+	for (i = 0; i < cursor->row_len; i++)
+		row[i] = sqlite3_value_dup (sqlite3_column_value (cursor->stmt, i));
+
+	tracker_db_interface_unlock (iface);
+
+	return row;
+}
+
+/* Moves to the next prefetched row, returns FALSE if there
+ * are none, and the statement must be stepped instead.
+ */
+static gboolean
+db_cursor_next_prefetched (TrackerDBCursor  *cursor,
+                           gboolean         *has_row,
+                           GError          **error)
+{
+	if (cursor->row) {
+		db_cursor_free_row (cursor, cursor->row);
+		cursor->row = NULL;
+	}
+
+	cursor->row = g_queue_pop_head (&cursor->prefetched);
+
+	if (cursor->row) {
+		*has_row = TRUE;
+		return TRUE;
+	}
+
+	if (cursor->prefetch_error) {
+		g_propagate_error (error, g_steal_pointer (&cursor->prefetch_error));
+		*has_row = FALSE;
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* The current row is either prefetched, or that of the statement */
+static inline sqlite3_value *
+db_cursor_get_column_value (TrackerDBCursor *cursor,
+                            gint             column)
+{
+	if (cursor->row && column >= 0 && (guint) column < cursor->row_len)
+		return cursor->row[column];
+
+	return sqlite3_column_value (cursor->stmt, column);
+}
+
 static void
 tracker_db_cursor_close (TrackerSparqlCursor *sparql_cursor)
 {
@@ -2632,6 +2773,10 @@ tracker_db_cursor_close (TrackerSparqlCursor *sparql_cursor)
 		return;
 	}
 
+	db_cursor_clear_prefetched (cursor);
+	g_clear_pointer (&cursor->service_prefetches,
+	                 tracker_service_prefetches_free);
+
 	iface = cursor->ref_stmt->db_interface;
 
 	g_object_ref (iface);
@@ -2644,6 +2789,15 @@ tracker_db_cursor_close (TrackerSparqlCursor *sparql_cursor)
 	tracker_db_interface_unref_use (iface);
 
 	g_object_unref (iface);
+
+	if (cursor->cost_func) {
+		cursor->cost_func (cursor->step_time, cursor->cost_data);
+		cursor->cost_func = NULL;
+	}
+
+	if (cursor->cost_destroy)
+		cursor->cost_destroy (g_steal_pointer (&cursor->cost_data));
+	cursor->cost_destroy = NULL;
 }
 
 static void
@@ -2668,14 +2822,32 @@ tracker_db_cursor_iter_next_thread (GTask        *task,
 
 	TrackerDBCursor *cursor = object;
 	GError *error = NULL;
-	gboolean result;
+	gboolean has_row = FALSE;
+	guint i;
 
-	result = db_cursor_iter_next (cursor, cancellable, &error);
-	if (error) {
-		g_task_return_error (task, error);
-	} else {
-		g_task_return_boolean (task, result);
+	/* Step a block of rows at once, following calls are
+	 * served from these without dispatching to a thread.
+	 */
+	for (i = 0; i < cursor->prefetch_size; i++) {
+		if (!db_cursor_iter_next (cursor, cancellable, &error))
+			break;
+
+		g_queue_push_tail (&cursor->prefetched, db_cursor_copy_row (cursor));
 	}
+
+	cursor->prefetch_size = MIN (cursor->prefetch_size * 2, MAX_PREFETCH_ROWS);
+
+	/* Errors are returned after the rows obtained before them */
+	if (error)
+		cursor->prefetch_error = error;
+
+	error = NULL;
+	db_cursor_next_prefetched (cursor, &has_row, &error);
+
+	if (error)
+		g_task_return_error (task, error);
+	else
+		g_task_return_boolean (task, has_row);
 }
 
 static void
@@ -2684,10 +2856,34 @@ tracker_db_cursor_iter_next_async (TrackerSparqlCursor     *cursor,
                                    GAsyncReadyCallback      callback,
                                    gpointer                 user_data)
 {
+	TrackerDBCursor *db_cursor = TRACKER_DB_CURSOR (cursor);
+	GError *error = NULL;
+	gboolean has_row;
 	GTask *task;
 
 	task = g_task_new (G_OBJECT (cursor), cancellable, callback, user_data);
-	g_task_run_in_thread (task, tracker_db_cursor_iter_next_thread);
+
+	/* Cancelling drops rows read ahead, as if they were not stepped yet */
+	if (g_cancellable_is_cancelled (cancellable))
+		db_cursor_clear_prefetched (db_cursor);
+
+	if (db_cursor_next_prefetched (db_cursor, &has_row, &error)) {
+		if (error)
+			g_task_return_error (task, error);
+		else
+			g_task_return_boolean (task, has_row);
+	} else if (db_cursor->finished || g_cancellable_is_cancelled (cancellable)) {
+		/* Does not need stepping the statement */
+		has_row = db_cursor_iter_next (db_cursor, cancellable, &error);
+
+		if (error)
+			g_task_return_error (task, error);
+		else
+			g_task_return_boolean (task, has_row);
+	} else {
+		g_task_run_in_thread (task, tracker_db_cursor_iter_next_thread);
+	}
+
 	g_object_unref (task);
 }
 
@@ -2720,6 +2916,7 @@ tracker_db_cursor_class_init (TrackerDBCursorClass *class)
 	sparql_cursor_class->get_integer = tracker_db_cursor_get_int;
 	sparql_cursor_class->get_double = tracker_db_cursor_get_double;
 	sparql_cursor_class->get_boolean = tracker_db_cursor_get_boolean;
+	sparql_cursor_class->fetch_rows = tracker_db_cursor_fetch_rows;
 }
 
 static TrackerDBCursor *
@@ -2760,6 +2957,20 @@ tracker_db_cursor_sqlite_new (TrackerDBStatement  *ref_stmt,
 	return cursor;
 }
 
+void
+tracker_db_cursor_set_cost_func (TrackerDBCursor         *cursor,
+                                 TrackerDBCursorCostFunc  func,
+                                 gpointer                 user_data,
+                                 GDestroyNotify           destroy)
+{
+	g_return_if_fail (TRACKER_IS_DB_CURSOR (cursor));
+	g_return_if_fail (cursor->cost_func == NULL);
+
+	cursor->cost_func = func;
+	cursor->cost_data = user_data;
+	cursor->cost_destroy = destroy;
+}
+
 void
 tracker_db_statement_bind_double (TrackerDBStatement *stmt,
                                   int                 index,
@@ -2908,6 +3119,8 @@ tracker_db_cursor_rewind (TrackerSparqlCursor *sparql_cursor)
 
 	iface = cursor->ref_stmt->db_interface;
 
+	db_cursor_clear_prefetched (cursor);
+
 	tracker_db_interface_lock (iface);
 
 	sqlite3_reset (cursor->stmt);
@@ -2921,7 +3134,16 @@ tracker_db_cursor_iter_next (TrackerSparqlCursor  *cursor,
                              GCancellable         *cancellable,
                              GError              **error)
 {
-	return db_cursor_iter_next (TRACKER_DB_CURSOR (cursor), cancellable, error);
+	TrackerDBCursor *db_cursor = TRACKER_DB_CURSOR (cursor);
+	gboolean has_row;
+
+	if (g_cancellable_is_cancelled (cancellable))
+		db_cursor_clear_prefetched (db_cursor);
+
+	if (db_cursor_next_prefetched (db_cursor, &has_row, error))
+		return has_row;
+
+	return db_cursor_iter_next (db_cursor, cancellable, error);
 }
 
 
@@ -2943,9 +3165,21 @@ db_cursor_iter_next (TrackerDBCursor *cursor,
 			sqlite3_reset (cursor->stmt);
 			cursor->finished = TRUE;
 		} else {
+			gint64 start_time;
+
 			/* only one statement can be active at the same time per interface */
 			iface->cancellable = cancellable;
+			if (cursor->service_prefetches) {
+				tracker_vtab_service_set_current_prefetches (iface->service_module,
+				                                             cursor->service_prefetches);
+			}
+
+			start_time = g_get_monotonic_time ();
 			result = stmt_step (cursor->stmt);
+			cursor->step_time += g_get_monotonic_time () - start_time;
+
+			if (cursor->service_prefetches)
+				tracker_vtab_service_set_current_prefetches (iface->service_module, NULL);
 			iface->cancellable = NULL;
 
 			if (result == SQLITE_INTERRUPT) {
@@ -2997,22 +3231,24 @@ tracker_db_cursor_get_value (TrackerDBCursor *cursor,
                              guint            column,
                              GValue          *value)
 {
+	sqlite3_value *val;
 	gint col_type;
 
-	col_type = sqlite3_column_type (cursor->stmt, column);
+	val = db_cursor_get_column_value (cursor, column);
+	col_type = sqlite3_value_type (val);
 
 	switch (col_type) {
 	case SQLITE_TEXT:
 		g_value_init (value, G_TYPE_STRING);
-		g_value_set_string (value, (gchar *) sqlite3_column_text (cursor->stmt, column));
+		g_value_set_string (value, sqlite3_value_text (val));
 		break;
 	case SQLITE_INTEGER:
 		g_value_init (value, G_TYPE_INT64);
-		g_value_set_int64 (value, sqlite3_column_int64 (cursor->stmt, column));
+		g_value_set_int64 (value, sqlite3_value_int64 (val));
 		break;
 	case SQLITE_FLOAT:
 		g_value_init (value, G_TYPE_DOUBLE);
-		g_value_set_double (value, sqlite3_column_double (cursor->stmt, column));
+		g_value_set_double (value, sqlite3_value_double (val));
 		break;
 	case SQLITE_NULL:
 		/* just ignore NULLs */
@@ -3038,7 +3274,7 @@ tracker_db_cursor_get_int (TrackerSparqlCursor *sparql_cursor,
 
 	tracker_db_interface_lock (iface);
 
-	result = (gint64) sqlite3_column_int64 (cursor->stmt, column);
+	result = (gint64) sqlite3_value_int64 (db_cursor_get_column_value (cursor, column));
 
 	tracker_db_interface_unlock (iface);
 
@@ -3060,13 +3296,28 @@ tracker_db_cursor_get_double (TrackerSparqlCursor *sparql_cursor,
 
 	tracker_db_interface_lock (iface);
 
-	result = (gdouble) sqlite3_column_double (cursor->stmt, column);
+	result = (gdouble) sqlite3_value_double (db_cursor_get_column_value (cursor, column));
 
 	tracker_db_interface_unlock (iface);
 
 	return result;
 }
 
+static gboolean
+db_value_get_boolean (sqlite3_value *val)
+{
+	gint col_type;
+
+	col_type = sqlite3_value_type (val);
+
+	if (col_type == SQLITE_INTEGER)
+		return sqlite3_value_int64 (val) != 0;
+	else if (col_type == SQLITE_TEXT)
+		return g_strcmp0 (sqlite3_value_text (val), "true") == 0;
+	else
+		return FALSE;
+}
+
 static gboolean
 tracker_db_cursor_get_boolean (TrackerSparqlCursor *sparql_cursor,
                                gint                 column)
@@ -3074,7 +3325,6 @@ tracker_db_cursor_get_boolean (TrackerSparqlCursor *sparql_cursor,
 	TrackerDBCursor *cursor = TRACKER_DB_CURSOR (sparql_cursor);
 	TrackerDBInterface *iface;
 	gboolean result;
-	gint col_type;
 
 	if (cursor->n_columns > 0 && column >= (gint) cursor->n_columns)
 		return FALSE;
@@ -3082,16 +3332,7 @@ tracker_db_cursor_get_boolean (TrackerSparqlCursor *sparql_cursor,
 	iface = cursor->ref_stmt->db_interface;
 
 	tracker_db_interface_lock (iface);
-
-	col_type = sqlite3_column_type (cursor->stmt, column);
-
-	if (col_type == SQLITE_INTEGER)
-		result = sqlite3_column_int64 (cursor->stmt, column) != 0;
-	else if (col_type == SQLITE_TEXT)
-		result = g_strcmp0 ((const gchar*) sqlite3_column_text (cursor->stmt, column), "true") == 0;
-	else
-		result = FALSE;
-
+	result = db_value_get_boolean (db_cursor_get_column_value (cursor, column));
 	tracker_db_interface_unlock (iface);
 
 	return result;
@@ -3112,7 +3353,7 @@ tracker_db_cursor_get_annotated_value_type (TrackerDBCursor        *cursor,
 	/* The value type may be annotated in extra columns, one per
 	 * user-visible column.
 	 */
-	property_type = sqlite3_column_int64 (cursor->stmt, column + cursor->n_columns);
+	property_type = sqlite3_value_int64 (db_cursor_get_column_value (cursor, column + cursor->n_columns));
 	is_null = column_type == SQLITE_NULL;
 
 	if (is_null) {
@@ -3141,7 +3382,7 @@ tracker_db_cursor_get_annotated_value_type (TrackerDBCursor        *cursor,
 		*value_type = TRACKER_SPARQL_VALUE_TYPE_DATETIME;
 		return TRUE;
 	case TRACKER_PROPERTY_TYPE_RESOURCE:
-		if (g_str_has_prefix ((const gchar *) sqlite3_column_text (cursor->stmt, column),
+		if (g_str_has_prefix (sqlite3_value_text (db_cursor_get_column_value (cursor, column)),
 		                      "urn:bnode:"))
 			*value_type = TRACKER_SPARQL_VALUE_TYPE_BLANK_NODE;
 		else
@@ -3153,24 +3394,18 @@ tracker_db_cursor_get_annotated_value_type (TrackerDBCursor        *cursor,
 	g_assert_not_reached ();
 }
 
-TrackerSparqlValueType
-tracker_db_cursor_get_value_type (TrackerSparqlCursor *sparql_cursor,
-                                  gint                 column)
+static TrackerSparqlValueType
+db_cursor_get_value_type_unlocked (TrackerDBCursor *cursor,
+                                   gint             column)
 {
-	TrackerDBCursor *cursor = TRACKER_DB_CURSOR (sparql_cursor);
-	TrackerDBInterface *iface;
-	gint column_type;
 	TrackerSparqlValueType value_type = TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
-
-	iface = cursor->ref_stmt->db_interface;
-
-	tracker_db_interface_lock (iface);
+	gint column_type;
 
 	if (cursor->n_columns > 0 &&
 	    column >= (int) cursor->n_columns)
-		goto out;
+		return value_type;
 
-	column_type = sqlite3_column_type (cursor->stmt, column);
+	column_type = sqlite3_value_type (db_cursor_get_column_value (cursor, column));
 
 	if (!tracker_db_cursor_get_annotated_value_type (cursor, column, column_type, &value_type)) {
 		if (column_type == SQLITE_NULL) {
@@ -3190,7 +3425,21 @@ tracker_db_cursor_get_value_type (TrackerSparqlCursor *sparql_cursor,
 		}
 	}
 
- out:
+	return value_type;
+}
+
+TrackerSparqlValueType
+tracker_db_cursor_get_value_type (TrackerSparqlCursor *sparql_cursor,
+                                  gint                 column)
+{
+	TrackerDBCursor *cursor = TRACKER_DB_CURSOR (sparql_cursor);
+	TrackerDBInterface *iface;
+	TrackerSparqlValueType value_type;
+
+	iface = cursor->ref_stmt->db_interface;
+
+	tracker_db_interface_lock (iface);
+	value_type = db_cursor_get_value_type_unlocked (cursor, column);
 	tracker_db_interface_unlock (iface);
 
 	return value_type;
@@ -3223,31 +3472,14 @@ tracker_db_cursor_get_variable_name (TrackerSparqlCursor *sparql_cursor,
 	return result;
 }
 
-const gchar*
-tracker_db_cursor_get_string (TrackerSparqlCursor  *sparql_cursor,
-                              gint                  column,
-                              const gchar         **langtag,
-                              glong                *length)
+static const gchar *
+db_value_get_string (sqlite3_value  *val,
+                     const gchar   **langtag,
+                     glong          *length)
 {
-	TrackerDBCursor *cursor = TRACKER_DB_CURSOR (sparql_cursor);
-	TrackerDBInterface *iface;
 	const gchar *result = NULL;
-	sqlite3_value *val;
 	int type;
 
-	if (langtag)
-		*langtag = NULL;
-	if (length)
-		*length = 0;
-
-	if (cursor->n_columns > 0 && column >= (gint) cursor->n_columns)
-		return NULL;
-
-	iface = cursor->ref_stmt->db_interface;
-
-	tracker_db_interface_lock (iface);
-
-	val = sqlite3_column_value (cursor->stmt, column);
 	type = sqlite3_value_type (val);
 
 	if (type == SQLITE_BLOB) {
@@ -3273,15 +3505,104 @@ tracker_db_cursor_get_string (TrackerSparqlCursor  *sparql_cursor,
 			*length = sqlite3_value_bytes (val);
 			result = (const gchar *) sqlite3_value_text (val);
 		} else {
-			result = (const gchar *) sqlite3_column_text (cursor->stmt, column);
+			result = sqlite3_value_text (val);
 		}
 	}
 
+	return result;
+}
+
+const gchar*
+tracker_db_cursor_get_string (TrackerSparqlCursor  *sparql_cursor,
+                              gint                  column,
+                              const gchar         **langtag,
+                              glong                *length)
+{
+	TrackerDBCursor *cursor = TRACKER_DB_CURSOR (sparql_cursor);
+	TrackerDBInterface *iface;
+	const gchar *result;
+
+	if (langtag)
+		*langtag = NULL;
+	if (length)
+		*length = 0;
+
+	if (cursor->n_columns > 0 && column >= (gint) cursor->n_columns)
+		return NULL;
+
+	iface = cursor->ref_stmt->db_interface;
+
+	tracker_db_interface_lock (iface);
+	result = db_value_get_string (db_cursor_get_column_value (cursor, column),
+	                              langtag, length);
 	tracker_db_interface_unlock (iface);
 
 	return result;
 }
 
+static gint
+tracker_db_cursor_fetch_rows (TrackerSparqlCursor  *sparql_cursor,
+                              TrackerCursorFetch   *fetch,
+                              GCancellable         *cancellable,
+                              GError              **error)
+{
+	TrackerDBCursor *cursor = TRACKER_DB_CURSOR (sparql_cursor);
+	TrackerDBInterface *iface = cursor->ref_stmt->db_interface;
+	gint row, column, n_columns;
+
+	for (row = 0; row < fetch->max_rows; row++) {
+		GError *inner_error = NULL;
+
+		if (!tracker_db_cursor_iter_next (sparql_cursor, cancellable, &inner_error)) {
+			if (inner_error) {
+				g_propagate_error (error, inner_error);
+				return -1;
+			}
+
+			break;
+		}
+
+		/* Read the whole row at once, without going through the getters */
+		tracker_db_interface_lock (iface);
+
+		n_columns = cursor->n_columns > 0 ?
+			(gint) cursor->n_columns : sqlite3_column_count (cursor->stmt);
+		n_columns = MIN (n_columns, fetch->n_columns);
+
+		for (column = 0; column < fetch->n_columns; column++) {
+			TrackerSparqlValueType type = TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
+			const gchar *str = NULL;
+			sqlite3_value *val;
+			gint64 integer = 0;
+			gdouble number = 0;
+			glong length = 0;
+
+			if (column < n_columns) {
+				val = db_cursor_get_column_value (cursor, column);
+				type = db_cursor_get_value_type_unlocked (cursor, column);
+
+				if (type == TRACKER_SPARQL_VALUE_TYPE_INTEGER)
+					integer = sqlite3_value_int64 (val);
+				else if (type == TRACKER_SPARQL_VALUE_TYPE_BOOLEAN)
+					integer = db_value_get_boolean (val);
+				else if (type == TRACKER_SPARQL_VALUE_TYPE_DOUBLE)
+					number = sqlite3_value_double (val);
+
+				if (type != TRACKER_SPARQL_VALUE_TYPE_UNBOUND && fetch->strings)
+					str = db_value_get_string (val, NULL, &length);
+			}
+
+			tracker_sparql_cursor_fetch_set_cell (sparql_cursor, fetch, row, column,
+			                                      type, integer, number,
+			                                      str, length);
+		}
+
+		tracker_db_interface_unlock (iface);
+	}
+
+	return row;
+}
+
 gboolean
 tracker_db_statement_execute (TrackerDBStatement  *stmt,
                               GError             **error)
@@ -3438,6 +3759,8 @@ tracker_db_statement_init (TrackerDBStatement *stmt)
 static void
 tracker_db_cursor_init (TrackerDBCursor *cursor)
 {
+	g_queue_init (&cursor->prefetched);
+	cursor->prefetch_size = MIN_PREFETCH_ROWS;
 }
 
 static void
@@ -3461,6 +3784,13 @@ tracker_db_interface_ref_use (TrackerDBInterface *db_interface)
 	g_atomic_int_inc (&db_interface->n_users);
 }
 
+/* Takes the interface only if nobody else is using it */
+gboolean
+tracker_db_interface_try_ref_use (TrackerDBInterface *db_interface)
+{
+	return g_atomic_int_compare_and_exchange (&db_interface->n_users, 0, 1);
+}
+
 gboolean
 tracker_db_interface_unref_use (TrackerDBInterface *db_interface)
 {
@@ -3477,7 +3807,26 @@ void
 tracker_db_interface_init_vtabs (TrackerDBInterface *db_interface)
 {
 	tracker_vtab_triples_init (db_interface->db, (gpointer) db_interface->user_data);
-	tracker_vtab_service_init (db_interface->db, (gpointer) db_interface->user_data);
+	db_interface->service_module =
+		tracker_vtab_service_init (db_interface->db, (gpointer) db_interface->user_data);
+}
+
+void
+tracker_db_cursor_prefetch_services (TrackerDBCursor *cursor,
+                                     GPtrArray       *service_queries)
+{
+	TrackerDBInterface *db_interface;
+
+	g_return_if_fail (TRACKER_IS_DB_CURSOR (cursor));
+	g_return_if_fail (cursor->ref_stmt != NULL);
+	g_return_if_fail (cursor->service_prefetches == NULL);
+
+	db_interface = cursor->ref_stmt->db_interface;
+	g_return_if_fail (db_interface->service_module != NULL);
+
+	cursor->service_prefetches =
+		tracker_vtab_service_prefetch (db_interface->service_module,
+		                               service_queries);
 }
 
 gboolean
@@ -50,11 +50,17 @@ gint64              tracker_db_interface_sqlite_get_last_insert_id     (TrackerD
 gboolean            tracker_db_interface_sqlite_fts_init               (TrackerDBInterface       *interface,
                                                                         TrackerDBManagerFlags     fts_flags,
                                                                         GError                  **error);
+gboolean            tracker_db_interface_sqlite_fts_rebuild            (TrackerDBInterface       *interface,
+                                                                        const gchar              *fts_table,
+                                                                        const gchar              *content_table,
+                                                                        GError                  **error);
 void                tracker_db_interface_sqlite_reset_collator         (TrackerDBInterface       *interface);
 gboolean            tracker_db_interface_sqlite_wal_checkpoint         (TrackerDBInterface       *interface,
                                                                         gboolean                  blocking,
                                                                         GError                  **error);
 void                tracker_db_interface_init_vtabs                    (TrackerDBInterface       *interface);
+void                tracker_db_cursor_prefetch_services                (TrackerDBCursor          *cursor,
+                                                                        GPtrArray                *service_queries);
 
 gboolean            tracker_db_interface_attach_database               (TrackerDBInterface       *db_interface,
                                                                         GFile                    *file,
@@ -62,8 +68,9 @@ gboolean            tracker_db_interface_attach_database               (TrackerD
                                                                         GError                  **error);
 gssize              tracker_db_interface_sqlite_release_memory         (TrackerDBInterface       *db_interface);
 
-void                tracker_db_interface_ref_use   (TrackerDBInterface *db_interface);
-gboolean            tracker_db_interface_unref_use (TrackerDBInterface *db_interface);
+void                tracker_db_interface_ref_use     (TrackerDBInterface *db_interface);
+gboolean            tracker_db_interface_try_ref_use (TrackerDBInterface *db_interface);
+gboolean            tracker_db_interface_unref_use   (TrackerDBInterface *db_interface);
 
 gboolean tracker_db_interface_found_corruption (TrackerDBInterface *db_interface);
 
@@ -170,4 +170,13 @@ void tracker_db_cursor_get_value (TrackerDBCursor            *cursor,
                                   guint                       column,
                                   GValue                     *value);
 
+/* Called when the cursor is closed, with the time spent stepping rows */
+typedef void (* TrackerDBCursorCostFunc) (gint64   step_time,
+                                          gpointer user_data);
+
+void tracker_db_cursor_set_cost_func (TrackerDBCursor         *cursor,
+                                      TrackerDBCursorCostFunc  func,
+                                      gpointer                 user_data,
+                                      GDestroyNotify           destroy);
+
 G_END_DECLS
@@ -35,6 +35,9 @@
 #define MAX_INTERFACES_PER_CPU        16
 #define MAX_INTERFACES                (MAX_INTERFACES_PER_CPU * g_get_num_processors ())
 
+/* Number of DB managers a thread remembers its interface for */
+#define MAX_THREAD_INTERFACES         8
+
 /* Required minimum space needed to create databases (5Mb) */
 #define TRACKER_DB_MIN_REQUIRED_SPACE 5242880
 
@@ -49,7 +52,8 @@
 #define FTS_FLAGS (TRACKER_DB_MANAGER_FTS_ENABLE_STEMMER |	  \
                    TRACKER_DB_MANAGER_FTS_ENABLE_UNACCENT |	  \
                    TRACKER_DB_MANAGER_FTS_ENABLE_STOP_WORDS |	  \
-                   TRACKER_DB_MANAGER_FTS_IGNORE_NUMBERS)
+                   TRACKER_DB_MANAGER_FTS_IGNORE_NUMBERS |	  \
+                   TRACKER_DB_MANAGER_FTS_ENABLE_PREFIX_INDEX)
 
 struct _TrackerDBManager {
 	GObject parent_instance;
@@ -67,9 +71,32 @@ struct _TrackerDBManager {
 
 	GWeakRef iface_data;
 
-	GAsyncQueue *interfaces;
+	/* Readonly interfaces. The lock is only taken for writing
+	 * when interfaces are created or released, threads otherwise
+	 * reuse the interface they were last given.
+	 */
+	GRWLock interfaces_lock;
+	GPtrArray *interfaces;
+	guint interfaces_epoch;
+	guint max_interfaces;
+	guint next_shared;
+	guint id;
 };
 
+typedef struct {
+	guint manager_id;
+	guint epoch;
+	TrackerDBInterface *iface;
+} ThreadInterface;
+
+typedef struct {
+	ThreadInterface slots[MAX_THREAD_INTERFACES];
+	guint next;
+} ThreadInterfaces;
+
+static GPrivate thread_interfaces = G_PRIVATE_INIT (g_free);
+static gint last_manager_id = 0;
+
 G_DEFINE_TYPE (TrackerDBManager, tracker_db_manager, G_TYPE_OBJECT)
 
 static TrackerDBInterface *tracker_db_manager_create_db_interface   (TrackerDBManager    *db_manager,
@@ -475,7 +502,6 @@ tracker_db_manager_new (TrackerDBManagerFlags   flags,
 	/* Set up locations */
 	db_manager->flags = flags;
 	db_manager->s_cache_size = select_cache_size;
-	db_manager->interfaces = g_async_queue_new_full (g_object_unref);
 
 	g_set_object (&db_manager->cache_location, cache_location);
 	g_weak_ref_init (&db_manager->iface_data, iface_data);
@@ -612,7 +638,8 @@ tracker_db_manager_finalize (GObject *object)
 
 	tracker_db_manager_release_memory (db_manager);
 
-	g_async_queue_unref (db_manager->interfaces);
+	g_ptr_array_unref (db_manager->interfaces);
+	g_rw_lock_clear (&db_manager->interfaces_lock);
 	g_free (db_manager->abs_filename);
 
 	if (db_manager->iface) {
@@ -694,6 +721,76 @@ tracker_db_manager_create_db_interface (TrackerDBManager  *db_manager,
 	return connection;
 }
 
+static ThreadInterface *
+lookup_thread_interface (TrackerDBManager *db_manager,
+                         gboolean          create)
+{
+	ThreadInterfaces *interfaces;
+	ThreadInterface *slot;
+	guint i;
+
+	interfaces = g_private_get (&thread_interfaces);
+
+	if (!interfaces) {
+		if (!create)
+			return NULL;
+
+		interfaces = g_new0 (ThreadInterfaces, 1);
+		g_private_set (&thread_interfaces, interfaces);
+	}
+
+	for (i = 0; i < MAX_THREAD_INTERFACES; i++) {
+		if (interfaces->slots[i].manager_id == db_manager->id)
+			return &interfaces->slots[i];
+	}
+
+	if (!create)
+		return NULL;
+
+	/* Manager IDs are never reused, so slots of finalized
+	 * managers are simply left to be overwritten.
+	 */
+	slot = &interfaces->slots[interfaces->next];
+	interfaces->next = (interfaces->next + 1) % MAX_THREAD_INTERFACES;
+	slot->manager_id = db_manager->id;
+
+	return slot;
+}
+
+static TrackerDBInterface *
+find_reusable_interface (TrackerDBManager *db_manager,
+                         gboolean          allow_busy)
+{
+	TrackerDBInterface *iface;
+	guint i;
+
+	for (i = 0; i < db_manager->interfaces->len; i++) {
+		iface = g_ptr_array_index (db_manager->interfaces, i);
+
+		if (!tracker_db_interface_get_is_used (iface))
+			return iface;
+	}
+
+	if (!allow_busy || db_manager->interfaces->len == 0)
+		return NULL;
+
+	/* Resign to sharing, spread threads over the interfaces */
+	i = db_manager->next_shared++ % db_manager->interfaces->len;
+
+	return g_ptr_array_index (db_manager->interfaces, i);
+}
+
+void
+tracker_db_manager_set_max_interfaces (TrackerDBManager *db_manager,
+                                       guint             max_interfaces)
+{
+	g_return_if_fail (max_interfaces > 0);
+
+	g_rw_lock_writer_lock (&db_manager->interfaces_lock);
+	db_manager->max_interfaces = max_interfaces;
+	g_rw_lock_writer_unlock (&db_manager->interfaces_lock);
+}
+
 /**
  * tracker_db_manager_get_db_interface:
  *
@@ -708,60 +805,70 @@ tracker_db_manager_get_db_interface (TrackerDBManager  *db_manager,
                                      GError           **error)
 {
 	GError *internal_error = NULL;
-	TrackerDBInterface *interface = NULL;
-	guint len, i;
-
-	/* The interfaces never actually leave the async queue,
-	 * we use it as a thread synchronized LRU, which doesn't
-	 * mean the interface found has no other active cursors,
-	 * in which case we either optionally create a new
-	 * TrackerDBInterface, or resign to sharing the obtained
-	 * one with other threads (thus getting increased contention
-	 * in the interface lock).
+	TrackerDBInterface *interface = NULL, *new_interface;
+	ThreadInterface *slot;
+
+	/* Interfaces are affine to the threads that use them, so
+	 * concurrent readers do not contend on the interface lock,
+	 * and each thread finds its statements cached. The interface
+	 * stays valid as long as no interfaces were released since
+	 * it was handed to this thread. If another thread took it
+	 * meanwhile, look for a free one instead of sharing it.
 	 */
-	g_async_queue_lock (db_manager->interfaces);
-	len = g_async_queue_length_unlocked (db_manager->interfaces);
+	slot = lookup_thread_interface (db_manager, FALSE);
 
-	/* 1st. Find a free interface */
-	for (i = 0; i < len; i++) {
-		interface = g_async_queue_try_pop_unlocked (db_manager->interfaces);
+	g_rw_lock_reader_lock (&db_manager->interfaces_lock);
 
-		if (!interface)
-			break;
-		if (!tracker_db_interface_get_is_used (interface))
-			break;
+	if (slot && slot->epoch == db_manager->interfaces_epoch &&
+	    tracker_db_interface_try_ref_use (slot->iface))
+		interface = slot->iface;
 
-		g_async_queue_push_unlocked (db_manager->interfaces, interface);
-		interface = NULL;
-	}
+	g_rw_lock_reader_unlock (&db_manager->interfaces_lock);
 
-	/* 2nd. If no more interfaces can be created, pick one */
-	if (!interface && len >= MAX_INTERFACES) {
-		interface = g_async_queue_try_pop_unlocked (db_manager->interfaces);
-	}
+	if (interface)
+		return interface;
+
+	/* 1st. Find a free interface, or pick one if no more can be created */
+	g_rw_lock_writer_lock (&db_manager->interfaces_lock);
+	interface = find_reusable_interface (db_manager,
+	                                     db_manager->interfaces->len >= db_manager->max_interfaces);
+	g_rw_lock_writer_unlock (&db_manager->interfaces_lock);
+
+	/* 2nd. Create a new interface to satisfy the request */
+	new_interface = NULL;
 
 	if (!interface) {
-		/* 3rd. Create a new interface to satisfy the request */
-		interface = tracker_db_manager_create_db_interface (db_manager,
-		                                                    TRUE, &internal_error);
+		new_interface = tracker_db_manager_create_db_interface (db_manager,
+		                                                        TRUE, &internal_error);
+	}
+
+	g_rw_lock_writer_lock (&db_manager->interfaces_lock);
+
+	if (new_interface &&
+	    db_manager->interfaces->len < db_manager->max_interfaces) {
+		g_ptr_array_add (db_manager->interfaces, new_interface);
+		interface = new_interface;
+	} else {
+		g_clear_object (&new_interface);
+
+		/* The interface might have been released meanwhile, look again */
+		interface = find_reusable_interface (db_manager, TRUE);
 
 		if (!interface) {
-			if (g_async_queue_length_unlocked (db_manager->interfaces) == 0) {
-				g_propagate_prefixed_error (error, internal_error, "Error opening database: ");
-				g_async_queue_unlock (db_manager->interfaces);
-				return NULL;
-			} else {
-				g_error_free (internal_error);
-				/* Fetch the first interface back. Oh well */
-				interface = g_async_queue_try_pop_unlocked (db_manager->interfaces);
-			}
+			g_rw_lock_writer_unlock (&db_manager->interfaces_lock);
+			g_propagate_prefixed_error (error, internal_error, "Error opening database: ");
+			return NULL;
 		}
 	}
 
+	g_clear_error (&internal_error);
 	tracker_db_interface_ref_use (interface);
 
-	g_async_queue_push_unlocked (db_manager->interfaces, interface);
-	g_async_queue_unlock (db_manager->interfaces);
+	slot = lookup_thread_interface (db_manager, TRUE);
+	slot->iface = interface;
+	slot->epoch = db_manager->interfaces_epoch;
+
+	g_rw_lock_writer_unlock (&db_manager->interfaces_lock);
 
 	return interface;
 }
@@ -769,6 +876,10 @@ tracker_db_manager_get_db_interface (TrackerDBManager  *db_manager,
 static void
 tracker_db_manager_init (TrackerDBManager *manager)
 {
+	g_rw_lock_init (&manager->interfaces_lock);
+	manager->interfaces = g_ptr_array_new_with_free_func (g_object_unref);
+	manager->max_interfaces = MAX_INTERFACES;
+	manager->id = g_atomic_int_add (&last_manager_id, 1) + 1;
 }
 
 static void
@@ -885,35 +996,37 @@ void
 tracker_db_manager_release_memory (TrackerDBManager *db_manager)
 {
 	TrackerDBInterface *iface;
-	gint i, len;
+	guint i, len;
 
-	g_async_queue_lock (db_manager->interfaces);
-	len = g_async_queue_length_unlocked (db_manager->interfaces);
+	g_rw_lock_writer_lock (&db_manager->interfaces_lock);
+	len = db_manager->interfaces->len;
+	i = 0;
 
-	for (i = 0; i < len; i++) {
-		iface = g_async_queue_try_pop_unlocked (db_manager->interfaces);
-		if (!iface)
-			break;
+	while (i < db_manager->interfaces->len) {
+		iface = g_ptr_array_index (db_manager->interfaces, i);
 
 		if (tracker_db_interface_get_is_used (iface)) {
-			g_async_queue_push_unlocked (db_manager->interfaces, iface);
-		} else {
-			if (tracker_db_interface_found_corruption (iface)) {
-				GError *error = NULL;
+			i++;
+			continue;
+		}
 
-				if (!g_file_set_contents (db_manager->corrupted_filename, "", -1, &error))
-					g_warning ("Could not mark database as corrupted: %s", error->message);
+		if (tracker_db_interface_found_corruption (iface)) {
+			GError *error = NULL;
 
-				g_clear_error (&error);
-			}
+			if (!g_file_set_contents (db_manager->corrupted_filename, "", -1, &error))
+				g_warning ("Could not mark database as corrupted: %s", error->message);
 
-			g_object_unref (iface);
+			g_clear_error (&error);
 		}
+
+		g_ptr_array_remove_index_fast (db_manager->interfaces, i);
 	}
 
-	if (g_async_queue_length_unlocked (db_manager->interfaces) < len) {
-		g_debug ("Freed %d readonly interfaces",
-		         len - g_async_queue_length_unlocked (db_manager->interfaces));
+	if (db_manager->interfaces->len < len) {
+		/* Threads must not keep using the interfaces they were given */
+		db_manager->interfaces_epoch++;
+		g_debug ("Freed %u readonly interfaces",
+		         len - db_manager->interfaces->len);
 	}
 
 	if (db_manager->iface) {
@@ -927,7 +1040,7 @@ tracker_db_manager_release_memory (TrackerDBManager *db_manager)
 		}
 	}
 
-	g_async_queue_unlock (db_manager->interfaces);
+	g_rw_lock_writer_unlock (&db_manager->interfaces_lock);
 }
 
 TrackerDBVersion
@@ -44,6 +44,8 @@ typedef enum {
 	TRACKER_DB_MANAGER_SKIP_VERSION_CHECK    = 1 << 8,
 	TRACKER_DB_MANAGER_ANONYMOUS_BNODES      = 1 << 9,
 	TRACKER_DB_MANAGER_ENABLE_SYNTAX_EXTENSIONS = 1 << 10,
+	TRACKER_DB_MANAGER_CACHE_SERVICE_RESULTS = 1 << 11,
+	TRACKER_DB_MANAGER_FTS_ENABLE_PREFIX_INDEX = 1 << 12,
 } TrackerDBManagerFlags;
 
 typedef enum {
@@ -74,6 +76,9 @@ TrackerDBInterface *tracker_db_manager_get_db_interface       (TrackerDBManager
                                                                GError               **error);
 TrackerDBInterface *tracker_db_manager_get_writable_db_interface (TrackerDBManager   *db_manager);
 
+void                tracker_db_manager_set_max_interfaces     (TrackerDBManager      *db_manager,
+                                                               guint                  max_interfaces);
+
 gboolean            tracker_db_manager_has_enough_space       (TrackerDBManager      *db_manager);
 
 gboolean            tracker_db_manager_is_first_time          (TrackerDBManager      *db_manager);
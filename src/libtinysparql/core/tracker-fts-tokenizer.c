@@ -36,9 +36,47 @@
 typedef struct TrackerTokenizerData TrackerTokenizerData;
 typedef struct TrackerTokenizer TrackerTokenizer;
 typedef struct TrackerTokenizerFunctionData TrackerTokenizerFunctionData;
+typedef struct TrackerTokenizerBatch TrackerTokenizerBatch;
 
 struct TrackerTokenizerData {
 	TrackerDBManagerFlags flags;
+
+	/* Pre-tokenized row being inserted during rebuilds */
+	TrackerTokenizerBatch *replay;
+	guint replay_row;
+	guint replay_column;
+};
+
+typedef struct {
+	gint start;
+	gint end;
+	gsize token; /* Offset in the batch token data */
+	gint len;
+} TrackerTokenizerToken;
+
+typedef struct {
+	gchar *text;
+	gint len;
+	guint first_token;
+	guint n_tokens;
+} TrackerTokenizerCell;
+
+/* A set of rows read by the writer during rebuilds, tokenized
+ * in a worker thread, then inserted by the writer.
+ */
+struct TrackerTokenizerBatch {
+	TrackerTokenizerData *data;
+	gint64 *rowids;
+	TrackerTokenizerCell *cells; /* n_rows * n_columns */
+	guint n_rows;
+	guint n_columns;
+	gsize text_size;
+	GArray *tokens;
+	GString *token_data;
+
+	GMutex mutex;
+	GCond cond;
+	gboolean done;
 };
 
 struct TrackerTokenizer {
@@ -55,6 +93,14 @@ struct TrackerTokenizerFunctionData {
 #define MAX_WORD_LENGTH 200
 #define MAX_WORDS 10000
 
+#define REBUILD_BATCH_SIZE 256
+/* Text read into a batch, and into all batches in flight */
+#define REBUILD_BATCH_BYTES (1 << 20)
+#define REBUILD_MAX_BYTES_IN_FLIGHT (16 << 20)
+#define REBUILD_PROGRESS_INTERVAL 10000
+
+static GPrivate rebuild_parser = G_PRIVATE_INIT ((GDestroyNotify) tracker_parser_free);
+
 static int
 tracker_tokenizer_create (void           *data,
                           const char    **argv,
@@ -88,6 +134,46 @@ typedef int (*TokenFunc) (void       *pCtx,    /* Copy of 2nd argument to xToken
                           int         start,   /* Byte offset of token within input text */
                           int         end);    /* Byte offset of end of token within input text */
 
+static gboolean
+tracker_tokenizer_replay (TrackerTokenizerData *data,
+                          void                 *ctx,
+                          const char           *text,
+                          int                   length,
+                          TokenFunc             token_func,
+                          int                  *rc)
+{
+	TrackerTokenizerBatch *batch = data->replay;
+	guint i, j;
+
+	/* Columns are tokenized in order, find the one matching this text */
+	for (i = data->replay_column; i < batch->n_columns; i++) {
+		TrackerTokenizerCell *cell;
+
+		cell = &batch->cells[data->replay_row * batch->n_columns + i];
+
+		if (!cell->text || cell->len != length ||
+		    memcmp (cell->text, text, length) != 0)
+			continue;
+
+		data->replay_column = i + 1;
+		*rc = SQLITE_OK;
+
+		for (j = 0; j < cell->n_tokens && *rc == SQLITE_OK; j++) {
+			TrackerTokenizerToken *token;
+
+			token = &g_array_index (batch->tokens, TrackerTokenizerToken,
+			                        cell->first_token + j);
+			*rc = token_func (ctx, 0,
+			                  &batch->token_data->str[token->token],
+			                  token->len, token->start, token->end);
+		}
+
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
 static int
 tracker_tokenizer_tokenize (Fts5Tokenizer *fts5_tokenizer,
                             void          *ctx,
@@ -98,6 +184,7 @@ tracker_tokenizer_tokenize (Fts5Tokenizer *fts5_tokenizer,
 {
 	TrackerTokenizer *tokenizer = (TrackerTokenizer *) fts5_tokenizer;
 	TrackerTokenizerData *data = tokenizer->data;
+	GPtrArray *prefixes = NULL;
 	const gchar *token;
 	int n_tokens = 0, pos, start, end, len;
 	int rc = SQLITE_OK;
@@ -105,6 +192,37 @@ tracker_tokenizer_tokenize (Fts5Tokenizer *fts5_tokenizer,
 	if (length <= 0)
 		return rc;
 
+	if (data->replay && (flags & FTS5_TOKENIZE_DOCUMENT) != 0 &&
+	    tracker_tokenizer_replay (data, ctx, text, length, token_func, &rc))
+		return rc;
+
+	/* Prefix search terms are most often incomplete words, stemming
+	 * those would produce unrelated stems. Look up the unstemmed
+	 * term, and the stemmed one as a synonym so whole words still
+	 * match their stemmed form in the index.
+	 */
+	if ((flags & FTS5_TOKENIZE_PREFIX) != 0 &&
+	    (data->flags & TRACKER_DB_MANAGER_FTS_ENABLE_STEMMER) != 0) {
+		prefixes = g_ptr_array_new_with_free_func (g_free);
+
+		tracker_parser_reset (tokenizer->parser, text, length,
+		                      MAX_WORD_LENGTH,
+		                      FALSE,
+		                      !!(data->flags & TRACKER_DB_MANAGER_FTS_ENABLE_UNACCENT),
+		                      !!(data->flags & TRACKER_DB_MANAGER_FTS_IGNORE_NUMBERS));
+
+		while (prefixes->len < MAX_WORDS) {
+			token = tracker_parser_next (tokenizer->parser,
+			                             &pos,
+			                             &start, &end,
+			                             &len);
+			if (!token)
+				break;
+
+			g_ptr_array_add (prefixes, g_strndup (token, len));
+		}
+	}
+
 	tracker_parser_reset (tokenizer->parser, text, length,
 			      MAX_WORD_LENGTH,
 			      !!(data->flags & TRACKER_DB_MANAGER_FTS_ENABLE_STEMMER),
@@ -120,7 +238,20 @@ tracker_tokenizer_tokenize (Fts5Tokenizer *fts5_tokenizer,
 		if (!token)
 			break;
 
-		rc = token_func (ctx, 0, token, len, start, end);
+		if (prefixes && (guint) n_tokens < prefixes->len) {
+			const gchar *prefix = g_ptr_array_index (prefixes, n_tokens);
+			int prefix_len = strlen (prefix);
+
+			rc = token_func (ctx, 0, prefix, prefix_len, start, end);
+
+			if (rc == SQLITE_OK &&
+			    (prefix_len != len || strncmp (prefix, token, len) != 0)) {
+				rc = token_func (ctx, FTS5_TOKEN_COLOCATED,
+				                 token, len, start, end);
+			}
+		} else {
+			rc = token_func (ctx, 0, token, len, start, end);
+		}
 
 		if (rc != SQLITE_OK)
 			break;
@@ -128,6 +259,8 @@ tracker_tokenizer_tokenize (Fts5Tokenizer *fts5_tokenizer,
 		n_tokens++;
 	}
 
+	g_clear_pointer (&prefixes, g_ptr_array_unref);
+
 	return rc;
 }
 
@@ -342,6 +475,343 @@ tracker_tokenizer_function_data_free (TrackerTokenizerFunctionData *data)
 	g_free (data);
 }
 
+static void
+tokenizer_batch_free (TrackerTokenizerBatch *batch)
+{
+	guint i;
+
+	for (i = 0; i < batch->n_rows * batch->n_columns; i++)
+		g_free (batch->cells[i].text);
+
+	g_free (batch->cells);
+	g_free (batch->rowids);
+	g_array_unref (batch->tokens);
+	g_string_free (batch->token_data, TRUE);
+	g_mutex_clear (&batch->mutex);
+	g_cond_clear (&batch->cond);
+	g_free (batch);
+}
+
+static void
+tokenize_batch_func (gpointer data,
+                     gpointer user_data)
+{
+	TrackerTokenizerBatch *batch = data;
+	TrackerParser *parser;
+	guint i;
+
+	parser = g_private_get (&rebuild_parser);
+	if (!parser) {
+		parser = tracker_parser_new ();
+		g_private_set (&rebuild_parser, parser);
+	}
+
+	/* This must produce the same tokens than tracker_tokenizer_tokenize() */
+	for (i = 0; i < batch->n_rows * batch->n_columns; i++) {
+		TrackerTokenizerCell *cell = &batch->cells[i];
+		const gchar *token;
+		int pos, start, end, len;
+
+		cell->first_token = batch->tokens->len;
+
+		if (!cell->text || cell->len <= 0)
+			continue;
+
+		tracker_parser_reset (parser, cell->text, cell->len,
+		                      MAX_WORD_LENGTH,
+		                      !!(batch->data->flags & TRACKER_DB_MANAGER_FTS_ENABLE_STEMMER),
+		                      !!(batch->data->flags & TRACKER_DB_MANAGER_FTS_ENABLE_UNACCENT),
+		                      !!(batch->data->flags & TRACKER_DB_MANAGER_FTS_IGNORE_NUMBERS));
+
+		while (cell->n_tokens < MAX_WORDS) {
+			TrackerTokenizerToken t;
+
+			token = tracker_parser_next (parser, &pos, &start, &end, &len);
+			if (!token)
+				break;
+
+			t.start = start;
+			t.end = end;
+			t.token = batch->token_data->len;
+			t.len = len;
+			g_string_append_len (batch->token_data, token, len);
+			g_array_append_val (batch->tokens, t);
+			cell->n_tokens++;
+		}
+	}
+
+	g_mutex_lock (&batch->mutex);
+	batch->done = TRUE;
+	g_cond_signal (&batch->cond);
+	g_mutex_unlock (&batch->mutex);
+}
+
+static TrackerTokenizerBatch *
+read_batch (TrackerTokenizerData  *data,
+            sqlite3_stmt          *select_stmt,
+            guint                  n_columns,
+            int                   *rc)
+{
+	TrackerTokenizerBatch *batch = NULL;
+
+	while ((*rc = sqlite3_step (select_stmt)) == SQLITE_ROW) {
+		guint i;
+
+		if (!batch) {
+			batch = g_new0 (TrackerTokenizerBatch, 1);
+			batch->data = data;
+			batch->n_columns = n_columns;
+			batch->rowids = g_new0 (gint64, REBUILD_BATCH_SIZE);
+			batch->cells = g_new0 (TrackerTokenizerCell, REBUILD_BATCH_SIZE * n_columns);
+			batch->tokens = g_array_new (FALSE, FALSE, sizeof (TrackerTokenizerToken));
+			batch->token_data = g_string_new (NULL);
+			g_mutex_init (&batch->mutex);
+			g_cond_init (&batch->cond);
+		}
+
+		/* First column is the rowid, the FTS columns follow */
+		batch->rowids[batch->n_rows] = sqlite3_column_int64 (select_stmt, 0);
+
+		for (i = 0; i < n_columns; i++) {
+			TrackerTokenizerCell *cell;
+
+			if (sqlite3_column_type (select_stmt, i + 1) == SQLITE_NULL)
+				continue;
+
+			cell = &batch->cells[batch->n_rows * n_columns + i];
+			cell->len = sqlite3_column_bytes (select_stmt, i + 1);
+			cell->text = g_strndup ((const gchar *) sqlite3_column_text (select_stmt, i + 1),
+			                        cell->len);
+			batch->text_size += cell->len;
+		}
+
+		batch->n_rows++;
+
+		if (batch->n_rows == REBUILD_BATCH_SIZE ||
+		    batch->text_size >= REBUILD_BATCH_BYTES) {
+			*rc = SQLITE_ROW;
+			break;
+		}
+	}
+
+	if (*rc != SQLITE_DONE && *rc != SQLITE_ROW) {
+		g_clear_pointer (&batch, tokenizer_batch_free);
+		return NULL;
+	}
+
+	*rc = SQLITE_OK;
+
+	return batch;
+}
+
+static int
+insert_batch (TrackerTokenizerData  *data,
+              TrackerTokenizerBatch *batch,
+              sqlite3_stmt          *insert_stmt)
+{
+	int rc = SQLITE_OK;
+	guint row, i;
+
+	g_mutex_lock (&batch->mutex);
+	while (!batch->done)
+		g_cond_wait (&batch->cond, &batch->mutex);
+	g_mutex_unlock (&batch->mutex);
+
+	for (row = 0; row < batch->n_rows && rc == SQLITE_OK; row++) {
+		sqlite3_bind_int64 (insert_stmt, 1, batch->rowids[row]);
+
+		for (i = 0; i < batch->n_columns; i++) {
+			TrackerTokenizerCell *cell;
+
+			cell = &batch->cells[row * batch->n_columns + i];
+
+			if (cell->text) {
+				sqlite3_bind_text (insert_stmt, i + 2,
+				                   cell->text, cell->len,
+				                   SQLITE_STATIC);
+			} else {
+				sqlite3_bind_null (insert_stmt, i + 2);
+			}
+		}
+
+		data->replay = batch;
+		data->replay_row = row;
+		data->replay_column = 0;
+
+		rc = sqlite3_step (insert_stmt);
+		if (rc == SQLITE_DONE)
+			rc = SQLITE_OK;
+
+		data->replay = NULL;
+		sqlite3_reset (insert_stmt);
+	}
+
+	sqlite3_clear_bindings (insert_stmt);
+
+	return rc;
+}
+
+static TrackerTokenizerData *
+find_tokenizer_data (sqlite3  *db,
+                     GError  **error)
+{
+	fts5_tokenizer tokenizer;
+	fts5_api *api;
+	void *user_data = NULL;
+
+	api = get_fts5_api (db, error);
+	if (!api)
+		return NULL;
+
+	if (api->xFindTokenizer (api, "TrackerTokenizer",
+	                         &user_data, &tokenizer) != SQLITE_OK) {
+		g_set_error (error,
+		             TRACKER_DB_INTERFACE_ERROR,
+		             TRACKER_DB_QUERY_ERROR,
+		             "Could not find fts5 tokenizer");
+		return NULL;
+	}
+
+	return user_data;
+}
+
+/* Rebuilds the FTS index from its content table. This is equivalent
+ * to the FTS5 'rebuild' command, but content is tokenized in parallel
+ * by worker threads while the writer inserts the already tokenized
+ * rows into the FTS table.
+ */
+gboolean
+tracker_tokenizer_rebuild (sqlite3      *db,
+                           const gchar  *fts_table,
+                           const gchar  *content_table,
+                           GError      **error)
+{
+	TrackerTokenizerData *data;
+	sqlite3_stmt *select_stmt = NULL, *insert_stmt = NULL;
+	GQueue in_flight = G_QUEUE_INIT;
+	GThreadPool *pool = NULL;
+	GString *sql = NULL;
+	gboolean finished = FALSE;
+	guint n_columns, n_threads, i;
+	gint64 n_rows = 0, last_progress = 0;
+	gsize bytes_in_flight = 0;
+	gchar *query;
+	int rc;
+
+	data = find_tokenizer_data (db, error);
+	if (!data)
+		return FALSE;
+
+	query = g_strdup_printf ("INSERT INTO \"%s\" (\"%s\") VALUES ('delete-all')",
+	                         fts_table, fts_table);
+	rc = sqlite3_exec (db, query, NULL, NULL, NULL);
+	g_free (query);
+	if (rc != SQLITE_OK)
+		goto error;
+
+	query = g_strdup_printf ("SELECT * FROM \"%s\"", content_table);
+	rc = sqlite3_prepare_v2 (db, query, -1, &select_stmt, NULL);
+	g_free (query);
+	if (rc != SQLITE_OK)
+		goto error;
+
+	n_columns = sqlite3_column_count (select_stmt) - 1;
+
+	sql = g_string_new (NULL);
+	g_string_append_printf (sql, "INSERT INTO \"%s\" (rowid", fts_table);
+	for (i = 0; i < n_columns; i++) {
+		g_string_append_printf (sql, ", \"%s\"",
+		                        sqlite3_column_name (select_stmt, i + 1));
+	}
+	g_string_append (sql, ") VALUES (?");
+	for (i = 0; i < n_columns; i++)
+		g_string_append (sql, ", ?");
+	g_string_append_c (sql, ')');
+
+	rc = sqlite3_prepare_v2 (db, sql->str, -1, &insert_stmt, NULL);
+	if (rc != SQLITE_OK)
+		goto error;
+
+	n_threads = CLAMP (g_get_num_processors (), 1, 16);
+	pool = g_thread_pool_new (tokenize_batch_func, NULL,
+	                          n_threads, TRUE, NULL);
+
+	while (TRUE) {
+		TrackerTokenizerBatch *batch;
+
+		if (!finished) {
+			batch = read_batch (data, select_stmt, n_columns, &rc);
+			if (rc != SQLITE_OK)
+				goto error;
+
+			if (batch) {
+				bytes_in_flight += batch->text_size;
+				g_queue_push_tail (&in_flight, batch);
+				g_thread_pool_push (pool, batch, NULL);
+			} else {
+				finished = TRUE;
+			}
+		}
+
+		if (g_queue_is_empty (&in_flight))
+			break;
+
+		/* Keep all workers busy while the writer inserts, as long
+		 * as the text being tokenized stays within bounds.
+		 */
+		if (!finished &&
+		    g_queue_get_length (&in_flight) < 2 * n_threads &&
+		    bytes_in_flight < REBUILD_MAX_BYTES_IN_FLIGHT)
+			continue;
+
+		batch = g_queue_pop_head (&in_flight);
+		rc = insert_batch (data, batch, insert_stmt);
+		n_rows += batch->n_rows;
+		bytes_in_flight -= batch->text_size;
+		tokenizer_batch_free (batch);
+
+		if (rc != SQLITE_OK)
+			goto error;
+
+		if (n_rows - last_progress >= REBUILD_PROGRESS_INTERVAL) {
+			g_debug ("Rebuilding FTS index %s: %" G_GINT64_FORMAT " rows indexed",
+			         fts_table, n_rows);
+			last_progress = n_rows;
+		}
+	}
+
+	g_debug ("Rebuilt FTS index %s: %" G_GINT64_FORMAT " rows indexed",
+	         fts_table, n_rows);
+
+	g_thread_pool_free (pool, FALSE, TRUE);
+	g_string_free (sql, TRUE);
+	sqlite3_finalize (select_stmt);
+	sqlite3_finalize (insert_stmt);
+
+	return TRUE;
+
+error:
+	g_set_error (error,
+	             TRACKER_DB_INTERFACE_ERROR,
+	             TRACKER_DB_QUERY_ERROR,
+	             "Could not rebuild FTS index: %s",
+	             sqlite3_errmsg (db));
+
+	/* Let workers finish with the pending batches */
+	if (pool)
+		g_thread_pool_free (pool, FALSE, TRUE);
+
+	while (!g_queue_is_empty (&in_flight))
+		tokenizer_batch_free (g_queue_pop_head (&in_flight));
+
+	if (sql)
+		g_string_free (sql, TRUE);
+	g_clear_pointer (&select_stmt, sqlite3_finalize);
+	g_clear_pointer (&insert_stmt, sqlite3_finalize);
+
+	return FALSE;
+}
+
 gboolean
 tracker_tokenizer_initialize (sqlite3                *db,
                               TrackerDBInterface     *interface,
@@ -31,3 +31,8 @@ gboolean tracker_tokenizer_initialize (sqlite3                *db,
                                        TrackerDBManagerFlags   flags,
                                        TrackerDataManager     *data_manager,
                                        GError                **error);
+
+gboolean tracker_tokenizer_rebuild (sqlite3      *db,
+                                    const gchar  *fts_table,
+                                    const gchar  *content_table,
+                                    GError      **error);
@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2026, Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "tracker-service-cache.h"
+
+#include <string.h>
+
+typedef struct {
+	gchar *key;
+	TrackerServiceResults *results;
+	gint64 insertion_time;
+	GList *link;
+} CacheEntry;
+
+struct _TrackerServiceCache {
+	GMutex mutex;
+	GHashTable *entries;
+	GQueue lru; /* Least recently used first */
+	gint64 ttl;
+	gsize max_size;
+	gsize size;
+};
+
+static void
+tracker_service_value_clear (TrackerServiceValue *value)
+{
+	if (value->type == TRACKER_SPARQL_VALUE_TYPE_URI ||
+	    value->type == TRACKER_SPARQL_VALUE_TYPE_STRING ||
+	    value->type == TRACKER_SPARQL_VALUE_TYPE_DATETIME ||
+	    value->type == TRACKER_SPARQL_VALUE_TYPE_BLANK_NODE)
+		g_free (value->data.str);
+}
+
+TrackerServiceResults *
+tracker_service_results_new (void)
+{
+	TrackerServiceResults *results;
+
+	results = g_new0 (TrackerServiceResults, 1);
+	results->ref_count = 1;
+	results->values = g_array_new (FALSE, FALSE, sizeof (TrackerServiceValue));
+	g_array_set_clear_func (results->values,
+	                        (GDestroyNotify) tracker_service_value_clear);
+
+	return results;
+}
+
+TrackerServiceResults *
+tracker_service_results_ref (TrackerServiceResults *results)
+{
+	g_atomic_int_inc (&results->ref_count);
+	return results;
+}
+
+void
+tracker_service_results_unref (TrackerServiceResults *results)
+{
+	if (g_atomic_int_dec_and_test (&results->ref_count)) {
+		g_array_unref (results->values);
+		g_free (results);
+	}
+}
+
+void
+tracker_service_results_append_row (TrackerServiceResults *results,
+                                    TrackerSparqlCursor   *cursor,
+                                    guint                  max_columns)
+{
+	guint i;
+
+	g_assert (!results->complete);
+
+	if (results->n_rows == 0) {
+		results->n_columns = MIN ((guint) tracker_sparql_cursor_get_n_columns (cursor),
+		                          max_columns);
+	}
+
+	for (i = 0; i < results->n_columns; i++) {
+		TrackerServiceValue value = { 0, };
+		const gchar *str;
+
+		value.type = tracker_sparql_cursor_get_value_type (cursor, i);
+
+		switch (value.type) {
+		case TRACKER_SPARQL_VALUE_TYPE_URI:
+		case TRACKER_SPARQL_VALUE_TYPE_STRING:
+		case TRACKER_SPARQL_VALUE_TYPE_DATETIME:
+		case TRACKER_SPARQL_VALUE_TYPE_BLANK_NODE:
+			str = tracker_sparql_cursor_get_string (cursor, i, NULL);
+			value.data.str = g_strdup (str);
+			if (str)
+				results->size += strlen (str) + 1;
+			break;
+		case TRACKER_SPARQL_VALUE_TYPE_INTEGER:
+			value.data.integer = tracker_sparql_cursor_get_integer (cursor, i);
+			break;
+		case TRACKER_SPARQL_VALUE_TYPE_BOOLEAN:
+			value.data.integer = tracker_sparql_cursor_get_boolean (cursor, i);
+			break;
+		case TRACKER_SPARQL_VALUE_TYPE_DOUBLE:
+			value.data.number = tracker_sparql_cursor_get_double (cursor, i);
+			break;
+		case TRACKER_SPARQL_VALUE_TYPE_UNBOUND:
+		default:
+			value.type = TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
+			break;
+		}
+
+		g_array_append_val (results->values, value);
+	}
+
+	results->size += sizeof (TrackerServiceValue) * results->n_columns;
+	results->n_rows++;
+}
+
+const TrackerServiceValue *
+tracker_service_results_get_value (TrackerServiceResults *results,
+                                   guint                  row,
+                                   guint                  column)
+{
+	if (row >= results->n_rows || column >= results->n_columns)
+		return NULL;
+
+	return &g_array_index (results->values, TrackerServiceValue,
+	                       row * results->n_columns + column);
+}
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+	tracker_service_results_unref (entry->results);
+	g_free (entry->key);
+	g_free (entry);
+}
+
+TrackerServiceCache *
+tracker_service_cache_new (gint64 ttl,
+                           gsize  max_size)
+{
+	TrackerServiceCache *cache;
+
+	cache = g_new0 (TrackerServiceCache, 1);
+	g_mutex_init (&cache->mutex);
+	cache->entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+	                                        (GDestroyNotify) cache_entry_free);
+	cache->ttl = ttl;
+	cache->max_size = max_size;
+
+	return cache;
+}
+
+void
+tracker_service_cache_free (TrackerServiceCache *cache)
+{
+	g_queue_clear (&cache->lru);
+	g_hash_table_unref (cache->entries);
+	g_mutex_clear (&cache->mutex);
+	g_free (cache);
+}
+
+static void
+remove_entry (TrackerServiceCache *cache,
+              CacheEntry          *entry)
+{
+	g_queue_delete_link (&cache->lru, entry->link);
+	cache->size -= entry->results->size;
+	g_hash_table_remove (cache->entries, entry->key);
+}
+
+static void
+evict_entries (TrackerServiceCache *cache,
+               gsize                max_size)
+{
+	while (cache->size > max_size) {
+		CacheEntry *oldest;
+
+		oldest = g_queue_peek_head (&cache->lru);
+		remove_entry (cache, oldest);
+	}
+}
+
+void
+tracker_service_cache_set_limits (TrackerServiceCache *cache,
+                                  gint64               ttl,
+                                  gsize                max_size)
+{
+	g_mutex_lock (&cache->mutex);
+
+	/* Existing entries are subject to the new limits too */
+	cache->ttl = ttl;
+	cache->max_size = max_size;
+	evict_entries (cache, max_size);
+
+	g_mutex_unlock (&cache->mutex);
+}
+
+TrackerServiceResults *
+tracker_service_cache_lookup (TrackerServiceCache *cache,
+                              const gchar         *key)
+{
+	TrackerServiceResults *results = NULL;
+	CacheEntry *entry;
+
+	g_mutex_lock (&cache->mutex);
+
+	entry = g_hash_table_lookup (cache->entries, key);
+
+	if (entry) {
+		if (entry->insertion_time + cache->ttl <= g_get_monotonic_time ()) {
+			remove_entry (cache, entry);
+		} else {
+			/* Move to the most recently used end */
+			g_queue_unlink (&cache->lru, entry->link);
+			g_queue_push_tail_link (&cache->lru, entry->link);
+			results = tracker_service_results_ref (entry->results);
+		}
+	}
+
+	g_mutex_unlock (&cache->mutex);
+
+	return results;
+}
+
+void
+tracker_service_cache_insert (TrackerServiceCache   *cache,
+                              const gchar           *key,
+                              TrackerServiceResults *results)
+{
+	CacheEntry *entry;
+
+	g_return_if_fail (results->complete);
+
+	g_mutex_lock (&cache->mutex);
+
+	if (results->size > cache->max_size) {
+		g_mutex_unlock (&cache->mutex);
+		return;
+	}
+
+	entry = g_hash_table_lookup (cache->entries, key);
+	if (entry)
+		remove_entry (cache, entry);
+
+	evict_entries (cache, cache->max_size - results->size);
+
+	entry = g_new0 (CacheEntry, 1);
+	entry->key = g_strdup (key);
+	entry->results = tracker_service_results_ref (results);
+	entry->insertion_time = g_get_monotonic_time ();
+	entry->link = g_list_alloc ();
+	entry->link->data = entry;
+
+	g_queue_push_tail_link (&cache->lru, entry->link);
+	g_hash_table_insert (cache->entries, entry->key, entry);
+	cache->size += results->size;
+
+	g_mutex_unlock (&cache->mutex);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026, Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "tracker-cursor.h"
+
+typedef struct _TrackerServiceCache TrackerServiceCache;
+typedef struct _TrackerServiceValue TrackerServiceValue;
+typedef struct _TrackerServiceResults TrackerServiceResults;
+
+struct _TrackerServiceValue {
+	TrackerSparqlValueType type;
+	union {
+		gchar *str;
+		gint64 integer;
+		gdouble number;
+	} data;
+};
+
+/* Rows obtained from a SERVICE subquery. Results are not modified
+ * after being marked complete, so they can be shared.
+ */
+struct _TrackerServiceResults {
+	GArray *values;
+	guint n_columns;
+	guint n_rows;
+	gsize size;
+	gint ref_count;
+	guint complete : 1;
+};
+
+TrackerServiceResults * tracker_service_results_new (void);
+
+TrackerServiceResults * tracker_service_results_ref (TrackerServiceResults *results);
+
+void tracker_service_results_unref (TrackerServiceResults *results);
+
+void tracker_service_results_append_row (TrackerServiceResults *results,
+                                         TrackerSparqlCursor   *cursor,
+                                         guint                  max_columns);
+
+const TrackerServiceValue * tracker_service_results_get_value (TrackerServiceResults *results,
+                                                               guint                  row,
+                                                               guint                  column);
+
+TrackerServiceCache * tracker_service_cache_new (gint64 ttl,
+                                                 gsize  max_size);
+
+void tracker_service_cache_free (TrackerServiceCache *cache);
+
+void tracker_service_cache_set_limits (TrackerServiceCache *cache,
+                                       gint64               ttl,
+                                       gsize                max_size);
+
+TrackerServiceResults * tracker_service_cache_lookup (TrackerServiceCache *cache,
+                                                      const gchar         *key);
+
+void tracker_service_cache_insert (TrackerServiceCache   *cache,
+                                   const gchar           *key,
+                                   TrackerServiceResults *results);
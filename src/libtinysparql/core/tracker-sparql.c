@@ -244,6 +244,11 @@ struct _TrackerSparql
 	GPtrArray *literal_bindings;
 	guint n_columns;
 
+	/* Pairs of service/query strings of SERVICE clauses whose
+	 * results do not depend on the rest of the query.
+	 */
+	GPtrArray *service_queries;
+
 	GArray *update_ops;
 	GArray *update_groups;
 
@@ -354,6 +359,7 @@ tracker_sparql_finalize (GObject *object)
 
 	g_clear_pointer (&sparql->sql_string, g_free);
 	g_clear_pointer (&sparql->literal_bindings, g_ptr_array_unref);
+	g_clear_pointer (&sparql->service_queries, g_ptr_array_unref);
 
 	if (sparql->tree)
 		tracker_node_tree_free (sparql->tree);
@@ -5486,7 +5492,8 @@ translate_ServiceGraphPattern (TrackerSparql  *sparql,
 	GList *join_vars = NULL;
 	TrackerToken service;
 	GString *service_sparql = NULL;
-	gboolean silent = FALSE, do_join;
+	gchar *service_query = NULL;
+	gboolean silent = FALSE, do_join, has_parameters = FALSE;
 	gint i = 0;
 
 	/* ServiceGraphPattern ::= 'SERVICE' 'SILENT'? VarOrIri GroupGraphPattern
@@ -5544,8 +5551,10 @@ translate_ServiceGraphPattern (TrackerSparql  *sparql,
 		rule = tracker_parser_node_get_rule (node);
 
 		if (tracker_grammar_rule_is_a (rule, RULE_TYPE_TERMINAL,
-		                               TERMINAL_TYPE_PARAMETERIZED_VAR))
+		                               TERMINAL_TYPE_PARAMETERIZED_VAR)) {
+			has_parameters = TRUE;
 			continue;
+		}
 
 		var_str = _extract_node_string (node, sparql);
 		var = tracker_select_context_ensure_variable (TRACKER_SELECT_CONTEXT (sparql->current_state->top_context),
@@ -5599,12 +5608,29 @@ translate_ServiceGraphPattern (TrackerSparql  *sparql,
 		tracker_parser_node_get_extents (pattern, &pattern_start, &pattern_end);
 		pattern_str = g_strndup (&sparql->sparql[pattern_start], pattern_end - pattern_start);
 		escaped_str = _escape_sql_string (pattern_str, '\'');
+		service_query = g_strconcat (service_sparql->str, pattern_str, NULL);
 		g_string_append (service_sparql, escaped_str);
 		g_list_free (variables);
 		g_free (pattern_str);
 		g_free (escaped_str);
 	}
 
+	/* The subquery of constant services without parameters can be
+	 * started as soon as the statement is executed.
+	 */
+	if (service_query && !has_parameters &&
+	    !tracker_token_get_variable (&service)) {
+		if (!sparql->service_queries)
+			sparql->service_queries = g_ptr_array_new_with_free_func (g_free);
+
+		g_ptr_array_add (sparql->service_queries,
+		                 g_strdup (tracker_token_get_idstring (&service)));
+		g_ptr_array_add (sparql->service_queries,
+		                 g_steal_pointer (&service_query));
+	}
+
+	g_free (service_query);
+
 	_append_string_printf (sparql, "FROM tracker_service WHERE query='%s' AND silent=%d ",
 	                       service_sparql ? service_sparql->str : "",
 			       silent);
@@ -10054,6 +10080,7 @@ tracker_sparql_execute_cursor (TrackerSparql  *sparql,
 
 		sparql->current_state = &state;
 		tracker_sparql_state_init (&state, sparql);
+		g_clear_pointer (&sparql->service_queries, g_ptr_array_unref);
 		retval = _call_rule_func (sparql, NAMED_RULE_Query, error);
 		g_clear_pointer (&sparql->sql_string, g_free);
 		sparql->sql_string = tracker_string_builder_to_string (state.result);
@@ -10090,6 +10117,12 @@ tracker_sparql_execute_cursor (TrackerSparql  *sparql,
 							   error);
 	g_object_unref (stmt);
 
+	/* Query all services concurrently, rather than one after
+	 * another as the virtual tables are scanned.
+	 */
+	if (cursor && sparql->service_queries && sparql->service_queries->len > 2)
+		tracker_db_cursor_prefetch_services (cursor, sparql->service_queries);
+
 error:
 	if (iface)
 		tracker_db_interface_unref_use (iface);
@@ -10794,3 +10827,36 @@ tracker_sparql_is_serializable (TrackerSparql *sparql)
 
 	return FALSE;
 }
+
+gboolean
+tracker_sparql_is_deterministic (TrackerSparql *sparql)
+{
+	TrackerParserNode *node;
+
+	if (!sparql->tree)
+		return FALSE;
+
+	node = tracker_node_tree_get_root (sparql->tree);
+
+	for (node = tracker_sparql_parser_tree_find_first (node, FALSE);
+	     node;
+	     node = tracker_sparql_parser_tree_find_next (node, FALSE)) {
+		const TrackerGrammarRule *rule;
+
+		rule = tracker_parser_node_get_rule (node);
+
+		/* Results of remote services and of these built-in
+		 * calls may change without modifications to the
+		 * local database.
+		 */
+		if (tracker_grammar_rule_is_a (rule, RULE_TYPE_RULE, NAMED_RULE_ServiceGraphPattern) ||
+		    tracker_grammar_rule_is_a (rule, RULE_TYPE_LITERAL, LITERAL_NOW) ||
+		    tracker_grammar_rule_is_a (rule, RULE_TYPE_LITERAL, LITERAL_RAND) ||
+		    tracker_grammar_rule_is_a (rule, RULE_TYPE_LITERAL, LITERAL_UUID) ||
+		    tracker_grammar_rule_is_a (rule, RULE_TYPE_LITERAL, LITERAL_STRUUID) ||
+		    tracker_grammar_rule_is_a (rule, RULE_TYPE_LITERAL, LITERAL_BNODE))
+			return FALSE;
+	}
+
+	return TRUE;
+}
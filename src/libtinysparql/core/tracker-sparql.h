@@ -33,6 +33,8 @@ TrackerSparql *       tracker_sparql_new (TrackerDataManager  *manager,
 
 gboolean              tracker_sparql_is_serializable (TrackerSparql *sparql);
 
+gboolean              tracker_sparql_is_deterministic (TrackerSparql *sparql);
+
 TrackerSparqlCursor * tracker_sparql_execute_cursor (TrackerSparql  *sparql,
                                                      GHashTable     *parameters,
                                                      GError        **error);
@@ -25,6 +25,7 @@
 #include <tracker-common.h>
 
 #include "tracker-connection.h"
+#include "tracker-service-cache.h"
 
 #define N_VARIABLES 100
 #define N_PARAMETERS 50
@@ -35,14 +36,52 @@
 #define COL_FIRST_PARAMETER COL_LAST
 #define COL_FIRST_VARIABLE (COL_LAST + (N_PARAMETERS * 2))
 
+/* Maximum number of rows kept around per cursor, so repeated
+ * scans with the same arguments are replayed without querying
+ * the service again.
+ */
+#define MAX_BUFFERED_ROWS 10000
+
+/* Maximum number of SERVICE subqueries of a query fetched concurrently,
+ * any further ones are fetched as the virtual table gets to them.
+ */
+#define MAX_PREFETCH_THREADS 16
+
 /* Avoid casts everywhere. */
 #define sqlite3_value_text(x) ((const gchar *) sqlite3_value_text(x))
 #define sqlite3_column_text(x, y) ((const gchar *) sqlite3_column_text(x, y))
 
-typedef struct {
+struct _TrackerServiceModule {
 	sqlite3 *db;
 	TrackerDataManager *data_manager;
-} TrackerServiceModule;
+	/* Those of the query cursor being stepped */
+	TrackerServicePrefetches *current_prefetches;
+};
+
+/* SERVICE subqueries fetched ahead of time for a query cursor */
+struct _TrackerServicePrefetches {
+	TrackerServiceModule *module;
+	GHashTable *prefetches;
+	GThreadPool *pool;
+};
+
+/* Results of a SERVICE subquery being fetched ahead of time */
+typedef struct {
+	TrackerDataManager *data_manager;
+	gchar *service;
+	gchar *query;
+	TrackerServiceResults *results;
+	/* Set if results go past the buffered row limit, in order
+	 * to stream the remaining rows.
+	 */
+	TrackerSparqlCursor *sparql_cursor;
+	GCancellable *cancellable;
+	GMutex mutex;
+	GCond cond;
+	gint ref_count;
+	guint started : 1;
+	guint done : 1;
+} ServicePrefetch;
 
 typedef struct {
 	struct sqlite3_vtab parent;
@@ -54,12 +93,19 @@ typedef struct {
 	struct sqlite3_vtab_cursor parent;
 	TrackerServiceVTab *vtab;
 	TrackerSparqlCursor *sparql_cursor;
+	TrackerSparqlStatement *statement;
+	gchar *statement_key;
 	GHashTable *parameter_columns;
 	gchar *service;
 	gchar *query;
+	GHashTable *results;
+	TrackerServiceResults *current;
+	gchar *current_key;
+	guint n_buffered_rows;
 	guint64 rowid;
-	guint silent   : 1;
-	guint finished : 1;
+	guint silent    : 1;
+	guint finished  : 1;
+	guint replaying : 1;
 } TrackerServiceCursor;
 
 typedef struct {
@@ -79,11 +125,44 @@ tracker_service_cursor_set_vtab_error (TrackerServiceCursor *cursor,
 	                                        cursor->service, message);
 }
 
+static ServicePrefetch *
+service_prefetch_ref (ServicePrefetch *prefetch)
+{
+	g_atomic_int_inc (&prefetch->ref_count);
+	return prefetch;
+}
+
+static void
+service_prefetch_unref (ServicePrefetch *prefetch)
+{
+	if (!g_atomic_int_dec_and_test (&prefetch->ref_count))
+		return;
+
+	g_clear_pointer (&prefetch->results, tracker_service_results_unref);
+	g_clear_object (&prefetch->sparql_cursor);
+	g_object_unref (prefetch->data_manager);
+	g_object_unref (prefetch->cancellable);
+	g_mutex_clear (&prefetch->mutex);
+	g_cond_clear (&prefetch->cond);
+	g_free (prefetch->service);
+	g_free (prefetch->query);
+	g_free (prefetch);
+}
+
+/* Prefetches not claimed by a scan are of no further use */
+static void
+service_prefetch_discard (ServicePrefetch *prefetch)
+{
+	g_cancellable_cancel (prefetch->cancellable);
+	service_prefetch_unref (prefetch);
+}
+
 static void
 tracker_service_module_free (gpointer data)
 {
 	TrackerServiceModule *module = data;
 
+	g_assert (module->current_prefetches == NULL);
 	g_free (module);
 }
 
@@ -102,9 +181,13 @@ tracker_service_cursor_free (gpointer data)
 	TrackerServiceCursor *cursor = data;
 
 	g_clear_pointer (&cursor->parameter_columns, g_hash_table_unref);
+	g_clear_pointer (&cursor->results, g_hash_table_unref);
 	g_free (cursor->service);
 	g_free (cursor->query);
+	g_free (cursor->statement_key);
+	g_free (cursor->current_key);
 	g_clear_object (&cursor->sparql_cursor);
+	g_clear_object (&cursor->statement);
 
 	g_free (cursor);
 }
@@ -217,6 +300,8 @@ service_open (sqlite3_vtab         *vtab_sqlite,
 
 	cursor = g_new0 (TrackerServiceCursor, 1);
 	cursor->vtab = vtab;
+	cursor->results = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+	                                         (GDestroyNotify) tracker_service_results_unref);
 
 	vtab->cursors = g_list_prepend (vtab->cursors, cursor);
 	*cursor_ret = (sqlite3_vtab_cursor *) cursor;
@@ -287,6 +372,373 @@ apply_statement_parameters (TrackerSparqlStatement *statement,
 	}
 }
 
+/* Returns TRUE if the caller gets to run the prefetch */
+static gboolean
+claim_prefetch (ServicePrefetch *prefetch)
+{
+	gboolean claimed;
+
+	g_mutex_lock (&prefetch->mutex);
+	claimed = !prefetch->started;
+	prefetch->started = TRUE;
+	g_mutex_unlock (&prefetch->mutex);
+
+	return claimed;
+}
+
+static void
+run_prefetch (ServicePrefetch *prefetch)
+{
+	TrackerServiceResults *results = NULL;
+	TrackerSparqlConnection *connection = NULL;
+	TrackerSparqlCursor *sparql_cursor = NULL;
+
+	if (!g_cancellable_is_cancelled (prefetch->cancellable)) {
+		connection = tracker_data_manager_get_remote_connection (prefetch->data_manager,
+		                                                         prefetch->service,
+		                                                         NULL);
+	}
+
+	if (connection) {
+		sparql_cursor = tracker_sparql_connection_query (connection,
+		                                                 prefetch->query,
+		                                                 prefetch->cancellable,
+		                                                 NULL);
+	}
+
+	if (sparql_cursor) {
+		GError *error = NULL;
+
+		results = tracker_service_results_new ();
+
+		while (results->n_rows < MAX_BUFFERED_ROWS &&
+		       tracker_sparql_cursor_next (sparql_cursor,
+		                                   prefetch->cancellable,
+		                                   &error))
+			tracker_service_results_append_row (results, sparql_cursor, N_VARIABLES);
+
+		if (error) {
+			/* Left to the virtual table to query again, and
+			 * handle errors as usual.
+			 */
+			g_clear_pointer (&results, tracker_service_results_unref);
+			g_clear_object (&sparql_cursor);
+			g_clear_error (&error);
+		} else if (results->n_rows < MAX_BUFFERED_ROWS) {
+			results->complete = TRUE;
+			g_clear_object (&sparql_cursor);
+		}
+	}
+
+	g_mutex_lock (&prefetch->mutex);
+	prefetch->results = results;
+	prefetch->sparql_cursor = sparql_cursor;
+	prefetch->done = TRUE;
+	g_cond_broadcast (&prefetch->cond);
+	g_mutex_unlock (&prefetch->mutex);
+}
+
+static void
+prefetch_pool_func (gpointer data,
+                    gpointer user_data)
+{
+	ServicePrefetch *prefetch = data;
+
+	if (claim_prefetch (prefetch))
+		run_prefetch (prefetch);
+
+	service_prefetch_unref (prefetch);
+}
+
+TrackerServicePrefetches *
+tracker_vtab_service_prefetch (TrackerServiceModule *module,
+                               GPtrArray            *service_queries)
+{
+	TrackerServicePrefetches *prefetches;
+	TrackerServiceCache *cache;
+	GHashTableIter iter;
+	ServicePrefetch *prefetch;
+	guint i;
+
+	prefetches = g_new0 (TrackerServicePrefetches, 1);
+	prefetches->module = module;
+	prefetches->prefetches =
+		g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+		                       (GDestroyNotify) service_prefetch_discard);
+
+	cache = tracker_data_manager_get_service_cache (module->data_manager);
+
+	for (i = 0; i + 1 < service_queries->len; i += 2) {
+		const gchar *service = g_ptr_array_index (service_queries, i);
+		const gchar *query = g_ptr_array_index (service_queries, i + 1);
+		gchar *key;
+
+		/* Mapped local connections are cheap to query */
+		if (g_str_has_prefix (service, "private:"))
+			continue;
+
+		key = g_strconcat (service, "\n", query, NULL);
+
+		if (g_hash_table_contains (prefetches->prefetches, key)) {
+			g_free (key);
+			continue;
+		}
+
+		if (cache) {
+			TrackerServiceResults *cached;
+
+			/* Already at hand for the virtual table */
+			cached = tracker_service_cache_lookup (cache, key);
+
+			if (cached) {
+				tracker_service_results_unref (cached);
+				g_free (key);
+				continue;
+			}
+		}
+
+		prefetch = g_new0 (ServicePrefetch, 1);
+		prefetch->ref_count = 1;
+		prefetch->data_manager = g_object_ref (module->data_manager);
+		prefetch->service = g_strdup (service);
+		prefetch->query = g_strdup (query);
+		prefetch->cancellable = g_cancellable_new ();
+		g_mutex_init (&prefetch->mutex);
+		g_cond_init (&prefetch->cond);
+		g_hash_table_insert (prefetches->prefetches, key, prefetch);
+	}
+
+	if (g_hash_table_size (prefetches->prefetches) == 0) {
+		g_hash_table_unref (prefetches->prefetches);
+		g_free (prefetches);
+		return NULL;
+	}
+
+	/* A thread per subquery, so the latency of the query is that
+	 * of the slowest service.
+	 */
+	prefetches->pool =
+		g_thread_pool_new (prefetch_pool_func, NULL,
+		                   MIN (g_hash_table_size (prefetches->prefetches),
+		                        MAX_PREFETCH_THREADS),
+		                   FALSE, NULL);
+
+	g_hash_table_iter_init (&iter, prefetches->prefetches);
+
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &prefetch)) {
+		g_thread_pool_push (prefetches->pool,
+		                    service_prefetch_ref (prefetch), NULL);
+	}
+
+	return prefetches;
+}
+
+void
+tracker_service_prefetches_free (TrackerServicePrefetches *prefetches)
+{
+	g_assert (prefetches->module->current_prefetches != prefetches);
+
+	/* Unclaimed prefetches are cancelled, so the pool is
+	 * done with them soon after.
+	 */
+	g_hash_table_unref (prefetches->prefetches);
+	g_thread_pool_free (prefetches->pool, FALSE, FALSE);
+	g_free (prefetches);
+}
+
+/* Sets the prefetches of the query cursor being stepped, virtual
+ * table scans only look into these.
+ */
+void
+tracker_vtab_service_set_current_prefetches (TrackerServiceModule     *module,
+                                             TrackerServicePrefetches *prefetches)
+{
+	module->current_prefetches = prefetches;
+}
+
+/* Waits for results being fetched ahead of time, if any. Results
+ * past the buffered row limit are returned incomplete, along with
+ * the cursor to stream the remaining rows from.
+ */
+static TrackerServiceResults *
+take_prefetched_results (TrackerServiceModule  *module,
+                         const gchar           *key,
+                         TrackerSparqlCursor  **sparql_cursor)
+{
+	TrackerServicePrefetches *prefetches = module->current_prefetches;
+	TrackerServiceResults *results = NULL;
+	ServicePrefetch *prefetch = NULL;
+	gpointer stolen_key;
+
+	if (!prefetches ||
+	    !g_hash_table_lookup_extended (prefetches->prefetches, key,
+	                                   &stolen_key, (gpointer *) &prefetch))
+		return NULL;
+
+	g_hash_table_steal (prefetches->prefetches, key);
+	g_free (stolen_key);
+
+	/* Not picked up by the thread pool yet, run it here
+	 * rather than waiting for a free thread.
+	 */
+	if (claim_prefetch (prefetch))
+		run_prefetch (prefetch);
+
+	g_mutex_lock (&prefetch->mutex);
+
+	while (!prefetch->done)
+		g_cond_wait (&prefetch->cond, &prefetch->mutex);
+
+	if (prefetch->results) {
+		results = tracker_service_results_ref (prefetch->results);
+		*sparql_cursor = g_steal_pointer (&prefetch->sparql_cursor);
+	}
+
+	g_mutex_unlock (&prefetch->mutex);
+
+	service_prefetch_unref (prefetch);
+
+	return results;
+}
+
+/* Identifies the service, query and parameter values of a scan */
+static gchar *
+create_results_key (TrackerServiceCursor *cursor)
+{
+	GString *str;
+	gint i;
+
+	str = g_string_new (cursor->service);
+	g_string_append_c (str, '\n');
+	g_string_append (str, cursor->query);
+
+	if (!cursor->parameter_columns)
+		return g_string_free (str, FALSE);
+
+	for (i = COL_FIRST_PARAMETER; i < COL_FIRST_VARIABLE; i++) {
+		sqlite3_value *value;
+
+		value = g_hash_table_lookup (cursor->parameter_columns,
+		                             GINT_TO_POINTER (i));
+		if (!value)
+			continue;
+
+		g_string_append_printf (str, "\n%d:%d:",
+		                        i, sqlite3_value_type (value));
+
+		if (sqlite3_value_type (value) != SQLITE_NULL)
+			g_string_append (str, sqlite3_value_text (value));
+	}
+
+	return g_string_free (str, FALSE);
+}
+
+static TrackerServiceCache *
+get_service_cache (TrackerServiceCursor *cursor)
+{
+	TrackerServiceModule *module = cursor->vtab->module;
+
+	/* Mapped local connections are cheap to query, and may change
+	 * anytime.
+	 */
+	if (g_str_has_prefix (cursor->service, "private:"))
+		return NULL;
+
+	return tracker_data_manager_get_service_cache (module->data_manager);
+}
+
+static void
+forget_results (TrackerServiceCursor *cursor,
+                const gchar          *key)
+{
+	TrackerServiceResults *results;
+
+	results = g_hash_table_lookup (cursor->results, key);
+	if (!results)
+		return;
+
+	cursor->n_buffered_rows -= results->n_rows;
+
+	if (cursor->current == results) {
+		cursor->current = NULL;
+		g_hash_table_remove (cursor->results, key);
+		g_clear_pointer (&cursor->current_key, g_free);
+	} else {
+		g_hash_table_remove (cursor->results, key);
+	}
+}
+
+static void
+record_current_row (TrackerServiceCursor *cursor)
+{
+	TrackerServiceResults *results = cursor->current;
+	TrackerServiceCache *cache;
+
+	if (!results || results->complete)
+		return;
+
+	if (cursor->finished) {
+		results->complete = TRUE;
+
+		cache = get_service_cache (cursor);
+		if (cache)
+			tracker_service_cache_insert (cache, cursor->current_key, results);
+		return;
+	}
+
+	if (cursor->n_buffered_rows >= MAX_BUFFERED_ROWS) {
+		/* Too large to keep around, stop buffering these results */
+		forget_results (cursor, cursor->current_key);
+		return;
+	}
+
+	tracker_service_results_append_row (results, cursor->sparql_cursor, N_VARIABLES);
+	cursor->n_buffered_rows++;
+}
+
+/* The prepared statement is reused across scans of the same
+ * service and query, only parameters are bound again.
+ */
+static TrackerSparqlStatement *
+ensure_statement (TrackerServiceCursor  *cursor,
+                  GError               **error)
+{
+	TrackerServiceModule *module = cursor->vtab->module;
+	TrackerSparqlConnection *connection;
+	gchar *key;
+
+	key = g_strconcat (cursor->service, "\n", cursor->query, NULL);
+
+	if (cursor->statement && g_strcmp0 (cursor->statement_key, key) == 0) {
+		g_free (key);
+		return cursor->statement;
+	}
+
+	g_clear_object (&cursor->statement);
+	g_clear_pointer (&cursor->statement_key, g_free);
+
+	connection = tracker_data_manager_get_remote_connection (module->data_manager,
+	                                                         cursor->service,
+	                                                         error);
+	if (!connection) {
+		g_free (key);
+		return NULL;
+	}
+
+	cursor->statement =
+		tracker_sparql_connection_query_statement (connection,
+		                                           cursor->query,
+		                                           NULL, error);
+	if (!cursor->statement) {
+		g_free (key);
+		return NULL;
+	}
+
+	cursor->statement_key = key;
+
+	return cursor->statement;
+}
+
 static int
 service_filter (sqlite3_vtab_cursor  *vtab_cursor,
 		int                   idx,
@@ -296,17 +748,27 @@ service_filter (sqlite3_vtab_cursor  *vtab_cursor,
 {
 	TrackerServiceCursor *cursor = (TrackerServiceCursor *) vtab_cursor;
 	const ConstraintData *constraints = (const ConstraintData *) idx_str;
-	TrackerServiceVTab *vtab = cursor->vtab;
-	TrackerServiceModule *module = vtab->module;
-	TrackerSparqlConnection *connection;
 	TrackerSparqlStatement *statement;
+	TrackerSparqlCursor *sparql_cursor = NULL;
+	TrackerServiceResults *results;
+	TrackerServiceCache *cache;
 	GHashTable *names = NULL, *values = NULL;
+	gchar *results_key;
 	GError *error = NULL;
 	gboolean empty_query = FALSE;
 	gint i;
 
 	cursor->finished = FALSE;
+	cursor->replaying = FALSE;
+	cursor->current = NULL;
 	cursor->rowid = 0;
+	g_clear_pointer (&cursor->current_key, g_free);
+	g_clear_object (&cursor->sparql_cursor);
+	g_clear_pointer (&cursor->service, g_free);
+	g_clear_pointer (&cursor->query, g_free);
+
+	if (cursor->parameter_columns)
+		g_hash_table_remove_all (cursor->parameter_columns);
 
 	for (i = 0; i < argc; i++) {
 		if (constraints[i].column == COL_SERVICE) {
@@ -368,26 +830,85 @@ service_filter (sqlite3_vtab_cursor  *vtab_cursor,
 		return SQLITE_OK;
 	}
 
-	connection = tracker_data_manager_get_remote_connection (module->data_manager,
-	                                                         cursor->service,
-	                                                         &error);
-	if (!connection)
-		goto fail;
+	results_key = create_results_key (cursor);
+	results = g_hash_table_lookup (cursor->results, results_key);
+	cache = get_service_cache (cursor);
 
-	statement = tracker_sparql_connection_query_statement (connection,
-	                                                       cursor->query,
-	                                                       NULL, &error);
-	if (error)
+	if (!results) {
+		results = take_prefetched_results (cursor->vtab->module, results_key,
+		                                   &sparql_cursor);
+
+		if (results) {
+			g_hash_table_insert (cursor->results,
+			                     g_strdup (results_key), results);
+			cursor->n_buffered_rows += results->n_rows;
+
+			if (cache && results->complete)
+				tracker_service_cache_insert (cache, results_key, results);
+		}
+	}
+
+	if (sparql_cursor) {
+		/* Replay the rows fetched ahead of time, then stream the rest */
+		g_clear_pointer (&names, g_hash_table_unref);
+		g_clear_pointer (&values, g_hash_table_unref);
+		cursor->sparql_cursor = sparql_cursor;
+		cursor->current = results;
+		cursor->current_key = results_key;
+		cursor->replaying = TRUE;
+		return SQLITE_OK;
+	}
+
+	if (!results && cache) {
+		results = tracker_service_cache_lookup (cache, results_key);
+
+		if (results) {
+			g_hash_table_insert (cursor->results,
+			                     g_strdup (results_key), results);
+			cursor->n_buffered_rows += results->n_rows;
+		}
+	}
+
+	if (results && results->complete) {
+		/* Same arguments as a previous scan, replay the results */
+		g_free (results_key);
+		g_clear_pointer (&names, g_hash_table_unref);
+		g_clear_pointer (&values, g_hash_table_unref);
+		cursor->current = results;
+		cursor->replaying = TRUE;
+		cursor->finished = results->n_rows == 0;
+		return SQLITE_OK;
+	}
+
+	if (results) {
+		/* A previous scan did not run to completion */
+		forget_results (cursor, results_key);
+	}
+
+	statement = ensure_statement (cursor, &error);
+	if (!statement) {
+		g_free (results_key);
 		goto fail;
+	}
 
+	tracker_sparql_statement_clear_bindings (statement);
 	apply_statement_parameters (statement, names, values);
 	cursor->sparql_cursor = tracker_sparql_statement_execute (statement,
 	                                                          NULL,
 	                                                          &error);
-	g_object_unref (statement);
-
-	if (error)
+	if (error) {
+		g_free (results_key);
 		goto fail;
+	}
+
+	if (cursor->n_buffered_rows < MAX_BUFFERED_ROWS) {
+		/* Results are recorded while being streamed */
+		cursor->current = tracker_service_results_new ();
+		cursor->current_key = g_strdup (results_key);
+		g_hash_table_insert (cursor->results, results_key, cursor->current);
+	} else {
+		g_free (results_key);
+	}
 
 	cursor->finished =
 		!tracker_sparql_cursor_next (cursor->sparql_cursor, NULL, &error);
@@ -395,6 +916,8 @@ service_filter (sqlite3_vtab_cursor  *vtab_cursor,
 	if (error)
 		goto fail;
 
+	record_current_row (cursor);
+
 	g_clear_pointer (&names, g_hash_table_unref);
 	g_clear_pointer (&values, g_hash_table_unref);
 
@@ -420,11 +943,33 @@ service_next (sqlite3_vtab_cursor *vtab_cursor)
 {
 	TrackerServiceCursor *cursor = (TrackerServiceCursor *) vtab_cursor;
 
+	if (cursor->replaying) {
+		cursor->rowid++;
+
+		if (cursor->rowid < cursor->current->n_rows)
+			return SQLITE_OK;
+
+		if (!cursor->sparql_cursor) {
+			cursor->finished = TRUE;
+			return SQLITE_OK;
+		}
+
+		/* Prefetched rows are over, these results are too
+		 * large to keep around.
+		 */
+		cursor->replaying = FALSE;
+		forget_results (cursor, cursor->current_key);
+		cursor->finished =
+			!tracker_sparql_cursor_next (cursor->sparql_cursor, NULL, NULL);
+		return SQLITE_OK;
+	}
+
 	if (!cursor->sparql_cursor)
 		return SQLITE_ERROR;
 
 	cursor->finished =
 		!tracker_sparql_cursor_next (cursor->sparql_cursor, NULL, NULL);
+	record_current_row (cursor);
 
 	cursor->rowid++;
 	return SQLITE_OK;
@@ -476,6 +1021,41 @@ cursor_column_to_result (TrackerSparqlCursor *cursor,
 	}
 }
 
+static void
+buffered_column_to_result (TrackerServiceResults *results,
+                           guint64                row,
+                           gint                   column,
+                           sqlite3_context       *context)
+{
+	const TrackerServiceValue *value;
+
+	value = tracker_service_results_get_value (results, row, column);
+
+	if (!value) {
+		sqlite3_result_null (context);
+		return;
+	}
+
+	switch (value->type) {
+	case TRACKER_SPARQL_VALUE_TYPE_URI:
+	case TRACKER_SPARQL_VALUE_TYPE_STRING:
+	case TRACKER_SPARQL_VALUE_TYPE_DATETIME:
+	case TRACKER_SPARQL_VALUE_TYPE_BLANK_NODE:
+		sqlite3_result_text (context, value->data.str, -1, SQLITE_TRANSIENT);
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_INTEGER:
+	case TRACKER_SPARQL_VALUE_TYPE_BOOLEAN:
+		sqlite3_result_int64 (context, value->data.integer);
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_DOUBLE:
+		sqlite3_result_double (context, value->data.number);
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_UNBOUND:
+	default:
+		sqlite3_result_null (context);
+	}
+}
+
 static int
 service_column (sqlite3_vtab_cursor *vtab_cursor,
 		sqlite3_context     *context,
@@ -503,9 +1083,16 @@ service_column (sqlite3_vtab_cursor *vtab_cursor,
 			sqlite3_result_null (context);
 	} else if (n_col >= COL_FIRST_VARIABLE &&
 	           n_col < COL_FIRST_VARIABLE + N_VARIABLES) {
-		cursor_column_to_result (cursor->sparql_cursor,
-		                         n_col - COL_FIRST_VARIABLE,
-		                         context);
+		if (cursor->replaying) {
+			buffered_column_to_result (cursor->current,
+			                           cursor->rowid,
+			                           n_col - COL_FIRST_VARIABLE,
+			                           context);
+		} else {
+			cursor_column_to_result (cursor->sparql_cursor,
+			                         n_col - COL_FIRST_VARIABLE,
+			                         context);
+		}
 	} else {
 		sqlite3_result_null (context);
 	}
@@ -523,7 +1110,7 @@ service_rowid (sqlite3_vtab_cursor *vtab_cursor,
 	return SQLITE_OK;
 }
 
-void
+TrackerServiceModule *
 tracker_vtab_service_init (sqlite3            *db,
                            TrackerDataManager *data_manager)
 {
@@ -559,4 +1146,6 @@ tracker_vtab_service_init (sqlite3            *db,
 	module->data_manager = data_manager;
 	sqlite3_create_module_v2 (db, "tracker_service", &service_module,
 	                          module, tracker_service_module_free);
+
+	return module;
 }
@@ -24,5 +24,16 @@
 #include <sqlite3.h>
 #include "tracker-data-manager.h"
 
-void tracker_vtab_service_init (sqlite3            *db,
-                                TrackerDataManager *data_manager);
+typedef struct _TrackerServiceModule TrackerServiceModule;
+typedef struct _TrackerServicePrefetches TrackerServicePrefetches;
+
+TrackerServiceModule * tracker_vtab_service_init (sqlite3            *db,
+                                                  TrackerDataManager *data_manager);
+
+TrackerServicePrefetches * tracker_vtab_service_prefetch (TrackerServiceModule *module,
+                                                          GPtrArray            *service_queries);
+
+void tracker_service_prefetches_free (TrackerServicePrefetches *prefetches);
+
+void tracker_vtab_service_set_current_prefetches (TrackerServiceModule     *module,
+                                                  TrackerServicePrefetches *prefetches);
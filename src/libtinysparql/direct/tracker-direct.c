@@ -32,6 +32,21 @@
 #include "tracker-private.h"
 #include "tracker-serializer.h"
 
+#define N_SELECT_THREADS 16
+
+/* Readers are affine to threads, leave room for as many
+ * threads running queries synchronously as there are in
+ * the select pool.
+ */
+#define MAX_READERS (2 * N_SELECT_THREADS)
+
+/* Queries known to take longer than this run in a separate
+ * lane, with less threads, so they do not delay the rest.
+ */
+#define N_LONG_QUERY_THREADS 4
+#define QUERY_TIME_SLICE (100 * G_TIME_SPAN_MILLISECOND)
+#define MAX_QUERY_COSTS 1000
+
 typedef struct _TrackerDirectConnectionPrivate TrackerDirectConnectionPrivate;
 
 struct _TrackerDirectConnectionPrivate
@@ -47,6 +62,13 @@ struct _TrackerDirectConnectionPrivate
 
 	GThreadPool *update_thread; /* Contains 1 exclusive thread */
 	GThreadPool *select_pool;
+	GThreadPool *long_query_pool;
+
+	/* Query string -> QueryCost, least recently updated first */
+	GHashTable *query_costs;
+	GQueue query_costs_lru;
+	guint64 last_query_seq;
+	GMutex query_costs_mutex;
 
 	GList *notifiers;
 	GMutex notifiers_mutex;
@@ -61,6 +83,19 @@ struct _TrackerDirectConnectionPrivate
 	guint closing     : 1;
 };
 
+typedef struct {
+	gchar *query;
+	gint64 cost;
+	GList link;
+} QueryCost;
+
+/* Reports the cost of a cursor once it is closed */
+typedef struct {
+	GWeakRef conn;
+	gchar *query;
+	gint64 prepare_time;
+} CursorCostData;
+
 typedef enum {
 	TASK_TYPE_QUERY,
 	TASK_TYPE_QUERY_STATEMENT,
@@ -77,6 +112,8 @@ typedef enum {
 
 typedef struct {
 	TaskType type;
+	gint64 expected_cost;
+	guint64 seq;
 
 	union {
 		gchar *sparql;
@@ -269,6 +306,10 @@ convert_format (TrackerRdfFormat format)
 		return TRACKER_SERIALIZER_FORMAT_TRIG;
 	case TRACKER_RDF_FORMAT_JSON_LD:
 		return TRACKER_SERIALIZER_FORMAT_JSON_LD;
+	case TRACKER_RDF_FORMAT_N_TRIPLES:
+		return TRACKER_SERIALIZER_FORMAT_NTRIPLES;
+	case TRACKER_RDF_FORMAT_N_QUADS:
+		return TRACKER_SERIALIZER_FORMAT_NQUADS;
 	default:
 		g_assert_not_reached ();
 	}
@@ -374,9 +415,172 @@ update_thread_func (gpointer data,
 	g_mutex_unlock (&priv->update_mutex);
 }
 
+static const gchar *
+task_data_get_query (TaskData *task_data)
+{
+	switch (task_data->type) {
+	case TASK_TYPE_QUERY:
+		return task_data->d.sparql;
+	case TASK_TYPE_QUERY_STATEMENT:
+		return tracker_sparql_statement_get_sparql (task_data->d.statement.stmt);
+	case TASK_TYPE_SERIALIZE:
+		return task_data->d.serialize.sparql;
+	case TASK_TYPE_SERIALIZE_STATEMENT:
+		return tracker_sparql_statement_get_sparql (task_data->d.serialize_statement.stmt);
+	default:
+		return NULL;
+	}
+}
+
+static void
+query_cost_free (QueryCost *query_cost)
+{
+	g_free (query_cost->query);
+	g_free (query_cost);
+}
+
+static void
+record_query_cost (TrackerDirectConnection *conn,
+                   const gchar             *query,
+                   gint64                   cost)
+{
+	TrackerDirectConnectionPrivate *priv;
+	QueryCost *query_cost;
+
+	priv = tracker_direct_connection_get_instance_private (conn);
+
+	g_mutex_lock (&priv->query_costs_mutex);
+
+	query_cost = g_hash_table_lookup (priv->query_costs, query);
+
+	if (query_cost) {
+		/* Average with prior runs, so queries get promoted back if they get faster */
+		query_cost->cost = (cost + query_cost->cost) / 2;
+		g_queue_unlink (&priv->query_costs_lru, &query_cost->link);
+	} else {
+		/* Evict the least recently updated query */
+		if (g_hash_table_size (priv->query_costs) >= MAX_QUERY_COSTS) {
+			QueryCost *oldest;
+
+			oldest = g_queue_pop_head_link (&priv->query_costs_lru)->data;
+			g_hash_table_remove (priv->query_costs, oldest->query);
+		}
+
+		query_cost = g_new0 (QueryCost, 1);
+		query_cost->query = g_strdup (query);
+		query_cost->cost = cost;
+		query_cost->link.data = query_cost;
+		g_hash_table_insert (priv->query_costs, query_cost->query, query_cost);
+	}
+
+	g_queue_push_tail_link (&priv->query_costs_lru, &query_cost->link);
+
+	g_mutex_unlock (&priv->query_costs_mutex);
+}
+
+static gint64
+lookup_query_cost (TrackerDirectConnection *conn,
+                   const gchar             *query)
+{
+	TrackerDirectConnectionPrivate *priv;
+	QueryCost *query_cost;
+	gint64 cost = 0;
+
+	priv = tracker_direct_connection_get_instance_private (conn);
+
+	g_mutex_lock (&priv->query_costs_mutex);
+
+	query_cost = g_hash_table_lookup (priv->query_costs, query);
+	if (query_cost)
+		cost = query_cost->cost;
+
+	g_mutex_unlock (&priv->query_costs_mutex);
+
+	return cost;
+}
+
+static void
+cursor_cost_data_free (CursorCostData *data)
+{
+	g_weak_ref_clear (&data->conn);
+	g_free (data->query);
+	g_free (data);
+}
+
+static void
+cursor_cost_cb (gint64   step_time,
+                gpointer user_data)
+{
+	CursorCostData *data = user_data;
+	TrackerDirectConnection *conn;
+
+	conn = g_weak_ref_get (&data->conn);
+	if (!conn)
+		return;
+
+	record_query_cost (conn, data->query, data->prepare_time + step_time);
+	g_object_unref (conn);
+}
+
+/* Cursors are lazy, rows are stepped by the caller after the task
+ * returned. The cost of the query is recorded once the cursor is
+ * closed, adding the time spent in the select pool and stepping.
+ */
+static void
+track_cursor_cost (TrackerDirectConnection *conn,
+                   TaskData                *task_data,
+                   TrackerSparqlCursor     *cursor,
+                   gint64                   start_time)
+{
+	CursorCostData *data;
+	const gchar *query;
+
+	query = task_data_get_query (task_data);
+	if (!query || !TRACKER_IS_DB_CURSOR (cursor))
+		return;
+
+	data = g_new0 (CursorCostData, 1);
+	g_weak_ref_init (&data->conn, conn);
+	data->query = g_strdup (query);
+	data->prepare_time = g_get_monotonic_time () - start_time;
+
+	tracker_db_cursor_set_cost_func (TRACKER_DB_CURSOR (cursor),
+	                                 cursor_cost_cb, data,
+	                                 (GDestroyNotify) cursor_cost_data_free);
+}
+
+gboolean
+tracker_direct_connection_is_long_query (TrackerDirectConnection *conn,
+                                         const gchar             *sparql)
+{
+	return lookup_query_cost (conn, sparql) >= QUERY_TIME_SLICE;
+}
+
+/* Whether the results of a query only depend on the database contents */
+gboolean
+tracker_direct_connection_is_deterministic_query (TrackerDirectConnection *conn,
+                                                  const gchar             *sparql)
+{
+	TrackerDirectConnectionPrivate *priv;
+	TrackerSparql *query;
+	gboolean deterministic;
+
+	priv = tracker_direct_connection_get_instance_private (conn);
+
+	query = tracker_sparql_new (priv->data_manager, sparql, NULL);
+	if (!query)
+		return FALSE;
+
+	deterministic = tracker_sparql_is_deterministic (query);
+	g_object_unref (query);
+
+	return deterministic;
+}
+
 static void
 execute_query_in_thread (GTask    *task,
-                         TaskData *task_data)
+                         TaskData *task_data,
+                         gint64    start_time)
 {
 	TrackerSparqlConnection *conn;
 	TrackerSparqlCursor *cursor;
@@ -404,6 +608,8 @@ execute_query_in_thread (GTask    *task,
 	}
 
 	if (cursor) {
+		track_cursor_cost (TRACKER_DIRECT_CONNECTION (conn), task_data,
+		                   cursor, start_time);
 		tracker_direct_connection_update_timestamp (TRACKER_DIRECT_CONNECTION (conn));
 		g_task_return_pointer (task, cursor, g_object_unref);
 	} else {
@@ -413,7 +619,8 @@ execute_query_in_thread (GTask    *task,
 
 static void
 serialize_in_thread (GTask    *task,
-                     TaskData *task_data)
+                     TaskData *task_data,
+                     gint64    start_time)
 {
 	TrackerDirectConnectionPrivate *priv;
 	TrackerDirectConnection *conn;
@@ -458,6 +665,7 @@ serialize_in_thread (GTask    *task,
 	if (!cursor)
 		goto out;
 
+	track_cursor_cost (conn, task_data, cursor, start_time);
 	tracker_direct_connection_update_timestamp (conn);
 	tracker_sparql_cursor_set_connection (cursor, TRACKER_SPARQL_CONNECTION (conn));
 	namespaces = tracker_sparql_connection_get_namespace_manager (TRACKER_SPARQL_CONNECTION (conn));
@@ -473,6 +681,53 @@ serialize_in_thread (GTask    *task,
 		g_task_return_error (task, error);
 }
 
+/* Runs higher priority tasks first, then the ones expected
+ * to be fastest, then in the order they were pushed.
+ */
+static gint
+compare_query_tasks (gconstpointer a,
+                     gconstpointer b,
+                     gpointer      user_data)
+{
+	GTask *task_a = (GTask *) a, *task_b = (GTask *) b;
+	TaskData *data_a = g_task_get_task_data (task_a);
+	TaskData *data_b = g_task_get_task_data (task_b);
+
+	if (g_task_get_priority (task_a) != g_task_get_priority (task_b))
+		return g_task_get_priority (task_a) < g_task_get_priority (task_b) ? -1 : 1;
+	if (data_a->expected_cost != data_b->expected_cost)
+		return data_a->expected_cost < data_b->expected_cost ? -1 : 1;
+	if (data_a->seq != data_b->seq)
+		return data_a->seq < data_b->seq ? -1 : 1;
+
+	return 0;
+}
+
+static gboolean
+push_query_task (TrackerDirectConnection  *conn,
+                 GTask                    *task,
+                 GError                  **error)
+{
+	TrackerDirectConnectionPrivate *priv;
+	TaskData *task_data = g_task_get_task_data (task);
+	const gchar *query;
+
+	priv = tracker_direct_connection_get_instance_private (conn);
+	query = task_data_get_query (task_data);
+
+	task_data->expected_cost = query ? lookup_query_cost (conn, query) : 0;
+
+	g_mutex_lock (&priv->query_costs_mutex);
+	task_data->seq = priv->last_query_seq++;
+	g_mutex_unlock (&priv->query_costs_mutex);
+
+	if (task_data->expected_cost >= QUERY_TIME_SLICE ||
+	    g_task_get_priority (task) > G_PRIORITY_DEFAULT)
+		return g_thread_pool_push (priv->long_query_pool, task, error);
+	else
+		return g_thread_pool_push (priv->select_pool, task, error);
+}
+
 static void
 query_thread_pool_func (gpointer data,
                         gpointer user_data)
@@ -481,6 +736,7 @@ query_thread_pool_func (gpointer data,
 	TrackerDirectConnectionPrivate *priv;
 	GTask *task = data;
 	TaskData *task_data = g_task_get_task_data (task);
+	gint64 start_time;
 
 	priv = tracker_direct_connection_get_instance_private (conn);
 
@@ -493,14 +749,16 @@ query_thread_pool_func (gpointer data,
 		return;
 	}
 
+	start_time = g_get_monotonic_time ();
+
 	switch (task_data->type) {
 	case TASK_TYPE_QUERY:
 	case TASK_TYPE_QUERY_STATEMENT:
-		execute_query_in_thread (task, task_data);
+		execute_query_in_thread (task, task_data, start_time);
 		break;
 	case TASK_TYPE_SERIALIZE:
 	case TASK_TYPE_SERIALIZE_STATEMENT:
-		serialize_in_thread (task, task_data);
+		serialize_in_thread (task, task_data, start_time);
 		break;
 	default:
 		g_assert_not_reached ();
@@ -518,10 +776,22 @@ set_up_thread_pools (TrackerDirectConnection  *conn,
 	priv = tracker_direct_connection_get_instance_private (conn);
 
 	priv->select_pool = g_thread_pool_new (query_thread_pool_func,
-	                                       conn, 16, FALSE, error);
+	                                       conn, N_SELECT_THREADS, FALSE, error);
 	if (!priv->select_pool)
 		return FALSE;
 
+	g_thread_pool_set_sort_function (priv->select_pool,
+	                                 compare_query_tasks, NULL);
+
+	priv->long_query_pool = g_thread_pool_new (query_thread_pool_func,
+	                                           conn, N_LONG_QUERY_THREADS,
+	                                           FALSE, error);
+	if (!priv->long_query_pool)
+		return FALSE;
+
+	g_thread_pool_set_sort_function (priv->long_query_pool,
+	                                 compare_query_tasks, NULL);
+
 	priv->update_thread = g_thread_pool_new (update_thread_func,
 	                                         conn, 1, TRUE, error);
 	if (!priv->update_thread)
@@ -545,8 +815,12 @@ translate_flags (TrackerSparqlConnectionFlags flags)
 		db_flags |= TRACKER_DB_MANAGER_FTS_ENABLE_STOP_WORDS;
 	if ((flags & TRACKER_SPARQL_CONNECTION_FLAGS_FTS_IGNORE_NUMBERS) != 0)
 		db_flags |= TRACKER_DB_MANAGER_FTS_IGNORE_NUMBERS;
+	if ((flags & TRACKER_SPARQL_CONNECTION_FLAGS_FTS_ENABLE_PREFIX_INDEX) != 0)
+		db_flags |= TRACKER_DB_MANAGER_FTS_ENABLE_PREFIX_INDEX;
 	if ((flags & TRACKER_SPARQL_CONNECTION_FLAGS_ANONYMOUS_BNODES) != 0)
 		db_flags |= TRACKER_DB_MANAGER_ANONYMOUS_BNODES;
+	if ((flags & TRACKER_SPARQL_CONNECTION_FLAGS_CACHE_SERVICE_RESULTS) != 0)
+		db_flags |= TRACKER_DB_MANAGER_CACHE_SERVICE_RESULTS;
 
 	/* This flag is inverted */
 	if ((flags & TRACKER_SPARQL_CONNECTION_FLAGS_DISABLE_SYNTAX_EXTENSIONS) == 0)
@@ -608,6 +882,12 @@ tracker_direct_connection_initable_init (GInitable     *initable,
 		case TRACKER_RDF_FORMAT_JSON_LD:
 			format = TRACKER_SERIALIZER_FORMAT_JSON_LD;
 			break;
+		case TRACKER_RDF_FORMAT_N_TRIPLES:
+			format = TRACKER_SERIALIZER_FORMAT_NTRIPLES;
+			break;
+		case TRACKER_RDF_FORMAT_N_QUADS:
+			format = TRACKER_SERIALIZER_FORMAT_NQUADS;
+			break;
 		default:
 			g_assert_not_reached ();
 			break;
@@ -627,6 +907,9 @@ tracker_direct_connection_initable_init (GInitable     *initable,
 		return FALSE;
 	}
 
+	tracker_db_manager_set_max_interfaces (tracker_data_manager_get_db_manager (priv->data_manager),
+	                                       MAX_READERS);
+
 	/* Initialize namespace manager */
 	priv->namespace_manager = tracker_namespace_manager_new ();
 	namespaces = tracker_data_manager_get_namespaces (priv->data_manager);
@@ -704,6 +987,9 @@ tracker_direct_connection_init (TrackerDirectConnection *conn)
 
 	g_mutex_init (&priv->update_mutex);
 	g_mutex_init (&priv->notifiers_mutex);
+	g_mutex_init (&priv->query_costs_mutex);
+	priv->query_costs = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                           NULL, (GDestroyNotify) query_cost_free);
 }
 
 static GHashTable *
@@ -765,9 +1051,11 @@ statement_cb (TrackerDataUpdateType  type,
 	TrackerProperty *rdf_type = tracker_ontologies_get_rdf_type (ontologies);
 	TrackerNotifierEventCache *cache;
 	TrackerClass *rdf_type_class = NULL;
+	const gchar *property_uri;
 	guint i;
 
 	cache = lookup_event_cache (notifier, graph);
+	property_uri = tracker_ontologies_get_uri_by_id (ontologies, predicate_id);
 
 	if (predicate_id == tracker_property_get_id (rdf_type)) {
 		const gchar *uri;
@@ -792,7 +1080,9 @@ statement_cb (TrackerDataUpdateType  type,
 			event_type = TRACKER_NOTIFIER_EVENT_UPDATE;
 		}
 
-		_tracker_notifier_event_cache_push_event (cache, subject_id, event_type);
+		_tracker_notifier_event_cache_push_event_full (cache, subject_id, event_type,
+		                                               tracker_class_get_uri (class),
+		                                               property_uri);
 	}
 }
 
@@ -871,6 +1161,8 @@ tracker_direct_connection_finalize (GObject *object)
 	g_clear_object (&priv->ontology_rdf);
 	g_mutex_clear (&priv->update_mutex);
 	g_mutex_clear (&priv->notifiers_mutex);
+	g_mutex_clear (&priv->query_costs_mutex);
+	g_hash_table_unref (priv->query_costs);
 
 	G_OBJECT_CLASS (tracker_direct_connection_parent_class)->finalize (object);
 }
@@ -988,7 +1280,7 @@ tracker_direct_connection_query_async (TrackerSparqlConnection *self,
 	g_task_set_task_data (task, task_data,
 	                      (GDestroyNotify) task_data_free);
 
-	if (!g_thread_pool_push (priv->select_pool, task, &error)) {
+	if (!push_query_task (conn, task, &error)) {
 		g_task_return_error (task, _translate_internal_error (error));
 		g_object_unref (task);
 	}
@@ -1270,6 +1562,11 @@ tracker_direct_connection_close (TrackerSparqlConnection *self)
 		priv->select_pool = NULL;
 	}
 
+	if (priv->long_query_pool) {
+		g_thread_pool_free (priv->long_query_pool, TRUE, TRUE);
+		priv->long_query_pool = NULL;
+	}
+
 	g_mutex_lock (&priv->notifiers_mutex);
 
 	while (priv->notifiers) {
@@ -1469,7 +1766,7 @@ tracker_direct_connection_serialize_async (TrackerSparqlConnection  *self,
 	g_task_set_task_data (task, task_data,
 	                      (GDestroyNotify) task_data_free);
 
-	if (!g_thread_pool_push (priv->select_pool, task, &error)) {
+	if (!push_query_task (conn, task, &error)) {
 		g_task_return_error (task, _translate_internal_error (error));
 		g_object_unref (task);
 	}
@@ -1538,6 +1835,25 @@ tracker_direct_connection_map_connection (TrackerSparqlConnection *connection,
 	                                     service_connection);
 }
 
+static void
+tracker_direct_connection_set_service_cache_limits (TrackerSparqlConnection *connection,
+                                                    guint                    max_age,
+                                                    gsize                    max_size)
+{
+	TrackerDirectConnectionPrivate *priv;
+	TrackerServiceCache *cache;
+
+	priv = tracker_direct_connection_get_instance_private (TRACKER_DIRECT_CONNECTION (connection));
+
+	cache = tracker_data_manager_get_service_cache (priv->data_manager);
+	if (!cache)
+		return;
+
+	tracker_service_cache_set_limits (cache,
+	                                  (gint64) max_age * G_USEC_PER_SEC,
+	                                  max_size);
+}
+
 static void
 tracker_direct_connection_class_init (TrackerDirectConnectionClass *klass)
 {
@@ -1579,6 +1895,7 @@ tracker_direct_connection_class_init (TrackerDirectConnectionClass *klass)
 	sparql_connection_class->deserialize_async = tracker_direct_connection_deserialize_async;
 	sparql_connection_class->deserialize_finish = tracker_direct_connection_deserialize_finish;
 	sparql_connection_class->map_connection = tracker_direct_connection_map_connection;
+	sparql_connection_class->set_service_cache_limits = tracker_direct_connection_set_service_cache_limits;
 
 	props[PROP_FLAGS] =
 		g_param_spec_flags ("flags",
@@ -1725,6 +2042,25 @@ tracker_direct_connection_get_data_manager (TrackerDirectConnection *conn)
 	return priv->data_manager;
 }
 
+gboolean
+tracker_direct_connection_get_modification_count (TrackerDirectConnection *conn,
+                                                  guint64                 *count)
+{
+	TrackerDirectConnectionPrivate *priv;
+
+	priv = tracker_direct_connection_get_instance_private (conn);
+
+	/* Readonly connections may be looking at a database that
+	 * is modified by another process.
+	 */
+	if ((priv->flags & TRACKER_SPARQL_CONNECTION_FLAGS_READONLY) != 0 ||
+	    !priv->data_manager)
+		return FALSE;
+
+	*count = tracker_data_manager_get_modification_count (priv->data_manager);
+	return TRUE;
+}
+
 void
 tracker_direct_connection_update_timestamp (TrackerDirectConnection *conn)
 {
@@ -1856,7 +2192,7 @@ tracker_direct_connection_execute_query_statement_async (TrackerDirectConnection
 	g_task_set_task_data (task, task_data,
 	                      (GDestroyNotify) task_data_free);
 
-	if (!g_thread_pool_push (priv->select_pool, task, &error)) {
+	if (!push_query_task (conn, task, &error)) {
 		g_task_return_error (task, _translate_internal_error (error));
 		g_object_unref (task);
 	}
@@ -1897,7 +2233,7 @@ tracker_direct_connection_execute_serialize_statement_async (TrackerDirectConnec
 	g_task_set_task_data (task, task_data,
 	                      (GDestroyNotify) task_data_free);
 
-	if (!g_thread_pool_push (priv->select_pool, task, &error)) {
+	if (!push_query_task (conn, task, &error)) {
 		g_task_return_error (task, _translate_internal_error (error));
 		g_object_unref (task);
 	}
@@ -81,8 +81,17 @@ TrackerSparqlConnection * tracker_direct_connection_new_from_rdf_finish (GAsyncR
 
 TrackerDataManager *tracker_direct_connection_get_data_manager (TrackerDirectConnection *conn);
 
+gboolean tracker_direct_connection_get_modification_count (TrackerDirectConnection *conn,
+                                                           guint64                 *count);
+
 void tracker_direct_connection_update_timestamp (TrackerDirectConnection *conn);
 
+gboolean tracker_direct_connection_is_long_query (TrackerDirectConnection *conn,
+                                                  const gchar             *sparql);
+
+gboolean tracker_direct_connection_is_deterministic_query (TrackerDirectConnection *conn,
+                                                           const gchar             *sparql);
+
 /* Internal helper functions */
 GError *translate_db_interface_error (GError *error);
 
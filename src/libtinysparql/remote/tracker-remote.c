@@ -122,7 +122,8 @@ tracker_remote_connection_query (TrackerSparqlConnection  *connection,
 	GInputStream *stream;
 	guint formats =
 		(1 << TRACKER_SERIALIZER_FORMAT_JSON) |
-		(1 << TRACKER_SERIALIZER_FORMAT_XML);
+		(1 << TRACKER_SERIALIZER_FORMAT_XML) |
+		(1 << TRACKER_SERIALIZER_FORMAT_BINARY);
 
 	stream = tracker_http_client_send_message (priv->client,
 						   priv->base_uri,
@@ -180,7 +181,8 @@ tracker_remote_connection_query_async (TrackerSparqlConnection *connection,
 	GTask *task;
 	guint flags =
 		(1 << TRACKER_SERIALIZER_FORMAT_JSON) |
-		(1 << TRACKER_SERIALIZER_FORMAT_XML);
+		(1 << TRACKER_SERIALIZER_FORMAT_XML) |
+		(1 << TRACKER_SERIALIZER_FORMAT_BINARY);
 
 	task = g_task_new (connection, cancellable, callback, user_data);
 	tracker_http_client_send_message_async (priv->client,
@@ -277,6 +279,10 @@ tracker_remote_connection_serialize_async (TrackerSparqlConnection  *connection,
 		formats = 1 << TRACKER_SERIALIZER_FORMAT_TRIG;
 	else if (format == TRACKER_RDF_FORMAT_JSON_LD)
 		formats = 1 << TRACKER_SERIALIZER_FORMAT_JSON_LD;
+	else if (format == TRACKER_RDF_FORMAT_N_TRIPLES)
+		formats = 1 << TRACKER_SERIALIZER_FORMAT_NTRIPLES;
+	else if (format == TRACKER_RDF_FORMAT_N_QUADS)
+		formats = 1 << TRACKER_SERIALIZER_FORMAT_NQUADS;
 
 	task = g_task_new (connection, cancellable, callback, user_data);
 	tracker_http_client_send_message_async (priv->client,
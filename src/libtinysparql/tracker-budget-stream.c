@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2026, Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/* Input stream wrapping a serializer. Reads from the serializer are
+ * performed with a "budget" cancellable, so that the cursor being
+ * serialized is interrupted once the budget expires. The closed
+ * function is called once the stream is closed, possibly from a
+ * thread other than the one that created the stream.
+ */
+
+#include "config.h"
+
+#include "tracker-budget-stream.h"
+
+struct _TrackerBudgetStream
+{
+	GFilterInputStream parent_instance;
+	GCancellable *budget;
+	GDestroyNotify closed_func;
+	gpointer user_data;
+};
+
+G_DEFINE_TYPE (TrackerBudgetStream, tracker_budget_stream,
+               G_TYPE_FILTER_INPUT_STREAM)
+
+static void
+tracker_budget_stream_finalize (GObject *object)
+{
+	TrackerBudgetStream *stream = TRACKER_BUDGET_STREAM (object);
+
+	g_clear_object (&stream->budget);
+
+	G_OBJECT_CLASS (tracker_budget_stream_parent_class)->finalize (object);
+}
+
+static void
+cancel_budget (GCancellable *cancellable,
+               GCancellable *budget)
+{
+	g_cancellable_cancel (budget);
+}
+
+static gssize
+tracker_budget_stream_read (GInputStream  *istream,
+                            gpointer       buffer,
+                            gsize          count,
+                            GCancellable  *cancellable,
+                            GError       **error)
+{
+	TrackerBudgetStream *stream = TRACKER_BUDGET_STREAM (istream);
+	GInputStream *base_stream;
+	GError *inner_error = NULL;
+	gulong handler_id = 0;
+	gssize retval;
+
+	base_stream = g_filter_input_stream_get_base_stream (G_FILTER_INPUT_STREAM (istream));
+
+	if (!stream->budget)
+		return g_input_stream_read (base_stream, buffer, count, cancellable, error);
+
+	/* Cancelling the read must still interrupt the base stream */
+	if (cancellable) {
+		handler_id = g_cancellable_connect (cancellable,
+		                                    G_CALLBACK (cancel_budget),
+		                                    stream->budget, NULL);
+	}
+
+	retval = g_input_stream_read (base_stream, buffer, count,
+	                              stream->budget, &inner_error);
+
+	if (cancellable)
+		g_cancellable_disconnect (cancellable, handler_id);
+
+	if (inner_error) {
+		if (g_error_matches (inner_error, G_IO_ERROR, G_IO_ERROR_CANCELLED) &&
+		    !g_cancellable_is_cancelled (cancellable)) {
+			g_clear_error (&inner_error);
+			g_set_error_literal (&inner_error,
+			                     G_IO_ERROR,
+			                     G_IO_ERROR_TIMED_OUT,
+			                     "Query exceeded its time budget");
+		}
+
+		g_propagate_error (error, inner_error);
+	}
+
+	return retval;
+}
+
+static gboolean
+tracker_budget_stream_close (GInputStream  *istream,
+                             GCancellable  *cancellable,
+                             GError       **error)
+{
+	TrackerBudgetStream *stream = TRACKER_BUDGET_STREAM (istream);
+	GDestroyNotify closed_func;
+	gboolean retval;
+
+	retval = G_INPUT_STREAM_CLASS (tracker_budget_stream_parent_class)->close_fn (istream,
+	                                                                            cancellable,
+	                                                                            error);
+
+	closed_func = g_steal_pointer (&stream->closed_func);
+	if (closed_func)
+		closed_func (stream->user_data);
+
+	return retval;
+}
+
+static void
+tracker_budget_stream_class_init (TrackerBudgetStreamClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	GInputStreamClass *istream_class = G_INPUT_STREAM_CLASS (klass);
+
+	object_class->finalize = tracker_budget_stream_finalize;
+
+	istream_class->read_fn = tracker_budget_stream_read;
+	istream_class->close_fn = tracker_budget_stream_close;
+}
+
+static void
+tracker_budget_stream_init (TrackerBudgetStream *stream)
+{
+}
+
+GInputStream *
+tracker_budget_stream_new (GInputStream   *base_stream,
+                           GCancellable   *budget,
+                           GDestroyNotify  closed_func,
+                           gpointer        user_data)
+{
+	TrackerBudgetStream *stream;
+
+	g_return_val_if_fail (G_IS_INPUT_STREAM (base_stream), NULL);
+	g_return_val_if_fail (!budget || G_IS_CANCELLABLE (budget), NULL);
+
+	stream = g_object_new (TRACKER_TYPE_BUDGET_STREAM,
+	                       "base-stream", base_stream,
+	                       NULL);
+
+	if (budget)
+		stream->budget = g_object_ref (budget);
+
+	stream->closed_func = closed_func;
+	stream->user_data = user_data;
+
+	return G_INPUT_STREAM (stream);
+}
@@ -103,6 +103,19 @@ tracker_sparql_connection_init (TrackerSparqlConnection *connection)
 {
 }
 
+typedef struct
+{
+	GPtrArray *cursors;
+	guint n_pending;
+	GError *error;
+} QueryBatchData;
+
+typedef struct
+{
+	GTask *task;
+	guint idx;
+} QueryBatchItem;
+
 static void
 tracker_sparql_connection_dispose (GObject *object)
 {
@@ -111,6 +124,121 @@ tracker_sparql_connection_dispose (GObject *object)
 	G_OBJECT_CLASS (tracker_sparql_connection_parent_class)->dispose (object);
 }
 
+static void
+query_batch_data_free (QueryBatchData *data)
+{
+	guint i;
+
+	if (data->cursors) {
+		/* Cursors may be missing if some statement failed */
+		for (i = 0; i < data->cursors->len; i++) {
+			if (g_ptr_array_index (data->cursors, i))
+				g_object_unref (g_ptr_array_index (data->cursors, i));
+		}
+
+		g_ptr_array_unref (data->cursors);
+	}
+
+	g_clear_error (&data->error);
+	g_free (data);
+}
+
+static void
+query_batch_return_cursors (GTask *task)
+{
+	QueryBatchData *data = g_task_get_task_data (task);
+
+	g_ptr_array_set_free_func (data->cursors, g_object_unref);
+	g_task_return_pointer (task, g_steal_pointer (&data->cursors),
+	                       (GDestroyNotify) g_ptr_array_unref);
+}
+
+static void
+query_batch_execute_cb (GObject      *source,
+                        GAsyncResult *res,
+                        gpointer      user_data)
+{
+	QueryBatchItem *item = user_data;
+	GTask *task = item->task;
+	QueryBatchData *data;
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+
+	data = g_task_get_task_data (task);
+	cursor = tracker_sparql_statement_execute_finish (TRACKER_SPARQL_STATEMENT (source),
+	                                                  res, &error);
+
+	if (cursor)
+		g_ptr_array_index (data->cursors, item->idx) = cursor;
+	else if (!data->error)
+		data->error = error;
+	else
+		g_error_free (error);
+
+	g_free (item);
+	data->n_pending--;
+
+	if (data->n_pending == 0) {
+		if (data->error)
+			g_task_return_error (task, g_steal_pointer (&data->error));
+		else
+			query_batch_return_cursors (task);
+	}
+
+	g_object_unref (task);
+}
+
+static void
+tracker_sparql_connection_real_query_batch_async (TrackerSparqlConnection  *connection,
+                                                  TrackerSparqlStatement  **statements,
+                                                  guint                     n_statements,
+                                                  GCancellable             *cancellable,
+                                                  GAsyncReadyCallback       callback,
+                                                  gpointer                  user_data)
+{
+	QueryBatchData *data;
+	GTask *task;
+	guint i;
+
+	task = g_task_new (connection, cancellable, callback, user_data);
+
+	data = g_new0 (QueryBatchData, 1);
+	data->cursors = g_ptr_array_sized_new (n_statements);
+	g_ptr_array_set_size (data->cursors, n_statements);
+	data->n_pending = n_statements;
+	g_task_set_task_data (task, data, (GDestroyNotify) query_batch_data_free);
+
+	if (n_statements == 0) {
+		query_batch_return_cursors (task);
+		g_object_unref (task);
+		return;
+	}
+
+	/* Statements are executed in parallel */
+	for (i = 0; i < n_statements; i++) {
+		QueryBatchItem *item;
+
+		item = g_new0 (QueryBatchItem, 1);
+		item->task = g_object_ref (task);
+		item->idx = i;
+
+		tracker_sparql_statement_execute_async (statements[i],
+		                                        cancellable,
+		                                        query_batch_execute_cb,
+		                                        item);
+	}
+
+	g_object_unref (task);
+}
+
+static GPtrArray *
+tracker_sparql_connection_real_query_batch_finish (TrackerSparqlConnection  *connection,
+                                                   GAsyncResult             *res,
+                                                   GError                  **error)
+{
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
 static void
 tracker_sparql_connection_class_init (TrackerSparqlConnectionClass *klass)
 {
@@ -118,6 +246,9 @@ tracker_sparql_connection_class_init (TrackerSparqlConnectionClass *klass)
 
 	object_class->dispose = tracker_sparql_connection_dispose;
 
+	klass->query_batch_async = tracker_sparql_connection_real_query_batch_async;
+	klass->query_batch_finish = tracker_sparql_connection_real_query_batch_finish;
+
 	/* Initialize debug flags */
 	tracker_get_debug_flags ();
 
@@ -1225,6 +1356,103 @@ tracker_sparql_connection_deserialize_finish (TrackerSparqlConnection  *connecti
 	                                                                             error);
 }
 
+/**
+ * tracker_sparql_connection_query_batch_async:
+ * @connection: A `TrackerSparqlConnection`
+ * @statements: (array length=n_statements): Query statements to execute
+ * @n_statements: Number of statements
+ * @cancellable: (nullable): Optional [type@Gio.Cancellable]
+ * @callback: User-defined [type@Gio.AsyncReadyCallback] to be called when
+ *            the asynchronous operation is finished.
+ * @user_data: User-defined data to be passed to @callback
+ *
+ * Executes a number of query statements, with their current bindings,
+ * at once.
+ *
+ * The statements are executed concurrently, and for D-Bus connections
+ * they are all sent in a single request. This is useful to reduce the
+ * latency of issuing several independent queries, e.g. to populate
+ * a view.
+ *
+ * All statements must have been created from @connection through
+ * [method@SparqlConnection.query_statement] or
+ * [method@SparqlConnection.load_statement_from_gresource].
+ *
+ * Since: 3.12
+ **/
+void
+tracker_sparql_connection_query_batch_async (TrackerSparqlConnection  *connection,
+                                             TrackerSparqlStatement  **statements,
+                                             guint                     n_statements,
+                                             GCancellable             *cancellable,
+                                             GAsyncReadyCallback       callback,
+                                             gpointer                  user_data)
+{
+	guint i;
+
+	g_return_if_fail (TRACKER_IS_SPARQL_CONNECTION (connection));
+	g_return_if_fail (statements != NULL || n_statements == 0);
+	g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (callback != NULL);
+
+	for (i = 0; i < n_statements; i++) {
+		g_return_if_fail (TRACKER_IS_SPARQL_STATEMENT (statements[i]));
+		g_return_if_fail (tracker_sparql_statement_get_connection (statements[i]) == connection);
+	}
+
+	if (tracker_sparql_connection_report_async_error_on_closed (connection,
+	                                                            callback,
+	                                                            user_data))
+		return;
+
+	TRACKER_SPARQL_CONNECTION_GET_CLASS (connection)->query_batch_async (connection,
+	                                                                     statements,
+	                                                                     n_statements,
+	                                                                     cancellable,
+	                                                                     callback,
+	                                                                     user_data);
+}
+
+/**
+ * tracker_sparql_connection_query_batch_finish:
+ * @connection: A `TrackerSparqlConnection`
+ * @result: A [type@Gio.AsyncResult] with the result of the operation
+ * @error: Error location
+ *
+ * Finishes the operation started with [method@SparqlConnection.query_batch_async].
+ *
+ * If any of the statements failed, an error is returned and no cursors
+ * are available.
+ *
+ * Returns: (transfer full) (element-type TrackerSparqlCursor): An array
+ *   with a [class@SparqlCursor] for each statement, in the same order.
+ *
+ * Since: 3.12
+ **/
+GPtrArray *
+tracker_sparql_connection_query_batch_finish (TrackerSparqlConnection  *connection,
+                                              GAsyncResult             *result,
+                                              GError                  **error)
+{
+	GPtrArray *cursors;
+	guint i;
+
+	g_return_val_if_fail (TRACKER_IS_SPARQL_CONNECTION (connection), NULL);
+	g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
+	g_return_val_if_fail (!error || !*error, NULL);
+
+	cursors = TRACKER_SPARQL_CONNECTION_GET_CLASS (connection)->query_batch_finish (connection,
+	                                                                                result,
+	                                                                                error);
+	if (cursors) {
+		for (i = 0; i < cursors->len; i++)
+			tracker_sparql_cursor_set_connection (g_ptr_array_index (cursors, i),
+			                                      connection);
+	}
+
+	return cursors;
+}
+
 /**
  * tracker_sparql_connection_map_connection:
  * @connection: A `TrackerSparqlConnection`
@@ -1276,6 +1504,38 @@ tracker_sparql_connection_map_connection (TrackerSparqlConnection *connection,
 	                                                                  service_connection);
 }
 
+/**
+ * tracker_sparql_connection_set_service_cache_limits:
+ * @connection: A `TrackerSparqlConnection`
+ * @max_age: Time in seconds that `SERVICE` results are kept for
+ * @max_size: Maximum size in bytes of all kept `SERVICE` results
+ *
+ * Changes the limits of the cache enabled through the
+ * `CACHE_SERVICE_RESULTS` [flags@SparqlConnectionFlags]. When
+ * @max_size is exceeded, the least recently used results are
+ * dropped first.
+ *
+ * The new limits also apply to the results already in the cache.
+ * This does nothing if @connection was not created with the
+ * `CACHE_SERVICE_RESULTS` [flags@SparqlConnectionFlags].
+ *
+ * Since: 3.12
+ **/
+void
+tracker_sparql_connection_set_service_cache_limits (TrackerSparqlConnection *connection,
+                                                    guint                    max_age,
+                                                    gsize                    max_size)
+{
+	g_return_if_fail (TRACKER_IS_SPARQL_CONNECTION (connection));
+
+	if (!TRACKER_SPARQL_CONNECTION_GET_CLASS (connection)->set_service_cache_limits)
+		return;
+
+	TRACKER_SPARQL_CONNECTION_GET_CLASS (connection)->set_service_cache_limits (connection,
+	                                                                            max_age,
+	                                                                            max_size);
+}
+
 /**
  * tracker_sparql_connection_remote_new:
  * @uri_base: Base URI of the remote connection
@@ -63,6 +63,32 @@ G_BEGIN_DECLS
  *
  * Since: 3.11
  */
+/**
+ * TRACKER_SPARQL_CONNECTION_FLAGS_CACHE_SERVICE_RESULTS:
+ *
+ * Keeps the results of `SERVICE` subqueries to other D-Bus and HTTP
+ * endpoints for a short while, further queries with the same `SERVICE`
+ * subquery and parameters reuse these results instead of querying
+ * the endpoint again. This is intended for endpoints whose data
+ * changes infrequently.
+ *
+ * By default results are kept for 60 seconds, and at most 16 MiB of
+ * results are kept. These limits may be changed through
+ * [method@SparqlConnection.set_service_cache_limits].
+ *
+ * Since: 3.12
+ */
+/**
+ * TRACKER_SPARQL_CONNECTION_FLAGS_FTS_ENABLE_PREFIX_INDEX:
+ *
+ * Adds prefix indexes for 2, 3 and 4 character prefixes to the
+ * full-text search index, so that prefix searches (e.g. as typed
+ * by the user in a search-as-you-type UI) do not need to scan all
+ * terms in the range. This makes the index bigger. Changing this
+ * flag on an existing database rebuilds the full-text search index.
+ *
+ * Since: 3.12
+ */
 typedef enum {
 	TRACKER_SPARQL_CONNECTION_FLAGS_NONE                  = 0,
 	TRACKER_SPARQL_CONNECTION_FLAGS_READONLY              = 1 << 0,
@@ -72,6 +98,8 @@ typedef enum {
 	TRACKER_SPARQL_CONNECTION_FLAGS_FTS_IGNORE_NUMBERS    = 1 << 4,
 	TRACKER_SPARQL_CONNECTION_FLAGS_ANONYMOUS_BNODES      = 1 << 5,
 	TRACKER_SPARQL_CONNECTION_FLAGS_DISABLE_SYNTAX_EXTENSIONS = 1 << 6,
+	TRACKER_SPARQL_CONNECTION_FLAGS_CACHE_SERVICE_RESULTS = 1 << 7,
+	TRACKER_SPARQL_CONNECTION_FLAGS_FTS_ENABLE_PREFIX_INDEX = 1 << 8,
 
 	TRACKER_SPARQL_CONNECTION_FLAGS_SPARQL_STRICT = (TRACKER_SPARQL_CONNECTION_FLAGS_DISABLE_SYNTAX_EXTENSIONS |
 	                                                 TRACKER_SPARQL_CONNECTION_FLAGS_ANONYMOUS_BNODES),
@@ -298,6 +326,18 @@ gboolean tracker_sparql_connection_deserialize_finish (TrackerSparqlConnection
                                                        GAsyncResult             *result,
                                                        GError                  **error);
 
+TRACKER_AVAILABLE_IN_3_12
+void tracker_sparql_connection_query_batch_async (TrackerSparqlConnection  *connection,
+                                                  TrackerSparqlStatement  **statements,
+                                                  guint                     n_statements,
+                                                  GCancellable             *cancellable,
+                                                  GAsyncReadyCallback       callback,
+                                                  gpointer                  user_data);
+TRACKER_AVAILABLE_IN_3_12
+GPtrArray * tracker_sparql_connection_query_batch_finish (TrackerSparqlConnection  *connection,
+                                                          GAsyncResult             *result,
+                                                          GError                  **error);
+
 TRACKER_AVAILABLE_IN_ALL
 void tracker_sparql_connection_close_async (TrackerSparqlConnection *connection,
                                             GCancellable            *cancellable,
@@ -320,4 +360,9 @@ void tracker_sparql_connection_map_connection (TrackerSparqlConnection *connecti
 					       const gchar             *handle_name,
 					       TrackerSparqlConnection *service_connection);
 
+TRACKER_AVAILABLE_IN_3_12
+void tracker_sparql_connection_set_service_cache_limits (TrackerSparqlConnection *connection,
+                                                         guint                    max_age,
+                                                         gsize                    max_size);
+
 G_END_DECLS
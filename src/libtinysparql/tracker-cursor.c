@@ -61,6 +61,7 @@ static GParamSpec *props[N_PROPS];
 
 typedef struct {
 	TrackerSparqlConnection *connection;
+	GStringChunk *fetched_strings;
 } TrackerSparqlCursorPrivate;
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (TrackerSparqlCursor, tracker_sparql_cursor,
@@ -131,6 +132,58 @@ tracker_sparql_cursor_real_get_datetime (TrackerSparqlCursor *cursor,
 	return date_time;
 }
 
+static gint
+tracker_sparql_cursor_real_fetch_rows (TrackerSparqlCursor  *cursor,
+                                       TrackerCursorFetch   *fetch,
+                                       GCancellable         *cancellable,
+                                       GError              **error)
+{
+	TrackerSparqlCursorClass *klass = TRACKER_SPARQL_CURSOR_GET_CLASS (cursor);
+	gint row, column, n_columns;
+
+	for (row = 0; row < fetch->max_rows; row++) {
+		GError *inner_error = NULL;
+
+		if (!klass->next (cursor, cancellable, &inner_error)) {
+			if (inner_error) {
+				g_propagate_error (error, inner_error);
+				return -1;
+			}
+
+			break;
+		}
+
+		n_columns = MIN (fetch->n_columns, klass->get_n_columns (cursor));
+
+		for (column = 0; column < fetch->n_columns; column++) {
+			TrackerSparqlValueType type = TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
+			const gchar *str = NULL;
+			gint64 integer = 0;
+			gdouble number = 0;
+			glong length = 0;
+
+			if (column < n_columns)
+				type = klass->get_value_type (cursor, column);
+
+			if (type == TRACKER_SPARQL_VALUE_TYPE_INTEGER)
+				integer = klass->get_integer (cursor, column);
+			else if (type == TRACKER_SPARQL_VALUE_TYPE_BOOLEAN)
+				integer = klass->get_boolean (cursor, column);
+			else if (type == TRACKER_SPARQL_VALUE_TYPE_DOUBLE)
+				number = klass->get_double (cursor, column);
+
+			if (type != TRACKER_SPARQL_VALUE_TYPE_UNBOUND && fetch->strings)
+				str = klass->get_string (cursor, column, NULL, &length);
+
+			tracker_sparql_cursor_fetch_set_cell (cursor, fetch, row, column,
+			                                      type, integer, number,
+			                                      str, length);
+		}
+	}
+
+	return row;
+}
+
 static void
 tracker_sparql_cursor_finalize (GObject *object)
 {
@@ -138,6 +191,7 @@ tracker_sparql_cursor_finalize (GObject *object)
 	TrackerSparqlCursorPrivate *priv = tracker_sparql_cursor_get_instance_private (cursor);
 
 	g_clear_object (&priv->connection);
+	g_clear_pointer (&priv->fetched_strings, g_string_chunk_free);
 	G_OBJECT_CLASS (tracker_sparql_cursor_parent_class)->finalize (object);
 }
 
@@ -194,6 +248,7 @@ tracker_sparql_cursor_class_init (TrackerSparqlCursorClass *klass)
 	klass->get_boolean = tracker_sparql_cursor_real_get_boolean;
 	klass->get_datetime = tracker_sparql_cursor_real_get_datetime;
 	klass->is_bound = tracker_sparql_cursor_real_is_bound;
+	klass->fetch_rows = tracker_sparql_cursor_real_fetch_rows;
 
 	/**
 	 * TrackerSparqlCursor:connection:
@@ -621,6 +676,123 @@ tracker_sparql_cursor_next_finish (TrackerSparqlCursor  *cursor,
 	return success;
 }
 
+void
+tracker_sparql_cursor_fetch_set_cell (TrackerSparqlCursor    *cursor,
+                                      TrackerCursorFetch     *fetch,
+                                      gint                    row,
+                                      gint                    column,
+                                      TrackerSparqlValueType  type,
+                                      gint64                  integer,
+                                      gdouble                 number,
+                                      const gchar            *str,
+                                      glong                   length)
+{
+	TrackerSparqlCursorPrivate *priv = tracker_sparql_cursor_get_instance_private (cursor);
+	gsize cell = (gsize) column * fetch->max_rows + row;
+
+	if (fetch->types)
+		fetch->types[cell] = type;
+	if (fetch->integers)
+		fetch->integers[cell] = integer;
+	if (fetch->doubles)
+		fetch->doubles[cell] = number;
+	if (fetch->lengths)
+		fetch->lengths[cell] = str ? length : 0;
+
+	if (fetch->strings) {
+		/* Strings of prior rows are gone after next(), keep copies */
+		fetch->strings[cell] = str ?
+			g_string_chunk_insert_len (priv->fetched_strings, str, length) :
+			NULL;
+	}
+}
+
+/**
+ * tracker_sparql_cursor_fetch_rows: (skip):
+ * @cursor: a `TrackerSparqlCursor`
+ * @max_rows: maximum number of rows to fetch
+ * @n_columns: number of columns in the given arrays
+ * @types: (nullable): array for the value types, or %NULL
+ * @integers: (nullable): array for integer and boolean values, or %NULL
+ * @doubles: (nullable): array for double values, or %NULL
+ * @strings: (nullable): array for the string representation of values, or %NULL
+ * @lengths: (nullable): array for the length of strings, or %NULL
+ * @cancellable: (nullable): Optional [type@Gio.Cancellable]
+ * @error: Error location
+ *
+ * Iterates the cursor over up to @max_rows results at once, and stores
+ * the values of the first @n_columns columns in the given arrays. This is
+ * faster than [method@SparqlCursor.next] and the value getters for large
+ * result sets.
+ *
+ * The given arrays must have room for @max_rows * @n_columns elements,
+ * which must not exceed %G_MAXINT. Values are stored by column, the value of a row and column being at
+ * `column * max_rows + row`. Columns that do not exist in the result set
+ * are stored as unbound values.
+ *
+ * Values of type %TRACKER_SPARQL_VALUE_TYPE_INTEGER and
+ * %TRACKER_SPARQL_VALUE_TYPE_BOOLEAN are stored in @integers, values of
+ * type %TRACKER_SPARQL_VALUE_TYPE_DOUBLE in @doubles. The strings stored
+ * in @strings are owned by the cursor, and are valid until the next call
+ * to this function.
+ *
+ * After this call, the cursor points to the last fetched result.
+ *
+ * Returns: The number of rows fetched, 0 if there are no more results,
+ * or -1 if an error is found.
+ *
+ * Since: 3.12
+ */
+gint
+tracker_sparql_cursor_fetch_rows (TrackerSparqlCursor     *cursor,
+                                  gint                     max_rows,
+                                  gint                     n_columns,
+                                  TrackerSparqlValueType  *types,
+                                  gint64                  *integers,
+                                  gdouble                 *doubles,
+                                  const gchar            **strings,
+                                  glong                   *lengths,
+                                  GCancellable            *cancellable,
+                                  GError                 **error)
+{
+	TrackerSparqlCursorPrivate *priv = tracker_sparql_cursor_get_instance_private (cursor);
+	TrackerCursorFetch fetch = { 0, };
+	GError *inner_error = NULL;
+	gint n_rows;
+
+	g_return_val_if_fail (TRACKER_IS_SPARQL_CURSOR (cursor), -1);
+	g_return_val_if_fail (max_rows >= 0, -1);
+	g_return_val_if_fail (n_columns >= 0, -1);
+	g_return_val_if_fail (n_columns == 0 || max_rows <= G_MAXINT / n_columns, -1);
+	g_return_val_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable), -1);
+	g_return_val_if_fail (!error || !*error, -1);
+
+	if (priv->fetched_strings)
+		g_string_chunk_clear (priv->fetched_strings);
+	else
+		priv->fetched_strings = g_string_chunk_new (4096);
+
+	fetch.max_rows = max_rows;
+	fetch.n_columns = n_columns;
+	fetch.types = types;
+	fetch.integers = integers;
+	fetch.doubles = doubles;
+	fetch.strings = strings;
+	fetch.lengths = lengths;
+
+	n_rows = TRACKER_SPARQL_CURSOR_GET_CLASS (cursor)->fetch_rows (cursor,
+	                                                               &fetch,
+	                                                               cancellable,
+	                                                               &inner_error);
+
+	if (inner_error) {
+		g_propagate_error (error, _translate_internal_error (inner_error));
+		return -1;
+	}
+
+	return n_rows;
+}
+
 /**
  * tracker_sparql_cursor_rewind:
  * @cursor: a `TrackerSparqlCursor`
@@ -115,6 +115,18 @@ gboolean tracker_sparql_cursor_next_finish (TrackerSparqlCursor  *cursor,
                                             GAsyncResult         *res,
                                             GError              **error);
 
+TRACKER_AVAILABLE_IN_3_12
+gint tracker_sparql_cursor_fetch_rows (TrackerSparqlCursor     *cursor,
+                                       gint                     max_rows,
+                                       gint                     n_columns,
+                                       TrackerSparqlValueType  *types,
+                                       gint64                  *integers,
+                                       gdouble                 *doubles,
+                                       const gchar            **strings,
+                                       glong                   *lengths,
+                                       GCancellable            *cancellable,
+                                       GError                 **error);
+
 TRACKER_DEPRECATED_IN_3_5
 void tracker_sparql_cursor_rewind (TrackerSparqlCursor *cursor);
 
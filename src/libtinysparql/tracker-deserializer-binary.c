@@ -0,0 +1,828 @@
+/*
+ * Copyright (C) 2026, Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/* Deserialization to cursors for the binary format described in
+ * tracker-serializer-binary.h
+ */
+
+#include "config.h"
+
+#include "tracker-deserializer-binary.h"
+#include "tracker-serializer-binary.h"
+
+#include <tracker-common.h>
+
+/* Same limit than bus cursors, we may store up to 1GB
+ * in a single value, leave room for 2GB blocks.
+ */
+#define MAX_BLOCK_SIZE (2 * 1000 * 1000 * 1000)
+#define MAX_BLOCK_ROWS 65536
+/* Blocks are read in chunks of this size, so that the memory
+ * used follows the data actually received, not the length
+ * the peer announced.
+ */
+#define READ_CHUNK_SIZE (1024 * 1024)
+
+typedef struct {
+	TrackerSparqlValueType type;
+	TrackerBinaryValueTag tag;
+	const gchar *str;
+	const gchar *langtag;
+	gsize len;
+	union {
+		gint64 integer;
+		gdouble number;
+		struct {
+			gint64 usec;
+			gint32 offset;
+		} datetime;
+	} value;
+	gchar *formatted;
+} Cell;
+
+struct _TrackerDeserializerBinary {
+	TrackerDeserializer parent_instance;
+	GByteArray *block;
+	/* Values of the columns present in the current block */
+	GArray *cells;
+	/* Column to first cell index, or -1 if absent in the block */
+	GArray *column_cells;
+	Cell unbound;
+	GPtrArray *dictionary;
+	GPtrArray *vars;
+	guint n_rows;
+	gint row;
+	GError *init_error;
+	guint finished : 1;
+};
+
+G_DEFINE_TYPE (TrackerDeserializerBinary,
+               tracker_deserializer_binary,
+               TRACKER_TYPE_DESERIALIZER)
+
+static void
+clear_cell (gpointer data)
+{
+	Cell *cell = data;
+
+	g_free (cell->formatted);
+}
+
+static void
+tracker_deserializer_binary_finalize (GObject *object)
+{
+	TrackerDeserializerBinary *deserializer =
+		TRACKER_DESERIALIZER_BINARY (object);
+
+	g_byte_array_unref (deserializer->block);
+	g_array_unref (deserializer->cells);
+	g_array_unref (deserializer->column_cells);
+	g_ptr_array_unref (deserializer->dictionary);
+	g_ptr_array_unref (deserializer->vars);
+	g_clear_error (&deserializer->init_error);
+
+	G_OBJECT_CLASS (tracker_deserializer_binary_parent_class)->finalize (object);
+}
+
+static void
+set_corrupted_error (GError **error)
+{
+	g_set_error (error,
+	             TRACKER_SPARQL_ERROR,
+	             TRACKER_SPARQL_ERROR_PARSE,
+	             "Corrupted binary result set");
+}
+
+static gboolean
+read_varint (const guint8 **ptr,
+             const guint8  *end,
+             guint64       *value)
+{
+	guint shift = 0;
+
+	*value = 0;
+
+	while (*ptr < end && shift < 64) {
+		guint8 byte = **ptr;
+
+		(*ptr)++;
+		*value |= ((guint64) (byte & 0x7f)) << shift;
+
+		if ((byte & 0x80) == 0)
+			return TRUE;
+
+		shift += 7;
+	}
+
+	return FALSE;
+}
+
+static gboolean
+read_zigzag (const guint8 **ptr,
+             const guint8  *end,
+             gint64        *value)
+{
+	guint64 encoded;
+
+	if (!read_varint (ptr, end, &encoded))
+		return FALSE;
+
+	*value = (gint64) (encoded >> 1) ^ -((gint64) (encoded & 1));
+	return TRUE;
+}
+
+static gboolean
+read_string (const guint8  **ptr,
+             const guint8   *end,
+             const gchar   **str,
+             gsize          *len)
+{
+	guint64 str_len;
+
+	if (!read_varint (ptr, end, &str_len))
+		return FALSE;
+
+	/* Strings are followed by a nul terminator */
+	if (str_len >= (guint64) (end - *ptr) ||
+	    (*ptr)[str_len] != '\0')
+		return FALSE;
+
+	*str = (const gchar *) *ptr;
+	*len = str_len;
+	*ptr += str_len + 1;
+
+	return TRUE;
+}
+
+static gboolean
+read_frame (TrackerDeserializerBinary  *deserializer,
+            GCancellable               *cancellable,
+            guint32                    *frame_len,
+            GError                    **error)
+{
+	GInputStream *stream;
+	guint32 len, offset = 0;
+	gsize bytes_read;
+
+	stream = tracker_deserializer_get_stream (TRACKER_DESERIALIZER (deserializer));
+
+	if (!g_input_stream_read_all (stream, &len, sizeof (len),
+	                              &bytes_read, cancellable, error))
+		return FALSE;
+
+	if (bytes_read != sizeof (len)) {
+		set_corrupted_error (error);
+		return FALSE;
+	}
+
+	len = GUINT32_FROM_LE (len);
+
+	if (len > MAX_BLOCK_SIZE) {
+		set_corrupted_error (error);
+		return FALSE;
+	}
+
+	while (offset < len) {
+		guint32 chunk_len;
+
+		chunk_len = MIN (len - offset, READ_CHUNK_SIZE);
+		g_byte_array_set_size (deserializer->block, offset + chunk_len);
+
+		if (!g_input_stream_read_all (stream,
+		                              &deserializer->block->data[offset],
+		                              chunk_len,
+		                              &bytes_read, cancellable, error))
+			return FALSE;
+
+		if (bytes_read != chunk_len) {
+			set_corrupted_error (error);
+			return FALSE;
+		}
+
+		offset += chunk_len;
+	}
+
+	*frame_len = len;
+
+	return TRUE;
+}
+
+static gboolean
+read_head (TrackerDeserializerBinary  *deserializer,
+           GError                    **error)
+{
+	GInputStream *stream;
+	guint8 magic[TRACKER_BINARY_RESULTS_MAGIC_LEN + 1];
+	const guint8 *ptr, *end;
+	guint64 n_columns, i;
+	gsize bytes_read;
+	guint32 len;
+
+	stream = tracker_deserializer_get_stream (TRACKER_DESERIALIZER (deserializer));
+
+	if (!g_input_stream_read_all (stream, magic, sizeof (magic),
+	                              &bytes_read, NULL, error))
+		return FALSE;
+
+	if (bytes_read != sizeof (magic) ||
+	    memcmp (magic, TRACKER_BINARY_RESULTS_MAGIC,
+	            TRACKER_BINARY_RESULTS_MAGIC_LEN) != 0) {
+		set_corrupted_error (error);
+		return FALSE;
+	}
+
+	if (magic[TRACKER_BINARY_RESULTS_MAGIC_LEN] != TRACKER_BINARY_RESULTS_VERSION) {
+		g_set_error (error,
+		             TRACKER_SPARQL_ERROR,
+		             TRACKER_SPARQL_ERROR_PARSE,
+		             "Unsupported binary result set version %d",
+		             magic[TRACKER_BINARY_RESULTS_MAGIC_LEN]);
+		return FALSE;
+	}
+
+	if (!read_frame (deserializer, NULL, &len, error))
+		return FALSE;
+
+	ptr = deserializer->block->data;
+	end = ptr + len;
+
+	if (!read_varint (&ptr, end, &n_columns) ||
+	    n_columns > (guint64) (end - ptr)) {
+		set_corrupted_error (error);
+		return FALSE;
+	}
+
+	for (i = 0; i < n_columns; i++) {
+		const gchar *name;
+		gsize name_len;
+
+		if (!read_string (&ptr, end, &name, &name_len)) {
+			set_corrupted_error (error);
+			return FALSE;
+		}
+
+		g_ptr_array_add (deserializer->vars, g_strndup (name, name_len));
+	}
+
+	return TRUE;
+}
+
+static void
+tracker_deserializer_binary_constructed (GObject *object)
+{
+	TrackerDeserializerBinary *deserializer =
+		TRACKER_DESERIALIZER_BINARY (object);
+
+	G_OBJECT_CLASS (tracker_deserializer_binary_parent_class)->constructed (object);
+
+	if (!read_head (deserializer, &deserializer->init_error))
+		deserializer->finished = TRUE;
+}
+
+static gboolean
+parse_value (TrackerDeserializerBinary  *deserializer,
+             const guint8              **ptr,
+             const guint8               *end,
+             Cell                       *cell)
+{
+	guint64 idx;
+
+	if (*ptr >= end)
+		return FALSE;
+
+	cell->tag = **ptr;
+	(*ptr)++;
+
+	switch (cell->tag) {
+	case TRACKER_BINARY_VALUE_UNBOUND:
+		cell->type = TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
+		return TRUE;
+	case TRACKER_BINARY_VALUE_IRI:
+		cell->type = TRACKER_SPARQL_VALUE_TYPE_URI;
+		return read_string (ptr, end, &cell->str, &cell->len);
+	case TRACKER_BINARY_VALUE_IRI_NEW:
+		cell->type = TRACKER_SPARQL_VALUE_TYPE_URI;
+		if (!read_string (ptr, end, &cell->str, &cell->len))
+			return FALSE;
+		g_ptr_array_add (deserializer->dictionary,
+		                 g_strndup (cell->str, cell->len));
+		return TRUE;
+	case TRACKER_BINARY_VALUE_IRI_REF:
+		cell->type = TRACKER_SPARQL_VALUE_TYPE_URI;
+		if (!read_varint (ptr, end, &idx) ||
+		    idx >= deserializer->dictionary->len)
+			return FALSE;
+		cell->str = g_ptr_array_index (deserializer->dictionary, idx);
+		cell->len = strlen (cell->str);
+		return TRUE;
+	case TRACKER_BINARY_VALUE_BLANK_NODE:
+		cell->type = TRACKER_SPARQL_VALUE_TYPE_BLANK_NODE;
+		return read_string (ptr, end, &cell->str, &cell->len);
+	case TRACKER_BINARY_VALUE_STRING:
+		cell->type = TRACKER_SPARQL_VALUE_TYPE_STRING;
+		return read_string (ptr, end, &cell->str, &cell->len);
+	case TRACKER_BINARY_VALUE_LANGSTRING: {
+		gsize langtag_len;
+
+		cell->type = TRACKER_SPARQL_VALUE_TYPE_STRING;
+		return (read_string (ptr, end, &cell->str, &cell->len) &&
+		        read_string (ptr, end, &cell->langtag, &langtag_len));
+	}
+	case TRACKER_BINARY_VALUE_INTEGER:
+		cell->type = TRACKER_SPARQL_VALUE_TYPE_INTEGER;
+		return read_zigzag (ptr, end, &cell->value.integer);
+	case TRACKER_BINARY_VALUE_DOUBLE: {
+		guint64 bits;
+
+		if (end - *ptr < (gssize) sizeof (bits))
+			return FALSE;
+
+		memcpy (&bits, *ptr, sizeof (bits));
+		bits = GUINT64_FROM_LE (bits);
+		memcpy (&cell->value.number, &bits, sizeof (bits));
+		*ptr += sizeof (bits);
+		cell->type = TRACKER_SPARQL_VALUE_TYPE_DOUBLE;
+		return TRUE;
+	}
+	case TRACKER_BINARY_VALUE_FALSE:
+		cell->type = TRACKER_SPARQL_VALUE_TYPE_BOOLEAN;
+		cell->str = "false";
+		cell->len = strlen (cell->str);
+		return TRUE;
+	case TRACKER_BINARY_VALUE_TRUE:
+		cell->type = TRACKER_SPARQL_VALUE_TYPE_BOOLEAN;
+		cell->str = "true";
+		cell->len = strlen (cell->str);
+		return TRUE;
+	case TRACKER_BINARY_VALUE_DATETIME: {
+		gint64 offset;
+
+		cell->type = TRACKER_SPARQL_VALUE_TYPE_DATETIME;
+
+		if (!read_zigzag (ptr, end, &cell->value.datetime.usec) ||
+		    !read_zigzag (ptr, end, &offset) ||
+		    ABS (offset) > 24 * 60 * 60)
+			return FALSE;
+
+		cell->value.datetime.offset = offset;
+		return TRUE;
+	}
+	case TRACKER_BINARY_VALUE_TYPED_STRING:
+		if (*ptr >= end ||
+		    **ptr == TRACKER_SPARQL_VALUE_TYPE_UNBOUND ||
+		    **ptr > TRACKER_SPARQL_VALUE_TYPE_BOOLEAN)
+			return FALSE;
+
+		cell->type = **ptr;
+		(*ptr)++;
+		return read_string (ptr, end, &cell->str, &cell->len);
+	default:
+		return FALSE;
+	}
+}
+
+static gboolean
+parse_block (TrackerDeserializerBinary  *deserializer,
+             guint32                     len,
+             GError                    **error)
+{
+	const guint8 *ptr, *end, *present;
+	guint64 n_rows;
+	guint n_columns, n_present = 0, i, j;
+
+	n_columns = deserializer->vars->len;
+	ptr = deserializer->block->data;
+	end = ptr + len;
+
+	if (!read_varint (&ptr, end, &n_rows) ||
+	    n_rows == 0 || n_rows > MAX_BLOCK_ROWS ||
+	    (guint64) (end - ptr) < (n_columns + 7) / 8) {
+		set_corrupted_error (error);
+		return FALSE;
+	}
+
+	present = ptr;
+	ptr += (n_columns + 7) / 8;
+
+	g_array_set_size (deserializer->column_cells, n_columns);
+
+	for (i = 0; i < n_columns; i++) {
+		if ((present[i / 8] & (1 << (i % 8))) == 0) {
+			g_array_index (deserializer->column_cells, gint, i) = -1;
+		} else {
+			g_array_index (deserializer->column_cells, gint, i) = n_present * n_rows;
+			n_present++;
+		}
+	}
+
+	/* Every value takes at least one byte, do not trust the
+	 * row count to size the cells beyond what was received.
+	 */
+	if ((guint64) n_present * n_rows > (guint64) (end - ptr)) {
+		set_corrupted_error (error);
+		return FALSE;
+	}
+
+	g_array_set_size (deserializer->cells, 0);
+	g_array_set_size (deserializer->cells, n_present * n_rows);
+
+	/* Cells are stored column-major, as they come in the block */
+	for (i = 0; i < n_columns; i++) {
+		gint first_cell;
+
+		first_cell = g_array_index (deserializer->column_cells, gint, i);
+		if (first_cell < 0)
+			continue;
+
+		for (j = 0; j < n_rows; j++) {
+			Cell *cell;
+
+			cell = &g_array_index (deserializer->cells, Cell, first_cell + j);
+
+			if (!parse_value (deserializer, &ptr, end, cell)) {
+				set_corrupted_error (error);
+				return FALSE;
+			}
+		}
+	}
+
+	if (ptr != end) {
+		set_corrupted_error (error);
+		return FALSE;
+	}
+
+	deserializer->n_rows = n_rows;
+	deserializer->row = 0;
+
+	return TRUE;
+}
+
+static Cell *
+get_cell (TrackerDeserializerBinary *deserializer,
+          gint                       column)
+{
+	gint first_cell;
+
+	if (deserializer->finished ||
+	    deserializer->n_rows == 0 ||
+	    column < 0 || column >= (gint) deserializer->vars->len)
+		return NULL;
+
+	/* Columns absent in the block are unbound in all its rows */
+	first_cell = g_array_index (deserializer->column_cells, gint, column);
+	if (first_cell < 0)
+		return &deserializer->unbound;
+
+	return &g_array_index (deserializer->cells, Cell,
+	                       first_cell + deserializer->row);
+}
+
+static GDateTime *
+cell_get_datetime (Cell *cell)
+{
+	GDateTime *utc, *datetime;
+	GTimeZone *tz;
+	gint64 secs, usecs;
+
+	secs = cell->value.datetime.usec / G_USEC_PER_SEC;
+	usecs = cell->value.datetime.usec % G_USEC_PER_SEC;
+
+	if (usecs < 0) {
+		secs--;
+		usecs += G_USEC_PER_SEC;
+	}
+
+	utc = g_date_time_new_from_unix_utc (secs);
+	if (!utc)
+		return NULL;
+
+	datetime = g_date_time_add (utc, usecs);
+	g_date_time_unref (utc);
+
+	if (cell->value.datetime.offset != 0) {
+		utc = datetime;
+		tz = g_time_zone_new_offset (cell->value.datetime.offset);
+		datetime = g_date_time_to_timezone (utc, tz);
+		g_time_zone_unref (tz);
+		g_date_time_unref (utc);
+	}
+
+	return datetime;
+}
+
+static void
+format_cell (Cell *cell)
+{
+	switch (cell->tag) {
+	case TRACKER_BINARY_VALUE_INTEGER:
+		cell->formatted = g_strdup_printf ("%" G_GINT64_FORMAT,
+		                                   cell->value.integer);
+		break;
+	case TRACKER_BINARY_VALUE_DOUBLE: {
+		gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+		g_ascii_dtostr (buf, sizeof (buf), cell->value.number);
+		cell->formatted = g_strdup (buf);
+		break;
+	}
+	case TRACKER_BINARY_VALUE_DATETIME: {
+		GDateTime *datetime;
+
+		datetime = cell_get_datetime (cell);
+		if (datetime) {
+			cell->formatted = tracker_date_format_iso8601 (datetime);
+			g_date_time_unref (datetime);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+
+	if (cell->formatted) {
+		cell->str = cell->formatted;
+		cell->len = strlen (cell->formatted);
+	}
+}
+
+static gint
+tracker_deserializer_binary_get_n_columns (TrackerSparqlCursor *cursor)
+{
+	TrackerDeserializerBinary *deserializer =
+		TRACKER_DESERIALIZER_BINARY (cursor);
+
+	return deserializer->vars->len;
+}
+
+static TrackerSparqlValueType
+tracker_deserializer_binary_get_value_type (TrackerSparqlCursor *cursor,
+                                            gint                 column)
+{
+	TrackerDeserializerBinary *deserializer =
+		TRACKER_DESERIALIZER_BINARY (cursor);
+	Cell *cell;
+
+	cell = get_cell (deserializer, column);
+	if (!cell)
+		return TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
+
+	return cell->type;
+}
+
+static const gchar *
+tracker_deserializer_binary_get_variable_name (TrackerSparqlCursor *cursor,
+                                               gint                 column)
+{
+	TrackerDeserializerBinary *deserializer =
+		TRACKER_DESERIALIZER_BINARY (cursor);
+
+	if (column < 0 || column >= (gint) deserializer->vars->len)
+		return NULL;
+
+	return g_ptr_array_index (deserializer->vars, column);
+}
+
+static const gchar *
+tracker_deserializer_binary_get_string (TrackerSparqlCursor  *cursor,
+                                        gint                  column,
+                                        const gchar         **langtag,
+                                        glong                *length)
+{
+	TrackerDeserializerBinary *deserializer =
+		TRACKER_DESERIALIZER_BINARY (cursor);
+	Cell *cell;
+
+	if (length)
+		*length = 0;
+	if (langtag)
+		*langtag = NULL;
+
+	cell = get_cell (deserializer, column);
+	if (!cell || cell->type == TRACKER_SPARQL_VALUE_TYPE_UNBOUND)
+		return NULL;
+
+	/* Typed values are only converted to strings on demand */
+	if (!cell->str)
+		format_cell (cell);
+
+	if (length)
+		*length = cell->len;
+	if (langtag)
+		*langtag = cell->langtag;
+
+	return cell->str;
+}
+
+static gint64
+tracker_deserializer_binary_get_integer (TrackerSparqlCursor *cursor,
+                                         gint                 column)
+{
+	TrackerDeserializerBinary *deserializer =
+		TRACKER_DESERIALIZER_BINARY (cursor);
+	Cell *cell;
+
+	cell = get_cell (deserializer, column);
+	if (cell && cell->tag == TRACKER_BINARY_VALUE_INTEGER)
+		return cell->value.integer;
+
+	return TRACKER_SPARQL_CURSOR_CLASS (tracker_deserializer_binary_parent_class)->get_integer (cursor, column);
+}
+
+static gdouble
+tracker_deserializer_binary_get_double (TrackerSparqlCursor *cursor,
+                                        gint                 column)
+{
+	TrackerDeserializerBinary *deserializer =
+		TRACKER_DESERIALIZER_BINARY (cursor);
+	Cell *cell;
+
+	cell = get_cell (deserializer, column);
+	if (cell && cell->tag == TRACKER_BINARY_VALUE_DOUBLE)
+		return cell->value.number;
+	if (cell && cell->tag == TRACKER_BINARY_VALUE_INTEGER)
+		return (gdouble) cell->value.integer;
+
+	return TRACKER_SPARQL_CURSOR_CLASS (tracker_deserializer_binary_parent_class)->get_double (cursor, column);
+}
+
+static gboolean
+tracker_deserializer_binary_get_boolean (TrackerSparqlCursor *cursor,
+                                         gint                 column)
+{
+	TrackerDeserializerBinary *deserializer =
+		TRACKER_DESERIALIZER_BINARY (cursor);
+	Cell *cell;
+
+	cell = get_cell (deserializer, column);
+	if (cell && cell->tag == TRACKER_BINARY_VALUE_TRUE)
+		return TRUE;
+	if (cell && cell->tag == TRACKER_BINARY_VALUE_FALSE)
+		return FALSE;
+
+	return TRACKER_SPARQL_CURSOR_CLASS (tracker_deserializer_binary_parent_class)->get_boolean (cursor, column);
+}
+
+static GDateTime *
+tracker_deserializer_binary_get_datetime (TrackerSparqlCursor *cursor,
+                                          gint                 column)
+{
+	TrackerDeserializerBinary *deserializer =
+		TRACKER_DESERIALIZER_BINARY (cursor);
+	Cell *cell;
+
+	cell = get_cell (deserializer, column);
+	if (cell && cell->tag == TRACKER_BINARY_VALUE_DATETIME)
+		return cell_get_datetime (cell);
+
+	return TRACKER_SPARQL_CURSOR_CLASS (tracker_deserializer_binary_parent_class)->get_datetime (cursor, column);
+}
+
+static gboolean
+tracker_deserializer_binary_next (TrackerSparqlCursor  *cursor,
+                                  GCancellable         *cancellable,
+                                  GError              **error)
+{
+	TrackerDeserializerBinary *deserializer =
+		TRACKER_DESERIALIZER_BINARY (cursor);
+	guint32 len;
+
+	if (deserializer->init_error) {
+		GError *init_error;
+
+		init_error = g_steal_pointer (&deserializer->init_error);
+		g_propagate_error (error, init_error);
+		return FALSE;
+	}
+
+	if (deserializer->finished)
+		return FALSE;
+
+	if (deserializer->n_rows > 0 &&
+	    deserializer->row + 1 < (gint) deserializer->n_rows) {
+		deserializer->row++;
+		return TRUE;
+	}
+
+	if (g_cancellable_set_error_if_cancelled (cancellable, error))
+		return FALSE;
+
+	deserializer->n_rows = 0;
+	g_array_set_size (deserializer->cells, 0);
+
+	if (!read_frame (deserializer, cancellable, &len, error) ||
+	    len == 0 ||
+	    !parse_block (deserializer, len, error)) {
+		deserializer->finished = TRUE;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+tracker_deserializer_binary_next_async (TrackerSparqlCursor  *cursor,
+                                        GCancellable         *cancellable,
+                                        GAsyncReadyCallback   cb,
+                                        gpointer              user_data)
+{
+	GError *error = NULL;
+	GTask *task;
+
+	task = g_task_new (cursor, cancellable, cb, user_data);
+
+	if (tracker_sparql_cursor_next (cursor, cancellable, &error))
+		g_task_return_boolean (task, TRUE);
+	else if (!error)
+		g_task_return_boolean (task, FALSE);
+	else
+		g_task_return_error (task, error);
+
+	g_object_unref (task);
+}
+
+static gboolean
+tracker_deserializer_binary_next_finish (TrackerSparqlCursor  *cursor,
+                                         GAsyncResult         *res,
+                                         GError              **error)
+{
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+static gboolean
+tracker_deserializer_binary_get_parser_location (TrackerDeserializer  *deserializer,
+                                                 const char          **name,
+                                                 goffset              *line_no,
+                                                 goffset              *column_no)
+{
+	if (name)
+		*name = tracker_deserializer_get_name (deserializer);
+
+	return FALSE;
+}
+
+static void
+tracker_deserializer_binary_class_init (TrackerDeserializerBinaryClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	TrackerSparqlCursorClass *cursor_class =
+		TRACKER_SPARQL_CURSOR_CLASS (klass);
+	TrackerDeserializerClass *deserializer_class =
+		TRACKER_DESERIALIZER_CLASS (klass);
+
+	object_class->finalize = tracker_deserializer_binary_finalize;
+	object_class->constructed = tracker_deserializer_binary_constructed;
+
+	cursor_class->get_n_columns = tracker_deserializer_binary_get_n_columns;
+	cursor_class->get_value_type = tracker_deserializer_binary_get_value_type;
+	cursor_class->get_variable_name = tracker_deserializer_binary_get_variable_name;
+	cursor_class->get_string = tracker_deserializer_binary_get_string;
+	cursor_class->get_integer = tracker_deserializer_binary_get_integer;
+	cursor_class->get_double = tracker_deserializer_binary_get_double;
+	cursor_class->get_boolean = tracker_deserializer_binary_get_boolean;
+	cursor_class->get_datetime = tracker_deserializer_binary_get_datetime;
+	cursor_class->next = tracker_deserializer_binary_next;
+	cursor_class->next_async = tracker_deserializer_binary_next_async;
+	cursor_class->next_finish = tracker_deserializer_binary_next_finish;
+
+	deserializer_class->get_parser_location =
+		tracker_deserializer_binary_get_parser_location;
+}
+
+static void
+tracker_deserializer_binary_init (TrackerDeserializerBinary *deserializer)
+{
+	deserializer->block = g_byte_array_new ();
+	deserializer->cells = g_array_new (FALSE, TRUE, sizeof (Cell));
+	g_array_set_clear_func (deserializer->cells, clear_cell);
+	deserializer->column_cells = g_array_new (FALSE, FALSE, sizeof (gint));
+	deserializer->unbound.type = TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
+	deserializer->unbound.tag = TRACKER_BINARY_VALUE_UNBOUND;
+	deserializer->dictionary = g_ptr_array_new_with_free_func (g_free);
+	deserializer->vars = g_ptr_array_new_with_free_func (g_free);
+}
+
+TrackerSparqlCursor *
+tracker_deserializer_binary_new (GInputStream            *stream,
+                                 TrackerNamespaceManager *namespaces)
+{
+	return g_object_new (TRACKER_TYPE_DESERIALIZER_BINARY,
+	                     "stream", stream,
+	                     "namespace-manager", namespaces,
+	                     NULL);
+}
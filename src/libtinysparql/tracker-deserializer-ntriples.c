@@ -0,0 +1,788 @@
+/*
+ * Copyright (C) 2026, Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/* Deserialization to cursors for the N-Triples format defined at:
+ *  https://www.w3.org/TR/n-triples/
+ *
+ * And the related N-Quads format defined at:
+ *  https://www.w3.org/TR/n-quads/
+ *
+ * Both formats have one statement per line, so the input is split
+ * in chunks at line boundaries, and these are parsed in parallel by
+ * a thread pool. Statements are still returned in stream order.
+ */
+
+#include "config.h"
+
+#include "tracker-deserializer-ntriples.h"
+
+#include <string.h>
+
+#include "core/tracker-sparql-grammar.h"
+#include "tracker-private.h"
+
+#define CHUNK_SIZE (256 * 1024)
+#define MAX_PENDING_CHUNKS_PER_THREAD 2
+#define NO_VALUE G_MAXSIZE
+
+typedef struct {
+	gsize subject;
+	gsize predicate;
+	gsize object;
+	gsize object_lang;
+	gsize graph;
+	guint line;
+	guint subject_is_bnode : 1;
+	guint object_is_uri : 1;
+	guint object_is_bnode : 1;
+} Statement;
+
+typedef struct {
+	gchar *data;
+	gsize len;
+	/* Nul separated unescaped strings, referenced by offset */
+	GString *strings;
+	GArray *statements;
+	GError *error;
+	guint n_lines;
+	goffset error_column;
+	gboolean parse_quads;
+	gboolean done;
+} Chunk;
+
+struct _TrackerDeserializerNTriples {
+	TrackerDeserializerRdf parent_instance;
+	GThreadPool *pool;
+	GMutex mutex;
+	GCond cond;
+	GQueue chunks;
+	GByteArray *buffer;
+	Chunk *current;
+	gint cur_statement;
+	guint max_pending;
+	goffset chunk_line_no;
+	gboolean parse_quads;
+	gboolean eof;
+	gboolean failed;
+};
+
+G_DEFINE_TYPE (TrackerDeserializerNTriples,
+               tracker_deserializer_ntriples,
+               TRACKER_TYPE_DESERIALIZER_RDF)
+
+static void
+chunk_free (Chunk *chunk)
+{
+	g_free (chunk->data);
+	g_string_free (chunk->strings, TRUE);
+	g_array_unref (chunk->statements);
+	g_clear_error (&chunk->error);
+	g_free (chunk);
+}
+
+static gchar
+unescape_char (gchar ch)
+{
+	switch (ch) {
+	case 't':
+		return '\t';
+	case 'b':
+		return '\b';
+	case 'n':
+		return '\n';
+	case 'r':
+		return '\r';
+	case 'f':
+		return '\f';
+	case '"':
+	case '\'':
+	case '\\':
+		return ch;
+	default:
+		return '\0';
+	}
+}
+
+static gboolean
+append_unescaped (GString     *strings,
+                  const gchar *str,
+                  const gchar *end,
+                  gboolean     is_iri,
+                  gsize       *offset_out)
+{
+	gsize offset = strings->len;
+
+	while (str < end) {
+		const gchar *backslash;
+		gunichar ch = 0;
+		gchar c;
+		gint i, n_digits;
+
+		backslash = memchr (str, '\\', end - str);
+		if (!backslash) {
+			g_string_append_len (strings, str, end - str);
+			break;
+		}
+
+		g_string_append_len (strings, str, backslash - str);
+		str = backslash + 1;
+		if (str == end)
+			goto error;
+
+		if (*str == 'u' || *str == 'U') {
+			n_digits = (*str == 'u') ? 4 : 8;
+			if (end - str <= n_digits)
+				goto error;
+
+			for (i = 1; i <= n_digits; i++) {
+				if (!g_ascii_isxdigit (str[i]))
+					goto error;
+				ch = (ch << 4) | g_ascii_xdigit_value (str[i]);
+			}
+
+			if (ch == 0 || !g_unichar_validate (ch))
+				goto error;
+
+			g_string_append_unichar (strings, ch);
+			str += n_digits + 1;
+		} else if (!is_iri && (c = unescape_char (*str)) != '\0') {
+			g_string_append_c (strings, c);
+			str++;
+		} else {
+			goto error;
+		}
+	}
+
+	g_string_append_c (strings, '\0');
+	*offset_out = offset;
+	return TRUE;
+
+ error:
+	g_string_truncate (strings, offset);
+	return FALSE;
+}
+
+static void
+skip_whitespace (const gchar **cur,
+                 const gchar  *end)
+{
+	while (*cur < end && (**cur == ' ' || **cur == '\t'))
+		(*cur)++;
+}
+
+static gboolean
+parse_iri (Chunk        *chunk,
+           const gchar **cur,
+           const gchar  *end,
+           gsize        *offset_out)
+{
+	const gchar *str = *cur, *start;
+
+	if (str == end || *str != '<')
+		return FALSE;
+
+	start = ++str;
+
+	while (str < end && *str != '>') {
+		if ((guchar) *str <= 0x20 || strchr ("<\"{}|^`", *str))
+			return FALSE;
+		str++;
+	}
+
+	if (str == end)
+		return FALSE;
+
+	if (!append_unescaped (chunk->strings, start, str, TRUE, offset_out))
+		return FALSE;
+
+	*cur = str + 1;
+	return TRUE;
+}
+
+static gboolean
+parse_blank_node (Chunk        *chunk,
+                  const gchar **cur,
+                  const gchar  *end,
+                  gsize        *offset_out)
+{
+	const gchar *str;
+
+	if (!terminal_BLANK_NODE_LABEL (*cur, end, &str))
+		return FALSE;
+
+	*offset_out = chunk->strings->len;
+	g_string_append_len (chunk->strings, *cur, str - *cur);
+	g_string_append_c (chunk->strings, '\0');
+	*cur = str;
+	return TRUE;
+}
+
+static gboolean
+parse_literal (Chunk        *chunk,
+               const gchar **cur,
+               const gchar  *end,
+               gsize        *offset_out,
+               gsize        *lang_offset_out)
+{
+	const gchar *str = *cur, *start;
+	gsize datatype;
+
+	if (str == end || *str != '"')
+		return FALSE;
+
+	start = ++str;
+
+	while (str < end && *str != '"') {
+		if (*str == '\\')
+			str++;
+		str++;
+	}
+
+	if (str >= end)
+		return FALSE;
+
+	if (!append_unescaped (chunk->strings, start, str, FALSE, offset_out))
+		return FALSE;
+
+	*cur = str + 1;
+
+	if (*cur < end && **cur == '@') {
+		if (!terminal_LANGTAG (*cur, end, &str))
+			return FALSE;
+
+		/* Skip '@' starting langtag */
+		*lang_offset_out = chunk->strings->len;
+		g_string_append_len (chunk->strings, *cur + 1, str - *cur - 1);
+		g_string_append_c (chunk->strings, '\0');
+		*cur = str;
+	} else if (end - *cur >= 2 && strncmp (*cur, "^^", 2) == 0) {
+		/* These actually go ignored, imposed by the ontology */
+		*cur += 2;
+		if (!parse_iri (chunk, cur, end, &datatype))
+			return FALSE;
+
+		g_string_truncate (chunk->strings, datatype);
+	}
+
+	return TRUE;
+}
+
+static gboolean
+parse_line (Chunk        *chunk,
+            const gchar  *line,
+            const gchar  *end,
+            const gchar **error_pos)
+{
+	Statement statement = { 0, };
+	const gchar *cur = line;
+
+	skip_whitespace (&cur, end);
+
+	/* Empty line or comment */
+	if (cur == end || *cur == '#')
+		return TRUE;
+
+	statement.object_lang = NO_VALUE;
+	statement.graph = NO_VALUE;
+	statement.line = chunk->n_lines;
+
+	if (parse_iri (chunk, &cur, end, &statement.subject)) {
+		statement.subject_is_bnode = FALSE;
+	} else if (parse_blank_node (chunk, &cur, end, &statement.subject)) {
+		statement.subject_is_bnode = TRUE;
+	} else {
+		g_set_error (&chunk->error,
+		             TRACKER_SPARQL_ERROR,
+		             TRACKER_SPARQL_ERROR_PARSE,
+		             "Wrong subject token");
+		goto error;
+	}
+
+	skip_whitespace (&cur, end);
+
+	if (!parse_iri (chunk, &cur, end, &statement.predicate)) {
+		g_set_error (&chunk->error,
+		             TRACKER_SPARQL_ERROR,
+		             TRACKER_SPARQL_ERROR_PARSE,
+		             "Wrong predicate token");
+		goto error;
+	}
+
+	skip_whitespace (&cur, end);
+
+	if (parse_iri (chunk, &cur, end, &statement.object)) {
+		statement.object_is_uri = TRUE;
+	} else if (parse_blank_node (chunk, &cur, end, &statement.object)) {
+		statement.object_is_uri = TRUE;
+		statement.object_is_bnode = TRUE;
+	} else if (!parse_literal (chunk, &cur, end,
+	                           &statement.object,
+	                           &statement.object_lang)) {
+		g_set_error (&chunk->error,
+		             TRACKER_SPARQL_ERROR,
+		             TRACKER_SPARQL_ERROR_PARSE,
+		             "Wrong object token");
+		goto error;
+	}
+
+	skip_whitespace (&cur, end);
+
+	if (chunk->parse_quads && cur < end && *cur == '<') {
+		if (!parse_iri (chunk, &cur, end, &statement.graph)) {
+			g_set_error (&chunk->error,
+			             TRACKER_SPARQL_ERROR,
+			             TRACKER_SPARQL_ERROR_PARSE,
+			             "Wrong graph token");
+			goto error;
+		}
+
+		skip_whitespace (&cur, end);
+	}
+
+	if (cur == end || *cur != '.') {
+		g_set_error (&chunk->error,
+		             TRACKER_SPARQL_ERROR,
+		             TRACKER_SPARQL_ERROR_PARSE,
+		             "Expected dot");
+		goto error;
+	}
+
+	cur++;
+	skip_whitespace (&cur, end);
+
+	if (cur < end && *cur != '#') {
+		g_set_error (&chunk->error,
+		             TRACKER_SPARQL_ERROR,
+		             TRACKER_SPARQL_ERROR_PARSE,
+		             "Expected end of line");
+		goto error;
+	}
+
+	g_array_append_val (chunk->statements, statement);
+	return TRUE;
+
+ error:
+	*error_pos = cur;
+	return FALSE;
+}
+
+static void
+parse_chunk (gpointer data,
+             gpointer user_data)
+{
+	TrackerDeserializerNTriples *deserializer = user_data;
+	Chunk *chunk = data;
+	const gchar *line, *end, *error_pos;
+
+	line = chunk->data;
+	end = &chunk->data[chunk->len];
+
+	while (line < end) {
+		const gchar *eol, *line_end;
+
+		eol = memchr (line, '\n', end - line);
+		line_end = eol ? eol : end;
+
+		if (line_end > line && line_end[-1] == '\r')
+			line_end--;
+
+		if (!g_utf8_validate_len (line, line_end - line, &error_pos)) {
+			g_set_error (&chunk->error,
+			             TRACKER_SPARQL_ERROR,
+			             TRACKER_SPARQL_ERROR_PARSE,
+			             "Invalid UTF-8");
+			chunk->error_column = error_pos - line + 1;
+			break;
+		}
+
+		if (!parse_line (chunk, line, line_end, &error_pos)) {
+			chunk->error_column = error_pos - line + 1;
+			break;
+		}
+
+		chunk->n_lines++;
+		line = eol ? eol + 1 : end;
+	}
+
+	g_mutex_lock (&deserializer->mutex);
+	chunk->done = TRUE;
+	g_cond_broadcast (&deserializer->cond);
+	g_mutex_unlock (&deserializer->mutex);
+}
+
+static gboolean
+read_chunk (TrackerDeserializerNTriples  *deserializer,
+            GCancellable                 *cancellable,
+            GError                      **error)
+{
+	GInputStream *stream;
+	GByteArray *buffer = deserializer->buffer;
+	GError *inner_error = NULL;
+	Chunk *chunk;
+	gsize len = 0;
+
+	stream = tracker_deserializer_get_stream (TRACKER_DESERIALIZER (deserializer));
+
+	while (TRUE) {
+		gsize prev_len = buffer->len, bytes_read, i;
+
+		g_byte_array_set_size (buffer, prev_len + CHUNK_SIZE);
+
+		if (!g_input_stream_read_all (stream,
+		                              &buffer->data[prev_len],
+		                              CHUNK_SIZE,
+		                              &bytes_read,
+		                              cancellable,
+		                              &inner_error)) {
+			g_byte_array_set_size (buffer, prev_len);
+			g_propagate_error (error, inner_error);
+			return FALSE;
+		}
+
+		g_byte_array_set_size (buffer, prev_len + bytes_read);
+
+		if (bytes_read < CHUNK_SIZE) {
+			deserializer->eof = TRUE;
+			len = buffer->len;
+			break;
+		}
+
+		/* Cut the chunk after the last complete line */
+		for (i = buffer->len; i > prev_len; i--) {
+			if (buffer->data[i - 1] == '\n') {
+				len = i;
+				break;
+			}
+		}
+
+		if (len > 0)
+			break;
+	}
+
+	if (len == 0)
+		return TRUE;
+
+	chunk = g_new0 (Chunk, 1);
+	chunk->data = g_malloc (len);
+	memcpy (chunk->data, buffer->data, len);
+	chunk->len = len;
+	chunk->strings = g_string_sized_new (len);
+	chunk->statements = g_array_new (FALSE, FALSE, sizeof (Statement));
+	chunk->parse_quads = deserializer->parse_quads;
+	g_byte_array_remove_range (buffer, 0, len);
+
+	g_queue_push_tail (&deserializer->chunks, chunk);
+
+	if (!g_thread_pool_push (deserializer->pool, chunk, &inner_error)) {
+		/* Parse synchronously */
+		g_clear_error (&inner_error);
+		parse_chunk (chunk, deserializer);
+	}
+
+	return TRUE;
+}
+
+static void
+stop_parsing (TrackerDeserializerNTriples *deserializer)
+{
+	if (deserializer->pool) {
+		/* Drop unstarted chunks, and wait for the ongoing ones */
+		g_thread_pool_free (deserializer->pool, TRUE, TRUE);
+		deserializer->pool = NULL;
+	}
+
+	g_queue_clear_full (&deserializer->chunks, (GDestroyNotify) chunk_free);
+	g_clear_pointer (&deserializer->current, chunk_free);
+}
+
+static void
+tracker_deserializer_ntriples_finalize (GObject *object)
+{
+	TrackerDeserializerNTriples *deserializer = TRACKER_DESERIALIZER_NTRIPLES (object);
+
+	tracker_sparql_cursor_close (TRACKER_SPARQL_CURSOR (deserializer));
+
+	g_clear_pointer (&deserializer->buffer, g_byte_array_unref);
+	g_mutex_clear (&deserializer->mutex);
+	g_cond_clear (&deserializer->cond);
+
+	G_OBJECT_CLASS (tracker_deserializer_ntriples_parent_class)->finalize (object);
+}
+
+static void
+tracker_deserializer_ntriples_constructed (GObject *object)
+{
+	TrackerDeserializerNTriples *deserializer = TRACKER_DESERIALIZER_NTRIPLES (object);
+	guint n_threads;
+
+	G_OBJECT_CLASS (tracker_deserializer_ntriples_parent_class)->constructed (object);
+
+	g_object_get (object,
+	              "has-graph", &deserializer->parse_quads,
+	              NULL);
+
+	n_threads = MAX (g_get_num_processors (), 1);
+	deserializer->max_pending = n_threads * MAX_PENDING_CHUNKS_PER_THREAD;
+	deserializer->pool = g_thread_pool_new (parse_chunk, deserializer,
+	                                        n_threads, FALSE, NULL);
+}
+
+static Statement *
+get_current_statement (TrackerDeserializerNTriples *deserializer)
+{
+	if (!deserializer->current ||
+	    deserializer->cur_statement < 0 ||
+	    (guint) deserializer->cur_statement >= deserializer->current->statements->len)
+		return NULL;
+
+	return &g_array_index (deserializer->current->statements,
+	                       Statement, deserializer->cur_statement);
+}
+
+static TrackerSparqlValueType
+tracker_deserializer_ntriples_get_value_type (TrackerSparqlCursor *cursor,
+                                              gint                 column)
+{
+	TrackerDeserializerNTriples *deserializer = TRACKER_DESERIALIZER_NTRIPLES (cursor);
+	Statement *statement;
+
+	statement = get_current_statement (deserializer);
+	if (!statement)
+		return TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
+
+	switch (column) {
+	case TRACKER_RDF_COL_SUBJECT:
+		if (statement->subject_is_bnode)
+			return TRACKER_SPARQL_VALUE_TYPE_BLANK_NODE;
+		else
+			return TRACKER_SPARQL_VALUE_TYPE_URI;
+	case TRACKER_RDF_COL_PREDICATE:
+		return TRACKER_SPARQL_VALUE_TYPE_URI;
+	case TRACKER_RDF_COL_OBJECT:
+		if (statement->object_is_bnode)
+			return TRACKER_SPARQL_VALUE_TYPE_BLANK_NODE;
+		else if (statement->object_is_uri)
+			return TRACKER_SPARQL_VALUE_TYPE_URI;
+		else
+			return TRACKER_SPARQL_VALUE_TYPE_STRING;
+	case TRACKER_RDF_COL_GRAPH:
+		if (deserializer->parse_quads && statement->graph != NO_VALUE)
+			return TRACKER_SPARQL_VALUE_TYPE_URI;
+		else
+			return TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
+	default:
+		return TRACKER_SPARQL_VALUE_TYPE_UNBOUND;
+	}
+}
+
+static const gchar *
+tracker_deserializer_ntriples_get_string (TrackerSparqlCursor  *cursor,
+                                          gint                  column,
+                                          const gchar         **langtag,
+                                          glong                *length)
+{
+	TrackerDeserializerNTriples *deserializer = TRACKER_DESERIALIZER_NTRIPLES (cursor);
+	Statement *statement;
+	const gchar *strings;
+	gsize offset = NO_VALUE;
+
+	if (length)
+		*length = 0;
+	if (langtag)
+		*langtag = NULL;
+
+	statement = get_current_statement (deserializer);
+	if (!statement)
+		return NULL;
+
+	strings = deserializer->current->strings->str;
+
+	switch (column) {
+	case TRACKER_RDF_COL_SUBJECT:
+		offset = statement->subject;
+		break;
+	case TRACKER_RDF_COL_PREDICATE:
+		offset = statement->predicate;
+		break;
+	case TRACKER_RDF_COL_OBJECT:
+		if (langtag && statement->object_lang != NO_VALUE)
+			*langtag = &strings[statement->object_lang];
+		offset = statement->object;
+		break;
+	case TRACKER_RDF_COL_GRAPH:
+		if (deserializer->parse_quads)
+			offset = statement->graph;
+		break;
+	}
+
+	if (offset == NO_VALUE)
+		return NULL;
+
+	if (length)
+		*length = strlen (&strings[offset]);
+
+	return &strings[offset];
+}
+
+static gboolean
+tracker_deserializer_ntriples_next (TrackerSparqlCursor  *cursor,
+                                    GCancellable         *cancellable,
+                                    GError              **error)
+{
+	TrackerDeserializerNTriples *deserializer = TRACKER_DESERIALIZER_NTRIPLES (cursor);
+	Chunk *chunk;
+
+	if (deserializer->failed || !deserializer->pool)
+		return FALSE;
+
+	while (TRUE) {
+		chunk = deserializer->current;
+
+		if (chunk) {
+			deserializer->cur_statement++;
+
+			if ((guint) deserializer->cur_statement < chunk->statements->len)
+				return TRUE;
+
+			if (chunk->error) {
+				/* Keep the chunk around for the parser location */
+				deserializer->failed = TRUE;
+				g_propagate_error (error, g_steal_pointer (&chunk->error));
+				return FALSE;
+			}
+
+			deserializer->chunk_line_no += chunk->n_lines;
+			g_clear_pointer (&deserializer->current, chunk_free);
+		}
+
+		while (!deserializer->eof &&
+		       deserializer->chunks.length < deserializer->max_pending) {
+			if (!read_chunk (deserializer, cancellable, error)) {
+				deserializer->failed = TRUE;
+				return FALSE;
+			}
+		}
+
+		chunk = g_queue_pop_head (&deserializer->chunks);
+		if (!chunk)
+			return FALSE;
+
+		g_mutex_lock (&deserializer->mutex);
+		while (!chunk->done)
+			g_cond_wait (&deserializer->cond, &deserializer->mutex);
+		g_mutex_unlock (&deserializer->mutex);
+
+		deserializer->current = chunk;
+		deserializer->cur_statement = -1;
+	}
+}
+
+static void
+tracker_deserializer_ntriples_close (TrackerSparqlCursor *cursor)
+{
+	TrackerDeserializerNTriples *deserializer = TRACKER_DESERIALIZER_NTRIPLES (cursor);
+
+	stop_parsing (deserializer);
+
+	TRACKER_SPARQL_CURSOR_CLASS (tracker_deserializer_ntriples_parent_class)->close (cursor);
+}
+
+static gboolean
+tracker_deserializer_ntriples_get_parser_location (TrackerDeserializer  *deserializer,
+                                                   const char          **name,
+                                                   goffset              *line_no,
+                                                   goffset              *column_no)
+{
+	TrackerDeserializerNTriples *deserializer_nt = TRACKER_DESERIALIZER_NTRIPLES (deserializer);
+	Statement *statement;
+
+	if (name)
+		*name = tracker_deserializer_get_name (deserializer);
+
+	statement = get_current_statement (deserializer_nt);
+
+	if (statement) {
+		*line_no = deserializer_nt->chunk_line_no + statement->line;
+		*column_no = 1;
+	} else if (deserializer_nt->current &&
+	           deserializer_nt->current->error_column > 0) {
+		*line_no = deserializer_nt->chunk_line_no + deserializer_nt->current->n_lines;
+		*column_no = deserializer_nt->current->error_column;
+	} else {
+		*line_no = deserializer_nt->chunk_line_no;
+		*column_no = 1;
+	}
+
+	return TRUE;
+}
+
+static void
+tracker_deserializer_ntriples_class_init (TrackerDeserializerNTriplesClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	TrackerSparqlCursorClass *cursor_class = TRACKER_SPARQL_CURSOR_CLASS (klass);
+	TrackerDeserializerClass *deserializer_class = TRACKER_DESERIALIZER_CLASS (klass);
+
+	object_class->finalize = tracker_deserializer_ntriples_finalize;
+	object_class->constructed = tracker_deserializer_ntriples_constructed;
+
+	cursor_class->get_value_type = tracker_deserializer_ntriples_get_value_type;
+	cursor_class->get_string = tracker_deserializer_ntriples_get_string;
+	cursor_class->next = tracker_deserializer_ntriples_next;
+	cursor_class->close = tracker_deserializer_ntriples_close;
+
+	deserializer_class->get_parser_location = tracker_deserializer_ntriples_get_parser_location;
+}
+
+static void
+tracker_deserializer_ntriples_init (TrackerDeserializerNTriples *deserializer)
+{
+	g_mutex_init (&deserializer->mutex);
+	g_cond_init (&deserializer->cond);
+	g_queue_init (&deserializer->chunks);
+	deserializer->buffer = g_byte_array_new ();
+	deserializer->chunk_line_no = 1;
+	deserializer->cur_statement = -1;
+}
+
+TrackerSparqlCursor *
+tracker_deserializer_ntriples_new (GInputStream            *istream,
+                                   TrackerNamespaceManager *namespaces)
+{
+	g_return_val_if_fail (G_IS_INPUT_STREAM (istream), NULL);
+
+	return g_object_new (TRACKER_TYPE_DESERIALIZER_NTRIPLES,
+	                     "stream", istream,
+	                     "namespace-manager", namespaces,
+	                     "has-graph", FALSE,
+	                     NULL);
+}
+
+TrackerSparqlCursor *
+tracker_deserializer_nquads_new (GInputStream            *istream,
+                                 TrackerNamespaceManager *namespaces)
+{
+	g_return_val_if_fail (G_IS_INPUT_STREAM (istream), NULL);
+
+	return g_object_new (TRACKER_TYPE_DESERIALIZER_NTRIPLES,
+	                     "stream", istream,
+	                     "namespace-manager", namespaces,
+	                     "has-graph", TRUE,
+	                     NULL);
+}
@@ -23,8 +23,10 @@
 
 #include "tracker-deserializer.h"
 #include "tracker-deserializer-turtle.h"
+#include "tracker-deserializer-binary.h"
 #include "tracker-deserializer-json.h"
 #include "tracker-deserializer-json-ld.h"
+#include "tracker-deserializer-ntriples.h"
 #include "tracker-deserializer-xml.h"
 
 #include "tracker-private.h"
@@ -169,6 +171,12 @@ tracker_deserializer_new (GInputStream            *stream,
 		return tracker_deserializer_trig_new (stream, namespaces);
 	case TRACKER_SERIALIZER_FORMAT_JSON_LD:
 		return tracker_deserializer_json_ld_new (stream, namespaces);
+	case TRACKER_SERIALIZER_FORMAT_BINARY:
+		return tracker_deserializer_binary_new (stream, namespaces);
+	case TRACKER_SERIALIZER_FORMAT_NTRIPLES:
+		return tracker_deserializer_ntriples_new (stream, namespaces);
+	case TRACKER_SERIALIZER_FORMAT_NQUADS:
+		return tracker_deserializer_nquads_new (stream, namespaces);
 	default:
 		g_warn_if_reached ();
 		return NULL;
@@ -194,6 +202,12 @@ pick_format_for_file (GFile *file)
 	case TRACKER_RDF_FORMAT_JSON_LD:
 		format = TRACKER_SERIALIZER_FORMAT_JSON_LD;
 		break;
+	case TRACKER_RDF_FORMAT_N_TRIPLES:
+		format = TRACKER_SERIALIZER_FORMAT_NTRIPLES;
+		break;
+	case TRACKER_RDF_FORMAT_N_QUADS:
+		format = TRACKER_SERIALIZER_FORMAT_NQUADS;
+		break;
 	default:
 		g_assert_not_reached ();
 		break;
@@ -63,6 +63,11 @@
  *
  * A `TrackerEndpointDBus` may be created on a different thread/main
  * context from the one that created [class@SparqlConnection].
+ *
+ * Endpoints created with the [property@EndpointDBus:peer-to-peer] property
+ * additionally listen on a private socket, that unsandboxed clients from
+ * the same user will transparently use for queries and updates, bypassing
+ * the message bus.
  */
 
 #include "config.h"
@@ -79,6 +84,14 @@
 #include <gio/gunixoutputstream.h>
 #include <gio/gunixfdlist.h>
 #include <glib-unix.h>
+#include <glib/gstdio.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 static const gchar introspection_xml[] =
 	"<node>"
@@ -89,6 +102,36 @@ static const gchar introspection_xml[] =
 	"      <arg type='a{sv}' name='arguments' direction='in' />"
 	"      <arg type='as' name='result' direction='out' />"
 	"    </method>"
+	"    <method name='QueryCursor'>"
+	"      <arg type='s' name='query' direction='in' />"
+	"      <arg type='h' name='output_stream' direction='in' />"
+	"      <arg type='a{sv}' name='arguments' direction='in' />"
+	"      <arg type='u' name='max_format' direction='in' />"
+	"      <arg type='as' name='result' direction='out' />"
+	"      <arg type='u' name='format' direction='out' />"
+	"    </method>"
+	"    <method name='QueryBatch'>"
+	"      <arg type='a(sua{sv}h)' name='queries' direction='in' />"
+	"      <arg type='u' name='max_format' direction='in' />"
+	"      <arg type='a(asu)' name='results' direction='out' />"
+	"    </method>"
+	"    <method name='Prepare'>"
+	"      <arg type='s' name='query' direction='in' />"
+	"      <arg type='u' name='handle' direction='out' />"
+	"    </method>"
+	"    <method name='Execute'>"
+	"      <arg type='u' name='handle' direction='in' />"
+	"      <arg type='s' name='checksum' direction='in' />"
+	"      <arg type='h' name='output_stream' direction='in' />"
+	"      <arg type='a{sv}' name='arguments' direction='in' />"
+	"      <arg type='u' name='max_format' direction='in' />"
+	"      <arg type='as' name='result' direction='out' />"
+	"      <arg type='u' name='format' direction='out' />"
+	"    </method>"
+	"    <method name='Release'>"
+	"      <arg type='u' name='handle' direction='in' />"
+	"      <arg type='s' name='checksum' direction='in' />"
+	"    </method>"
 	"    <method name='Serialize'>"
 	"      <arg type='s' name='query' direction='in' />"
 	"      <arg type='h' name='output_stream' direction='in' />"
@@ -113,9 +156,29 @@ static const gchar introspection_xml[] =
 	"      <arg type='s' name='default_graph' direction='in' />"
 	"      <arg type='a{sv}' name='arguments' direction='in' />"
 	"    </method>"
+	"    <method name='GetPeerAddress'>"
+	"      <arg type='s' name='address' direction='out' />"
+	"      <arg type='s' name='token' direction='out' />"
+	"    </method>"
+	"    <method name='AuthorizePeer'>"
+	"      <arg type='s' name='token' direction='in' />"
+	"    </method>"
+	"    <method name='Subscribe'>"
+	"      <arg type='as' name='classes' direction='in' />"
+	"      <arg type='as' name='properties' direction='in' />"
+	"      <arg type='u' name='filter' direction='out' />"
+	"    </method>"
+	"    <method name='Unsubscribe'>"
+	"      <arg type='u' name='filter' direction='in' />"
+	"    </method>"
 	"    <signal name='GraphUpdated'>"
 	"      <arg type='sa{ii}' name='updates' />"
 	"    </signal>"
+	"    <signal name='FilteredGraphUpdated'>"
+	"      <arg type='s' name='graph' />"
+	"      <arg type='a{ii}' name='updates' />"
+	"      <arg type='u' name='filter' />"
+	"    </signal>"
 	"  </interface>"
 	"</node>";
 
@@ -128,19 +191,61 @@ enum {
 	PROP_0,
 	PROP_DBUS_CONNECTION,
 	PROP_OBJECT_PATH,
+	PROP_PEER_TO_PEER,
+	PROP_NOTIFY_INTERVAL,
+	PROP_NOTIFY_MAX_EVENTS,
 	N_PROPS
 };
 
+/* Upper bounds of the rows and string data sent in a single frame */
+#define FRAME_MAX_ROWS 512
+#define FRAME_MAX_DATA_SIZE (256 * 1024)
+
+/* Sizes of the memfds holding frames. These start small so the
+ * first rows arrive early, and grow for large results.
+ */
+#define CHUNK_MIN_SIZE (256 * 1024)
+#define CHUNK_MAX_SIZE (16 * 1024 * 1024)
+/* Memfds sent before waiting for the client to consume them */
+#define CHUNK_MAX_IN_FLIGHT 2
+
+/* Upper bound of the statements prepared by a single client */
+#define MAX_PREPARED_STMTS 256
+
+/* Upper bound of the notification filters set up by a single client */
+#define MAX_NOTIFY_FILTERS 1024
+
+typedef struct _BatchRequest BatchRequest;
+
 typedef struct {
 	TrackerEndpointDBus *endpoint;
 	GDBusMethodInvocation *invocation;
+	BatchRequest *batch;
+	guint batch_idx;
+	GOutputStream *output_stream;
 	GDataOutputStream *data_stream;
+	TrackerBusCursorFormat cursor_format;
+	int chunk_fd;
+	gsize chunk_size;
+	gsize chunk_limit;
+	guint chunks_in_flight;
 	GCancellable *global_cancellable;
 	GCancellable *cancellable;
 	gulong cancellable_id;
 	GSource *source;
 } QueryRequest;
 
+/* Queries sent in a single QueryBatch call, the reply is sent
+ * once all of them got a cursor.
+ */
+struct _BatchRequest {
+	GDBusMethodInvocation *invocation;
+	GPtrArray *requests;
+	GPtrArray *cursors;
+	guint n_pending;
+	GError *error;
+};
+
 typedef struct {
 	TrackerEndpointDBus *endpoint;
 	GDBusMethodInvocation *invocation;
@@ -148,6 +253,38 @@ typedef struct {
 	gchar *query;
 } UpdateRequest;
 
+/* Statements prepared by a client, these are kept
+ * until released, or until the client goes away.
+ */
+typedef struct {
+	GHashTable *statements;
+	guint32 last_handle;
+	guint watch_id;
+} PreparedStatements;
+
+/* Handles are only meaningful together with the checksum of the
+ * query they were prepared from, clients may keep handles from a
+ * previous instance of the endpoint.
+ */
+typedef struct {
+	TrackerSparqlStatement *stmt;
+	gchar *checksum;
+} PreparedStatement;
+
+/* Notification filter set up by a client, events not matching
+ * it are only sent to the client if it listens to GraphUpdated.
+ */
+typedef struct {
+	TrackerEndpointDBus *endpoint;
+	GDBusConnection *connection;
+	gchar *sender;
+	gchar *client;
+	GStrv classes;
+	GStrv properties;
+	guint32 id;
+	guint watch_id;
+} NotifyFilter;
+
 static GParamSpec *props[N_PROPS] = { 0, };
 
 static guint signals[N_SIGNALS] = { 0, };
@@ -158,18 +295,108 @@ G_DEFINE_TYPE_WITH_CODE (TrackerEndpointDBus, tracker_endpoint_dbus, TRACKER_TYP
                          G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE, tracker_endpoint_dbus_initable_iface_init))
 
 static gboolean
-tracker_endpoint_dbus_block_call (TrackerEndpointDBus   *endpoint_dbus,
-                                  GDBusMethodInvocation *invocation)
+tracker_endpoint_dbus_block_call (TrackerEndpointDBus *endpoint_dbus,
+                                  const gchar         *sender)
 {
 	gboolean block;
 
 	g_signal_emit (endpoint_dbus, signals[BLOCK_CALL], 0,
-	               g_dbus_method_invocation_get_sender (invocation),
-	               &block);
+	               sender, &block);
 
 	return block;
 }
 
+static gchar *
+generate_peer_token (void)
+{
+	guint8 buf[16];
+	gchar *token;
+	gsize len = 0;
+	int fd, i;
+
+	/* Tokens grant access to the endpoint, try to make them unguessable */
+	fd = open ("/dev/urandom", O_RDONLY | O_CLOEXEC);
+
+	if (fd >= 0) {
+		while (len < sizeof (buf)) {
+			gssize n_read;
+
+			n_read = read (fd, &buf[len], sizeof (buf) - len);
+			if (n_read <= 0)
+				break;
+			len += n_read;
+		}
+
+		close (fd);
+	}
+
+	for (i = len; i < (int) sizeof (buf); i++)
+		buf[i] = g_random_int_range (0, 256);
+
+	token = g_new0 (gchar, sizeof (buf) * 2 + 1);
+
+	for (i = 0; i < (int) sizeof (buf); i++)
+		g_snprintf (&token[i * 2], 3, "%.2x", buf[i]);
+
+	return token;
+}
+
+static gboolean
+sender_matches (gpointer key,
+                gpointer value,
+                gpointer user_data)
+{
+	return g_strcmp0 (value, user_data) == 0;
+}
+
+static const gchar *
+create_peer_token (TrackerEndpointDBus *endpoint_dbus,
+                   const gchar         *sender)
+{
+	gchar *token;
+
+	/* Only the last token handed to a client is valid */
+	g_hash_table_foreach_remove (endpoint_dbus->peer_tokens,
+	                             sender_matches,
+	                             (gpointer) sender);
+
+	token = generate_peer_token ();
+	g_hash_table_insert (endpoint_dbus->peer_tokens,
+	                     token, g_strdup (sender));
+
+	return token;
+}
+
+static void
+authorize_peer (TrackerEndpointDBus   *endpoint_dbus,
+                GDBusMethodInvocation *invocation,
+                const gchar           *token)
+{
+	GDBusConnection *connection;
+	gpointer stored_token, sender;
+
+	connection = g_dbus_method_invocation_get_connection (invocation);
+
+	if (!endpoint_dbus->peer_connections ||
+	    !g_hash_table_contains (endpoint_dbus->peer_connections, connection) ||
+	    !g_hash_table_lookup_extended (endpoint_dbus->peer_tokens, token,
+	                                   &stored_token, &sender)) {
+		g_dbus_method_invocation_return_error (invocation,
+		                                       G_DBUS_ERROR,
+		                                       G_DBUS_ERROR_ACCESS_DENIED,
+		                                       "Operation not allowed");
+		return;
+	}
+
+	/* Tokens are single use */
+	g_hash_table_steal (endpoint_dbus->peer_tokens, token);
+	g_free (stored_token);
+
+	/* The peer acts on behalf of the client that got the token */
+	g_hash_table_insert (endpoint_dbus->peer_senders, connection, sender);
+	g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
 static gboolean
 fd_watch_cb (gint          fd,
              GIOCondition  condition,
@@ -203,6 +430,8 @@ query_request_new (TrackerEndpointDBus   *endpoint,
 	request = g_new0 (QueryRequest, 1);
 	request->invocation = g_object_ref (invocation);
 	request->endpoint = endpoint;
+	request->chunk_fd = -1;
+	request->chunk_limit = CHUNK_MIN_SIZE;
 	request->global_cancellable = g_object_ref (endpoint->cancellable);
 	request->cancellable = g_cancellable_new ();
 	request->cancellable_id =
@@ -223,12 +452,12 @@ query_request_new (TrackerEndpointDBus   *endpoint,
 	buffered_stream = g_buffered_output_stream_new_sized (stream,
 	                                                      sysconf (_SC_PAGE_SIZE));
 
+	request->output_stream = stream;
 	request->data_stream = g_data_output_stream_new (buffered_stream);
 	g_data_output_stream_set_byte_order (request->data_stream,
 	                                     G_DATA_STREAM_BYTE_ORDER_HOST_ENDIAN);
 
 	g_object_unref (buffered_stream);
-	g_object_unref (stream);
 
 	return request;
 }
@@ -248,8 +477,12 @@ query_request_free (QueryRequest *request)
 				     G_PRIORITY_DEFAULT,
 				     NULL, NULL, NULL);
 
-	g_object_unref (request->invocation);
+	if (request->chunk_fd >= 0)
+		close (request->chunk_fd);
+
+	g_clear_object (&request->invocation);
 	g_object_unref (request->data_stream);
+	g_object_unref (request->output_stream);
 	g_free (request);
 }
 
@@ -367,9 +600,9 @@ update_request_free (UpdateRequest *request)
 }
 
 static gboolean
-write_cursor (QueryRequest          *request,
-              TrackerSparqlCursor   *cursor,
-              GError               **error)
+write_cursor_rows (QueryRequest          *request,
+                   TrackerSparqlCursor   *cursor,
+                   GError               **error)
 {
 	const gchar **values = NULL, **langtags = NULL;
 	glong *offsets = NULL;
@@ -462,6 +695,320 @@ out:
 	}
 }
 
+#ifdef HAVE_MEMFD_CREATE
+static gboolean
+send_fd (int      socket_fd,
+         int      fd,
+         GError **error)
+{
+	union {
+		struct cmsghdr align;
+		gchar buf[CMSG_SPACE (sizeof (int))];
+	} control;
+	struct msghdr msg = { 0, };
+	struct cmsghdr *cmsg;
+	struct iovec iov;
+	gchar byte = 0;
+	gssize res;
+
+	memset (&control, 0, sizeof (control));
+	iov.iov_base = &byte;
+	iov.iov_len = 1;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof (control.buf);
+
+	cmsg = CMSG_FIRSTHDR (&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+	memcpy (CMSG_DATA (cmsg), &fd, sizeof (int));
+
+	do {
+		res = sendmsg (socket_fd, &msg, MSG_NOSIGNAL);
+	} while (res < 0 && errno == EINTR);
+
+	if (res < 0) {
+		g_set_error (error,
+		             G_IO_ERROR,
+		             g_io_error_from_errno (errno),
+		             "Could not send file descriptor: %m");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+wait_chunk_consumed (QueryRequest  *request,
+                     int            socket_fd,
+                     GError       **error)
+{
+	GPollFD fds[2] = { 0, };
+	gchar byte;
+	gssize res;
+
+	/* The client writes a byte back for each memfd it is done with */
+	if (g_cancellable_make_pollfd (request->cancellable, &fds[1])) {
+		fds[0].fd = socket_fd;
+		fds[0].events = G_IO_IN | G_IO_HUP | G_IO_ERR;
+
+		while (g_poll (fds, 2, -1) < 0 && errno == EINTR)
+			;
+
+		g_cancellable_release_fd (request->cancellable);
+	}
+
+	if (g_cancellable_set_error_if_cancelled (request->cancellable, error))
+		return FALSE;
+
+	do {
+		res = read (socket_fd, &byte, 1);
+	} while (res < 0 && errno == EINTR);
+
+	if (res < 0) {
+		g_set_error (error,
+		             G_IO_ERROR,
+		             g_io_error_from_errno (errno),
+		             "Could not read from socket: %m");
+		return FALSE;
+	} else if (res == 0) {
+		g_set_error_literal (error,
+		                     G_IO_ERROR,
+		                     G_IO_ERROR_BROKEN_PIPE,
+		                     "Connection closed");
+		return FALSE;
+	}
+
+	request->chunks_in_flight--;
+
+	return TRUE;
+}
+#endif
+
+static gboolean
+flush_chunk (QueryRequest  *request,
+             GError       **error)
+{
+#ifdef HAVE_MEMFD_CREATE
+	gboolean retval = TRUE;
+	int socket_fd;
+
+	if (request->chunk_fd < 0)
+		return TRUE;
+
+	socket_fd = g_unix_output_stream_get_fd (G_UNIX_OUTPUT_STREAM (request->output_stream));
+
+	/* The client maps the memfd, it must not change after this */
+	if (fcntl (request->chunk_fd, F_ADD_SEALS,
+	           F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0) {
+		g_set_error (error,
+		             G_IO_ERROR,
+		             g_io_error_from_errno (errno),
+		             "Could not seal memfd: %m");
+		retval = FALSE;
+	}
+
+	while (retval && request->chunks_in_flight >= CHUNK_MAX_IN_FLIGHT)
+		retval = wait_chunk_consumed (request, socket_fd, error);
+
+	if (retval)
+		retval = send_fd (socket_fd, request->chunk_fd, error);
+	if (retval)
+		request->chunks_in_flight++;
+
+	close (request->chunk_fd);
+	request->chunk_fd = -1;
+	request->chunk_size = 0;
+	request->chunk_limit = MIN (request->chunk_limit * 2, CHUNK_MAX_SIZE);
+
+	return retval;
+#else
+	g_assert_not_reached ();
+	return FALSE;
+#endif
+}
+
+static gboolean
+write_chunk (QueryRequest  *request,
+             const guint8  *data,
+             gsize          len,
+             GError       **error)
+{
+#ifdef HAVE_MEMFD_CREATE
+	if (request->chunk_fd < 0) {
+		request->chunk_fd = memfd_create ("tracker-cursor",
+		                                  MFD_CLOEXEC | MFD_ALLOW_SEALING);
+		if (request->chunk_fd < 0) {
+			g_set_error (error,
+			             G_IO_ERROR,
+			             g_io_error_from_errno (errno),
+			             "Could not create memfd: %m");
+			return FALSE;
+		}
+	}
+
+	while (len > 0) {
+		gssize res;
+
+		res = write (request->chunk_fd, data, len);
+
+		if (res < 0) {
+			if (errno == EINTR)
+				continue;
+
+			g_set_error (error,
+			             G_IO_ERROR,
+			             g_io_error_from_errno (errno),
+			             "Could not write memfd: %m");
+			return FALSE;
+		}
+
+		data += res;
+		len -= res;
+		request->chunk_size += res;
+	}
+
+	if (request->chunk_size >= request->chunk_limit)
+		return flush_chunk (request, error);
+
+	return TRUE;
+#else
+	g_assert_not_reached ();
+	return FALSE;
+#endif
+}
+
+static gboolean
+write_frame (QueryRequest  *request,
+             guint          n_rows,
+             gint           n_columns,
+             const guint8  *types,
+             GArray        *offsets,
+             GByteArray    *data,
+             GByteArray    *frame,
+             GError       **error)
+{
+	TrackerBusFrameHeader header;
+	gint i;
+
+	header.n_rows = n_rows;
+	header.data_size = data->len;
+
+	g_byte_array_set_size (frame, 0);
+	g_byte_array_append (frame, (const guint8 *) &header, sizeof (header));
+	g_byte_array_append (frame, (const guint8 *) offsets->data,
+	                     offsets->len * sizeof (guint32));
+
+	for (i = 0; i < n_columns; i++)
+		g_byte_array_append (frame, &types[i * FRAME_MAX_ROWS], n_rows);
+
+	g_byte_array_append (frame, data->data, data->len);
+
+	g_array_set_size (offsets, 0);
+	g_byte_array_set_size (data, 0);
+
+	if (request->cursor_format == TRACKER_BUS_CURSOR_FORMAT_MEMFD_FRAMES) {
+		/* Keep the next frame aligned */
+		while (frame->len % TRACKER_BUS_FRAME_ALIGNMENT != 0)
+			g_byte_array_append (frame, (const guint8 *) "", 1);
+
+		return write_chunk (request, frame->data, frame->len, error);
+	}
+
+	/* Write the whole frame at once, bypassing the buffered stream */
+	return g_output_stream_write_all (request->output_stream,
+	                                  frame->data, frame->len,
+	                                  NULL,
+	                                  request->cancellable,
+	                                  error);
+}
+
+static gboolean
+write_cursor_frames (QueryRequest          *request,
+                     TrackerSparqlCursor   *cursor,
+                     GError               **error)
+{
+	GByteArray *data, *frame;
+	GArray *offsets;
+	guint8 *types;
+	guint n_rows = 0;
+	gint i, n_columns;
+	GError *inner_error = NULL;
+
+	n_columns = tracker_sparql_cursor_get_n_columns (cursor);
+	types = g_new0 (guint8, n_columns * FRAME_MAX_ROWS);
+	offsets = g_array_sized_new (FALSE, FALSE, sizeof (guint32),
+	                             n_columns * FRAME_MAX_ROWS);
+	data = g_byte_array_sized_new (FRAME_MAX_DATA_SIZE);
+	frame = g_byte_array_new ();
+
+	while (tracker_sparql_cursor_next (cursor, request->cancellable, &inner_error)) {
+		if (g_cancellable_set_error_if_cancelled (request->cancellable, &inner_error))
+			goto out;
+
+		for (i = 0; i < n_columns; i++) {
+			const gchar *value, *langtag;
+			guint32 offset;
+
+			types[i * FRAME_MAX_ROWS + n_rows] =
+				tracker_sparql_cursor_get_value_type (cursor, i);
+
+			value = tracker_sparql_cursor_get_langstring (cursor, i, &langtag, NULL);
+
+			if (value)
+				g_byte_array_append (data, (const guint8 *) value, strlen (value));
+			g_byte_array_append (data, (const guint8 *) "", 1);
+
+			if (langtag)
+				g_byte_array_append (data, (const guint8 *) langtag, strlen (langtag) + 1);
+
+			offset = data->len;
+			g_array_append_val (offsets, offset);
+		}
+
+		n_rows++;
+
+		if (n_rows == FRAME_MAX_ROWS || data->len >= FRAME_MAX_DATA_SIZE) {
+			if (!write_frame (request, n_rows, n_columns, types,
+			                  offsets, data, frame, &inner_error))
+				goto out;
+
+			n_rows = 0;
+		}
+	}
+
+	if (inner_error)
+		goto out;
+
+	if (n_rows > 0 &&
+	    !write_frame (request, n_rows, n_columns, types,
+	                  offsets, data, frame, &inner_error))
+		goto out;
+
+	/* Empty frame to terminate the results */
+	if (!write_frame (request, 0, n_columns, types,
+	                  offsets, data, frame, &inner_error))
+		goto out;
+
+	if (request->cursor_format == TRACKER_BUS_CURSOR_FORMAT_MEMFD_FRAMES)
+		flush_chunk (request, &inner_error);
+
+out:
+	g_free (types);
+	g_array_unref (offsets);
+	g_byte_array_unref (data);
+	g_byte_array_unref (frame);
+
+	if (inner_error) {
+		g_propagate_error (error, inner_error);
+		return FALSE;
+	} else {
+		return TRUE;
+	}
+}
+
 static void
 handle_cursor_reply (GTask        *task,
                      gpointer      source_object,
@@ -480,9 +1027,22 @@ handle_cursor_reply (GTask        *task,
 	for (i = 0; i < n_columns; i++)
 		variable_names[i] = tracker_sparql_cursor_get_variable_name (cursor, i);
 
-	g_dbus_method_invocation_return_value (request->invocation, g_variant_new ("(^as)", variable_names));
+	/* Batched queries were already replied to as a whole */
+	if (request->cursor_format == TRACKER_BUS_CURSOR_FORMAT_ROWS) {
+		if (request->invocation) {
+			g_dbus_method_invocation_return_value (request->invocation,
+			                                       g_variant_new ("(^as)", variable_names));
+		}
+		retval = write_cursor_rows (request, cursor, &error);
+	} else {
+		if (request->invocation) {
+			g_dbus_method_invocation_return_value (request->invocation,
+			                                       g_variant_new ("(^asu)", variable_names,
+			                                                      request->cursor_format));
+		}
+		retval = write_cursor_frames (request, cursor, &error);
+	}
 
-	retval = write_cursor (request, cursor, &error);
 	g_free (variable_names);
 
 	tracker_sparql_cursor_close (cursor);
@@ -535,6 +1095,113 @@ stmt_execute_cb (GObject      *object,
 	g_object_unref (task);
 }
 
+static void
+batch_request_free (BatchRequest *batch)
+{
+	guint i;
+
+	for (i = 0; i < batch->cursors->len; i++) {
+		TrackerSparqlCursor *cursor = g_ptr_array_index (batch->cursors, i);
+
+		if (cursor)
+			g_object_unref (cursor);
+	}
+
+	g_ptr_array_unref (batch->requests);
+	g_ptr_array_unref (batch->cursors);
+	g_clear_error (&batch->error);
+	g_object_unref (batch->invocation);
+	g_free (batch);
+}
+
+static void
+batch_request_reply (BatchRequest *batch)
+{
+	GVariantBuilder builder;
+	guint i;
+
+	if (batch->error) {
+		g_dbus_method_invocation_return_gerror (batch->invocation,
+		                                        batch->error);
+		g_ptr_array_set_free_func (batch->requests,
+		                           (GDestroyNotify) query_request_free);
+		batch_request_free (batch);
+		return;
+	}
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(asu)"));
+
+	for (i = 0; i < batch->requests->len; i++) {
+		TrackerSparqlCursor *cursor = g_ptr_array_index (batch->cursors, i);
+		QueryRequest *request = g_ptr_array_index (batch->requests, i);
+		gint j, n_columns;
+
+		g_variant_builder_open (&builder, G_VARIANT_TYPE ("(asu)"));
+		g_variant_builder_open (&builder, G_VARIANT_TYPE ("as"));
+
+		n_columns = tracker_sparql_cursor_get_n_columns (cursor);
+		for (j = 0; j < n_columns; j++) {
+			g_variant_builder_add (&builder, "s",
+			                       tracker_sparql_cursor_get_variable_name (cursor, j));
+		}
+
+		g_variant_builder_close (&builder);
+		g_variant_builder_add (&builder, "u", request->cursor_format);
+		g_variant_builder_close (&builder);
+	}
+
+	g_dbus_method_invocation_return_value (batch->invocation,
+	                                       g_variant_new ("(a(asu))", &builder));
+
+	for (i = 0; i < batch->requests->len; i++) {
+		TrackerSparqlCursor *cursor = g_ptr_array_index (batch->cursors, i);
+		QueryRequest *request = g_ptr_array_index (batch->requests, i);
+		GTask *task;
+
+		g_clear_object (&request->invocation);
+		request->batch = NULL;
+
+		task = g_task_new (g_object_ref (cursor), request->cancellable,
+		                   finish_query, NULL);
+		g_task_set_task_data (task, request, (GDestroyNotify) query_request_free);
+		g_task_run_in_thread (task, handle_cursor_reply);
+		g_object_unref (task);
+	}
+
+	batch_request_free (batch);
+}
+
+static void
+batch_request_complete_one (BatchRequest *batch)
+{
+	batch->n_pending--;
+
+	if (batch->n_pending == 0)
+		batch_request_reply (batch);
+}
+
+static void
+batch_stmt_execute_cb (GObject      *object,
+                       GAsyncResult *res,
+                       gpointer      user_data)
+{
+	QueryRequest *request = user_data;
+	BatchRequest *batch = request->batch;
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+
+	cursor = tracker_sparql_statement_execute_finish (TRACKER_SPARQL_STATEMENT (object),
+	                                                  res, &error);
+	if (cursor)
+		g_ptr_array_index (batch->cursors, request->batch_idx) = cursor;
+	else if (!batch->error)
+		batch->error = error;
+	else
+		g_error_free (error);
+
+	batch_request_complete_one (batch);
+}
+
 static void
 splice_rdf_cb (GObject      *object,
                GAsyncResult *res,
@@ -761,38 +1428,573 @@ bind_arguments (TrackerSparqlStatement *stmt,
 }
 
 static void
-endpoint_dbus_iface_method_call (GDBusConnection       *connection,
-                                 const gchar           *sender,
-                                 const gchar           *object_path,
-                                 const gchar           *interface_name,
-                                 const gchar           *method_name,
-                                 GVariant              *parameters,
-                                 GDBusMethodInvocation *invocation,
-                                 gpointer               user_data)
+prepared_statement_free (PreparedStatement *prepared_stmt)
 {
-	TrackerEndpointDBus *endpoint_dbus = user_data;
-	GUnixFDList *fd_list;
-	GError *error = NULL;
-	GVariantIter *arguments;
-	gchar *query;
-	gint handle, fd = -1;
+	g_object_unref (prepared_stmt->stmt);
+	g_free (prepared_stmt->checksum);
+	g_free (prepared_stmt);
+}
 
-	if (tracker_endpoint_dbus_block_call (endpoint_dbus, invocation)) {
-		g_dbus_method_invocation_return_error (invocation,
-		                                       G_DBUS_ERROR,
+static void
+prepared_statements_free (PreparedStatements *prepared)
+{
+	if (prepared->watch_id != 0)
+		g_bus_unwatch_name (prepared->watch_id);
+
+	g_hash_table_unref (prepared->statements);
+	g_free (prepared);
+}
+
+static void
+client_vanished_cb (GDBusConnection *connection,
+                    const gchar     *name,
+                    gpointer         user_data)
+{
+	TrackerEndpointDBus *endpoint_dbus = user_data;
+
+	g_hash_table_remove (endpoint_dbus->bus_statements, name);
+}
+
+static PreparedStatements *
+lookup_prepared_statements (TrackerEndpointDBus   *endpoint_dbus,
+                            GDBusMethodInvocation *invocation,
+                            gboolean               create)
+{
+	GDBusConnection *connection;
+	PreparedStatements *prepared;
+	const gchar *sender;
+
+	connection = g_dbus_method_invocation_get_connection (invocation);
+	sender = g_dbus_method_invocation_get_sender (invocation);
+
+	/* Clients are identified by their unique name on message
+	 * buses, and by the connection itself on peer-to-peer ones.
+	 */
+	if (sender)
+		prepared = g_hash_table_lookup (endpoint_dbus->bus_statements, sender);
+	else
+		prepared = g_hash_table_lookup (endpoint_dbus->peer_statements, connection);
+
+	if (prepared || !create)
+		return prepared;
+
+	prepared = g_new0 (PreparedStatements, 1);
+	prepared->statements =
+		g_hash_table_new_full (NULL, NULL, NULL,
+		                       (GDestroyNotify) prepared_statement_free);
+
+	if (sender) {
+		prepared->watch_id =
+			g_bus_watch_name_on_connection (connection,
+			                                sender,
+			                                G_BUS_NAME_WATCHER_FLAGS_NONE,
+			                                NULL,
+			                                client_vanished_cb,
+			                                endpoint_dbus,
+			                                NULL);
+		g_hash_table_insert (endpoint_dbus->bus_statements,
+		                     g_strdup (sender), prepared);
+	} else {
+		g_hash_table_insert (endpoint_dbus->peer_statements,
+		                     connection, prepared);
+	}
+
+	return prepared;
+}
+
+static PreparedStatement *
+find_prepared_statement (TrackerEndpointDBus   *endpoint_dbus,
+                         GDBusMethodInvocation *invocation,
+                         guint32                handle,
+                         const gchar           *checksum)
+{
+	PreparedStatements *prepared;
+	PreparedStatement *prepared_stmt = NULL;
+
+	prepared = lookup_prepared_statements (endpoint_dbus, invocation, FALSE);
+	if (prepared)
+		prepared_stmt = g_hash_table_lookup (prepared->statements, GUINT_TO_POINTER (handle));
+
+	if (prepared_stmt && g_strcmp0 (prepared_stmt->checksum, checksum) != 0)
+		return NULL;
+
+	return prepared_stmt;
+}
+
+static TrackerSparqlStatement *
+lookup_prepared_statement (TrackerEndpointDBus    *endpoint_dbus,
+                           GDBusMethodInvocation  *invocation,
+                           guint32                 handle,
+                           const gchar            *checksum,
+                           GError                **error)
+{
+	PreparedStatement *prepared_stmt;
+
+	prepared_stmt = find_prepared_statement (endpoint_dbus, invocation,
+	                                         handle, checksum);
+	if (!prepared_stmt) {
+		g_set_error (error,
+		             G_DBUS_ERROR,
+		             G_DBUS_ERROR_UNKNOWN_OBJECT,
+		             "Unknown statement %u", handle);
+		return NULL;
+	}
+
+	tracker_sparql_statement_clear_bindings (prepared_stmt->stmt);
+
+	return g_object_ref (prepared_stmt->stmt);
+}
+
+static void
+prepare_statement (TrackerEndpointDBus   *endpoint_dbus,
+                   GDBusMethodInvocation *invocation,
+                   const gchar           *query,
+                   const gchar           *checksum)
+{
+	TrackerSparqlConnection *conn;
+	TrackerSparqlStatement *stmt;
+	PreparedStatements *prepared;
+	PreparedStatement *prepared_stmt;
+	GError *error = NULL;
+
+	prepared = lookup_prepared_statements (endpoint_dbus, invocation, TRUE);
+
+	if (g_hash_table_size (prepared->statements) >= MAX_PREPARED_STMTS) {
+		g_dbus_method_invocation_return_error (invocation,
+		                                       G_DBUS_ERROR,
+		                                       G_DBUS_ERROR_LIMITS_EXCEEDED,
+		                                       "Too many prepared statements");
+		return;
+	}
+
+	conn = tracker_endpoint_get_sparql_connection (TRACKER_ENDPOINT (endpoint_dbus));
+	stmt = tracker_sparql_connection_query_statement (conn, query,
+	                                                  endpoint_dbus->cancellable,
+	                                                  &error);
+	if (!stmt) {
+		g_dbus_method_invocation_return_gerror (invocation, error);
+		g_error_free (error);
+		return;
+	}
+
+	do {
+		prepared->last_handle++;
+	} while (prepared->last_handle == 0 ||
+	         g_hash_table_contains (prepared->statements,
+	                                GUINT_TO_POINTER (prepared->last_handle)));
+
+	prepared_stmt = g_new0 (PreparedStatement, 1);
+	prepared_stmt->stmt = stmt;
+	prepared_stmt->checksum = g_strdup (checksum);
+
+	g_hash_table_insert (prepared->statements,
+	                     GUINT_TO_POINTER (prepared->last_handle),
+	                     prepared_stmt);
+	g_dbus_method_invocation_return_value (invocation,
+	                                       g_variant_new ("(u)",
+	                                                      prepared->last_handle));
+}
+
+static void
+release_statement (TrackerEndpointDBus   *endpoint_dbus,
+                   GDBusMethodInvocation *invocation,
+                   guint32                handle,
+                   const gchar           *checksum)
+{
+	PreparedStatements *prepared;
+
+	/* Handles of a previous endpoint instance may belong
+	 * to other statements here.
+	 */
+	if (find_prepared_statement (endpoint_dbus, invocation, handle, checksum)) {
+		prepared = lookup_prepared_statements (endpoint_dbus, invocation, FALSE);
+		g_hash_table_remove (prepared->statements, GUINT_TO_POINTER (handle));
+	}
+
+	g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
+static void
+query_batch (TrackerEndpointDBus   *endpoint_dbus,
+             GDBusMethodInvocation *invocation,
+             GVariant              *parameters)
+{
+	GUnixFDList *fd_list;
+	BatchRequest *batch;
+	GVariantIter *queries, *arguments;
+	guint32 max_format, stmt_handle;
+	gchar *query;
+	gint handle;
+
+	fd_list = g_dbus_message_get_unix_fd_list (g_dbus_method_invocation_get_message (invocation));
+	g_variant_get (parameters, "(a(sua{sv}h)u)", &queries, &max_format);
+
+	batch = g_new0 (BatchRequest, 1);
+	batch->invocation = g_object_ref (invocation);
+	batch->requests = g_ptr_array_new ();
+	batch->cursors = g_ptr_array_new ();
+	/* Keep the batch alive while the statements are set up */
+	batch->n_pending = 1;
+
+	while (g_variant_iter_loop (queries, "(sua{sv}h)",
+	                            &query, &stmt_handle, &arguments, &handle)) {
+		TrackerBusCursorFormat cursor_format;
+		TrackerSparqlStatement *stmt = NULL;
+		QueryRequest *request;
+		GError *error = NULL;
+		gchar *rewritten;
+		int fd = -1;
+
+		batch->n_pending++;
+		g_ptr_array_add (batch->cursors, NULL);
+
+		if (fd_list)
+			fd = g_unix_fd_list_get (fd_list, handle, &error);
+
+		if (fd < 0) {
+			if (!batch->error) {
+				g_set_error (&batch->error,
+				             G_DBUS_ERROR,
+				             G_DBUS_ERROR_INVALID_ARGS,
+				             "Did not get a file descriptor");
+			}
+			g_clear_error (&error);
+			batch_request_complete_one (batch);
+			continue;
+		}
+
+		cursor_format = MIN (max_format, TRACKER_BUS_CURSOR_FORMAT_LATEST);
+
+		/* Memfds can only be passed through sockets */
+		if (cursor_format == TRACKER_BUS_CURSOR_FORMAT_MEMFD_FRAMES) {
+			struct stat st;
+
+			if (fstat (fd, &st) < 0 || !S_ISSOCK (st.st_mode))
+				cursor_format = TRACKER_BUS_CURSOR_FORMAT_FRAMES;
+		}
+
+		request = query_request_new (endpoint_dbus, invocation, fd);
+		request->cursor_format = cursor_format;
+		request->batch = batch;
+		request->batch_idx = batch->requests->len;
+		g_ptr_array_add (batch->requests, request);
+
+		/* Statements released meanwhile are executed from their query */
+		if (stmt_handle != 0) {
+			gchar *checksum;
+
+			checksum = tracker_bus_compute_statement_checksum (query);
+			stmt = lookup_prepared_statement (endpoint_dbus,
+			                                  invocation,
+			                                  stmt_handle,
+			                                  checksum,
+			                                  NULL);
+			g_free (checksum);
+		}
+
+		if (!stmt) {
+			rewritten = g_strdup (query);
+			tracker_endpoint_rewrite_query (TRACKER_ENDPOINT (endpoint_dbus),
+			                                &rewritten);
+			stmt = tracker_endpoint_cache_select_sparql (TRACKER_ENDPOINT (endpoint_dbus),
+			                                             rewritten,
+			                                             request->cancellable,
+			                                             &error);
+			g_free (rewritten);
+		}
+
+		if (stmt) {
+			bind_arguments (stmt, arguments);
+			tracker_sparql_statement_execute_async (stmt,
+			                                        request->cancellable,
+			                                        batch_stmt_execute_cb,
+			                                        request);
+			g_object_unref (stmt);
+		} else {
+			if (!batch->error)
+				batch->error = error;
+			else
+				g_error_free (error);
+
+			batch_request_complete_one (batch);
+		}
+	}
+
+	g_variant_iter_free (queries);
+	batch_request_complete_one (batch);
+}
+
+static guint
+get_client_filter_count (TrackerEndpointDBus *endpoint_dbus,
+                         const gchar         *client)
+{
+	return GPOINTER_TO_UINT (g_hash_table_lookup (endpoint_dbus->notify_filter_counts,
+	                                              client));
+}
+
+static void
+notify_filter_free (NotifyFilter *filter)
+{
+	TrackerEndpointDBus *endpoint_dbus = filter->endpoint;
+	guint count;
+
+	if (filter->watch_id != 0)
+		g_bus_unwatch_name (filter->watch_id);
+
+	count = get_client_filter_count (endpoint_dbus, filter->client);
+	g_assert (count > 0);
+
+	if (count > 1) {
+		g_hash_table_insert (endpoint_dbus->notify_filter_counts,
+		                     g_strdup (filter->client),
+		                     GUINT_TO_POINTER (count - 1));
+	} else {
+		g_hash_table_remove (endpoint_dbus->notify_filter_counts,
+		                     filter->client);
+	}
+
+	g_object_unref (filter->connection);
+	g_strfreev (filter->classes);
+	g_strfreev (filter->properties);
+	g_free (filter->sender);
+	g_free (filter->client);
+	g_free (filter);
+}
+
+static void
+filter_client_vanished_cb (GDBusConnection *connection,
+                           const gchar     *name,
+                           gpointer         user_data)
+{
+	NotifyFilter *filter = user_data;
+
+	g_hash_table_remove (filter->endpoint->notify_filters,
+	                     GUINT_TO_POINTER (filter->id));
+}
+
+static void
+subscribe_filter (TrackerEndpointDBus   *endpoint_dbus,
+                  GDBusMethodInvocation *invocation,
+                  const gchar           *client,
+                  GVariant              *parameters)
+{
+	NotifyFilter *filter;
+	GStrv classes, properties;
+	guint count;
+
+	/* Peers are accounted on behalf of the client that authorized
+	 * them, connections without a message bus have no sender.
+	 */
+	if (!client)
+		client = "";
+
+	count = get_client_filter_count (endpoint_dbus, client);
+
+	if (count >= MAX_NOTIFY_FILTERS) {
+		g_dbus_method_invocation_return_error (invocation,
+		                                       G_DBUS_ERROR,
+		                                       G_DBUS_ERROR_LIMITS_EXCEEDED,
+		                                       "Too many notification filters");
+		return;
+	}
+
+	/* Classes and properties of changes are only tracked when needed */
+	tracker_notifier_enable_event_details (endpoint_dbus->notifier);
+
+	g_variant_get (parameters, "(^as^as)", &classes, &properties);
+
+	filter = g_new0 (NotifyFilter, 1);
+	filter->endpoint = endpoint_dbus;
+	filter->connection = g_object_ref (g_dbus_method_invocation_get_connection (invocation));
+	filter->sender = g_strdup (g_dbus_method_invocation_get_sender (invocation));
+	filter->client = g_strdup (client);
+	filter->id = ++endpoint_dbus->last_filter_id;
+
+	/* Empty lists do not restrict anything */
+	if (classes && classes[0])
+		filter->classes = classes;
+	else
+		g_strfreev (classes);
+
+	if (properties && properties[0])
+		filter->properties = properties;
+	else
+		g_strfreev (properties);
+
+	if (filter->sender) {
+		filter->watch_id =
+			g_bus_watch_name_on_connection (filter->connection,
+			                                filter->sender,
+			                                G_BUS_NAME_WATCHER_FLAGS_NONE,
+			                                NULL,
+			                                filter_client_vanished_cb,
+			                                filter,
+			                                NULL);
+	}
+
+	g_hash_table_insert (endpoint_dbus->notify_filters,
+	                     GUINT_TO_POINTER (filter->id), filter);
+	g_hash_table_insert (endpoint_dbus->notify_filter_counts,
+	                     g_strdup (client),
+	                     GUINT_TO_POINTER (count + 1));
+
+	g_dbus_method_invocation_return_value (invocation,
+	                                       g_variant_new ("(u)", filter->id));
+}
+
+static void
+unsubscribe_filter (TrackerEndpointDBus   *endpoint_dbus,
+                    GDBusMethodInvocation *invocation,
+                    guint32                filter_id)
+{
+	NotifyFilter *filter;
+
+	filter = g_hash_table_lookup (endpoint_dbus->notify_filters,
+	                              GUINT_TO_POINTER (filter_id));
+
+	/* Filters may only be removed by their owner */
+	if (filter &&
+	    filter->connection == g_dbus_method_invocation_get_connection (invocation) &&
+	    g_strcmp0 (filter->sender, g_dbus_method_invocation_get_sender (invocation)) == 0) {
+		g_hash_table_remove (endpoint_dbus->notify_filters,
+		                     GUINT_TO_POINTER (filter_id));
+	}
+
+	g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
+static void
+endpoint_dbus_iface_method_call (GDBusConnection       *connection,
+                                 const gchar           *sender,
+                                 const gchar           *object_path,
+                                 const gchar           *interface_name,
+                                 const gchar           *method_name,
+                                 GVariant              *parameters,
+                                 GDBusMethodInvocation *invocation,
+                                 gpointer               user_data)
+{
+	TrackerEndpointDBus *endpoint_dbus = user_data;
+	GUnixFDList *fd_list;
+	GError *error = NULL;
+	GVariantIter *arguments;
+	gchar *query = NULL;
+	gint handle, fd = -1;
+	gboolean authorized = TRUE;
+
+	/* Peer-to-peer connections have no sender, a peer must first
+	 * present a token obtained by a client through the message bus,
+	 * the peer calls are checked on behalf of that client.
+	 */
+	if (connection != endpoint_dbus->dbus_connection) {
+		if (g_strcmp0 (method_name, "AuthorizePeer") == 0) {
+			const gchar *token;
+
+			g_variant_get (parameters, "(&s)", &token);
+			authorize_peer (endpoint_dbus, invocation, token);
+			return;
+		}
+
+		sender = g_hash_table_lookup (endpoint_dbus->peer_senders, connection);
+		authorized = sender != NULL;
+	}
+
+	if (!authorized ||
+	    tracker_endpoint_dbus_block_call (endpoint_dbus, sender)) {
+		g_dbus_method_invocation_return_error (invocation,
+		                                       G_DBUS_ERROR,
 		                                       G_DBUS_ERROR_ACCESS_DENIED,
 		                                       "Operation not allowed");
 		return;
 	}
 
+	if (g_strcmp0 (method_name, "GetPeerAddress") == 0) {
+		const gchar *address = NULL, *token = NULL;
+
+		if (endpoint_dbus->peer_server &&
+		    connection == endpoint_dbus->dbus_connection) {
+			address = g_dbus_server_get_client_address (endpoint_dbus->peer_server);
+			token = create_peer_token (endpoint_dbus, sender);
+		}
+
+		g_dbus_method_invocation_return_value (invocation,
+		                                       g_variant_new ("(ss)",
+		                                                      address ? address : "",
+		                                                      token ? token : ""));
+		return;
+	} else if (g_strcmp0 (method_name, "AuthorizePeer") == 0) {
+		g_dbus_method_invocation_return_error (invocation,
+		                                       G_DBUS_ERROR,
+		                                       G_DBUS_ERROR_NOT_SUPPORTED,
+		                                       "Only available on peer-to-peer connections");
+		return;
+	} else if (g_strcmp0 (method_name, "Prepare") == 0) {
+		gchar *checksum;
+
+		g_variant_get (parameters, "(s)", &query);
+		/* Clients refer to the query as they sent it */
+		checksum = tracker_bus_compute_statement_checksum (query);
+		tracker_endpoint_rewrite_query (TRACKER_ENDPOINT (endpoint_dbus),
+		                                &query);
+		prepare_statement (endpoint_dbus, invocation, query, checksum);
+		g_free (checksum);
+		g_free (query);
+		return;
+	} else if (g_strcmp0 (method_name, "Subscribe") == 0) {
+		subscribe_filter (endpoint_dbus, invocation, sender, parameters);
+		return;
+	} else if (g_strcmp0 (method_name, "Unsubscribe") == 0) {
+		guint32 filter_id;
+
+		g_variant_get (parameters, "(u)", &filter_id);
+		unsubscribe_filter (endpoint_dbus, invocation, filter_id);
+		return;
+	} else if (g_strcmp0 (method_name, "QueryBatch") == 0) {
+		query_batch (endpoint_dbus, invocation, parameters);
+		return;
+	} else if (g_strcmp0 (method_name, "Release") == 0) {
+		const gchar *checksum;
+		guint32 stmt_handle;
+
+		g_variant_get (parameters, "(u&s)", &stmt_handle, &checksum);
+		release_statement (endpoint_dbus, invocation, stmt_handle, checksum);
+		return;
+	}
+
 	fd_list = g_dbus_message_get_unix_fd_list (g_dbus_method_invocation_get_message (invocation));
 
-	if (g_strcmp0 (method_name, "Query") == 0) {
-		g_variant_get (parameters, "(sha{sv})", &query, &handle, &arguments);
+	if (g_strcmp0 (method_name, "Query") == 0 ||
+	    g_strcmp0 (method_name, "QueryCursor") == 0 ||
+	    g_strcmp0 (method_name, "Execute") == 0) {
+		TrackerBusCursorFormat cursor_format = TRACKER_BUS_CURSOR_FORMAT_ROWS;
+		const gchar *checksum = NULL;
+		guint32 stmt_handle = 0;
+
+		if (g_strcmp0 (method_name, "Execute") == 0) {
+			guint32 max_format;
+
+			g_variant_get (parameters, "(u&sha{sv}u)", &stmt_handle, &checksum, &handle, &arguments, &max_format);
+			cursor_format = MIN (max_format, TRACKER_BUS_CURSOR_FORMAT_LATEST);
+		} else if (g_strcmp0 (method_name, "QueryCursor") == 0) {
+			guint32 max_format;
+
+			g_variant_get (parameters, "(sha{sv}u)", &query, &handle, &arguments, &max_format);
+			cursor_format = MIN (max_format, TRACKER_BUS_CURSOR_FORMAT_LATEST);
+		} else {
+			g_variant_get (parameters, "(sha{sv})", &query, &handle, &arguments);
+		}
 
 		if (fd_list)
 			fd = g_unix_fd_list_get (fd_list, handle, &error);
 
+		/* Memfds can only be passed through sockets */
+		if (fd >= 0 &&
+		    cursor_format == TRACKER_BUS_CURSOR_FORMAT_MEMFD_FRAMES) {
+			struct stat st;
+
+			if (fstat (fd, &st) < 0 || !S_ISSOCK (st.st_mode))
+				cursor_format = TRACKER_BUS_CURSOR_FORMAT_FRAMES;
+		}
+
 		if (fd < 0) {
 			g_dbus_method_invocation_return_error (invocation,
 			                                       G_DBUS_ERROR,
@@ -802,15 +2004,24 @@ endpoint_dbus_iface_method_call (GDBusConnection       *connection,
 			TrackerSparqlStatement *stmt;
 			QueryRequest *request;
 
-			tracker_endpoint_rewrite_query (TRACKER_ENDPOINT (endpoint_dbus),
-			                                &query);
-
 			request = query_request_new (endpoint_dbus, invocation, fd);
+			request->cursor_format = cursor_format;
+
+			if (stmt_handle != 0) {
+				stmt = lookup_prepared_statement (endpoint_dbus,
+				                                  invocation,
+				                                  stmt_handle,
+				                                  checksum,
+				                                  &error);
+			} else {
+				tracker_endpoint_rewrite_query (TRACKER_ENDPOINT (endpoint_dbus),
+				                                &query);
 
-			stmt = tracker_endpoint_cache_select_sparql (TRACKER_ENDPOINT (endpoint_dbus),
-			                                             query,
-			                                             request->cancellable,
-			                                             &error);
+				stmt = tracker_endpoint_cache_select_sparql (TRACKER_ENDPOINT (endpoint_dbus),
+				                                             query,
+				                                             request->cancellable,
+				                                             &error);
+			}
 
 			if (stmt && arguments)
 				bind_arguments (stmt, arguments);
@@ -991,6 +2202,58 @@ endpoint_dbus_iface_method_call (GDBusConnection       *connection,
 	}
 }
 
+static void
+emit_filtered_events (TrackerEndpointDBus *endpoint_dbus,
+                      NotifyFilter        *filter,
+                      const gchar         *graph,
+                      GPtrArray           *events)
+{
+	GVariantBuilder builder;
+	GError *error = NULL;
+	gboolean empty = TRUE;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("(sa{ii}u)"));
+	g_variant_builder_add (&builder, "s", graph ? graph : "");
+	g_variant_builder_open (&builder, G_VARIANT_TYPE ("a{ii}"));
+
+	for (i = 0; i < events->len; i++) {
+		TrackerNotifierEvent *event;
+
+		event = g_ptr_array_index (events, i);
+
+		if (!tracker_notifier_event_matches_filter (event,
+		                                            (const gchar * const *) filter->classes,
+		                                            (const gchar * const *) filter->properties))
+			continue;
+
+		g_variant_builder_add (&builder, "{ii}",
+		                       tracker_notifier_event_get_event_type (event),
+		                       (gint) tracker_notifier_event_get_id (event));
+		empty = FALSE;
+	}
+
+	g_variant_builder_close (&builder);
+	g_variant_builder_add (&builder, "u", filter->id);
+
+	/* Do not wake up clients for nothing */
+	if (empty) {
+		g_variant_builder_clear (&builder);
+		return;
+	}
+
+	if (!g_dbus_connection_emit_signal (filter->connection,
+	                                    filter->sender,
+	                                    endpoint_dbus->object_path,
+	                                    "org.freedesktop.Tracker3.Endpoint",
+	                                    "FilteredGraphUpdated",
+	                                    g_variant_builder_end (&builder),
+	                                    &error)) {
+		g_warning ("Could not emit FilteredGraphUpdated signal: %s", error->message);
+		g_error_free (error);
+	}
+}
+
 static void
 notifier_events_cb (TrackerNotifier *notifier,
                     const gchar     *service,
@@ -1000,12 +2263,19 @@ notifier_events_cb (TrackerNotifier *notifier,
 {
 	TrackerEndpointDBus *endpoint_dbus = user_data;
 	GVariantBuilder builder;
+	GHashTableIter iter;
+	NotifyFilter *filter;
 	GError *error = NULL;
 	guint i;
 
 	if (tracker_endpoint_is_graph_filtered (TRACKER_ENDPOINT (endpoint_dbus), graph))
 		return;
 
+	g_hash_table_iter_init (&iter, endpoint_dbus->notify_filters);
+
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &filter))
+		emit_filtered_events (endpoint_dbus, filter, graph, events);
+
 	g_variant_builder_init (&builder, G_VARIANT_TYPE ("(sa{ii})"));
 	g_variant_builder_add (&builder, "s", graph ? graph : "");
 	g_variant_builder_open (&builder, G_VARIANT_TYPE ("a{ii}"));
@@ -1034,6 +2304,205 @@ notifier_events_cb (TrackerNotifier *notifier,
 	}
 }
 
+static guint
+register_endpoint_object (TrackerEndpointDBus  *endpoint_dbus,
+                          GDBusConnection      *dbus_connection,
+                          GError              **error)
+{
+	return g_dbus_connection_register_object (dbus_connection,
+	                                          endpoint_dbus->object_path,
+	                                          endpoint_dbus->node_info->interfaces[0],
+	                                          &(GDBusInterfaceVTable) {
+		                                          endpoint_dbus_iface_method_call,
+		                                          NULL,
+		                                          NULL
+	                                          },
+	                                          endpoint_dbus,
+	                                          NULL,
+	                                          error);
+}
+
+static void peer_connection_closed_cb (GDBusConnection     *connection,
+                                       gboolean             remote_peer_vanished,
+                                       GError              *error,
+                                       TrackerEndpointDBus *endpoint_dbus);
+
+static gboolean
+filter_matches_connection (gpointer key,
+                           gpointer value,
+                           gpointer user_data)
+{
+	NotifyFilter *filter = value;
+
+	return filter->connection == user_data;
+}
+
+static void
+remove_peer_connection (TrackerEndpointDBus *endpoint_dbus,
+                        GDBusConnection     *connection)
+{
+	guint register_id;
+
+	register_id = GPOINTER_TO_UINT (g_hash_table_lookup (endpoint_dbus->peer_connections,
+	                                                     connection));
+	g_dbus_connection_unregister_object (connection, register_id);
+	g_hash_table_remove (endpoint_dbus->peer_statements, connection);
+	g_hash_table_remove (endpoint_dbus->peer_senders, connection);
+	g_hash_table_foreach_remove (endpoint_dbus->notify_filters,
+	                             filter_matches_connection,
+	                             connection);
+	g_signal_handlers_disconnect_by_func (connection,
+	                                      peer_connection_closed_cb,
+	                                      endpoint_dbus);
+	g_hash_table_remove (endpoint_dbus->peer_connections, connection);
+}
+
+static void
+peer_connection_closed_cb (GDBusConnection     *connection,
+                           gboolean             remote_peer_vanished,
+                           GError              *error,
+                           TrackerEndpointDBus *endpoint_dbus)
+{
+	remove_peer_connection (endpoint_dbus, connection);
+}
+
+static gboolean
+peer_new_connection_cb (GDBusServer     *server,
+                        GDBusConnection *connection,
+                        gpointer         user_data)
+{
+	TrackerEndpointDBus *endpoint_dbus = user_data;
+	GError *error = NULL;
+	guint register_id;
+
+	register_id = register_endpoint_object (endpoint_dbus, connection, &error);
+	if (register_id == 0) {
+		g_warning ("Could not register endpoint on peer connection: %s",
+		           error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	g_hash_table_insert (endpoint_dbus->peer_connections,
+	                     g_object_ref (connection),
+	                     GUINT_TO_POINTER (register_id));
+	g_signal_connect (connection, "closed",
+	                  G_CALLBACK (peer_connection_closed_cb), endpoint_dbus);
+
+	return TRUE;
+}
+
+static gboolean
+authorize_peer_cb (GDBusAuthObserver *observer,
+                   GIOStream         *stream,
+                   GCredentials      *credentials,
+                   gpointer           user_data)
+{
+	/* Only allow peers from the same user */
+	return (credentials &&
+	        g_credentials_get_unix_user (credentials, NULL) == getuid ());
+}
+
+static gboolean
+start_peer_server (TrackerEndpointDBus  *endpoint_dbus,
+                   GCancellable         *cancellable,
+                   GError              **error)
+{
+	GDBusAuthObserver *observer;
+	gchar *dir, *guid, *basename, *escaped, *address;
+
+	/* The socket is created in the runtime dir, so that it is
+	 * not reachable from sandboxes.
+	 */
+	dir = g_build_filename (g_get_user_runtime_dir (), "tinysparql", NULL);
+
+	if (g_mkdir_with_parents (dir, 0700) < 0) {
+		int errsv = errno;
+
+		g_set_error (error,
+		             G_IO_ERROR,
+		             g_io_error_from_errno (errsv),
+		             "Could not create directory %s: %s",
+		             dir, g_strerror (errsv));
+		g_free (dir);
+		return FALSE;
+	}
+
+	guid = g_dbus_generate_guid ();
+	basename = g_strdup_printf ("endpoint-%s", guid);
+	endpoint_dbus->peer_socket_path = g_build_filename (dir, basename, NULL);
+	escaped = g_dbus_address_escape_value (endpoint_dbus->peer_socket_path);
+	address = g_strdup_printf ("unix:path=%s", escaped);
+
+	observer = g_dbus_auth_observer_new ();
+	g_signal_connect (observer, "authorize-authenticated-peer",
+	                  G_CALLBACK (authorize_peer_cb), NULL);
+
+	endpoint_dbus->peer_server =
+		g_dbus_server_new_sync (address,
+		                        G_DBUS_SERVER_FLAGS_NONE,
+		                        guid,
+		                        observer,
+		                        cancellable,
+		                        error);
+	g_object_unref (observer);
+	g_free (address);
+	g_free (escaped);
+	g_free (basename);
+	g_free (guid);
+	g_free (dir);
+
+	if (!endpoint_dbus->peer_server)
+		return FALSE;
+
+	endpoint_dbus->peer_connections =
+		g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+	g_signal_connect (endpoint_dbus->peer_server, "new-connection",
+	                  G_CALLBACK (peer_new_connection_cb), endpoint_dbus);
+	g_dbus_server_start (endpoint_dbus->peer_server);
+
+	return TRUE;
+}
+
+static void
+stop_peer_server (TrackerEndpointDBus *endpoint_dbus)
+{
+	if (endpoint_dbus->peer_server) {
+		g_dbus_server_stop (endpoint_dbus->peer_server);
+		g_signal_handlers_disconnect_by_func (endpoint_dbus->peer_server,
+		                                      peer_new_connection_cb,
+		                                      endpoint_dbus);
+		g_clear_object (&endpoint_dbus->peer_server);
+	}
+
+	if (endpoint_dbus->peer_connections) {
+		GHashTableIter iter;
+		GDBusConnection *connection;
+		GList *connections = NULL, *l;
+
+		g_hash_table_iter_init (&iter, endpoint_dbus->peer_connections);
+		while (g_hash_table_iter_next (&iter, (gpointer *) &connection, NULL))
+			connections = g_list_prepend (connections, connection);
+
+		for (l = connections; l; l = l->next) {
+			connection = l->data;
+			/* Close before unregistering, so clients see the
+			 * connection closed instead of unknown methods.
+			 */
+			g_dbus_connection_close_sync (connection, NULL, NULL);
+			remove_peer_connection (endpoint_dbus, connection);
+		}
+
+		g_list_free (connections);
+		g_clear_pointer (&endpoint_dbus->peer_connections, g_hash_table_unref);
+	}
+
+	if (endpoint_dbus->peer_socket_path) {
+		g_unlink (endpoint_dbus->peer_socket_path);
+		g_clear_pointer (&endpoint_dbus->peer_socket_path, g_free);
+	}
+}
+
 static gboolean
 tracker_endpoint_dbus_initable_init (GInitable     *initable,
                                      GCancellable  *cancellable,
@@ -1049,21 +2518,23 @@ tracker_endpoint_dbus_initable_init (GInitable     *initable,
 		return FALSE;
 
 	endpoint_dbus->register_id =
-		g_dbus_connection_register_object (endpoint_dbus->dbus_connection,
-		                                   endpoint_dbus->object_path,
-		                                   endpoint_dbus->node_info->interfaces[0],
-		                                   &(GDBusInterfaceVTable) {
-			                                   endpoint_dbus_iface_method_call,
-				                           NULL,
-				                           NULL
-				                   },
-		                                   endpoint_dbus,
-		                                   NULL,
-		                                   error);
+		register_endpoint_object (endpoint_dbus,
+		                          endpoint_dbus->dbus_connection,
+		                          error);
+	if (endpoint_dbus->register_id == 0)
+		return FALSE;
+
+	if (endpoint_dbus->peer_to_peer &&
+	    !start_peer_server (endpoint_dbus, cancellable, error))
+		return FALSE;
 
 	conn = tracker_endpoint_get_sparql_connection (endpoint);
 	endpoint_dbus->notifier = tracker_sparql_connection_create_notifier (conn);
 	tracker_notifier_disable_urn_query (endpoint_dbus->notifier);
+	g_object_set (endpoint_dbus->notifier,
+	              "coalesce-interval", endpoint_dbus->notify_interval,
+	              "coalesce-max-events", endpoint_dbus->notify_max_events,
+	              NULL);
 	g_signal_connect (endpoint_dbus->notifier, "events",
 	                  G_CALLBACK (notifier_events_cb), endpoint);
 
@@ -1083,12 +2554,20 @@ tracker_endpoint_dbus_finalize (GObject *object)
 
 	g_cancellable_cancel (endpoint_dbus->cancellable);
 
+	stop_peer_server (endpoint_dbus);
+
 	if (endpoint_dbus->register_id != 0) {
 		g_dbus_connection_unregister_object (endpoint_dbus->dbus_connection,
 		                                     endpoint_dbus->register_id);
 		endpoint_dbus->register_id = 0;
 	}
 
+	g_clear_pointer (&endpoint_dbus->bus_statements, g_hash_table_unref);
+	g_clear_pointer (&endpoint_dbus->peer_statements, g_hash_table_unref);
+	g_clear_pointer (&endpoint_dbus->peer_senders, g_hash_table_unref);
+	g_clear_pointer (&endpoint_dbus->peer_tokens, g_hash_table_unref);
+	g_clear_pointer (&endpoint_dbus->notify_filters, g_hash_table_unref);
+	g_clear_pointer (&endpoint_dbus->notify_filter_counts, g_hash_table_unref);
 	g_clear_object (&endpoint_dbus->notifier);
 	g_clear_object (&endpoint_dbus->cancellable);
 	g_clear_object (&endpoint_dbus->dbus_connection);
@@ -1114,6 +2593,25 @@ tracker_endpoint_dbus_set_property (GObject      *object,
 	case PROP_OBJECT_PATH:
 		endpoint_dbus->object_path = g_value_dup_string (value);
 		break;
+	case PROP_PEER_TO_PEER:
+		endpoint_dbus->peer_to_peer = g_value_get_boolean (value);
+		break;
+	case PROP_NOTIFY_INTERVAL:
+		endpoint_dbus->notify_interval = g_value_get_uint (value);
+		if (endpoint_dbus->notifier) {
+			g_object_set (endpoint_dbus->notifier,
+			              "coalesce-interval", endpoint_dbus->notify_interval,
+			              NULL);
+		}
+		break;
+	case PROP_NOTIFY_MAX_EVENTS:
+		endpoint_dbus->notify_max_events = g_value_get_uint (value);
+		if (endpoint_dbus->notifier) {
+			g_object_set (endpoint_dbus->notifier,
+			              "coalesce-max-events", endpoint_dbus->notify_max_events,
+			              NULL);
+		}
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -1135,6 +2633,15 @@ tracker_endpoint_dbus_get_property (GObject    *object,
 	case PROP_OBJECT_PATH:
 		g_value_set_string (value, endpoint_dbus->object_path);
 		break;
+	case PROP_PEER_TO_PEER:
+		g_value_set_boolean (value, endpoint_dbus->peer_to_peer);
+		break;
+	case PROP_NOTIFY_INTERVAL:
+		g_value_set_uint (value, endpoint_dbus->notify_interval);
+		break;
+	case PROP_NOTIFY_MAX_EVENTS:
+		g_value_set_uint (value, endpoint_dbus->notify_max_events);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -1191,6 +2698,59 @@ tracker_endpoint_dbus_class_init (TrackerEndpointDBusClass *klass)
 		                     "DBus object path",
 		                     NULL,
 		                     G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+	/**
+	 * TrackerEndpointDBus:peer-to-peer:
+	 *
+	 * Whether the endpoint additionally listens on a private socket.
+	 *
+	 * Clients from the same user that are not sandboxed will connect
+	 * to it and use a direct D-Bus connection for their requests,
+	 * avoiding the message bus. Requests received through the
+	 * peer-to-peer connection do not emit
+	 * [signal@EndpointDBus::block-call].
+	 *
+	 * Since: 3.12
+	 */
+	props[PROP_PEER_TO_PEER] =
+		g_param_spec_boolean ("peer-to-peer",
+		                      "Peer to peer",
+		                      "Peer to peer",
+		                      FALSE,
+		                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+	/**
+	 * TrackerEndpointDBus:notify-interval:
+	 *
+	 * Time in milliseconds that change notifications are held for
+	 * before being broadcast. Changes to the same resource within
+	 * this time are merged, see [property@Notifier:coalesce-interval].
+	 * 0 broadcasts changes as soon as they are committed.
+	 *
+	 * Since: 3.12
+	 */
+	props[PROP_NOTIFY_INTERVAL] =
+		g_param_spec_uint ("notify-interval",
+		                   "Notify interval",
+		                   "Notify interval",
+		                   0, G_MAXUINT, 0,
+		                   G_PARAM_READWRITE);
+
+	/**
+	 * TrackerEndpointDBus:notify-max-events:
+	 *
+	 * Maximum number of held change notifications, once reached they
+	 * are broadcast without waiting for
+	 * [property@EndpointDBus:notify-interval] to elapse. 0 means no
+	 * limit.
+	 *
+	 * Since: 3.12
+	 */
+	props[PROP_NOTIFY_MAX_EVENTS] =
+		g_param_spec_uint ("notify-max-events",
+		                   "Notify max events",
+		                   "Notify max events",
+		                   0, G_MAXUINT, 0,
+		                   G_PARAM_READWRITE);
 
 	g_object_class_install_properties (object_class, N_PROPS, props);
 }
@@ -1199,6 +2759,21 @@ static void
 tracker_endpoint_dbus_init (TrackerEndpointDBus *endpoint)
 {
 	endpoint->cancellable = g_cancellable_new ();
+	endpoint->bus_statements =
+		g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+		                       (GDestroyNotify) prepared_statements_free);
+	endpoint->peer_statements =
+		g_hash_table_new_full (NULL, NULL, NULL,
+		                       (GDestroyNotify) prepared_statements_free);
+	endpoint->peer_senders =
+		g_hash_table_new_full (NULL, NULL, NULL, g_free);
+	endpoint->peer_tokens =
+		g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	endpoint->notify_filters =
+		g_hash_table_new_full (NULL, NULL, NULL,
+		                       (GDestroyNotify) notify_filter_free);
+	endpoint->notify_filter_counts =
+		g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 }
 
 /**
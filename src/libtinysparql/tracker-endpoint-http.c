@@ -62,6 +62,16 @@
  * A `TrackerEndpointHttp` may be created on a different thread/main
  * context from the one that created [class@SparqlConnection].
  *
+ * If the [class@SparqlConnection] is a local, writable database, query
+ * results obtained via GET requests are given an `ETag`, and conditional
+ * requests with a matching `If-None-Match` header are answered with
+ * `304 Not Modified` as long as the database was not modified since.
+ *
+ * The load put on the [class@SparqlConnection] may be limited through the
+ * [property@EndpointHttp:max-concurrent-queries],
+ * [property@EndpointHttp:max-queued-queries] and
+ * [property@EndpointHttp:query-timeout] properties.
+ *
  * Since: 3.1
  */
 
@@ -69,18 +79,26 @@
 
 #include "tracker-endpoint-http.h"
 
+#include "tracker-budget-stream.h"
 #include "tracker-deserializer-resource.h"
 #include "tracker-serializer.h"
 #include "tracker-private.h"
 
+#include "direct/tracker-direct.h"
+
 #include <tracker-http.h>
 
+#include <string.h>
+
 const gchar *supported_formats[] = {
 	"http://www.w3.org/ns/formats/SPARQL_Results_JSON",
 	"http://www.w3.org/ns/formats/SPARQL_Results_XML",
 	"http://www.w3.org/ns/formats/Turtle",
 	"http://www.w3.org/ns/formats/TriG",
 	"http://www.w3.org/ns/formats/JSON-LD",
+	"http://tracker.api.gnome.org/ns/formats/SPARQL_Results_Binary",
+	"http://www.w3.org/ns/formats/N-Triples",
+	"http://www.w3.org/ns/formats/N-Quads",
 };
 
 static const gchar *mimetypes[] = {
@@ -89,25 +107,51 @@ static const gchar *mimetypes[] = {
 	"text/turtle",
 	"application/trig",
 	"application/ld+json",
+	"application/x-tinysparql-results",
+	"application/n-triples",
+	"application/n-quads",
 };
 
 
 G_STATIC_ASSERT (G_N_ELEMENTS (supported_formats) == TRACKER_N_SERIALIZER_FORMATS);
 
+#define DEFAULT_MAX_QUEUED_QUERIES 64
+/* Share of the queued queries that a single remote address may hold */
+#define MAX_QUEUED_SHARE 4
+#define RETRY_AFTER_SECONDS "1"
+
 struct _TrackerEndpointHttp {
 	TrackerEndpoint parent_instance;
 	TrackerHttpServer *server;
 	GTlsCertificate *certificate;
 	guint port;
+	guint compression_min_size;
 	GCancellable *cancellable;
+	GMainContext *main_context;
+
+	/* Admission control */
+	guint max_concurrent_queries;
+	guint max_queued_queries;
+	guint query_timeout;
+	guint n_running;
+	guint n_queued;
+	GHashTable *queued; /* Remote address -> GQueue of Request */
+	GQueue remotes; /* Remote addresses with queued requests, round robin */
 };
 
 typedef struct {
+	/* Only running requests hold a reference on the endpoint */
 	TrackerEndpoint *endpoint;
 	TrackerHttpRequest *request;
 	GInputStream *istream;
 	GTask *task;
 	TrackerSerializerFormat format;
+	gchar *etag;
+	gchar *query;
+	gchar *remote;
+	GCancellable *budget;
+	GSource *budget_source;
+	GSource *queue_source;
 } Request;
 
 enum {
@@ -119,6 +163,10 @@ enum {
 	PROP_0,
 	PROP_HTTP_PORT,
 	PROP_HTTP_CERTIFICATE,
+	PROP_COMPRESSION_MIN_SIZE,
+	PROP_MAX_CONCURRENT_QUERIES,
+	PROP_MAX_QUEUED_QUERIES,
+	PROP_QUERY_TIMEOUT,
 	N_PROPS
 };
 
@@ -130,13 +178,63 @@ static void tracker_endpoint_http_initable_iface_init (GInitableIface *iface);
 G_DEFINE_TYPE_WITH_CODE (TrackerEndpointHttp, tracker_endpoint_http, TRACKER_TYPE_ENDPOINT,
                          G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE, tracker_endpoint_http_initable_iface_init))
 
+static void dispatch_queued_requests (TrackerEndpointHttp *endpoint_http);
+
+static void
+clear_source (GSource **source)
+{
+	if (*source) {
+		g_source_destroy (*source);
+		g_clear_pointer (source, g_source_unref);
+	}
+}
+
 static void
 request_free (Request *request)
 {
+	clear_source (&request->budget_source);
+	clear_source (&request->queue_source);
+
 	g_clear_object (&request->istream);
+	g_clear_object (&request->budget);
+	g_free (request->etag);
+	g_free (request->query);
+	g_free (request->remote);
 	g_free (request);
 }
 
+/* Frees the running request, and lets the next ones in */
+static gboolean
+request_finish (gpointer user_data)
+{
+	Request *request = user_data;
+	TrackerEndpointHttp *endpoint_http;
+
+	endpoint_http = TRACKER_ENDPOINT_HTTP (request->endpoint);
+
+	g_assert (endpoint_http->n_running > 0);
+	endpoint_http->n_running--;
+	request_free (request);
+
+	dispatch_queued_requests (endpoint_http);
+	/* Drops the reference taken in start_request() */
+	g_object_unref (endpoint_http);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+response_stream_closed (gpointer user_data)
+{
+	Request *request = user_data;
+	TrackerEndpointHttp *endpoint_http;
+
+	/* The stream may be closed from a thread */
+	endpoint_http = TRACKER_ENDPOINT_HTTP (request->endpoint);
+	g_main_context_invoke (endpoint_http->main_context,
+	                       request_finish, request);
+}
+
 static void
 query_async_cb (GObject      *object,
                 GAsyncResult *result,
@@ -146,35 +244,271 @@ query_async_cb (GObject      *object,
 	TrackerSparqlCursor *cursor;
 	TrackerSparqlConnection *conn;
 	Request *request = user_data;
-	GInputStream *stream;
+	GInputStream *stream, *serializer;
 	GError *error = NULL;
 
 	endpoint_http = TRACKER_ENDPOINT_HTTP (request->endpoint);
 	cursor = tracker_sparql_connection_query_finish (TRACKER_SPARQL_CONNECTION (object),
 	                                                 result, &error);
 	if (error) {
-		tracker_http_server_error (endpoint_http->server,
-		                           request->request,
-		                           400,
-		                           error->message);
-		request_free (request);
+		if (request->budget && g_cancellable_is_cancelled (request->budget)) {
+			tracker_http_server_error (endpoint_http->server,
+			                           request->request,
+			                           503,
+			                           "Query exceeded its time budget");
+		} else {
+			tracker_http_server_error (endpoint_http->server,
+			                           request->request,
+			                           400,
+			                           error->message);
+		}
+
+		request_finish (request);
 		g_error_free (error);
 		return;
 	}
 
 	conn = tracker_sparql_cursor_get_connection (cursor);
-	stream = tracker_serializer_new (cursor,
-	                                 tracker_sparql_connection_get_namespace_manager (conn),
-	                                 request->format);
+	serializer = tracker_serializer_new (cursor,
+	                                     tracker_sparql_connection_get_namespace_manager (conn),
+	                                     request->format);
+
+	/* The request is finished once the response is sent */
+	stream = tracker_budget_stream_new (serializer,
+	                                    request->budget,
+	                                    response_stream_closed,
+	                                    request);
+	g_object_unref (serializer);
+
+	if (request->etag) {
+		tracker_http_server_set_response_header (endpoint_http->server,
+		                                         request->request,
+		                                         "ETag", request->etag);
+		tracker_http_server_set_response_header (endpoint_http->server,
+		                                         request->request,
+		                                         "Cache-Control", "no-cache");
+	} else {
+		tracker_http_server_set_response_header (endpoint_http->server,
+		                                         request->request,
+		                                         "Cache-Control", "no-store");
+	}
+
 	/* Consumes the input stream */
 	tracker_http_server_response (endpoint_http->server,
 	                              request->request,
 	                              mimetypes[request->format],
 	                              stream);
-	request_free (request);
+	request->request = NULL;
 	g_object_unref (cursor);
 }
 
+static gboolean
+budget_expired_cb (gpointer user_data)
+{
+	Request *request = user_data;
+
+	/* Interrupts the query on the next SQLite progress handler check */
+	g_cancellable_cancel (request->budget);
+	g_clear_pointer (&request->budget_source, g_source_unref);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+start_request (TrackerEndpointHttp *endpoint_http,
+               Request             *request)
+{
+	TrackerSparqlConnection *conn;
+
+	g_object_ref (endpoint_http);
+	endpoint_http->n_running++;
+
+	if (endpoint_http->query_timeout > 0) {
+		request->budget = g_cancellable_new ();
+		request->budget_source = g_timeout_source_new (endpoint_http->query_timeout);
+		g_source_set_callback (request->budget_source,
+		                       budget_expired_cb, request, NULL);
+		g_source_attach (request->budget_source, endpoint_http->main_context);
+	}
+
+	conn = tracker_endpoint_get_sparql_connection (TRACKER_ENDPOINT (endpoint_http));
+	tracker_sparql_connection_query_async (conn,
+	                                       request->query,
+	                                       request->budget,
+	                                       query_async_cb,
+	                                       request);
+}
+
+static Request *
+pop_queued_request (TrackerEndpointHttp *endpoint_http)
+{
+	Request *request;
+	gchar *remote;
+	GQueue *queue;
+
+	remote = g_queue_pop_head (&endpoint_http->remotes);
+	if (!remote)
+		return NULL;
+
+	queue = g_hash_table_lookup (endpoint_http->queued, remote);
+	request = g_queue_pop_head (queue);
+	endpoint_http->n_queued--;
+	clear_source (&request->queue_source);
+
+	/* Requests from other addresses go first next time */
+	if (g_queue_is_empty (queue))
+		g_hash_table_remove (endpoint_http->queued, remote);
+	else
+		g_queue_push_tail (&endpoint_http->remotes, remote);
+
+	return request;
+}
+
+static void
+dispatch_queued_requests (TrackerEndpointHttp *endpoint_http)
+{
+	Request *request;
+
+	while (endpoint_http->max_concurrent_queries == 0 ||
+	       endpoint_http->n_running < endpoint_http->max_concurrent_queries) {
+		request = pop_queued_request (endpoint_http);
+		if (!request)
+			break;
+
+		start_request (endpoint_http, request);
+	}
+}
+
+static void
+reject_request (TrackerEndpointHttp *endpoint_http,
+                Request             *request,
+                gint                 code,
+                const gchar         *message)
+{
+	tracker_http_server_set_response_header (endpoint_http->server,
+	                                         request->request,
+	                                         "Retry-After",
+	                                         RETRY_AFTER_SECONDS);
+	tracker_http_server_error (endpoint_http->server,
+	                           request->request,
+	                           code, message);
+	request_free (request);
+}
+
+static void
+unqueue_request (TrackerEndpointHttp *endpoint_http,
+                 Request             *request)
+{
+	gpointer remote;
+	GQueue *queue;
+
+	if (!g_hash_table_lookup_extended (endpoint_http->queued,
+	                                   request->remote,
+	                                   &remote, (gpointer *) &queue))
+		g_assert_not_reached ();
+
+	g_queue_remove (queue, request);
+	endpoint_http->n_queued--;
+
+	if (g_queue_is_empty (queue)) {
+		g_queue_remove (&endpoint_http->remotes, remote);
+		g_hash_table_remove (endpoint_http->queued, remote);
+	}
+}
+
+static gboolean
+queue_timeout_cb (gpointer user_data)
+{
+	Request *request = user_data;
+	TrackerEndpointHttp *endpoint_http;
+
+	endpoint_http = TRACKER_ENDPOINT_HTTP (request->endpoint);
+	g_clear_pointer (&request->queue_source, g_source_unref);
+
+	/* The remote address has other queries ahead, it is
+	 * using up its share of the endpoint.
+	 */
+	unqueue_request (endpoint_http, request);
+	reject_request (endpoint_http, request, 429,
+	                "Query exceeded its time budget waiting its turn");
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+admit_request (TrackerEndpointHttp *endpoint_http,
+               Request             *request)
+{
+	GQueue *queue;
+
+	if (endpoint_http->max_concurrent_queries == 0 ||
+	    endpoint_http->n_running < endpoint_http->max_concurrent_queries) {
+		start_request (endpoint_http, request);
+		return;
+	}
+
+	if (endpoint_http->n_queued >= endpoint_http->max_queued_queries) {
+		reject_request (endpoint_http, request, 503, "Too many queries");
+		return;
+	}
+
+	queue = g_hash_table_lookup (endpoint_http->queued, request->remote);
+
+	if (queue &&
+	    g_queue_get_length (queue) >= MAX (1, endpoint_http->max_queued_queries / MAX_QUEUED_SHARE)) {
+		reject_request (endpoint_http, request, 429,
+		                "Too many queries from this address");
+		return;
+	}
+
+	if (!queue) {
+		gchar *remote;
+
+		remote = g_strdup (request->remote);
+		queue = g_queue_new ();
+		g_hash_table_insert (endpoint_http->queued, remote, queue);
+		g_queue_push_tail (&endpoint_http->remotes, remote);
+	}
+
+	g_queue_push_tail (queue, request);
+	endpoint_http->n_queued++;
+
+	if (endpoint_http->query_timeout > 0) {
+		request->queue_source = g_timeout_source_new (endpoint_http->query_timeout);
+		g_source_set_callback (request->queue_source,
+		                       queue_timeout_cb, request, NULL);
+		g_source_attach (request->queue_source, endpoint_http->main_context);
+	}
+}
+
+static void
+fail_queued_requests (TrackerEndpointHttp *endpoint_http)
+{
+	Request *request;
+
+	while ((request = pop_queued_request (endpoint_http)) != NULL) {
+		tracker_http_server_error (endpoint_http->server,
+		                           request->request,
+		                           503,
+		                           "Endpoint is shutting down");
+		request_free (request);
+	}
+}
+
+static gchar *
+get_remote_key (GSocketAddress *remote_address)
+{
+	GInetAddress *inet_address;
+
+	/* Requests are queued per host, regardless of the port */
+	if (!G_IS_INET_SOCKET_ADDRESS (remote_address))
+		return g_strdup ("");
+
+	inet_address = g_inet_socket_address_get_address (G_INET_SOCKET_ADDRESS (remote_address));
+
+	return g_inet_address_to_string (inet_address);
+}
+
 static gboolean
 pick_format (guint                    formats,
              TrackerSerializerFormat *format)
@@ -192,6 +526,14 @@ pick_format (guint                    formats,
 		}
 	}
 
+	/* These are the formats the client prefers the most, if
+	 * the compact binary format is among them, pick it.
+	 */
+	if ((formats & (1 << TRACKER_SERIALIZER_FORMAT_BINARY)) != 0) {
+		*format = TRACKER_SERIALIZER_FORMAT_BINARY;
+		return TRUE;
+	}
+
 	for (i = 0; i < TRACKER_N_SERIALIZER_FORMATS; i++) {
 		if ((formats & (1 << i)) != 0) {
 			*format = i;
@@ -202,6 +544,73 @@ pick_format (guint                    formats,
 	return FALSE;
 }
 
+/* The ETag identifies the query, the serialization format and
+ * the state of the database. It is a weak validator since the
+ * response may be compressed.
+ */
+static gchar *
+create_etag (TrackerEndpoint         *endpoint,
+             const gchar             *query,
+             TrackerSerializerFormat  format)
+{
+	TrackerSparqlConnection *conn;
+	GChecksum *checksum;
+	guint64 modification_count;
+	guint32 format_value = format;
+	gchar *etag;
+
+	conn = tracker_endpoint_get_sparql_connection (endpoint);
+
+	/* Only direct connections know whether their data changed */
+	if (!TRACKER_IS_DIRECT_CONNECTION (conn) ||
+	    !tracker_direct_connection_get_modification_count (TRACKER_DIRECT_CONNECTION (conn),
+	                                                       &modification_count))
+		return NULL;
+
+	if (!tracker_direct_connection_is_deterministic_query (TRACKER_DIRECT_CONNECTION (conn),
+	                                                       query))
+		return NULL;
+
+	checksum = g_checksum_new (G_CHECKSUM_SHA256);
+	g_checksum_update (checksum, (const guchar *) query, -1);
+	g_checksum_update (checksum, (const guchar *) &format_value,
+	                   sizeof (format_value));
+	g_checksum_update (checksum, (const guchar *) &modification_count,
+	                   sizeof (modification_count));
+	etag = g_strdup_printf ("W/\"%s\"", g_checksum_get_string (checksum));
+	g_checksum_free (checksum);
+
+	return etag;
+}
+
+/* Implements the weak comparison of If-None-Match entity tags */
+static gboolean
+etag_matches (const gchar *if_none_match,
+              const gchar *etag)
+{
+	gchar **tags;
+	gboolean matches = FALSE;
+	guint i;
+
+	/* Skip the weak indicator of our own ETag */
+	etag += 2;
+
+	tags = g_strsplit (if_none_match, ",", -1);
+
+	for (i = 0; !matches && tags[i]; i++) {
+		const gchar *tag = g_strstrip (tags[i]);
+
+		if (g_str_has_prefix (tag, "W/"))
+			tag += 2;
+
+		matches = strcmp (tag, "*") == 0 || strcmp (tag, etag) == 0;
+	}
+
+	g_strfreev (tags);
+
+	return matches;
+}
+
 static void
 add_supported_formats (TrackerResource *resource,
                        const gchar     *property)
@@ -252,7 +661,6 @@ sparql_server_request_cb (TrackerHttpServer  *server,
                           gpointer            user_data)
 {
 	TrackerEndpoint *endpoint = user_data;
-	TrackerSparqlConnection *conn;
 	TrackerSerializerFormat format;
 	const gchar *sparql = NULL;
 	Request *data;
@@ -285,17 +693,35 @@ sparql_server_request_cb (TrackerHttpServer  *server,
 		data->endpoint = endpoint;
 		data->request = request;
 		data->format = format;
+		data->remote = get_remote_key (remote_address);
 
 		query = g_strdup (sparql);
 		tracker_endpoint_rewrite_query (TRACKER_ENDPOINT (endpoint), &query);
+		data->query = query;
+
+		/* Only GET requests may be answered from caches */
+		if (g_strcmp0 (method, "GET") == 0)
+			data->etag = create_etag (endpoint, query, format);
+
+		if (data->etag) {
+			const gchar *if_none_match;
+
+			if_none_match = tracker_http_server_get_request_header (server,
+			                                                        request,
+			                                                        "If-None-Match");
+
+			if (if_none_match && etag_matches (if_none_match, data->etag)) {
+				tracker_http_server_set_response_header (server, request,
+				                                         "ETag", data->etag);
+				tracker_http_server_set_response_header (server, request,
+				                                         "Cache-Control", "no-cache");
+				tracker_http_server_not_modified (server, request);
+				request_free (data);
+				return;
+			}
+		}
 
-		conn = tracker_endpoint_get_sparql_connection (endpoint);
-		tracker_sparql_connection_query_async (conn,
-		                                       query,
-		                                       NULL,
-		                                       query_async_cb,
-		                                       data);
-		g_free (query);
+		admit_request (TRACKER_ENDPOINT_HTTP (endpoint), data);
 	} else {
 		TrackerNamespaceManager *namespaces;
 		TrackerResource *description;
@@ -344,6 +770,12 @@ tracker_endpoint_http_initable_init (GInitable     *initable,
 	if (!endpoint_http->server)
 		return FALSE;
 
+	endpoint_http->main_context = g_main_context_ref_thread_default ();
+
+	g_object_bind_property (endpoint_http, "compression-min-size",
+	                        endpoint_http->server, "compression-min-size",
+	                        G_BINDING_SYNC_CREATE);
+
 	g_signal_connect (endpoint_http->server, "request",
 	                  G_CALLBACK (sparql_server_request_cb), initable);
 	return TRUE;
@@ -355,6 +787,18 @@ tracker_endpoint_http_initable_iface_init (GInitableIface *iface)
 	iface->init = tracker_endpoint_http_initable_init;
 }
 
+static void
+tracker_endpoint_http_dispose (GObject *object)
+{
+	TrackerEndpointHttp *endpoint_http = TRACKER_ENDPOINT_HTTP (object);
+
+	/* Running requests keep the endpoint alive, but queued ones do not */
+	if (endpoint_http->queued)
+		fail_queued_requests (endpoint_http);
+
+	G_OBJECT_CLASS (tracker_endpoint_http_parent_class)->dispose (object);
+}
+
 static void
 tracker_endpoint_http_finalize (GObject *object)
 {
@@ -366,6 +810,9 @@ tracker_endpoint_http_finalize (GObject *object)
 
 	g_clear_object (&endpoint_http->server);
 
+	g_clear_pointer (&endpoint_http->queued, g_hash_table_unref);
+	g_clear_pointer (&endpoint_http->main_context, g_main_context_unref);
+
 	G_OBJECT_CLASS (tracker_endpoint_http_parent_class)->finalize (object);
 }
 
@@ -384,6 +831,20 @@ tracker_endpoint_http_set_property (GObject      *object,
 	case PROP_HTTP_CERTIFICATE:
 		endpoint_http->certificate = g_value_dup_object (value);
 		break;
+	case PROP_COMPRESSION_MIN_SIZE:
+		endpoint_http->compression_min_size = g_value_get_uint (value);
+		break;
+	case PROP_MAX_CONCURRENT_QUERIES:
+		endpoint_http->max_concurrent_queries = g_value_get_uint (value);
+		if (endpoint_http->server)
+			dispatch_queued_requests (endpoint_http);
+		break;
+	case PROP_MAX_QUEUED_QUERIES:
+		endpoint_http->max_queued_queries = g_value_get_uint (value);
+		break;
+	case PROP_QUERY_TIMEOUT:
+		endpoint_http->query_timeout = g_value_get_uint (value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -405,6 +866,18 @@ tracker_endpoint_http_get_property (GObject    *object,
 	case PROP_HTTP_CERTIFICATE:
 		g_value_set_object (value, endpoint_http->certificate);
 		break;
+	case PROP_COMPRESSION_MIN_SIZE:
+		g_value_set_uint (value, endpoint_http->compression_min_size);
+		break;
+	case PROP_MAX_CONCURRENT_QUERIES:
+		g_value_set_uint (value, endpoint_http->max_concurrent_queries);
+		break;
+	case PROP_MAX_QUEUED_QUERIES:
+		g_value_set_uint (value, endpoint_http->max_queued_queries);
+		break;
+	case PROP_QUERY_TIMEOUT:
+		g_value_set_uint (value, endpoint_http->query_timeout);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -416,6 +889,7 @@ tracker_endpoint_http_class_init (TrackerEndpointHttpClass *klass)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
+	object_class->dispose = tracker_endpoint_http_dispose;
 	object_class->finalize = tracker_endpoint_http_finalize;
 	object_class->set_property = tracker_endpoint_http_set_property;
 	object_class->get_property = tracker_endpoint_http_get_property;
@@ -461,6 +935,73 @@ tracker_endpoint_http_class_init (TrackerEndpointHttpClass *klass)
 		                     "HTTP certificate",
 		                     G_TYPE_TLS_CERTIFICATE,
 		                     G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+	/**
+	 * TrackerEndpointHttp:compression-min-size:
+	 *
+	 * Minimum size in bytes of a response for it to be compressed,
+	 * if the client accepts gzip or deflate content encodings.
+	 * %G_MAXUINT disables response compression.
+	 *
+	 * Since: 3.12
+	 */
+	props[PROP_COMPRESSION_MIN_SIZE] =
+		g_param_spec_uint ("compression-min-size",
+		                   "Compression minimum size",
+		                   "Compression minimum size",
+		                   0, G_MAXUINT,
+		                   TRACKER_HTTP_DEFAULT_COMPRESSION_MIN_SIZE,
+		                   G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+	/**
+	 * TrackerEndpointHttp:max-concurrent-queries:
+	 *
+	 * Maximum number of queries being run at the same time, further
+	 * queries are put on hold until others finish. 0 means no limit.
+	 *
+	 * Since: 3.12
+	 */
+	props[PROP_MAX_CONCURRENT_QUERIES] =
+		g_param_spec_uint ("max-concurrent-queries",
+		                   "Max concurrent queries",
+		                   "Max concurrent queries",
+		                   0, G_MAXUINT,
+		                   0,
+		                   G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+	/**
+	 * TrackerEndpointHttp:max-queued-queries:
+	 *
+	 * Maximum number of queries on hold while
+	 * [property@EndpointHttp:max-concurrent-queries] are being run.
+	 * Queries beyond this limit are replied with a `503 Service Unavailable`
+	 * status. Queries on hold are taken in turns from each remote address,
+	 * a remote address holding a quarter of this limit gets further queries
+	 * replied with a `429 Too Many Requests` status.
+	 *
+	 * Since: 3.12
+	 */
+	props[PROP_MAX_QUEUED_QUERIES] =
+		g_param_spec_uint ("max-queued-queries",
+		                   "Max queued queries",
+		                   "Max queued queries",
+		                   0, G_MAXUINT,
+		                   DEFAULT_MAX_QUEUED_QUERIES,
+		                   G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+	/**
+	 * TrackerEndpointHttp:query-timeout:
+	 *
+	 * Time in milliseconds that a query is allowed to run, including
+	 * the time spent sending its results. Queries are interrupted past
+	 * this time. Queries on hold for longer than this time are replied
+	 * with a `429 Too Many Requests` status. 0 means no limit.
+	 *
+	 * Since: 3.12
+	 */
+	props[PROP_QUERY_TIMEOUT] =
+		g_param_spec_uint ("query-timeout",
+		                   "Query timeout",
+		                   "Query timeout",
+		                   0, G_MAXUINT,
+		                   0,
+		                   G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
 
 	g_object_class_install_properties (object_class, N_PROPS, props);
 }
@@ -469,6 +1010,8 @@ static void
 tracker_endpoint_http_init (TrackerEndpointHttp *endpoint)
 {
 	endpoint->cancellable = g_cancellable_new ();
+	endpoint->queued = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                          g_free, (GDestroyNotify) g_queue_free);
 }
 
 /**
@@ -28,5 +28,8 @@ typedef enum
 	TRACKER_SERIALIZER_FORMAT_TTL, /* text/turtle */
 	TRACKER_SERIALIZER_FORMAT_TRIG, /* application/trig */
 	TRACKER_SERIALIZER_FORMAT_JSON_LD, /* application/ld+json */
+	TRACKER_SERIALIZER_FORMAT_BINARY, /* application/x-tinysparql-results */
+	TRACKER_SERIALIZER_FORMAT_NTRIPLES, /* application/n-triples */
+	TRACKER_SERIALIZER_FORMAT_NQUADS, /* application/n-quads */
 	TRACKER_N_SERIALIZER_FORMATS
 } TrackerSerializerFormat;
@@ -34,6 +34,12 @@
  * @TRACKER_RDF_FORMAT_JSON_LD: JSON-LD format
  *   ([http://www.w3.org/ns/formats/JSON-LD](http://www.w3.org/ns/formats/JSON-LD)).
  *   This value was added in version 3.5.
+ * @TRACKER_RDF_FORMAT_N_TRIPLES: N-Triples format
+ *   ([http://www.w3.org/ns/formats/N-Triples](http://www.w3.org/ns/formats/N-Triples)).
+ *   This value was added in version 3.12.
+ * @TRACKER_RDF_FORMAT_N_QUADS: N-Quads format
+ *   ([http://www.w3.org/ns/formats/N-Quads](http://www.w3.org/ns/formats/N-Quads)).
+ *   This value was added in version 3.12.
  * @TRACKER_RDF_FORMAT_LAST: The total number of RDF formats
  *
  * Describes a RDF format to be used in data exchange.
@@ -42,6 +48,8 @@ typedef enum {
 	TRACKER_RDF_FORMAT_TURTLE,
 	TRACKER_RDF_FORMAT_TRIG,
 	TRACKER_RDF_FORMAT_JSON_LD,
+	TRACKER_RDF_FORMAT_N_TRIPLES,
+	TRACKER_RDF_FORMAT_N_QUADS,
 	TRACKER_RDF_FORMAT_LAST
 } TrackerRdfFormat;
 
@@ -36,6 +36,17 @@ _tracker_notifier_event_cache_push_event (TrackerNotifierEventCache *cache,
                                           gint64                     id,
                                           TrackerNotifierEventType   event_type);
 
+void
+_tracker_notifier_event_cache_push_event_full (TrackerNotifierEventCache *cache,
+                                               gint64                     id,
+                                               TrackerNotifierEventType   event_type,
+                                               const gchar               *class_uri,
+                                               const gchar               *property_uri);
+
+gboolean tracker_notifier_event_matches_filter (TrackerNotifierEvent *event,
+                                                const gchar * const  *classes,
+                                                const gchar * const  *properties);
+
 void _tracker_notifier_event_cache_flush_events (TrackerNotifier           *notifier,
                                                  TrackerNotifierEventCache *cache);
 
@@ -43,4 +54,6 @@ const gchar * tracker_notifier_event_cache_get_graph (TrackerNotifierEventCache
 
 void tracker_notifier_disable_urn_query (TrackerNotifier *notifier);
 
+void tracker_notifier_enable_event_details (TrackerNotifier *notifier);
+
 void tracker_notifier_stop (TrackerNotifier *notifier);
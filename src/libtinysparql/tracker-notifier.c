@@ -51,6 +51,11 @@
  *
  * The [signal@Notifier::events] signal is emitted in the thread-default
  * main context of the thread where the `TrackerNotifier` instance was created.
+ *
+ * Events may be restricted to resources of specific classes, or to
+ * changes on specific properties, through [method@Notifier.set_filter].
+ * This filtering is performed by the endpoint for D-Bus connections,
+ * so that irrelevant changes do not reach the client at all.
  */
 
 #include "config.h"
@@ -64,27 +69,43 @@
 
 typedef struct _TrackerNotifierPrivate TrackerNotifierPrivate;
 typedef struct _TrackerNotifierSubscription TrackerNotifierSubscription;
+typedef struct _TrackerNotifierResolver TrackerNotifierResolver;
+
+#define N_SLOTS 50 /* In sync with tracker-vtab-service.c parameters */
+#define N_LOCAL_SLOTS 500 /* Used when no SERVICE is involved */
+#define MAX_QUERIES_IN_FLIGHT 4
 
 struct _TrackerNotifierSubscription {
 	GDBusConnection *connection;
 	TrackerNotifier *notifier;
-	TrackerSparqlStatement *statement;
-	gint n_statement_slots;
+	TrackerNotifierResolver *resolver;
+	GCancellable *cancellable;
 	gchar *service;
 	gchar *object_path;
+	gchar *dbus_name;
+	gchar *dbus_path;
+	gchar *graph;
 	guint handler_id;
+	guint unfiltered_handler_id; /* GraphUpdated, until subscribed */
+	guint32 filter_id;
 };
 
 struct _TrackerNotifierPrivate {
 	TrackerSparqlConnection *connection;
 	GHashTable *subscriptions; /* guint -> TrackerNotifierSubscription */
 	GCancellable *cancellable;
-	TrackerSparqlStatement *local_statement;
-	GAsyncQueue *queue;
+	TrackerNotifierResolver *local_resolver;
+	GQueue pending; /* Event caches waiting for URNs, in order */
 	GMainContext *main_context;
-	gint n_local_statement_slots;
-	guint querying : 1;
+	GStrv filter_classes;
+	GStrv filter_properties;
+	GHashTable *coalescing; /* gchar * -> TrackerNotifierEventCache */
+	GSource *coalesce_source;
+	guint coalesce_interval;
+	guint coalesce_max_events;
 	guint urn_query_disabled : 1;
+	guint track_details : 1;
+	guint details_enabled : 1;
 	GMutex mutex;
 };
 
@@ -92,23 +113,63 @@ struct _TrackerNotifierEventCache {
 	gchar *service;
 	gchar *graph;
 	GWeakRef notifier;
-	GCancellable *cancellable;
-	TrackerSparqlStatement *stmt;
+	TrackerNotifierResolver *resolver;
 	GPtrArray *events;
 	GHashTable *events_by_id;
-	guint first;
+	guint n_unresolved;
+	guint track_details : 1;
+	guint resolved : 1;
+	guint coalesced : 1;
 };
 
+/* Resolves resource IDs to URNs for all notifiers of a connection
+ * that query the same service. Lookups for the same resource are
+ * merged, and are performed in batches.
+ */
+struct _TrackerNotifierResolver {
+	TrackerSparqlConnection *connection;
+	gchar *service;
+	GMutex mutex;
+	TrackerSparqlStatement *stmts[MAX_QUERIES_IN_FLIGHT];
+	guint busy_slots;
+	guint n_slots;
+	GHashTable *lookups; /* gint64 -> ResolverLookup */
+	GQueue queue; /* Lookups not queried yet */
+	gint ref_count;
+};
+
+typedef struct {
+	TrackerNotifierEventCache *cache;
+	TrackerNotifierEvent *event;
+} ResolverWaiter;
+
+typedef struct {
+	TrackerNotifierResolver *resolver;
+	GPtrArray *lookups;
+	guint slot;
+} ResolverQuery;
+
+typedef struct {
+	gint64 id;
+	GArray *waiters; /* Unset once resolved */
+	ResolverQuery *query;
+} ResolverLookup;
+
 struct _TrackerNotifierEvent {
 	gint8 type;
 	gint64 id;
 	gchar *urn;
+	/* Class and property URIs, owned by the ontology */
+	GPtrArray *classes;
+	GPtrArray *properties;
 	guint ref_count;
 };
 
 enum {
 	PROP_0,
 	PROP_CONNECTION,
+	PROP_COALESCE_INTERVAL,
+	PROP_COALESCE_MAX_EVENTS,
 	N_PROPS
 };
 
@@ -119,21 +180,29 @@ enum {
 
 static guint signals[N_SIGNALS] = { 0 };
 
-#define N_SLOTS 50 /* In sync with tracker-vtab-service.c parameters */
-
 #define DEFAULT_OBJECT_PATH "/org/freedesktop/Tracker3/Endpoint"
 
 G_DEFINE_TYPE_WITH_CODE (TrackerNotifier, tracker_notifier, G_TYPE_OBJECT,
                          G_ADD_PRIVATE (TrackerNotifier))
 
-static void tracker_notifier_query_extra_info (TrackerNotifier           *notifier,
-                                               TrackerNotifierEventCache *cache);
+G_DEFINE_QUARK (TrackerNotifierResolvers, tracker_notifier_resolvers)
+
+G_LOCK_DEFINE_STATIC (resolvers);
 
 static gchar * get_service_name (TrackerNotifier             *notifier,
                                  TrackerNotifierSubscription *subscription);
 
-static TrackerSparqlStatement * ensure_extra_info_statement (TrackerNotifier             *notifier,
-                                                             TrackerNotifierSubscription *subscription);
+static TrackerNotifierResolver * ensure_resolver (TrackerNotifier             *notifier,
+                                                  TrackerNotifierSubscription *subscription);
+
+static TrackerNotifierResolver * tracker_notifier_resolver_get (TrackerSparqlConnection *connection,
+                                                                const gchar             *service);
+
+static TrackerNotifierResolver * tracker_notifier_resolver_ref (TrackerNotifierResolver *resolver);
+
+static void tracker_notifier_resolver_unref (TrackerNotifierResolver *resolver);
+
+static void tracker_notifier_subscription_connect (TrackerNotifierSubscription *subscription);
 
 static TrackerNotifierSubscription *
 tracker_notifier_subscription_new (TrackerNotifier *notifier,
@@ -152,15 +221,52 @@ tracker_notifier_subscription_new (TrackerNotifier *notifier,
 	return subscription;
 }
 
+static void
+tracker_notifier_subscription_release_filter (TrackerNotifierSubscription *subscription)
+{
+	if (subscription->cancellable) {
+		g_cancellable_cancel (subscription->cancellable);
+		g_clear_object (&subscription->cancellable);
+	}
+
+	if (subscription->unfiltered_handler_id != 0) {
+		g_dbus_connection_signal_unsubscribe (subscription->connection,
+		                                      subscription->unfiltered_handler_id);
+		subscription->unfiltered_handler_id = 0;
+	}
+
+	if (subscription->filter_id != 0) {
+		GDBusMessage *message;
+
+		message = g_dbus_message_new_method_call (subscription->dbus_name,
+		                                          subscription->dbus_path,
+		                                          "org.freedesktop.Tracker3.Endpoint",
+		                                          "Unsubscribe");
+		g_dbus_message_set_body (message,
+		                         g_variant_new ("(u)", subscription->filter_id));
+		g_dbus_message_set_flags (message,
+		                          G_DBUS_MESSAGE_FLAGS_NO_REPLY_EXPECTED);
+		g_dbus_connection_send_message (subscription->connection, message,
+		                                G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+		                                NULL, NULL);
+		g_object_unref (message);
+		subscription->filter_id = 0;
+	}
+}
+
 static void
 tracker_notifier_subscription_free (TrackerNotifierSubscription *subscription)
 {
+	tracker_notifier_subscription_release_filter (subscription);
 	g_dbus_connection_signal_unsubscribe (subscription->connection,
 	                                      subscription->handler_id);
 	g_object_unref (subscription->connection);
-	g_clear_object (&subscription->statement);
+	g_clear_pointer (&subscription->resolver, tracker_notifier_resolver_unref);
 	g_free (subscription->service);
 	g_free (subscription->object_path);
+	g_free (subscription->dbus_name);
+	g_free (subscription->dbus_path);
+	g_free (subscription->graph);
 	g_free (subscription);
 }
 
@@ -187,6 +293,8 @@ static void
 tracker_notifier_event_unref (TrackerNotifierEvent *event)
 {
 	if (g_atomic_int_dec_and_test (&event->ref_count)) {
+		g_clear_pointer (&event->classes, g_ptr_array_unref);
+		g_clear_pointer (&event->properties, g_ptr_array_unref);
 		g_free (event->urn);
 		g_free (event);
 	}
@@ -210,10 +318,10 @@ _tracker_notifier_event_cache_new_full (TrackerNotifier             *notifier,
 	event_cache = g_new0 (TrackerNotifierEventCache, 1);
 	g_weak_ref_init (&event_cache->notifier, notifier);
 	event_cache->graph = g_strdup (graph);
-	event_cache->cancellable = g_object_ref (priv->cancellable);
 	event_cache->events = g_ptr_array_new_with_free_func ((GDestroyNotify) tracker_notifier_event_unref);
 	event_cache->events_by_id = g_hash_table_new (g_int64_hash, g_int64_equal);
-	event_cache->stmt = ensure_extra_info_statement (notifier, subscription);
+	event_cache->resolver = tracker_notifier_resolver_ref (ensure_resolver (notifier, subscription));
+	event_cache->track_details = priv->track_details;
 
 	if (subscription)
 		event_cache->service = get_service_name (notifier, subscription);
@@ -234,7 +342,7 @@ _tracker_notifier_event_cache_free (TrackerNotifierEventCache *event_cache)
 	g_hash_table_unref (event_cache->events_by_id);
 	g_clear_pointer (&event_cache->events, g_ptr_array_unref);
 	g_weak_ref_clear (&event_cache->notifier);
-	g_object_unref (event_cache->cancellable);
+	tracker_notifier_resolver_unref (event_cache->resolver);
 	g_free (event_cache->service);
 	g_free (event_cache->graph);
 	g_free (event_cache);
@@ -260,10 +368,41 @@ tracker_notifier_event_cache_get_event (TrackerNotifierEventCache *cache,
 	return event;
 }
 
+static void
+add_event_detail (GPtrArray   **details,
+                  const gchar  *uri)
+{
+	guint i;
+
+	if (!uri)
+		return;
+
+	if (!*details)
+		*details = g_ptr_array_new ();
+
+	for (i = 0; i < (*details)->len; i++) {
+		if (g_ptr_array_index (*details, i) == uri)
+			return;
+	}
+
+	g_ptr_array_add (*details, (gpointer) uri);
+}
+
 void
 _tracker_notifier_event_cache_push_event (TrackerNotifierEventCache *cache,
                                           gint64                     id,
                                           TrackerNotifierEventType   event_type)
+{
+	_tracker_notifier_event_cache_push_event_full (cache, id, event_type,
+	                                               NULL, NULL);
+}
+
+void
+_tracker_notifier_event_cache_push_event_full (TrackerNotifierEventCache *cache,
+                                               gint64                     id,
+                                               TrackerNotifierEventType   event_type,
+                                               const gchar               *class_uri,
+                                               const gchar               *property_uri)
 {
 	TrackerNotifierEvent *event;
 
@@ -271,6 +410,91 @@ _tracker_notifier_event_cache_push_event (TrackerNotifierEventCache *cache,
 
 	if (event->type < 0 || event_type != TRACKER_NOTIFIER_EVENT_UPDATE)
 		event->type = event_type;
+
+	if (cache->track_details) {
+		add_event_detail (&event->classes, class_uri);
+		add_event_detail (&event->properties, property_uri);
+	}
+}
+
+static gboolean
+strv_contains_any (const gchar * const *strv,
+                   GPtrArray           *uris)
+{
+	guint i;
+
+	for (i = 0; i < uris->len; i++) {
+		if (g_strv_contains (strv, g_ptr_array_index (uris, i)))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+gboolean
+tracker_notifier_event_matches_filter (TrackerNotifierEvent *event,
+                                       const gchar * const  *classes,
+                                       const gchar * const  *properties)
+{
+	/* Events without details cannot be filtered out */
+	if (!event->classes)
+		return TRUE;
+
+	if (classes && !strv_contains_any (classes, event->classes))
+		return FALSE;
+
+	/* Resources being created or deleted are always notified */
+	if (properties && event->type == TRACKER_NOTIFIER_EVENT_UPDATE &&
+	    (!event->properties || !strv_contains_any (properties, event->properties)))
+		return FALSE;
+
+	return TRUE;
+}
+
+/* Drops events that cancelled out while coalescing, and
+ * those not matching the notifier filter.
+ */
+static void
+tracker_notifier_event_cache_filter_events (TrackerNotifier           *notifier,
+                                            TrackerNotifierEventCache *cache)
+{
+	TrackerNotifierPrivate *priv;
+	const gchar * const *classes = NULL, * const *properties = NULL;
+	GPtrArray *events;
+	guint i;
+
+	priv = tracker_notifier_get_instance_private (notifier);
+
+	g_mutex_lock (&priv->mutex);
+
+	if (cache->track_details) {
+		classes = (const gchar * const *) priv->filter_classes;
+		properties = (const gchar * const *) priv->filter_properties;
+	}
+
+	if (!cache->coalesced && !classes && !properties) {
+		g_mutex_unlock (&priv->mutex);
+		return;
+	}
+
+	events = g_ptr_array_new_full (cache->events->len,
+	                               (GDestroyNotify) tracker_notifier_event_unref);
+
+	for (i = 0; i < cache->events->len; i++) {
+		TrackerNotifierEvent *event = g_ptr_array_index (cache->events, i);
+
+		if (event->type >= 0 &&
+		    ((!classes && !properties) ||
+		     tracker_notifier_event_matches_filter (event, classes, properties)))
+			g_ptr_array_add (events, tracker_notifier_event_ref (event));
+		else
+			g_hash_table_remove (cache->events_by_id, &event->id);
+	}
+
+	g_mutex_unlock (&priv->mutex);
+
+	g_ptr_array_unref (cache->events);
+	cache->events = events;
 }
 
 const gchar *
@@ -388,17 +612,14 @@ tracker_notifier_emit_events_in_idle (TrackerNotifier           *notifier,
 }
 
 static gchar *
-create_extra_info_query (TrackerNotifier             *notifier,
-                         TrackerNotifierSubscription *subscription)
+create_extra_info_query (const gchar *service,
+                         guint        n_slots)
 {
 	GString *sparql;
-	gchar *service;
-	gint i;
+	guint i;
 
 	sparql = g_string_new ("SELECT ?id ?uri ");
 
-	service = get_service_name (notifier, subscription);
-
 	if (service) {
 		g_string_append_printf (sparql,
 		                        "{ SERVICE <%s> ",
@@ -407,7 +628,7 @@ create_extra_info_query (TrackerNotifier             *notifier,
 
 	g_string_append (sparql, "{ VALUES ?id { ");
 
-	for (i = 0; i < N_SLOTS; i++) {
+	for (i = 0; i < n_slots; i++) {
 		g_string_append_printf (sparql, "~arg%d ", i + 1);
 	}
 
@@ -420,82 +641,133 @@ create_extra_info_query (TrackerNotifier             *notifier,
 	if (service)
 		g_string_append (sparql, "} ");
 
-	g_free (service);
-
 	return g_string_free (sparql, FALSE);
 }
 
-static TrackerSparqlStatement *
-ensure_extra_info_statement (TrackerNotifier             *notifier,
-                             TrackerNotifierSubscription *subscription)
+static TrackerNotifierResolver *
+ensure_resolver (TrackerNotifier             *notifier,
+                 TrackerNotifierSubscription *subscription)
 {
-	TrackerSparqlStatement **ptr;
+	TrackerNotifierResolver **ptr;
 	TrackerNotifierPrivate *priv;
-	gchar *sparql;
-	GError *error = NULL;
 
 	priv = tracker_notifier_get_instance_private (notifier);
 
-	if (subscription) {
-		ptr = &subscription->statement;
-	} else {
-		ptr = &priv->local_statement;
-	}
+	if (subscription)
+		ptr = &subscription->resolver;
+	else
+		ptr = &priv->local_resolver;
 
-	if (*ptr) {
-		return *ptr;
-	}
+	g_mutex_lock (&priv->mutex);
 
-	sparql = create_extra_info_query (notifier, subscription);
-	*ptr = tracker_sparql_connection_query_statement (priv->connection,
-	                                                  sparql,
-	                                                  priv->cancellable,
-	                                                  &error);
-	g_free (sparql);
+	if (!*ptr) {
+		gchar *service;
 
-	if (error) {
-		g_warning ("Error querying notifier info: %s\n", error->message);
-		g_error_free (error);
-		return NULL;
+		service = get_service_name (notifier, subscription);
+		*ptr = tracker_notifier_resolver_get (priv->connection, service);
+		g_free (service);
 	}
 
+	g_mutex_unlock (&priv->mutex);
+
 	return *ptr;
 }
 
-static void
-handle_cursor (GTask        *task,
-	       gpointer      source_object,
-	       gpointer      task_data,
-	       GCancellable *cancellable)
+static GHashTable *
+get_resolvers (TrackerSparqlConnection *connection)
 {
-	TrackerNotifierEventCache *cache = task_data;
-	TrackerSparqlCursor *cursor = source_object;
-	TrackerNotifier *notifier;
-	TrackerNotifierPrivate *priv;
-	TrackerNotifierEvent *event;
-	gint64 id;
+	GHashTable *resolvers;
+
+	resolvers = g_object_get_qdata (G_OBJECT (connection),
+	                                tracker_notifier_resolvers_quark ());
+	if (!resolvers) {
+		resolvers = g_hash_table_new (g_str_hash, g_str_equal);
+		g_object_set_qdata_full (G_OBJECT (connection),
+		                         tracker_notifier_resolvers_quark (),
+		                         resolvers,
+		                         (GDestroyNotify) g_hash_table_unref);
+	}
 
-	while (tracker_sparql_cursor_next (cursor, cancellable, NULL)) {
-		id = tracker_sparql_cursor_get_integer (cursor, 0);
-		event = g_ptr_array_index (cache->events, cache->first);
+	return resolvers;
+}
 
-		if (!event || event->id != id) {
-			g_critical ("Queried for id %" G_GINT64_FORMAT " but it is not "
-			            "found, bailing out", id);
-			break;
-		}
+static TrackerNotifierResolver *
+tracker_notifier_resolver_get (TrackerSparqlConnection *connection,
+                               const gchar             *service)
+{
+	TrackerNotifierResolver *resolver;
+	GHashTable *resolvers;
+
+	G_LOCK (resolvers);
 
-		event->urn = g_strdup (tracker_sparql_cursor_get_string (cursor, 1, NULL));
-		cache->first++;
+	resolvers = get_resolvers (connection);
+	resolver = g_hash_table_lookup (resolvers, service ? service : "");
+
+	if (resolver) {
+		resolver->ref_count++;
+	} else {
+		resolver = g_new0 (TrackerNotifierResolver, 1);
+		resolver->ref_count = 1;
+		resolver->connection = g_object_ref (connection);
+		resolver->service = g_strdup (service ? service : "");
+		resolver->n_slots = service ? N_SLOTS : N_LOCAL_SLOTS;
+		resolver->lookups = g_hash_table_new (g_int64_hash, g_int64_equal);
+		g_mutex_init (&resolver->mutex);
+		g_hash_table_insert (resolvers, resolver->service, resolver);
 	}
 
-	tracker_sparql_cursor_close (cursor);
+	G_UNLOCK (resolvers);
 
-	if (g_task_return_error_if_cancelled (task)) {
-		_tracker_notifier_event_cache_free (cache);
+	return resolver;
+}
+
+static TrackerNotifierResolver *
+tracker_notifier_resolver_ref (TrackerNotifierResolver *resolver)
+{
+	G_LOCK (resolvers);
+	resolver->ref_count++;
+	G_UNLOCK (resolvers);
+
+	return resolver;
+}
+
+static void
+tracker_notifier_resolver_unref (TrackerNotifierResolver *resolver)
+{
+	guint i;
+
+	G_LOCK (resolvers);
+
+	resolver->ref_count--;
+
+	if (resolver->ref_count > 0) {
+		G_UNLOCK (resolvers);
 		return;
 	}
 
+	g_hash_table_remove (get_resolvers (resolver->connection),
+	                     resolver->service);
+	G_UNLOCK (resolvers);
+
+	/* Lookups keep the resolver alive until they are done */
+	g_assert (g_hash_table_size (resolver->lookups) == 0);
+
+	for (i = 0; i < MAX_QUERIES_IN_FLIGHT; i++)
+		g_clear_object (&resolver->stmts[i]);
+
+	g_hash_table_unref (resolver->lookups);
+	g_mutex_clear (&resolver->mutex);
+	g_object_unref (resolver->connection);
+	g_free (resolver->service);
+	g_free (resolver);
+}
+
+static void
+tracker_notifier_event_cache_resolved (TrackerNotifierEventCache *cache)
+{
+	TrackerNotifier *notifier;
+	TrackerNotifierPrivate *priv;
+
 	notifier = g_weak_ref_get (&cache->notifier);
 	if (!notifier) {
 		_tracker_notifier_event_cache_free (cache);
@@ -504,26 +776,149 @@ handle_cursor (GTask        *task,
 
 	priv = tracker_notifier_get_instance_private (notifier);
 
-	if (cache->first >= cache->events->len) {
-		TrackerNotifierEventCache *next;
+	/* Emit events in the order they happened, even if
+	 * lookups for later caches finish first.
+	 */
+	g_mutex_lock (&priv->mutex);
+	cache->resolved = TRUE;
+
+	while (!g_queue_is_empty (&priv->pending)) {
+		TrackerNotifierEventCache *head = g_queue_peek_head (&priv->pending);
 
-		tracker_notifier_emit_events_in_idle (notifier, cache);
+		if (!head->resolved)
+			break;
 
-		g_async_queue_lock (priv->queue);
-		next = g_async_queue_try_pop_unlocked (priv->queue);
-		if (next)
-			tracker_notifier_query_extra_info (notifier, next);
+		g_queue_pop_head (&priv->pending);
+
+		if (g_cancellable_is_cancelled (priv->cancellable))
+			_tracker_notifier_event_cache_free (head);
 		else
-			priv->querying = FALSE;
-		g_async_queue_unlock (priv->queue);
-	} else {
-		tracker_notifier_query_extra_info (notifier, cache);
+			tracker_notifier_emit_events_in_idle (notifier, head);
 	}
 
-	g_task_return_boolean (task, TRUE);
+	g_mutex_unlock (&priv->mutex);
 	g_object_unref (notifier);
 }
 
+/* Must be called with the resolver lock held, caches that got
+ * all their events resolved are added to @resolved_caches.
+ */
+static void
+resolve_lookup (TrackerNotifierResolver *resolver,
+                ResolverLookup          *lookup,
+                const gchar             *urn,
+                GPtrArray               *resolved_caches)
+{
+	guint i;
+
+	for (i = 0; i < lookup->waiters->len; i++) {
+		ResolverWaiter *waiter = &g_array_index (lookup->waiters, ResolverWaiter, i);
+
+		g_free (waiter->event->urn);
+		waiter->event->urn = g_strdup (urn);
+		waiter->cache->n_unresolved--;
+
+		if (waiter->cache->n_unresolved == 0)
+			g_ptr_array_add (resolved_caches, waiter->cache);
+	}
+
+	g_hash_table_remove (resolver->lookups, &lookup->id);
+	g_clear_pointer (&lookup->waiters, g_array_unref);
+}
+
+static void tracker_notifier_resolver_dispatch (TrackerNotifierResolver *resolver);
+
+static void
+resolver_query_free (ResolverQuery *query)
+{
+	g_ptr_array_set_free_func (query->lookups, g_free);
+	g_ptr_array_unref (query->lookups);
+	tracker_notifier_resolver_unref (query->resolver);
+	g_free (query);
+}
+
+static void
+resolver_query_finish (ResolverQuery *query,
+                       GArray        *ids,
+                       GPtrArray     *urns)
+{
+	TrackerNotifierResolver *resolver = query->resolver;
+	GPtrArray *resolved_caches;
+	guint i;
+
+	resolved_caches = g_ptr_array_new ();
+
+	g_mutex_lock (&resolver->mutex);
+
+	for (i = 0; ids && i < ids->len; i++) {
+		gint64 id = g_array_index (ids, gint64, i);
+		ResolverLookup *lookup;
+
+		lookup = g_hash_table_lookup (resolver->lookups, &id);
+		if (lookup && lookup->query == query && lookup->waiters) {
+			resolve_lookup (resolver, lookup,
+			                g_ptr_array_index (urns, i),
+			                resolved_caches);
+		}
+	}
+
+	/* Lookups not returned by the query are resolved without URN */
+	for (i = 0; i < query->lookups->len; i++) {
+		ResolverLookup *lookup = g_ptr_array_index (query->lookups, i);
+
+		if (lookup->waiters)
+			resolve_lookup (resolver, lookup, NULL, resolved_caches);
+	}
+
+	resolver->busy_slots &= ~(1 << query->slot);
+
+	g_mutex_unlock (&resolver->mutex);
+
+	for (i = 0; i < resolved_caches->len; i++)
+		tracker_notifier_event_cache_resolved (g_ptr_array_index (resolved_caches, i));
+
+	g_ptr_array_unref (resolved_caches);
+
+	/* Issue lookups that were queued meanwhile */
+	tracker_notifier_resolver_dispatch (resolver);
+}
+
+static void
+handle_cursor (GTask        *task,
+	       gpointer      source_object,
+	       gpointer      task_data,
+	       GCancellable *cancellable)
+{
+	ResolverQuery *query = task_data;
+	TrackerSparqlCursor *cursor = source_object;
+	GPtrArray *urns;
+	GArray *ids;
+	GError *error = NULL;
+
+	ids = g_array_new (FALSE, FALSE, sizeof (gint64));
+	urns = g_ptr_array_new_with_free_func (g_free);
+
+	while (tracker_sparql_cursor_next (cursor, cancellable, &error)) {
+		gint64 id;
+
+		id = tracker_sparql_cursor_get_integer (cursor, 0);
+		g_array_append_val (ids, id);
+		g_ptr_array_add (urns, g_strdup (tracker_sparql_cursor_get_string (cursor, 1, NULL)));
+	}
+
+	tracker_sparql_cursor_close (cursor);
+
+	resolver_query_finish (query, ids, urns);
+
+	g_array_unref (ids);
+	g_ptr_array_unref (urns);
+
+	if (error)
+		g_task_return_error (task, error);
+	else
+		g_task_return_boolean (task, TRUE);
+}
+
 static void
 finish_query (GObject      *source_object,
               GAsyncResult *res,
@@ -549,7 +944,7 @@ query_extra_info_cb (GObject      *object,
                      GAsyncResult *res,
                      gpointer      user_data)
 {
-	TrackerNotifierEventCache *cache = user_data;
+	ResolverQuery *query = user_data;
 	TrackerSparqlStatement *statement;
 	TrackerSparqlCursor *cursor;
 	GError *error = NULL;
@@ -565,90 +960,347 @@ query_extra_info_cb (GObject      *object,
 			g_critical ("Could not get cursor: %s\n", error->message);
 		}
 
-		_tracker_notifier_event_cache_free (cache);
+		resolver_query_finish (query, NULL, NULL);
+		resolver_query_free (query);
 		g_clear_error (&error);
 		return;
 	}
 
-	task = g_task_new (cursor, cache->cancellable, finish_query, NULL);
-	g_task_set_task_data (task, cache, NULL);
+	task = g_task_new (cursor, NULL, finish_query, NULL);
+	g_task_set_task_data (task, query, (GDestroyNotify) resolver_query_free);
 	g_task_run_in_thread (task, handle_cursor);
 	g_object_unref (task);
 }
 
+static TrackerSparqlStatement *
+ensure_extra_info_statement (TrackerNotifierResolver *resolver,
+                             guint                    slot)
+{
+	gchar *sparql;
+	GError *error = NULL;
+
+	if (resolver->stmts[slot])
+		return resolver->stmts[slot];
+
+	sparql = create_extra_info_query (resolver->service[0] ? resolver->service : NULL,
+	                                  resolver->n_slots);
+	resolver->stmts[slot] =
+		tracker_sparql_connection_query_statement (resolver->connection,
+		                                           sparql,
+		                                           NULL,
+		                                           &error);
+	g_free (sparql);
+
+	if (error) {
+		g_warning ("Error querying notifier info: %s\n", error->message);
+		g_error_free (error);
+		return NULL;
+	}
+
+	return resolver->stmts[slot];
+}
+
 static void
-bind_arguments (TrackerSparqlStatement    *statement,
-                TrackerNotifierEventCache *cache)
+bind_arguments (TrackerSparqlStatement *statement,
+                ResolverQuery          *query,
+                guint                   n_slots)
 {
 	gchar *arg_name;
-	guint i = 0, n_args = 0;
+	guint n_args;
 
 	tracker_sparql_statement_clear_bindings (statement);
 
-	for (i = cache->first;
-	     (n_args < N_SLOTS && i < cache->events->len);
-	     i++) {
-		TrackerNotifierEvent *event;
+	for (n_args = 0; n_args < n_slots; n_args++) {
+		ResolverLookup *lookup = NULL;
 
-		event = g_ptr_array_index (cache->events, i);
+		if (n_args < query->lookups->len)
+			lookup = g_ptr_array_index (query->lookups, n_args);
 
+		/* Missing slots are filled in with 0's */
 		arg_name = g_strdup_printf ("arg%d", n_args + 1);
-		tracker_sparql_statement_bind_int (statement, arg_name, event->id);
+		tracker_sparql_statement_bind_int (statement, arg_name,
+		                                   lookup ? lookup->id : 0);
 		g_free (arg_name);
-		n_args++;
 	}
+}
 
-	/* Fill in missing slots with 0's */
-	while (n_args < N_SLOTS) {
-		arg_name = g_strdup_printf ("arg%d", n_args + 1);
-		tracker_sparql_statement_bind_int (statement, arg_name, 0);
-		g_free (arg_name);
-		n_args++;
+/* Issues queries for the queued lookups, up to MAX_QUERIES_IN_FLIGHT
+ * queries are kept running at once so that lookups are pipelined.
+ */
+static void
+tracker_notifier_resolver_dispatch (TrackerNotifierResolver *resolver)
+{
+	while (TRUE) {
+		TrackerSparqlStatement *stmt;
+		ResolverQuery *query;
+		guint slot;
+
+		g_mutex_lock (&resolver->mutex);
+
+		for (slot = 0; slot < MAX_QUERIES_IN_FLIGHT; slot++) {
+			if ((resolver->busy_slots & (1 << slot)) == 0)
+				break;
+		}
+
+		if (slot == MAX_QUERIES_IN_FLIGHT ||
+		    g_queue_is_empty (&resolver->queue)) {
+			g_mutex_unlock (&resolver->mutex);
+			break;
+		}
+
+		query = g_new0 (ResolverQuery, 1);
+		query->resolver = tracker_notifier_resolver_ref (resolver);
+		query->slot = slot;
+		query->lookups = g_ptr_array_sized_new (resolver->n_slots);
+
+		while (query->lookups->len < resolver->n_slots &&
+		       !g_queue_is_empty (&resolver->queue)) {
+			ResolverLookup *lookup = g_queue_pop_head (&resolver->queue);
+
+			lookup->query = query;
+			g_ptr_array_add (query->lookups, lookup);
+		}
+
+		resolver->busy_slots |= 1 << slot;
+		g_mutex_unlock (&resolver->mutex);
+
+		/* The statement in a busy slot is only used by this query */
+		stmt = ensure_extra_info_statement (resolver, slot);
+
+		if (!stmt) {
+			resolver_query_finish (query, NULL, NULL);
+			resolver_query_free (query);
+			break;
+		}
+
+		bind_arguments (stmt, query, resolver->n_slots);
+		tracker_sparql_statement_execute_async (stmt,
+		                                        NULL,
+		                                        query_extra_info_cb,
+		                                        query);
 	}
 }
 
 static void
-tracker_notifier_query_extra_info (TrackerNotifier           *notifier,
-                                   TrackerNotifierEventCache *cache)
+tracker_notifier_resolver_lookup (TrackerNotifierResolver   *resolver,
+                                  TrackerNotifierEventCache *cache)
 {
-	TrackerNotifierPrivate *priv;
+	guint i;
 
-	priv = tracker_notifier_get_instance_private (notifier);
+	g_mutex_lock (&resolver->mutex);
 
-	g_mutex_lock (&priv->mutex);
+	cache->n_unresolved = cache->events->len;
 
-	bind_arguments (cache->stmt, cache);
-	tracker_sparql_statement_execute_async (cache->stmt,
-	                                        cache->cancellable,
-	                                        query_extra_info_cb,
-	                                        cache);
+	for (i = 0; i < cache->events->len; i++) {
+		TrackerNotifierEvent *event = g_ptr_array_index (cache->events, i);
+		ResolverWaiter waiter = { cache, event };
+		ResolverLookup *lookup;
 
-	g_mutex_unlock (&priv->mutex);
+		/* Other notifiers may be waiting for the same resource */
+		lookup = g_hash_table_lookup (resolver->lookups, &event->id);
+
+		if (!lookup) {
+			lookup = g_new0 (ResolverLookup, 1);
+			lookup->id = event->id;
+			lookup->waiters = g_array_new (FALSE, FALSE, sizeof (ResolverWaiter));
+			g_hash_table_insert (resolver->lookups, &lookup->id, lookup);
+			g_queue_push_tail (&resolver->queue, lookup);
+		}
+
+		g_array_append_val (lookup->waiters, waiter);
+	}
+
+	g_mutex_unlock (&resolver->mutex);
+
+	tracker_notifier_resolver_dispatch (resolver);
 }
 
-void
-_tracker_notifier_event_cache_flush_events (TrackerNotifier           *notifier,
-                                            TrackerNotifierEventCache *cache)
+static void
+tracker_notifier_event_cache_dispatch (TrackerNotifier           *notifier,
+                                       TrackerNotifierEventCache *cache)
 {
 	TrackerNotifierPrivate *priv = tracker_notifier_get_instance_private (notifier);
 
+	/* Skip querying for events that are filtered out anyway */
+	tracker_notifier_event_cache_filter_events (notifier, cache);
+
 	if (cache->events->len == 0) {
 		_tracker_notifier_event_cache_free (cache);
 		return;
 	}
 
-	cache->first = 0;
-
-	g_async_queue_lock (priv->queue);
 	if (priv->urn_query_disabled) {
 		tracker_notifier_emit_events_in_idle (notifier, cache);
-	} else if (priv->querying) {
-		g_async_queue_push_unlocked (priv->queue, cache);
+		return;
+	}
+
+	g_mutex_lock (&priv->mutex);
+	g_queue_push_tail (&priv->pending, cache);
+	g_mutex_unlock (&priv->mutex);
+
+	tracker_notifier_resolver_lookup (cache->resolver, cache);
+}
+
+static gint
+merge_event_type (gint                     type,
+                  TrackerNotifierEventType new_type)
+{
+	if (type < 0)
+		return new_type;
+
+	switch (new_type) {
+	case TRACKER_NOTIFIER_EVENT_CREATE:
+		/* The resource existed before, and exists again */
+		return type == TRACKER_NOTIFIER_EVENT_CREATE ?
+			TRACKER_NOTIFIER_EVENT_CREATE : TRACKER_NOTIFIER_EVENT_UPDATE;
+	case TRACKER_NOTIFIER_EVENT_DELETE:
+		/* Nothing to notify about resources that came and went */
+		return type == TRACKER_NOTIFIER_EVENT_CREATE ?
+			-1 : TRACKER_NOTIFIER_EVENT_DELETE;
+	case TRACKER_NOTIFIER_EVENT_UPDATE:
+	default:
+		return type == TRACKER_NOTIFIER_EVENT_DELETE ?
+			TRACKER_NOTIFIER_EVENT_UPDATE : type;
+	}
+}
+
+static void
+merge_event_details (GPtrArray **details,
+                     GPtrArray  *other)
+{
+	guint i;
+
+	for (i = 0; other && i < other->len; i++)
+		add_event_detail (details, g_ptr_array_index (other, i));
+}
+
+/* Merges the events of @other, which happened later, into @cache */
+static void
+tracker_notifier_event_cache_merge (TrackerNotifierEventCache *cache,
+                                    TrackerNotifierEventCache *other)
+{
+	guint i;
+
+	for (i = 0; i < other->events->len; i++) {
+		TrackerNotifierEvent *event = g_ptr_array_index (other->events, i);
+		TrackerNotifierEvent *existing;
+
+		existing = g_hash_table_lookup (cache->events_by_id, &event->id);
+
+		if (!existing) {
+			g_ptr_array_add (cache->events, tracker_notifier_event_ref (event));
+			g_hash_table_insert (cache->events_by_id, &event->id, event);
+			continue;
+		}
+
+		/* Events cancelling out are kept until the cache is flushed */
+		existing->type = merge_event_type (existing->type, event->type);
+		merge_event_details (&existing->classes, event->classes);
+		merge_event_details (&existing->properties, event->properties);
+	}
+
+	cache->track_details &= other->track_details;
+	cache->coalesced = TRUE;
+}
+
+static gboolean
+coalesce_timeout_cb (gpointer user_data)
+{
+	TrackerNotifier *notifier = user_data;
+	TrackerNotifierPrivate *priv = tracker_notifier_get_instance_private (notifier);
+	TrackerNotifierEventCache *cache;
+	GHashTableIter iter;
+	GPtrArray *caches;
+	gchar *key;
+	guint i;
+
+	caches = g_ptr_array_new ();
+
+	g_mutex_lock (&priv->mutex);
+	g_hash_table_iter_init (&iter, priv->coalescing);
+
+	while (g_hash_table_iter_next (&iter, (gpointer *) &key, (gpointer *) &cache)) {
+		g_ptr_array_add (caches, cache);
+		g_hash_table_iter_steal (&iter);
+		g_free (key);
+	}
+
+	g_clear_pointer (&priv->coalesce_source, g_source_unref);
+	g_mutex_unlock (&priv->mutex);
+
+	for (i = 0; i < caches->len; i++)
+		tracker_notifier_event_cache_dispatch (notifier, g_ptr_array_index (caches, i));
+
+	g_ptr_array_unref (caches);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+tracker_notifier_event_cache_coalesce (TrackerNotifier           *notifier,
+                                       TrackerNotifierEventCache *cache)
+{
+	TrackerNotifierPrivate *priv = tracker_notifier_get_instance_private (notifier);
+	TrackerNotifierEventCache *pending, *flush = NULL;
+	gchar *key;
+
+	key = g_strconcat (cache->service ? cache->service : "", " ",
+	                   cache->graph ? cache->graph : "", NULL);
+
+	g_mutex_lock (&priv->mutex);
+
+	pending = g_hash_table_lookup (priv->coalescing, key);
+
+	if (pending) {
+		tracker_notifier_event_cache_merge (pending, cache);
+		_tracker_notifier_event_cache_free (cache);
 	} else {
-		priv->querying = TRUE;
-		tracker_notifier_query_extra_info (notifier, cache);
+		pending = cache;
+		g_hash_table_insert (priv->coalescing, g_strdup (key), pending);
 	}
-	g_async_queue_unlock (priv->queue);
+
+	if (priv->coalesce_max_events > 0 &&
+	    pending->events->len >= priv->coalesce_max_events) {
+		gpointer stored_key;
+
+		/* Flush early, latency is only traded up to a point */
+		if (g_hash_table_lookup_extended (priv->coalescing, key,
+		                                  &stored_key, NULL)) {
+			g_hash_table_steal (priv->coalescing, key);
+			g_free (stored_key);
+		}
+
+		flush = pending;
+	} else if (!priv->coalesce_source) {
+		priv->coalesce_source = g_timeout_source_new (priv->coalesce_interval);
+		g_source_set_callback (priv->coalesce_source,
+		                       coalesce_timeout_cb,
+		                       notifier, NULL);
+		g_source_attach (priv->coalesce_source, priv->main_context);
+	}
+
+	g_mutex_unlock (&priv->mutex);
+	g_free (key);
+
+	if (flush)
+		tracker_notifier_event_cache_dispatch (notifier, flush);
+}
+
+void
+_tracker_notifier_event_cache_flush_events (TrackerNotifier           *notifier,
+                                            TrackerNotifierEventCache *cache)
+{
+	TrackerNotifierPrivate *priv = tracker_notifier_get_instance_private (notifier);
+	gboolean coalesce;
+
+	g_mutex_lock (&priv->mutex);
+	coalesce = priv->coalesce_interval > 0;
+	g_mutex_unlock (&priv->mutex);
+
+	if (coalesce)
+		tracker_notifier_event_cache_coalesce (notifier, cache);
+	else
+		tracker_notifier_event_cache_dispatch (notifier, cache);
 }
 
 void
@@ -679,7 +1331,19 @@ graph_updated_cb (GDBusConnection *connection,
 	if (g_cancellable_is_cancelled (priv->cancellable))
 		return;
 
-	g_variant_get (parameters, "(&sa{ii})", &graph, &events);
+	if (g_strcmp0 (signal_name, "FilteredGraphUpdated") == 0) {
+		guint32 filter_id;
+
+		g_variant_get (parameters, "(&sa{ii}u)", &graph, &events, &filter_id);
+
+		/* Events for other filters, or from before the current one was set up */
+		if (filter_id == 0 || filter_id != subscription->filter_id) {
+			g_variant_iter_free (events);
+			return;
+		}
+	} else {
+		g_variant_get (parameters, "(&sa{ii})", &graph, &events);
+	}
 
 	cache = _tracker_notifier_event_cache_new_full (notifier, subscription, graph);
 	handle_events (notifier, cache, events);
@@ -688,6 +1352,128 @@ graph_updated_cb (GDBusConnection *connection,
 	_tracker_notifier_event_cache_flush_events (notifier, cache);
 }
 
+static guint
+tracker_notifier_subscription_subscribe_signal (TrackerNotifierSubscription *subscription,
+                                                const gchar                 *signal_name)
+{
+	return g_dbus_connection_signal_subscribe (subscription->connection,
+	                                           subscription->dbus_name,
+	                                           "org.freedesktop.Tracker3.Endpoint",
+	                                           signal_name,
+	                                           subscription->dbus_path,
+	                                           subscription->graph,
+	                                           G_DBUS_SIGNAL_FLAGS_NONE,
+	                                           graph_updated_cb,
+	                                           subscription, NULL);
+}
+
+static void
+tracker_notifier_subscription_watch (TrackerNotifierSubscription *subscription,
+                                     const gchar                 *signal_name)
+{
+	if (subscription->handler_id != 0) {
+		g_dbus_connection_signal_unsubscribe (subscription->connection,
+		                                      subscription->handler_id);
+	}
+
+	subscription->handler_id =
+		tracker_notifier_subscription_subscribe_signal (subscription,
+		                                                signal_name);
+}
+
+static void
+subscribe_filter_cb (GObject      *source,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+	TrackerNotifierSubscription *subscription = user_data;
+	GVariant *reply;
+	GError *error = NULL;
+
+	reply = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source),
+	                                       res, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		/* The subscription may be already gone */
+		g_error_free (error);
+		return;
+	}
+
+	g_clear_object (&subscription->cancellable);
+
+	/* Events are no longer missed, messages from the endpoint arrive
+	 * in order so anything after the reply is sent to our filter.
+	 */
+	if (subscription->unfiltered_handler_id != 0) {
+		g_dbus_connection_signal_unsubscribe (subscription->connection,
+		                                      subscription->unfiltered_handler_id);
+		subscription->unfiltered_handler_id = 0;
+	}
+
+	if (reply) {
+		g_variant_get (reply, "(u)", &subscription->filter_id);
+		g_variant_unref (reply);
+	} else {
+		if (!g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD))
+			g_warning ("Could not set up notifier filter: %s", error->message);
+
+		/* Older endpoint, receive all events */
+		tracker_notifier_subscription_watch (subscription, "GraphUpdated");
+		g_error_free (error);
+	}
+}
+
+static GVariant *
+strv_to_variant (GStrv strv)
+{
+	return g_variant_new_strv ((const gchar * const *) strv, strv ? -1 : 0);
+}
+
+static void
+tracker_notifier_subscription_connect (TrackerNotifierSubscription *subscription)
+{
+	TrackerNotifierPrivate *priv =
+		tracker_notifier_get_instance_private (subscription->notifier);
+	GVariant *filter;
+
+	tracker_notifier_subscription_release_filter (subscription);
+
+	g_mutex_lock (&priv->mutex);
+
+	if (!priv->filter_classes && !priv->filter_properties) {
+		g_mutex_unlock (&priv->mutex);
+		tracker_notifier_subscription_watch (subscription, "GraphUpdated");
+		return;
+	}
+
+	filter = g_variant_new ("(@as@as)",
+	                        strv_to_variant (priv->filter_classes),
+	                        strv_to_variant (priv->filter_properties));
+	g_mutex_unlock (&priv->mutex);
+
+	/* Filtered events are sent by the endpoint just to us, until
+	 * the filter is set up all events are still received.
+	 */
+	tracker_notifier_subscription_watch (subscription, "FilteredGraphUpdated");
+	subscription->unfiltered_handler_id =
+		tracker_notifier_subscription_subscribe_signal (subscription,
+		                                                "GraphUpdated");
+
+	subscription->cancellable = g_cancellable_new ();
+	g_dbus_connection_call (subscription->connection,
+	                        subscription->dbus_name,
+	                        subscription->dbus_path,
+	                        "org.freedesktop.Tracker3.Endpoint",
+	                        "Subscribe",
+	                        filter,
+	                        G_VARIANT_TYPE ("(u)"),
+	                        G_DBUS_CALL_FLAGS_NONE,
+	                        -1,
+	                        subscription->cancellable,
+	                        subscribe_filter_cb,
+	                        subscription);
+}
+
 static void
 tracker_notifier_set_property (GObject      *object,
                                guint         prop_id,
@@ -701,6 +1487,16 @@ tracker_notifier_set_property (GObject      *object,
 	case PROP_CONNECTION:
 		priv->connection = g_value_dup_object (value);
 		break;
+	case PROP_COALESCE_INTERVAL:
+		g_mutex_lock (&priv->mutex);
+		priv->coalesce_interval = g_value_get_uint (value);
+		g_mutex_unlock (&priv->mutex);
+		break;
+	case PROP_COALESCE_MAX_EVENTS:
+		g_mutex_lock (&priv->mutex);
+		priv->coalesce_max_events = g_value_get_uint (value);
+		g_mutex_unlock (&priv->mutex);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -720,12 +1516,28 @@ tracker_notifier_get_property (GObject    *object,
 	case PROP_CONNECTION:
 		g_value_set_object (value, priv->connection);
 		break;
+	case PROP_COALESCE_INTERVAL:
+		g_value_set_uint (value, priv->coalesce_interval);
+		break;
+	case PROP_COALESCE_MAX_EVENTS:
+		g_value_set_uint (value, priv->coalesce_max_events);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
 	}
 }
 
+/* Caches still waiting for their lookup are freed once it finishes,
+ * resolved ones queued behind them are only owned by the queue.
+ */
+static void
+pending_event_cache_free (TrackerNotifierEventCache *cache)
+{
+	if (cache->resolved)
+		_tracker_notifier_event_cache_free (cache);
+}
+
 static void
 tracker_notifier_finalize (GObject *object)
 {
@@ -735,8 +1547,18 @@ tracker_notifier_finalize (GObject *object)
 
 	g_cancellable_cancel (priv->cancellable);
 	g_clear_object (&priv->cancellable);
-	g_clear_object (&priv->local_statement);
-	g_async_queue_unref (priv->queue);
+	g_clear_pointer (&priv->local_resolver, tracker_notifier_resolver_unref);
+
+	if (priv->coalesce_source) {
+		g_source_destroy (priv->coalesce_source);
+		g_source_unref (priv->coalesce_source);
+	}
+
+	g_hash_table_unref (priv->coalescing);
+	g_strfreev (priv->filter_classes);
+	g_strfreev (priv->filter_properties);
+	g_queue_clear_full (&priv->pending,
+	                    (GDestroyNotify) pending_event_cache_free);
 	g_mutex_clear (&priv->mutex);
 
 	if (priv->connection)
@@ -790,6 +1612,43 @@ tracker_notifier_class_init (TrackerNotifierClass *klass)
 		                     G_PARAM_STATIC_STRINGS |
 		                     G_PARAM_CONSTRUCT_ONLY);
 
+	/**
+	 * TrackerNotifier:coalesce-interval:
+	 *
+	 * Time in milliseconds to hold events before emitting them. Events
+	 * happening on the same resource during this time are merged into a
+	 * single one, a resource created and then updated is notified as
+	 * created, and a resource created and then deleted is not notified
+	 * at all. 0 disables coalescing.
+	 *
+	 * Since: 3.12
+	 */
+	pspecs[PROP_COALESCE_INTERVAL] =
+		g_param_spec_uint ("coalesce-interval",
+		                   "Coalesce interval",
+		                   "Coalesce interval",
+		                   0, G_MAXUINT, 0,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_STATIC_STRINGS);
+
+	/**
+	 * TrackerNotifier:coalesce-max-events:
+	 *
+	 * Maximum number of events held while coalescing, once reached
+	 * events are emitted without waiting for
+	 * [property@Notifier:coalesce-interval] to elapse. 0 means no
+	 * limit.
+	 *
+	 * Since: 3.12
+	 */
+	pspecs[PROP_COALESCE_MAX_EVENTS] =
+		g_param_spec_uint ("coalesce-max-events",
+		                   "Coalesce max events",
+		                   "Coalesce max events",
+		                   0, G_MAXUINT, 0,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_STATIC_STRINGS);
+
 	g_object_class_install_properties (object_class, N_PROPS, pspecs);
 }
 
@@ -802,7 +1661,8 @@ tracker_notifier_init (TrackerNotifier *notifier)
 	priv->subscriptions = g_hash_table_new_full (NULL, NULL, NULL,
 	                                             (GDestroyNotify) tracker_notifier_subscription_free);
 	priv->cancellable = g_cancellable_new ();
-	priv->queue = g_async_queue_new ();
+	priv->coalescing = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+	                                          (GDestroyNotify) _tracker_notifier_event_cache_free);
 	priv->main_context = g_main_context_get_thread_default ();
 	g_mutex_init (&priv->mutex);
 }
@@ -844,6 +1704,7 @@ tracker_notifier_signal_subscribe (TrackerNotifier *notifier,
 	TrackerNotifierSubscription *subscription;
 	TrackerNotifierPrivate *priv;
 	gchar *dbus_name = NULL, *dbus_path = NULL, *full_graph = NULL;
+	guint id;
 
 	g_return_val_if_fail (TRACKER_IS_NOTIFIER (notifier), 0);
 	g_return_val_if_fail (G_IS_DBUS_CONNECTION (connection), 0);
@@ -874,27 +1735,21 @@ tracker_notifier_signal_subscribe (TrackerNotifier *notifier,
 
 	subscription = tracker_notifier_subscription_new (notifier, connection,
 	                                                  service, object_path);
+	subscription->dbus_name = dbus_name ? dbus_name : g_strdup (service);
+	subscription->dbus_path = dbus_path ? dbus_path : g_strdup (object_path);
+	subscription->graph = full_graph ? full_graph : g_strdup (graph);
 
-	subscription->handler_id =
-		g_dbus_connection_signal_subscribe (connection,
-		                                    dbus_name ? dbus_name : service,
-		                                    "org.freedesktop.Tracker3.Endpoint",
-		                                    "GraphUpdated",
-		                                    dbus_path ? dbus_path : object_path,
-		                                    full_graph ? full_graph : graph,
-		                                    G_DBUS_SIGNAL_FLAGS_NONE,
-		                                    graph_updated_cb,
-		                                    subscription, NULL);
+	tracker_notifier_subscription_connect (subscription);
 
+	/* Signal subscriptions are replaced if the filter changes,
+	 * keep the first handler ID as the subscription ID.
+	 */
+	id = subscription->handler_id;
 	g_hash_table_insert (priv->subscriptions,
-	                     GUINT_TO_POINTER (subscription->handler_id),
+	                     GUINT_TO_POINTER (id),
 	                     subscription);
 
-	g_free (dbus_name);
-	g_free (dbus_path);
-	g_free (full_graph);
-
-	return subscription->handler_id;
+	return id;
 }
 
 /**
@@ -920,6 +1775,86 @@ tracker_notifier_signal_unsubscribe (TrackerNotifier *notifier,
 	g_hash_table_remove (priv->subscriptions, GUINT_TO_POINTER (handler_id));
 }
 
+static GStrv
+expand_uris (TrackerNotifier     *notifier,
+             const gchar * const *uris)
+{
+	TrackerNotifierPrivate *priv;
+	TrackerNamespaceManager *namespaces;
+	GStrv expanded;
+	guint i;
+
+	priv = tracker_notifier_get_instance_private (notifier);
+
+	if (!uris || !uris[0])
+		return NULL;
+
+	namespaces = tracker_sparql_connection_get_namespace_manager (priv->connection);
+	expanded = g_new0 (gchar *, g_strv_length ((GStrv) uris) + 1);
+
+	for (i = 0; uris[i]; i++) {
+		if (namespaces)
+			expanded[i] = tracker_namespace_manager_expand_uri (namespaces, uris[i]);
+		else
+			expanded[i] = g_strdup (uris[i]);
+	}
+
+	return expanded;
+}
+
+/**
+ * tracker_notifier_set_filter:
+ * @notifier: A `TrackerNotifier`
+ * @classes: (nullable) (array zero-terminated=1): Classes to notify resources of, or %NULL
+ * @properties: (nullable) (array zero-terminated=1): Properties to notify changes of, or %NULL
+ *
+ * Restricts the events notified by @notifier.
+ *
+ * If @classes is set, only resources that have one of the given
+ * classes will be notified upon. These must be classes that are notified
+ * upon (see [nrl:notify](nrl-ontology.html#nrl:notify)). If @properties is set, updates
+ * on resources will only be notified if one of the given properties
+ * changed, creation and deletion of resources are notified regardless.
+ * Both may be given as full URIs or in prefixed form (e.g. `nmm:MusicPiece`).
+ *
+ * Setting both @classes and @properties to %NULL removes the filter.
+ *
+ * On D-Bus connections, the filter is evaluated by the endpoint, so
+ * that changes not matching it are not transmitted at all. Endpoints
+ * that do not support filters will keep notifying about all changes.
+ *
+ * This applies to all current and future subscriptions of @notifier.
+ *
+ * Since: 3.12
+ **/
+void
+tracker_notifier_set_filter (TrackerNotifier     *notifier,
+                             const gchar * const *classes,
+                             const gchar * const *properties)
+{
+	TrackerNotifierPrivate *priv;
+	GHashTableIter iter;
+	TrackerNotifierSubscription *subscription;
+
+	g_return_if_fail (TRACKER_IS_NOTIFIER (notifier));
+
+	priv = tracker_notifier_get_instance_private (notifier);
+
+	g_mutex_lock (&priv->mutex);
+	g_strfreev (priv->filter_classes);
+	priv->filter_classes = expand_uris (notifier, classes);
+	g_strfreev (priv->filter_properties);
+	priv->filter_properties = expand_uris (notifier, properties);
+	priv->track_details = priv->details_enabled ||
+		priv->filter_classes || priv->filter_properties;
+	g_mutex_unlock (&priv->mutex);
+
+	g_hash_table_iter_init (&iter, priv->subscriptions);
+
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &subscription))
+		tracker_notifier_subscription_connect (subscription);
+}
+
 gpointer
 _tracker_notifier_get_connection (TrackerNotifier *notifier)
 {
@@ -988,3 +1923,13 @@ tracker_notifier_disable_urn_query (TrackerNotifier *notifier)
 	priv = tracker_notifier_get_instance_private (notifier);
 	priv->urn_query_disabled = TRUE;
 }
+
+void
+tracker_notifier_enable_event_details (TrackerNotifier *notifier)
+{
+	TrackerNotifierPrivate *priv;
+
+	priv = tracker_notifier_get_instance_private (notifier);
+	priv->details_enabled = TRUE;
+	priv->track_details = TRUE;
+}
@@ -141,8 +141,33 @@ struct _TrackerSparqlConnectionClass
 	void (* map_connection) (TrackerSparqlConnection  *connection,
 	                         const gchar              *handle_name,
 	                         TrackerSparqlConnection  *service_connection);
+	void (* query_batch_async) (TrackerSparqlConnection  *connection,
+	                            TrackerSparqlStatement  **statements,
+	                            guint                     n_statements,
+	                            GCancellable             *cancellable,
+	                            GAsyncReadyCallback       callback,
+	                            gpointer                  user_data);
+	GPtrArray * (* query_batch_finish) (TrackerSparqlConnection  *connection,
+	                                    GAsyncResult             *res,
+	                                    GError                  **error);
+	void (* set_service_cache_limits) (TrackerSparqlConnection *connection,
+	                                   guint                    max_age,
+	                                   gsize                    max_size);
 };
 
+/* Caller arrays for tracker_sparql_cursor_fetch_rows(), cells are
+ * stored by column, at column * max_rows + row.
+ */
+typedef struct {
+	gint max_rows;
+	gint n_columns;
+	TrackerSparqlValueType *types;
+	gint64 *integers;
+	gdouble *doubles;
+	const gchar **strings;
+	glong *lengths;
+} TrackerCursorFetch;
+
 struct _TrackerSparqlCursorClass
 {
 	GObjectClass parent_class;
@@ -178,6 +203,10 @@ struct _TrackerSparqlCursorClass
         gboolean (* is_bound) (TrackerSparqlCursor *cursor,
                                gint                 column);
         gint (* get_n_columns) (TrackerSparqlCursor *cursor);
+        gint (* fetch_rows) (TrackerSparqlCursor  *cursor,
+                             TrackerCursorFetch   *fetch,
+                             GCancellable         *cancellable,
+                             GError              **error);
 };
 
 struct _TrackerEndpointClass {
@@ -192,6 +221,19 @@ struct _TrackerEndpointDBus {
 	GDBusNodeInfo *node_info;
 	GCancellable *cancellable;
 	TrackerNotifier *notifier;
+	gboolean peer_to_peer;
+	GDBusServer *peer_server;
+	gchar *peer_socket_path;
+	GHashTable *peer_connections;
+	GHashTable *peer_senders;
+	GHashTable *peer_tokens;
+	GHashTable *bus_statements;
+	GHashTable *peer_statements;
+	GHashTable *notify_filters;
+	GHashTable *notify_filter_counts;
+	guint32 last_filter_id;
+	guint notify_interval;
+	guint notify_max_events;
 };
 
 typedef struct _TrackerEndpointDBusClass TrackerEndpointDBusClass;
@@ -355,6 +397,15 @@ gboolean tracker_sparql_connection_report_async_error_on_closed (TrackerSparqlCo
 
 void tracker_sparql_cursor_set_connection (TrackerSparqlCursor     *cursor,
                                            TrackerSparqlConnection *connection);
+void tracker_sparql_cursor_fetch_set_cell (TrackerSparqlCursor    *cursor,
+                                           TrackerCursorFetch     *fetch,
+                                           gint                    row,
+                                           gint                    column,
+                                           TrackerSparqlValueType  type,
+                                           gint64                  integer,
+                                           gdouble                 number,
+                                           const gchar            *str,
+                                           glong                   length);
 GError * _translate_internal_error (GError *error);
 
 void tracker_namespace_manager_seal (TrackerNamespaceManager *namespaces);
@@ -1598,6 +1598,10 @@ convert_format (TrackerRdfFormat format)
 		return TRACKER_SERIALIZER_FORMAT_TRIG;
 	case TRACKER_RDF_FORMAT_JSON_LD:
 		return TRACKER_SERIALIZER_FORMAT_JSON_LD;
+	case TRACKER_RDF_FORMAT_N_TRIPLES:
+		return TRACKER_SERIALIZER_FORMAT_NTRIPLES;
+	case TRACKER_RDF_FORMAT_N_QUADS:
+		return TRACKER_SERIALIZER_FORMAT_NQUADS;
 	case TRACKER_RDF_FORMAT_LAST:
 		g_assert_not_reached ();
 	}
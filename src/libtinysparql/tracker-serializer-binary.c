@@ -0,0 +1,506 @@
+/*
+ * Copyright (C) 2026, Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/* Serialization of cursors to the binary format described in
+ * tracker-serializer-binary.h
+ */
+
+#include "config.h"
+
+#include "tracker-serializer-binary.h"
+
+#include <tracker-common.h>
+
+/* Rows are flushed in blocks of this many rows at most, or
+ * whenever the block data grows over BLOCK_FLUSH_SIZE.
+ */
+#define BLOCK_MAX_ROWS 1024
+#define BLOCK_FLUSH_SIZE (64 * 1024)
+
+/* Bounds for the IRI dictionary, further IRIs are sent inline */
+#define MAX_DICTIONARY_SIZE 65536
+#define MAX_DICTIONARY_IRI_LEN 1024
+
+struct _TrackerSerializerBinary
+{
+	TrackerSerializer parent_instance;
+	GByteArray *data;
+	GByteArray **columns;
+	guint8 *present;
+	GHashTable *dictionary;
+	gsize current_pos;
+	gint n_columns;
+	guint n_rows;
+	guint stream_closed : 1;
+	guint head_printed : 1;
+	guint cursor_finished : 1;
+};
+
+G_DEFINE_TYPE (TrackerSerializerBinary, tracker_serializer_binary,
+               TRACKER_TYPE_SERIALIZER)
+
+static void
+tracker_serializer_binary_finalize (GObject *object)
+{
+	g_input_stream_close (G_INPUT_STREAM (object), NULL, NULL);
+
+	G_OBJECT_CLASS (tracker_serializer_binary_parent_class)->finalize (object);
+}
+
+static void
+append_byte (GByteArray *buffer,
+             guint8      value)
+{
+	g_byte_array_append (buffer, &value, 1);
+}
+
+static void
+append_uint32 (GByteArray *buffer,
+               guint32     value)
+{
+	value = GUINT32_TO_LE (value);
+	g_byte_array_append (buffer, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+append_varint (GByteArray *buffer,
+               guint64     value)
+{
+	guint8 bytes[10];
+	guint n = 0;
+
+	do {
+		bytes[n] = value & 0x7f;
+		value >>= 7;
+		if (value != 0)
+			bytes[n] |= 0x80;
+		n++;
+	} while (value != 0);
+
+	g_byte_array_append (buffer, bytes, n);
+}
+
+static void
+append_zigzag (GByteArray *buffer,
+               gint64      value)
+{
+	append_varint (buffer, ((guint64) value << 1) ^ (guint64) (value >> 63));
+}
+
+static void
+append_string (GByteArray  *buffer,
+               const gchar *str,
+               gsize        len)
+{
+	append_varint (buffer, len);
+	g_byte_array_append (buffer, (const guint8 *) str, len);
+	append_byte (buffer, 0);
+}
+
+static void
+append_typed_string (GByteArray             *buffer,
+                     TrackerSparqlValueType  type,
+                     const gchar            *str,
+                     gsize                   len)
+{
+	append_byte (buffer, TRACKER_BINARY_VALUE_TYPED_STRING);
+	append_byte (buffer, type);
+	append_string (buffer, str, len);
+}
+
+static void
+append_iri (TrackerSerializerBinary *serializer_binary,
+            GByteArray              *buffer,
+            const gchar             *str,
+            gsize                    len)
+{
+	gpointer idx;
+
+	if (g_hash_table_lookup_extended (serializer_binary->dictionary,
+	                                  str, NULL, &idx)) {
+		append_byte (buffer, TRACKER_BINARY_VALUE_IRI_REF);
+		append_varint (buffer, GPOINTER_TO_UINT (idx));
+	} else if (len <= MAX_DICTIONARY_IRI_LEN &&
+	           g_hash_table_size (serializer_binary->dictionary) < MAX_DICTIONARY_SIZE) {
+		g_hash_table_insert (serializer_binary->dictionary,
+		                     g_strndup (str, len),
+		                     GUINT_TO_POINTER (g_hash_table_size (serializer_binary->dictionary)));
+		append_byte (buffer, TRACKER_BINARY_VALUE_IRI_NEW);
+		append_string (buffer, str, len);
+	} else {
+		append_byte (buffer, TRACKER_BINARY_VALUE_IRI);
+		append_string (buffer, str, len);
+	}
+}
+
+static void
+append_integer (GByteArray  *buffer,
+                gint64       value,
+                const gchar *str,
+                gsize        len)
+{
+	gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+	/* Only send typed values if the text form can be reproduced */
+	g_snprintf (buf, sizeof (buf), "%" G_GINT64_FORMAT, value);
+
+	if (strlen (buf) == len && strncmp (buf, str, len) == 0) {
+		append_byte (buffer, TRACKER_BINARY_VALUE_INTEGER);
+		append_zigzag (buffer, value);
+	} else {
+		append_typed_string (buffer, TRACKER_SPARQL_VALUE_TYPE_INTEGER, str, len);
+	}
+}
+
+static void
+append_double (GByteArray  *buffer,
+               gdouble      value,
+               const gchar *str,
+               gsize        len)
+{
+	gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+	g_ascii_dtostr (buf, sizeof (buf), value);
+
+	if (strlen (buf) == len && strncmp (buf, str, len) == 0) {
+		guint64 bits;
+
+		G_STATIC_ASSERT (sizeof (bits) == sizeof (value));
+		memcpy (&bits, &value, sizeof (bits));
+		bits = GUINT64_TO_LE (bits);
+
+		append_byte (buffer, TRACKER_BINARY_VALUE_DOUBLE);
+		g_byte_array_append (buffer, (const guint8 *) &bits, sizeof (bits));
+	} else {
+		append_typed_string (buffer, TRACKER_SPARQL_VALUE_TYPE_DOUBLE, str, len);
+	}
+}
+
+static void
+append_datetime (GByteArray  *buffer,
+                 GDateTime   *datetime,
+                 const gchar *str,
+                 gsize        len)
+{
+	gchar *formatted = NULL;
+
+	if (datetime)
+		formatted = tracker_date_format_iso8601 (datetime);
+
+	if (formatted && strlen (formatted) == len &&
+	    strncmp (formatted, str, len) == 0) {
+		gint64 usec;
+
+		usec = g_date_time_to_unix (datetime) * G_USEC_PER_SEC +
+			g_date_time_get_microsecond (datetime);
+
+		append_byte (buffer, TRACKER_BINARY_VALUE_DATETIME);
+		append_zigzag (buffer, usec);
+		append_zigzag (buffer, g_date_time_get_utc_offset (datetime) / G_USEC_PER_SEC);
+	} else {
+		append_typed_string (buffer, TRACKER_SPARQL_VALUE_TYPE_DATETIME, str, len);
+	}
+
+	g_free (formatted);
+}
+
+static void
+append_value (TrackerSerializerBinary *serializer_binary,
+              TrackerSparqlCursor     *cursor,
+              gint                     column)
+{
+	GByteArray *buffer = serializer_binary->columns[column];
+	TrackerSparqlValueType type;
+	const gchar *str, *langtag = NULL;
+	glong len = 0;
+
+	type = tracker_sparql_cursor_get_value_type (cursor, column);
+	str = tracker_sparql_cursor_get_langstring (cursor, column, &langtag, &len);
+
+	if (type == TRACKER_SPARQL_VALUE_TYPE_UNBOUND || !str) {
+		append_byte (buffer, TRACKER_BINARY_VALUE_UNBOUND);
+		return;
+	}
+
+	serializer_binary->present[column / 8] |= 1 << (column % 8);
+
+	switch (type) {
+	case TRACKER_SPARQL_VALUE_TYPE_URI:
+		append_iri (serializer_binary, buffer, str, len);
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_BLANK_NODE:
+		append_byte (buffer, TRACKER_BINARY_VALUE_BLANK_NODE);
+		append_string (buffer, str, len);
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_STRING:
+		if (langtag) {
+			append_byte (buffer, TRACKER_BINARY_VALUE_LANGSTRING);
+			append_string (buffer, str, len);
+			append_string (buffer, langtag, strlen (langtag));
+		} else {
+			append_byte (buffer, TRACKER_BINARY_VALUE_STRING);
+			append_string (buffer, str, len);
+		}
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_INTEGER:
+		append_integer (buffer,
+		                tracker_sparql_cursor_get_integer (cursor, column),
+		                str, len);
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_DOUBLE:
+		append_double (buffer,
+		               tracker_sparql_cursor_get_double (cursor, column),
+		               str, len);
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_BOOLEAN:
+		if (g_strcmp0 (str, "true") == 0)
+			append_byte (buffer, TRACKER_BINARY_VALUE_TRUE);
+		else if (g_strcmp0 (str, "false") == 0)
+			append_byte (buffer, TRACKER_BINARY_VALUE_FALSE);
+		else
+			append_typed_string (buffer, type, str, len);
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_DATETIME: {
+		GDateTime *datetime;
+
+		datetime = tracker_sparql_cursor_get_datetime (cursor, column);
+		append_datetime (buffer, datetime, str, len);
+		g_clear_pointer (&datetime, g_date_time_unref);
+		break;
+	}
+	default:
+		append_typed_string (buffer, type, str, len);
+		break;
+	}
+}
+
+static void
+serialize_head (TrackerSerializerBinary *serializer_binary,
+                TrackerSparqlCursor     *cursor)
+{
+	GByteArray *head;
+	gint i;
+
+	serializer_binary->n_columns = tracker_sparql_cursor_get_n_columns (cursor);
+	serializer_binary->columns = g_new0 (GByteArray *, serializer_binary->n_columns);
+	serializer_binary->present = g_new0 (guint8, (serializer_binary->n_columns + 7) / 8);
+
+	head = g_byte_array_new ();
+	append_varint (head, serializer_binary->n_columns);
+
+	for (i = 0; i < serializer_binary->n_columns; i++) {
+		const gchar *var;
+		gchar *name;
+
+		var = tracker_sparql_cursor_get_variable_name (cursor, i);
+
+		if (var && *var)
+			name = g_strdup (var);
+		else
+			name = g_strdup_printf ("var%d", i + 1);
+
+		append_string (head, name, strlen (name));
+		g_free (name);
+
+		serializer_binary->columns[i] = g_byte_array_new ();
+	}
+
+	g_byte_array_append (serializer_binary->data,
+	                     (const guint8 *) TRACKER_BINARY_RESULTS_MAGIC,
+	                     TRACKER_BINARY_RESULTS_MAGIC_LEN);
+	append_byte (serializer_binary->data, TRACKER_BINARY_RESULTS_VERSION);
+	append_uint32 (serializer_binary->data, head->len);
+	g_byte_array_append (serializer_binary->data, head->data, head->len);
+	g_byte_array_unref (head);
+
+	serializer_binary->head_printed = TRUE;
+}
+
+static void
+flush_block (TrackerSerializerBinary *serializer_binary)
+{
+	GByteArray *data = serializer_binary->data;
+	guint32 block_len;
+	guint len_pos;
+	gint i;
+
+	if (serializer_binary->n_rows == 0)
+		return;
+
+	/* Leave room for the block length, filled in below */
+	len_pos = data->len;
+	append_uint32 (data, 0);
+
+	append_varint (data, serializer_binary->n_rows);
+	g_byte_array_append (data, serializer_binary->present,
+	                     (serializer_binary->n_columns + 7) / 8);
+
+	for (i = 0; i < serializer_binary->n_columns; i++) {
+		GByteArray *column = serializer_binary->columns[i];
+
+		if ((serializer_binary->present[i / 8] & (1 << (i % 8))) != 0)
+			g_byte_array_append (data, column->data, column->len);
+
+		g_byte_array_set_size (column, 0);
+	}
+
+	block_len = GUINT32_TO_LE (data->len - len_pos - sizeof (guint32));
+	memcpy (&data->data[len_pos], &block_len, sizeof (block_len));
+
+	memset (serializer_binary->present, 0, (serializer_binary->n_columns + 7) / 8);
+	serializer_binary->n_rows = 0;
+}
+
+static gsize
+pending_block_size (TrackerSerializerBinary *serializer_binary)
+{
+	gsize size = 0;
+	gint i;
+
+	for (i = 0; i < serializer_binary->n_columns; i++)
+		size += serializer_binary->columns[i]->len;
+
+	return size;
+}
+
+static gboolean
+serialize_up_to_position (TrackerSerializerBinary  *serializer_binary,
+                          gsize                     pos,
+                          GCancellable             *cancellable,
+                          GError                  **error)
+{
+	TrackerSparqlCursor *cursor;
+	GError *inner_error = NULL;
+	gint i;
+
+	if (!serializer_binary->data)
+		serializer_binary->data = g_byte_array_new ();
+	if (!serializer_binary->dictionary)
+		serializer_binary->dictionary = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	cursor = tracker_serializer_get_cursor (TRACKER_SERIALIZER (serializer_binary));
+
+	if (!serializer_binary->head_printed)
+		serialize_head (serializer_binary, cursor);
+
+	while (!serializer_binary->cursor_finished &&
+	       serializer_binary->data->len < pos) {
+		if (!tracker_sparql_cursor_next (cursor, cancellable, &inner_error)) {
+			if (inner_error) {
+				g_propagate_error (error, inner_error);
+				return FALSE;
+			}
+
+			serializer_binary->cursor_finished = TRUE;
+			flush_block (serializer_binary);
+			append_uint32 (serializer_binary->data, 0);
+			break;
+		}
+
+		for (i = 0; i < serializer_binary->n_columns; i++)
+			append_value (serializer_binary, cursor, i);
+
+		serializer_binary->n_rows++;
+
+		if (serializer_binary->n_rows >= BLOCK_MAX_ROWS ||
+		    pending_block_size (serializer_binary) >= BLOCK_FLUSH_SIZE)
+			flush_block (serializer_binary);
+	}
+
+	return TRUE;
+}
+
+static gssize
+tracker_serializer_binary_read (GInputStream  *istream,
+                                gpointer       buffer,
+                                gsize          count,
+                                GCancellable  *cancellable,
+                                GError       **error)
+{
+	TrackerSerializerBinary *serializer_binary = TRACKER_SERIALIZER_BINARY (istream);
+	gsize bytes_unflushed, bytes_copied;
+
+	if (serializer_binary->stream_closed ||
+	    (serializer_binary->cursor_finished &&
+	     serializer_binary->current_pos == serializer_binary->data->len))
+		return 0;
+
+	/* Everything so far was consumed, reuse the buffer */
+	if (serializer_binary->data &&
+	    serializer_binary->current_pos == serializer_binary->data->len) {
+		g_byte_array_set_size (serializer_binary->data, 0);
+		serializer_binary->current_pos = 0;
+	}
+
+	if (!serialize_up_to_position (serializer_binary,
+	                               serializer_binary->current_pos + count,
+	                               cancellable,
+	                               error))
+		return -1;
+
+	bytes_unflushed =
+		serializer_binary->data->len - serializer_binary->current_pos;
+	bytes_copied = MIN (count, bytes_unflushed);
+
+	memcpy (buffer,
+	        &serializer_binary->data->data[serializer_binary->current_pos],
+	        bytes_copied);
+	serializer_binary->current_pos += bytes_copied;
+
+	return bytes_copied;
+}
+
+static gboolean
+tracker_serializer_binary_close (GInputStream  *istream,
+                                 GCancellable  *cancellable,
+                                 GError       **error)
+{
+	TrackerSerializerBinary *serializer_binary = TRACKER_SERIALIZER_BINARY (istream);
+	gint i;
+
+	if (serializer_binary->columns) {
+		for (i = 0; i < serializer_binary->n_columns; i++)
+			g_byte_array_unref (serializer_binary->columns[i]);
+		g_clear_pointer (&serializer_binary->columns, g_free);
+	}
+
+	g_clear_pointer (&serializer_binary->present, g_free);
+	g_clear_pointer (&serializer_binary->data, g_byte_array_unref);
+	g_clear_pointer (&serializer_binary->dictionary, g_hash_table_unref);
+	serializer_binary->stream_closed = TRUE;
+
+	return TRUE;
+}
+
+static void
+tracker_serializer_binary_class_init (TrackerSerializerBinaryClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	GInputStreamClass *istream_class = G_INPUT_STREAM_CLASS (klass);
+
+	object_class->finalize = tracker_serializer_binary_finalize;
+
+	istream_class->read_fn = tracker_serializer_binary_read;
+	istream_class->close_fn = tracker_serializer_binary_close;
+}
+
+static void
+tracker_serializer_binary_init (TrackerSerializerBinary *serializer)
+{
+}
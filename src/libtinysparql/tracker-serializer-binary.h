@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026, Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#pragma once
+
+#include <tinysparql.h>
+
+#include "tracker-serializer.h"
+
+#define TRACKER_TYPE_SERIALIZER_BINARY (tracker_serializer_binary_get_type())
+
+G_DECLARE_FINAL_TYPE (TrackerSerializerBinary,
+                      tracker_serializer_binary,
+                      TRACKER, SERIALIZER_BINARY,
+                      TrackerSerializer)
+
+/* Binary result set format, only meant for traffic between tinysparql
+ * peers. All fixed size integers are little endian, "varint" is an
+ * unsigned LEB128 integer, "zigzag" a signed integer in zigzag encoding
+ * stored as varint, and "string" is a varint length followed by as many
+ * bytes of UTF-8 data plus a nul terminator.
+ *
+ * The stream starts with a header frame:
+ *
+ *   "TSRB" magic, 1 byte version, 4 bytes header length,
+ *   varint number of columns, and a string per variable name.
+ *
+ * Followed by any number of row blocks:
+ *
+ *   4 bytes block length (0 marks the end of the result set),
+ *   varint number of rows, a bitmap of the columns present in this
+ *   block, and for each present column the values of all rows in
+ *   the block, each value being a 1 byte tag plus tag-specific data.
+ *
+ * Columns not present in a block are unbound for all its rows. IRIs
+ * are dictionary encoded, the first occurrence adds the IRI to the
+ * dictionary and later ones reference it by index.
+ */
+#define TRACKER_BINARY_RESULTS_MAGIC "TSRB"
+#define TRACKER_BINARY_RESULTS_MAGIC_LEN 4
+#define TRACKER_BINARY_RESULTS_VERSION 1
+
+typedef enum {
+	TRACKER_BINARY_VALUE_UNBOUND,
+	TRACKER_BINARY_VALUE_IRI,           /* string */
+	TRACKER_BINARY_VALUE_IRI_NEW,       /* string, added to dictionary */
+	TRACKER_BINARY_VALUE_IRI_REF,       /* varint dictionary index */
+	TRACKER_BINARY_VALUE_BLANK_NODE,    /* string */
+	TRACKER_BINARY_VALUE_STRING,        /* string */
+	TRACKER_BINARY_VALUE_LANGSTRING,    /* string, langtag string */
+	TRACKER_BINARY_VALUE_INTEGER,       /* zigzag */
+	TRACKER_BINARY_VALUE_DOUBLE,        /* 8 bytes IEEE 754 */
+	TRACKER_BINARY_VALUE_FALSE,
+	TRACKER_BINARY_VALUE_TRUE,
+	TRACKER_BINARY_VALUE_DATETIME,      /* zigzag unix usecs, zigzag UTC offset secs */
+	TRACKER_BINARY_VALUE_TYPED_STRING,  /* 1 byte TrackerSparqlValueType, string */
+	TRACKER_N_BINARY_VALUES
+} TrackerBinaryValueTag;
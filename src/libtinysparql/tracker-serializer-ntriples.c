@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2026, Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/* Serialization of cursors to the N-Triples format defined at:
+ *  https://www.w3.org/TR/n-triples/
+ *
+ * And the related N-Quads format defined at:
+ *  https://www.w3.org/TR/n-quads/
+ */
+
+#include "config.h"
+
+#include "tracker-serializer-ntriples.h"
+
+#include <string.h>
+
+#define XSD_NS "http://www.w3.org/2001/XMLSchema#"
+
+enum {
+	PROP_0,
+	PROP_HAS_GRAPH,
+	N_PROPS
+};
+
+static GParamSpec *props[N_PROPS];
+
+struct _TrackerSerializerNTriples
+{
+	TrackerSerializer parent_instance;
+	GString *data;
+	guint stream_closed : 1;
+	guint cursor_finished : 1;
+	guint has_graph : 1;
+};
+
+G_DEFINE_TYPE (TrackerSerializerNTriples, tracker_serializer_ntriples,
+               TRACKER_TYPE_SERIALIZER)
+
+static void
+tracker_serializer_ntriples_finalize (GObject *object)
+{
+	g_input_stream_close (G_INPUT_STREAM (object), NULL, NULL);
+
+	G_OBJECT_CLASS (tracker_serializer_ntriples_parent_class)->finalize (object);
+}
+
+static void
+tracker_serializer_ntriples_set_property (GObject      *object,
+                                          guint         prop_id,
+                                          const GValue *value,
+                                          GParamSpec   *pspec)
+{
+	TrackerSerializerNTriples *serializer_nt = TRACKER_SERIALIZER_NTRIPLES (object);
+
+	switch (prop_id) {
+	case PROP_HAS_GRAPH:
+		serializer_nt->has_graph = g_value_get_boolean (value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+tracker_serializer_ntriples_get_property (GObject    *object,
+                                          guint       prop_id,
+                                          GValue     *value,
+                                          GParamSpec *pspec)
+{
+	TrackerSerializerNTriples *serializer_nt = TRACKER_SERIALIZER_NTRIPLES (object);
+
+	switch (prop_id) {
+	case PROP_HAS_GRAPH:
+		g_value_set_boolean (value, serializer_nt->has_graph);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+print_iri (GString     *str,
+           const gchar *iri)
+{
+	const gchar *p = iri;
+
+	g_string_append_c (str, '<');
+
+	while (*p != '\0') {
+		gsize len;
+
+		len = strcspn (p, "<>\"{}|^`\\ \t\n\r\b\f");
+		g_string_append_len (str, p, len);
+		p += len;
+
+		if (*p == '\0')
+			break;
+
+		/* Characters not allowed in IRIREF, escape as UCHAR */
+		g_string_append_printf (str, "\\u%04X", (guchar) *p);
+		p++;
+	}
+
+	g_string_append_c (str, '>');
+}
+
+static void
+print_literal (GString     *str,
+               const gchar *value,
+               const gchar *langtag,
+               const gchar *datatype)
+{
+	gchar *escaped;
+
+	escaped = tracker_sparql_escape_string (value);
+	g_string_append_c (str, '"');
+	g_string_append (str, escaped);
+	g_string_append_c (str, '"');
+	g_free (escaped);
+
+	if (langtag) {
+		g_string_append_c (str, '@');
+		g_string_append (str, langtag);
+	} else if (datatype) {
+		g_string_append (str, "^^<" XSD_NS);
+		g_string_append (str, datatype);
+		g_string_append_c (str, '>');
+	}
+}
+
+static void
+print_value (GString                *str,
+             const gchar            *value,
+             const gchar            *langtag,
+             TrackerSparqlValueType  value_type)
+{
+	g_assert (value != NULL);
+
+	switch (value_type) {
+	case TRACKER_SPARQL_VALUE_TYPE_URI:
+		print_iri (str, value);
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_BLANK_NODE: {
+		gchar *bnode_label;
+
+		if (g_str_has_prefix (value, "_:")) {
+			g_string_append (str, value);
+		} else {
+			bnode_label = g_strdelimit (g_strdup (value), ":", '_');
+			g_string_append (str, "_:");
+			g_string_append (str, bnode_label);
+			g_free (bnode_label);
+		}
+		break;
+	}
+	case TRACKER_SPARQL_VALUE_TYPE_STRING:
+		print_literal (str, value, langtag, NULL);
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_DATETIME:
+		print_literal (str, value, NULL,
+		               strchr (value, 'T') ? "dateTime" : "date");
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_INTEGER:
+		print_literal (str, value, NULL, "integer");
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_DOUBLE:
+		print_literal (str, value, NULL, "double");
+		break;
+	case TRACKER_SPARQL_VALUE_TYPE_BOOLEAN:
+		print_literal (str,
+		               (value[0] == 't' || value[0] == 'T') ?
+		               "true" : "false",
+		               NULL, "boolean");
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+}
+
+static gboolean
+serialize_up_to_size (TrackerSerializerNTriples  *serializer_nt,
+                      gsize                       size,
+                      GCancellable               *cancellable,
+                      GError                    **error)
+{
+	TrackerSparqlCursor *cursor;
+	GError *inner_error = NULL;
+	gboolean print_graph;
+
+	if (!serializer_nt->data)
+		serializer_nt->data = g_string_new (NULL);
+
+	cursor = tracker_serializer_get_cursor (TRACKER_SERIALIZER (serializer_nt));
+	print_graph = serializer_nt->has_graph &&
+		tracker_sparql_cursor_get_n_columns (cursor) >= 4;
+
+	while (!serializer_nt->cursor_finished &&
+	       serializer_nt->data->len < size) {
+		TrackerSparqlValueType subject_type, object_type;
+		const gchar *subject, *predicate, *object, *graph = NULL;
+		const gchar *langtag = NULL;
+
+		if (!tracker_sparql_cursor_next (cursor, cancellable, &inner_error)) {
+			if (inner_error) {
+				g_propagate_error (error, inner_error);
+				return FALSE;
+			} else {
+				serializer_nt->cursor_finished = TRUE;
+				break;
+			}
+		}
+
+		subject = tracker_sparql_cursor_get_string (cursor, 0, NULL);
+		predicate = tracker_sparql_cursor_get_string (cursor, 1, NULL);
+		object = tracker_sparql_cursor_get_langstring (cursor, 2, &langtag, NULL);
+
+		if (!subject || !predicate || !object) {
+			g_set_error (error,
+			             TRACKER_SPARQL_ERROR,
+			             TRACKER_SPARQL_ERROR_INTERNAL,
+			             "Cursor has no subject/predicate/object/graph columns");
+			return FALSE;
+		}
+
+		if (print_graph)
+			graph = tracker_sparql_cursor_get_string (cursor, 3, NULL);
+
+		subject_type = tracker_sparql_cursor_get_value_type (cursor, 0);
+		object_type = tracker_sparql_cursor_get_value_type (cursor, 2);
+
+		if (subject_type == TRACKER_SPARQL_VALUE_TYPE_STRING) {
+			if (g_str_has_prefix (subject, "urn:bnode:"))
+				subject_type = TRACKER_SPARQL_VALUE_TYPE_BLANK_NODE;
+			else
+				subject_type = TRACKER_SPARQL_VALUE_TYPE_URI;
+		}
+
+		if (object_type == TRACKER_SPARQL_VALUE_TYPE_STRING &&
+		    g_str_has_prefix (object, "urn:bnode:"))
+			object_type = TRACKER_SPARQL_VALUE_TYPE_BLANK_NODE;
+
+		print_value (serializer_nt->data, subject, NULL, subject_type);
+		g_string_append_c (serializer_nt->data, ' ');
+		print_iri (serializer_nt->data, predicate);
+		g_string_append_c (serializer_nt->data, ' ');
+		print_value (serializer_nt->data, object, langtag, object_type);
+
+		if (graph) {
+			g_string_append_c (serializer_nt->data, ' ');
+			print_iri (serializer_nt->data, graph);
+		}
+
+		g_string_append (serializer_nt->data, " .\n");
+	}
+
+	return TRUE;
+}
+
+static gssize
+tracker_serializer_ntriples_read (GInputStream  *istream,
+                                  gpointer       buffer,
+                                  gsize          count,
+                                  GCancellable  *cancellable,
+                                  GError       **error)
+{
+	TrackerSerializerNTriples *serializer_nt = TRACKER_SERIALIZER_NTRIPLES (istream);
+	gsize bytes_copied;
+
+	if (serializer_nt->stream_closed ||
+	    (serializer_nt->cursor_finished &&
+	     serializer_nt->data->len == 0))
+		return 0;
+
+	if (!serialize_up_to_size (serializer_nt,
+	                           count,
+	                           cancellable,
+	                           error))
+		return -1;
+
+	bytes_copied = MIN (count, serializer_nt->data->len);
+
+	memcpy (buffer,
+	        serializer_nt->data->str,
+	        bytes_copied);
+	g_string_erase (serializer_nt->data, 0, bytes_copied);
+
+	return bytes_copied;
+}
+
+static gboolean
+tracker_serializer_ntriples_close (GInputStream  *istream,
+                                   GCancellable  *cancellable,
+                                   GError       **error)
+{
+	TrackerSerializerNTriples *serializer_nt = TRACKER_SERIALIZER_NTRIPLES (istream);
+
+	if (serializer_nt->data) {
+		g_string_free (serializer_nt->data, TRUE);
+		serializer_nt->data = NULL;
+	}
+
+	serializer_nt->stream_closed = TRUE;
+
+	return TRUE;
+}
+
+static void
+tracker_serializer_ntriples_class_init (TrackerSerializerNTriplesClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	GInputStreamClass *istream_class = G_INPUT_STREAM_CLASS (klass);
+
+	object_class->finalize = tracker_serializer_ntriples_finalize;
+	object_class->set_property = tracker_serializer_ntriples_set_property;
+	object_class->get_property = tracker_serializer_ntriples_get_property;
+
+	istream_class->read_fn = tracker_serializer_ntriples_read;
+	istream_class->close_fn = tracker_serializer_ntriples_close;
+
+	props[PROP_HAS_GRAPH] =
+		g_param_spec_boolean ("has-graph",
+		                      "Has graph",
+		                      "Has graph",
+		                      FALSE,
+		                      G_PARAM_CONSTRUCT_ONLY |
+		                      G_PARAM_STATIC_STRINGS |
+		                      G_PARAM_READABLE |
+		                      G_PARAM_WRITABLE);
+
+	g_object_class_install_properties (object_class, N_PROPS, props);
+}
+
+static void
+tracker_serializer_ntriples_init (TrackerSerializerNTriples *serializer)
+{
+}
@@ -22,8 +22,10 @@
 #include "config.h"
 
 #include "tracker-serializer.h"
+#include "tracker-serializer-binary.h"
 #include "tracker-serializer-json.h"
 #include "tracker-serializer-json-ld.h"
+#include "tracker-serializer-ntriples.h"
 #include "tracker-serializer-trig.h"
 #include "tracker-serializer-turtle.h"
 #include "tracker-serializer-xml.h"
@@ -143,6 +145,16 @@ tracker_serializer_new (TrackerSparqlCursor     *cursor,
 	case TRACKER_SERIALIZER_FORMAT_JSON_LD:
 		type = TRACKER_TYPE_SERIALIZER_JSON_LD;
 		break;
+	case TRACKER_SERIALIZER_FORMAT_BINARY:
+		type = TRACKER_TYPE_SERIALIZER_BINARY;
+		break;
+	case TRACKER_SERIALIZER_FORMAT_NTRIPLES:
+	case TRACKER_SERIALIZER_FORMAT_NQUADS:
+		return g_object_new (TRACKER_TYPE_SERIALIZER_NTRIPLES,
+		                     "cursor", cursor,
+		                     "namespace-manager", namespaces,
+		                     "has-graph", format == TRACKER_SERIALIZER_FORMAT_NQUADS,
+		                     NULL);
 	default:
 		g_warn_if_reached ();
 		return NULL;
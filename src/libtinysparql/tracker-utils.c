@@ -32,6 +32,8 @@ static const char *extensions[] = {
 	".ttl",
 	".trig",
 	".jsonld",
+	".nt",
+	".nq",
 };
 
 G_STATIC_ASSERT (G_N_ELEMENTS (extensions) == TRACKER_N_RDF_FORMATS);
@@ -165,6 +167,10 @@ tracker_rdf_format_pick_for_file (GFile            *file,
 		format = TRACKER_RDF_FORMAT_JSON_LD;
 	} else if (g_str_has_suffix (uri, extensions[TRACKER_RDF_FORMAT_TURTLE])) {
 		format = TRACKER_RDF_FORMAT_TURTLE;
+	} else if (g_str_has_suffix (uri, extensions[TRACKER_RDF_FORMAT_N_TRIPLES])) {
+		format = TRACKER_RDF_FORMAT_N_TRIPLES;
+	} else if (g_str_has_suffix (uri, extensions[TRACKER_RDF_FORMAT_N_QUADS])) {
+		format = TRACKER_RDF_FORMAT_N_QUADS;
 	} else {
 		g_free (uri);
 		return FALSE;
@@ -46,6 +46,7 @@ G_BEGIN_DECLS
 #define TRACKER_VERSION_3_7 G_ENCODE_VERSION (3, 7)
 #define TRACKER_VERSION_3_8 G_ENCODE_VERSION (3, 8)
 #define TRACKER_VERSION_3_11 G_ENCODE_VERSION (3, 11)
+#define TRACKER_VERSION_3_12 G_ENCODE_VERSION (3, 12)
 #define TRACKER_VERSION_CUR G_ENCODE_VERSION (TRACKER_MAJOR_VERSION, TRACKER_MINOR_VERSION)
 
 #ifndef TRACKER_VERSION_MIN_REQUIRED
@@ -197,6 +198,21 @@ G_BEGIN_DECLS
 #define TRACKER_AVAILABLE_IN_3_11 _TRACKER_EXTERN
 #endif
 
+/* 3.12 */
+#if TRACKER_VERSION_MIN_REQUIRED >= TRACKER_VERSION_3_12
+#define TRACKER_DEPRECATED_IN_3_12 _TRACKER_DEPRECATED
+#define TRACKER_DEPRECATED_IN_3_12_FOR(f) _TRACKER_DEPRECATED_FOR(f)
+#else
+#define TRACKER_DEPRECATED_IN_3_12 _TRACKER_EXTERN
+#define TRACKER_DEPRECATED_IN_3_12_FOR(f) _TRACKER_EXTERN
+#endif
+
+#if TRACKER_VERSION_MAX_ALLOWED < TRACKER_VERSION_3_12
+#define TRACKER_AVAILABLE_IN_3_12 _TRACKER_UNAVAILABLE(3, 12)
+#else
+#define TRACKER_AVAILABLE_IN_3_12 _TRACKER_EXTERN
+#endif
+
 /**
  * tracker_major_version:
  *
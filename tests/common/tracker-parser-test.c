@@ -199,6 +199,205 @@ test_unac (TrackerParserTestFixture *fixture,
 #endif
 }
 
+/* -------------- ASCII FAST PATH TESTS ----------------- */
+
+/* Test struct for the ASCII fast path tests */
+typedef struct TestDataAscii TestDataAscii;
+struct TestDataAscii {
+	const gchar *str;
+	gboolean ignore_numbers;
+};
+
+/* Parses str, returning the words and their original text */
+static void
+parse_words (TrackerParserTestFixture  *fixture,
+             const gchar               *str,
+             gboolean                   ignore_numbers,
+             GPtrArray                **words_out,
+             GPtrArray                **originals_out)
+{
+	GPtrArray *words, *originals;
+	const gchar *word;
+	gint position;
+	gint byte_offset_start;
+	gint byte_offset_end;
+	gint word_length;
+
+	words = g_ptr_array_new_with_free_func (g_free);
+	originals = g_ptr_array_new_with_free_func (g_free);
+
+	tracker_parser_reset (fixture->parser,
+	                      str,
+	                      strlen (str),
+	                      fixture->max_word_length,
+	                      fixture->enable_stemmer,
+	                      fixture->enable_unaccent,
+	                      ignore_numbers);
+
+	while ((word = tracker_parser_next (fixture->parser,
+	                                    &position,
+	                                    &byte_offset_start,
+	                                    &byte_offset_end,
+	                                    &word_length)) != NULL) {
+		g_assert_cmpint (byte_offset_start, <, byte_offset_end);
+		g_assert_cmpint (byte_offset_end, <=, strlen (str));
+
+		g_ptr_array_add (words, g_strndup (word, word_length));
+		g_ptr_array_add (originals,
+		                 g_strndup (&str[byte_offset_start],
+		                            byte_offset_end - byte_offset_start));
+	}
+
+	*words_out = words;
+	*originals_out = originals;
+}
+
+static void
+ascii_fast_path_check (TrackerParserTestFixture *fixture,
+                       gconstpointer             data)
+{
+	const TestDataAscii *testdata = data;
+	GPtrArray *words, *originals, *unicode_words, *unicode_originals;
+	GString *unicode_str;
+	const gchar *p;
+	guint i;
+
+	/* Separate words with U+2003 EM SPACE instead, so the string has
+	 * no ASCII whitespace and goes entirely through the Unicode word
+	 * breaker. Both must result in the same words.
+	 */
+	unicode_str = g_string_new (NULL);
+	for (p = testdata->str; *p; p++) {
+		if (g_ascii_isspace (*p))
+			g_string_append (unicode_str, "\xe2\x80\x83");
+		else
+			g_string_append_c (unicode_str, *p);
+	}
+
+	parse_words (fixture, testdata->str, testdata->ignore_numbers,
+	             &words, &originals);
+	parse_words (fixture, unicode_str->str, testdata->ignore_numbers,
+	             &unicode_words, &unicode_originals);
+
+	g_assert_cmpuint (words->len, >, 0);
+	g_assert_cmpuint (words->len, ==, unicode_words->len);
+
+	for (i = 0; i < words->len; i++) {
+		g_assert_cmpstr (g_ptr_array_index (words, i), ==,
+		                 g_ptr_array_index (unicode_words, i));
+		g_assert_cmpstr (g_ptr_array_index (originals, i), ==,
+		                 g_ptr_array_index (unicode_originals, i));
+	}
+
+	g_ptr_array_unref (words);
+	g_ptr_array_unref (originals);
+	g_ptr_array_unref (unicode_words);
+	g_ptr_array_unref (unicode_originals);
+	g_string_free (unicode_str, TRUE);
+}
+
+/* Test struct for the mixed ASCII/non-ASCII tests */
+typedef struct TestDataExpectedWords TestDataExpectedWords;
+struct TestDataExpectedWords {
+	const gchar *str;
+	const gchar *expected;
+	const gchar *expected_originals;
+};
+
+static void
+expected_words_check (TrackerParserTestFixture *fixture,
+                      gconstpointer             data)
+{
+	const TestDataExpectedWords *testdata = data;
+	GPtrArray *words, *originals;
+	gchar *str, *expected_nfkd;
+
+	fixture->enable_stemmer = FALSE;
+
+	parse_words (fixture, testdata->str, fixture->ignore_numbers,
+	             &words, &originals);
+
+	g_ptr_array_add (words, NULL);
+	g_ptr_array_add (originals, NULL);
+
+	/* Expected words MUST always be in NFKD normalization */
+	str = g_strjoinv (" ", (gchar **) words->pdata);
+	expected_nfkd = g_utf8_normalize (testdata->expected, -1,
+	                                  G_NORMALIZE_NFKD);
+	g_assert_cmpstr (str, ==, expected_nfkd);
+	g_free (expected_nfkd);
+	g_free (str);
+
+	str = g_strjoinv (" ", (gchar **) originals->pdata);
+	g_assert_cmpstr (str, ==, testdata->expected_originals);
+	g_free (str);
+
+	g_ptr_array_unref (words);
+	g_ptr_array_unref (originals);
+}
+
+static void
+test_unac_words (TrackerParserTestFixture *fixture,
+                 gconstpointer             data)
+{
+#ifdef HAVE_UNAC
+       expected_words_check (fixture, data);
+#else
+       g_test_skip ("Built without UNAC");
+#endif
+}
+
+/* -------------- THROUGHPUT BENCHMARK ----------------- */
+
+#define BENCHMARK_TEXT_SIZE (4 * 1024 * 1024)
+
+static void
+throughput_check (TrackerParserTestFixture *fixture,
+                  gconstpointer             data)
+{
+	const gchar *sample = data;
+	GString *text;
+	gint position;
+	gint byte_offset_start;
+	gint byte_offset_end;
+	gint word_length;
+	guint nwords = 0;
+	gdouble elapsed;
+
+	text = g_string_new (NULL);
+	while (text->len < BENCHMARK_TEXT_SIZE) {
+		g_string_append (text, sample);
+		g_string_append_c (text, '\n');
+	}
+
+	g_test_timer_start ();
+
+	tracker_parser_reset (fixture->parser,
+	                      text->str,
+	                      text->len,
+	                      fixture->max_word_length,
+	                      fixture->enable_stemmer,
+	                      fixture->enable_unaccent,
+	                      fixture->ignore_numbers);
+
+	while (tracker_parser_next (fixture->parser,
+	                            &position,
+	                            &byte_offset_start,
+	                            &byte_offset_end,
+	                            &word_length))
+		nwords++;
+
+	elapsed = g_test_timer_elapsed ();
+
+	g_assert_cmpuint (nwords, >, 0);
+	g_test_maximized_result (text->len / elapsed / (1024 * 1024),
+	                         "Tokenized %.2f MB/s (%u words in %.3f seconds)",
+	                         text->len / elapsed / (1024 * 1024),
+	                         nwords, elapsed);
+
+	g_string_free (text, TRUE);
+}
+
 /* -------------- LIST OF TESTS ----------------- */
 
 /* Normalization-related tests (unaccenting) */
@@ -253,6 +452,43 @@ static const TestDataExpectedWord test_data_casefolding[] = {
 	{ NULL,    NULL,    FALSE, FALSE }
 };
 
+/* ASCII fast path tests, these must match the Unicode word breaker */
+static const TestDataAscii test_data_ascii[] = {
+	{ "The quick (\"brown\") fox can't jump 32.3 feet, right?",         TRUE  },
+	{ "The quick (\"brown\") fox can't jump 32.3 feet, right?",         FALSE },
+	{ "O'Neil's rock'n'roll costs 1,000,000 or 3;4 or 1'000 o''k",      FALSE },
+	{ "filename.txt .hidden.txt noextension. a..b a.'b 1.a a1.b",       FALSE },
+	{ "snake_case __init__ _private CamelCase a1b2 1a2b 2_a",           TRUE  },
+	{ "snake_case __init__ _private CamelCase a1b2 1a2b 2_a",           FALSE },
+	{ "mailto:user@example.com http://example.com/path?q=v#frag",       FALSE },
+	{ "foo:bar baz:123 12:30 :colon trailing:",                         FALSE },
+	{ "Tabs\tand\nnew\r\nlines\fand\vfeeds,trailing-hyphen-words",      TRUE  },
+	{ "Short pneumonoultramicroscopicsilicovolcanoconiosisandmore ok",  TRUE  },
+	{ NULL,                                                             FALSE }
+};
+
+/* Mixed ASCII and non-ASCII text, with unaccenting */
+static const TestDataExpectedWords test_data_mixed[] = {
+	{ "Café au LAIT, CRÈME brûlée and TEA",
+	  "cafe au lait creme brulee and tea",
+	  "Café au LAIT CRÈME brûlée and TEA" },
+	{ "plain ascii text Ærø then plain again",
+	  "plain ascii text ærø then plain again",
+	  "plain ascii text Ærø then plain again" },
+	{ "ascii\xcc\x81 combining é\xcc\x81 file.txt",
+	  "ascii combining e file txt",
+	  "ascii\xcc\x81 combining é\xcc\x81 file txt" },
+	{ NULL, NULL, NULL }
+};
+
+/* Throughput benchmarks */
+static const gchar *benchmark_ascii =
+	"The quick brown fox jumps over the lazy dog, while the 3 cats "
+	"can't decide whether file.txt or README.md is the better name.";
+static const gchar *benchmark_mixed =
+	"Le cœur déçu mais l'âme plutôt naïve, Louÿs rêva de crapaüter en "
+	"canoë au delà des îles, près du mälström où brûlent les novæ.";
+
 /* Number of expected words tests */
 static const TestDataExpectedNWords test_data_nwords[] = {
 	{ "The quick (\"brown\") fox can’t jump 32.3 feet, right?", TRUE,   8, -1 },
@@ -347,5 +583,49 @@ main (int argc, char **argv)
 		g_free (testpath);
 	}
 
+	/* Add ASCII fast path checks */
+	for (i = 0; test_data_ascii[i].str != NULL; i++) {
+		gchar *testpath;
+
+		testpath = g_strdup_printf ("/libtracker-fts/parser/ascii_%d", i);
+		g_test_add (testpath,
+		            TrackerParserTestFixture,
+		            &test_data_ascii[i],
+		            test_common_setup,
+		            ascii_fast_path_check,
+		            test_common_teardown);
+		g_free (testpath);
+	}
+
+	/* Add mixed text checks */
+	for (i = 0; test_data_mixed[i].str != NULL; i++) {
+		gchar *testpath;
+
+		testpath = g_strdup_printf ("/libtracker-fts/parser/mixed_%d", i);
+		g_test_add (testpath,
+		            TrackerParserTestFixture,
+		            &test_data_mixed[i],
+		            test_common_setup,
+		            test_unac_words,
+		            test_common_teardown);
+		g_free (testpath);
+	}
+
+	/* Add throughput benchmarks, run with "-m perf" */
+	if (g_test_perf ()) {
+		g_test_add ("/libtracker-fts/parser/throughput/ascii",
+		            TrackerParserTestFixture,
+		            benchmark_ascii,
+		            test_common_setup,
+		            throughput_check,
+		            test_common_teardown);
+		g_test_add ("/libtracker-fts/parser/throughput/mixed",
+		            TrackerParserTestFixture,
+		            benchmark_mixed,
+		            test_common_setup,
+		            throughput_check,
+		            test_common_teardown);
+	}
+
 	return g_test_run ();
 }
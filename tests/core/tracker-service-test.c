@@ -59,6 +59,8 @@ const TestInfo tests[] = {
 	{ "service/service-constraint-1", FALSE },
 	{ "service/service-constraint-2", TRUE },
 	{ "service/property-function-1", FALSE },
+	{ "service/service-concurrent-1", FALSE },
+	{ "service/service-concurrent-2", FALSE },
 };
 
 static GDBusConnection *dbus_conn = NULL;
@@ -66,6 +68,7 @@ static TrackerSparqlConnection *local = NULL;
 static TrackerSparqlConnection *remote = NULL;
 static TrackerEndpointDBus *endpoint = NULL;
 static GMainLoop *endpoint_loop = NULL;
+static gint n_endpoint_calls = 0;
 
 static void
 check_result (TrackerSparqlCursor *cursor,
@@ -169,6 +172,16 @@ check_result (TrackerSparqlCursor *cursor,
 	g_free (results);
 }
 
+static gboolean
+block_call_cb (TrackerEndpointDBus *endpoint_dbus,
+               const gchar         *sender,
+               gpointer             user_data)
+{
+	g_atomic_int_inc (&n_endpoint_calls);
+
+	return FALSE;
+}
+
 static gpointer
 thread_func (gpointer user_data)
 {
@@ -186,6 +199,9 @@ thread_func (gpointer user_data)
 	if (!endpoint)
 		return NULL;
 
+	g_signal_connect (endpoint, "block-call",
+	                  G_CALLBACK (block_call_cb), NULL);
+
 	g_main_loop_run (endpoint_loop);
 	g_main_context_pop_thread_default (context);
 	g_main_context_unref (context);
@@ -193,26 +209,15 @@ thread_func (gpointer user_data)
 	return NULL;
 }
 
-static void
-test_sparql_query (TestInfo      *test_info,
-                   gconstpointer  context)
+static GThread *
+start_endpoint (TrackerSparqlConnectionFlags flags)
 {
-	TrackerSparqlCursor *cursor;
 	GError *error = NULL;
-	gchar *query, *query_filename, *service_query;
-	gchar *results_filename;
-	gchar *prefix, *test_prefix, *uri;
 	GFile *ontology;
 	GThread *thread;
-	gboolean retval;
-
-	/* initialization */
-	prefix = g_build_filename (TOP_SRCDIR, "tests", "core", NULL);
-	test_prefix = g_build_filename (prefix, test_info->test_name, NULL);
-	g_free (prefix);
 
 	ontology = tracker_sparql_get_ontology_nepomuk ();
-	local = tracker_sparql_connection_new (0, NULL, ontology, NULL, &error);
+	local = tracker_sparql_connection_new (flags, NULL, ontology, NULL, &error);
 	g_assert_no_error (error);
 
 	remote = tracker_sparql_connection_new (0, NULL, ontology, NULL, &error);
@@ -228,6 +233,41 @@ test_sparql_query (TestInfo      *test_info,
 	                                          "other-connection",
 	                                          remote);
 
+	return thread;
+}
+
+static void
+stop_endpoint (GThread *thread)
+{
+	g_main_loop_quit (endpoint_loop);
+	g_main_loop_unref (endpoint_loop);
+	endpoint_loop = NULL;
+
+	g_clear_object (&local);
+	g_clear_object (&remote);
+	g_clear_object (&endpoint);
+	g_thread_unref (thread);
+}
+
+static void
+test_sparql_query (TestInfo      *test_info,
+                   gconstpointer  context)
+{
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+	gchar *query, *query_filename, *service_query;
+	gchar *results_filename;
+	gchar *prefix, *test_prefix, *uri;
+	GThread *thread;
+	gboolean retval;
+
+	/* initialization */
+	prefix = g_build_filename (TOP_SRCDIR, "tests", "core", NULL);
+	test_prefix = g_build_filename (prefix, test_info->test_name, NULL);
+	g_free (prefix);
+
+	thread = start_endpoint (TRACKER_SPARQL_CONNECTION_FLAGS_NONE);
+
 	query_filename = g_strconcat (test_prefix, ".rq", NULL);
 	retval = g_file_get_contents (query_filename, &query, NULL, &error);
 	g_assert_true (retval);
@@ -244,8 +284,8 @@ test_sparql_query (TestInfo      *test_info,
 		                       g_dbus_connection_get_unique_name (dbus_conn));
 	}
 
-	/* perform actual query */
-	service_query = g_strdup_printf (query, uri);
+	/* perform actual query, the service may be referenced several times */
+	service_query = g_strdup_printf (query, uri, uri, uri);
 	cursor = tracker_sparql_connection_query (local, service_query, NULL, &error);
 	g_free (service_query);
 	g_free (query);
@@ -257,14 +297,307 @@ test_sparql_query (TestInfo      *test_info,
 	g_clear_error (&error);
 
 	/* cleanup */
-	g_main_loop_quit (endpoint_loop);
-	g_main_loop_unref (endpoint_loop);
-	endpoint_loop = NULL;
+	stop_endpoint (thread);
+}
 
-	g_clear_object (&local);
-	g_clear_object (&remote);
-	g_clear_object (&endpoint);
-	g_thread_unref (thread);
+static gint64
+query_count (TrackerSparqlConnection *conn,
+             const gchar             *query)
+{
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+	gint64 count;
+
+	cursor = tracker_sparql_connection_query (conn, query, NULL, &error);
+	g_assert_no_error (error);
+
+	g_assert_true (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	count = tracker_sparql_cursor_get_integer (cursor, 0);
+
+	g_object_unref (cursor);
+
+	return count;
+}
+
+static void
+test_service_large_results (void)
+{
+	GThread *thread;
+	gchar *query;
+	gint64 expected, count;
+
+	thread = start_endpoint (TRACKER_SPARQL_CONNECTION_FLAGS_NONE);
+
+	expected = query_count (remote,
+	                        "SELECT (COUNT (*) AS ?c) { "
+	                        "  ?a a rdfs:Class . ?b a rdfs:Class "
+	                        "}");
+
+	/* Over the rows buffered from services fetched ahead of time */
+	g_assert_cmpint (expected, >, 10000);
+
+	query = g_strdup_printf ("SELECT (COUNT (*) AS ?c) { "
+	                         "  SERVICE <dbus:%s> { ?a a rdfs:Class . ?b a rdfs:Class } "
+	                         "  SERVICE <dbus:%s> { SELECT (42 AS ?n) { } } "
+	                         "}",
+	                         g_dbus_connection_get_unique_name (dbus_conn),
+	                         g_dbus_connection_get_unique_name (dbus_conn));
+	count = query_count (local, query);
+	g_assert_cmpint (count, ==, expected);
+	g_free (query);
+
+	stop_endpoint (thread);
+}
+
+static void
+test_service_interleaved_cursors (void)
+{
+	TrackerSparqlCursor *cursors[2];
+	GError *error = NULL;
+	GThread *thread;
+	gchar *query;
+	guint i;
+
+	thread = start_endpoint (TRACKER_SPARQL_CONNECTION_FLAGS_NONE);
+
+	query = g_strdup_printf ("SELECT ?a ?b { "
+	                         "  SERVICE <dbus:%s> { SELECT (42 AS ?a) { } } "
+	                         "  SERVICE <dbus:%s> { SELECT (true AS ?b) { } } "
+	                         "}",
+	                         g_dbus_connection_get_unique_name (dbus_conn),
+	                         g_dbus_connection_get_unique_name (dbus_conn));
+
+	/* Both cursors fetch the same subqueries ahead of time, each
+	 * must get its own results in whatever order they are stepped.
+	 */
+	for (i = 0; i < G_N_ELEMENTS (cursors); i++) {
+		cursors[i] = tracker_sparql_connection_query (local, query, NULL, &error);
+		g_assert_no_error (error);
+	}
+
+	for (i = G_N_ELEMENTS (cursors); i > 0; i--) {
+		TrackerSparqlCursor *cursor = cursors[i - 1];
+
+		g_assert_true (tracker_sparql_cursor_next (cursor, NULL, &error));
+		g_assert_no_error (error);
+		g_assert_cmpint (tracker_sparql_cursor_get_integer (cursor, 0), ==, 42);
+		g_assert_true (tracker_sparql_cursor_get_boolean (cursor, 1));
+
+		g_assert_false (tracker_sparql_cursor_next (cursor, NULL, &error));
+		g_assert_no_error (error);
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (cursors); i++)
+		g_object_unref (cursors[i]);
+
+	g_free (query);
+	stop_endpoint (thread);
+}
+
+static gchar *
+query_string (TrackerSparqlConnection *conn,
+              const gchar             *query)
+{
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+	gchar *str;
+
+	cursor = tracker_sparql_connection_query (conn, query, NULL, &error);
+	g_assert_no_error (error);
+
+	g_assert_true (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	str = g_strdup (tracker_sparql_cursor_get_string (cursor, 0, NULL));
+
+	/* Results are only cached after the scan is complete */
+	g_assert_false (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+
+	g_object_unref (cursor);
+
+	return str;
+}
+
+/* Returns the number of calls a query made to the endpoint */
+static gint
+run_query (TrackerSparqlConnection *conn,
+           const gchar             *query,
+           gint64                  *n_rows)
+{
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+	gint n_calls;
+
+	n_calls = g_atomic_int_get (&n_endpoint_calls);
+
+	cursor = tracker_sparql_connection_query (conn, query, NULL, &error);
+	g_assert_no_error (error);
+
+	*n_rows = 0;
+	while (tracker_sparql_cursor_next (cursor, NULL, &error))
+		(*n_rows)++;
+	g_assert_no_error (error);
+
+	g_object_unref (cursor);
+
+	return g_atomic_int_get (&n_endpoint_calls) - n_calls;
+}
+
+static void
+test_service_rescans (void)
+{
+	GThread *thread;
+	gchar *query;
+	gint64 n_classes, n_rows;
+	gint n_calls;
+
+	thread = start_endpoint (TRACKER_SPARQL_CONNECTION_FLAGS_NONE);
+
+	n_classes = query_count (local,
+	                         "SELECT (COUNT (*) AS ?c) { ?c a rdfs:Class }");
+
+	/* Also sets up the connection to the endpoint */
+	query = g_strdup_printf ("SELECT ?n { "
+	                         "  SERVICE <dbus:%s> { SELECT (42 AS ?n) { } } "
+	                         "}",
+	                         g_dbus_connection_get_unique_name (dbus_conn));
+	run_query (local, query, &n_rows);
+	n_calls = run_query (local, query, &n_rows);
+	g_assert_cmpint (n_rows, ==, 1);
+	g_free (query);
+
+	/* Scanning the SERVICE once per local row does not query
+	 * the endpoint again.
+	 */
+	query = g_strdup_printf ("SELECT ?c ?n { "
+	                         "  ?c a rdfs:Class . "
+	                         "  SERVICE <dbus:%s> { SELECT (42 AS ?n) { } } "
+	                         "  FILTER (?n = 42) "
+	                         "}",
+	                         g_dbus_connection_get_unique_name (dbus_conn));
+	g_assert_cmpint (run_query (local, query, &n_rows), ==, n_calls);
+	g_assert_cmpint (n_rows, ==, n_classes);
+	g_free (query);
+
+	stop_endpoint (thread);
+}
+
+static void
+update_remote_title (const gchar *urn,
+                     const gchar *title)
+{
+	GError *error = NULL;
+	gchar *update;
+
+	update = g_strdup_printf ("DELETE WHERE { <%s> nie:title ?t } ; "
+	                          "INSERT DATA { <%s> a nie:InformationElement ; nie:title '%s' }",
+	                          urn, urn, title);
+	tracker_sparql_connection_update (remote, update, NULL, &error);
+	g_assert_no_error (error);
+	g_free (update);
+}
+
+static gchar *
+create_title_query (const gchar *urn)
+{
+	return g_strdup_printf ("SELECT ?t { "
+	                        "  SERVICE <dbus:%s> { <%s> nie:title ?t } "
+	                        "}",
+	                        g_dbus_connection_get_unique_name (dbus_conn),
+	                        urn);
+}
+
+static void
+assert_title (const gchar *query,
+              const gchar *title)
+{
+	gchar *str;
+
+	str = query_string (local, query);
+	g_assert_cmpstr (str, ==, title);
+	g_free (str);
+}
+
+static void
+test_service_cache_hit (void)
+{
+	GThread *thread;
+	gchar *query;
+	gint n_calls;
+
+	thread = start_endpoint (TRACKER_SPARQL_CONNECTION_FLAGS_CACHE_SERVICE_RESULTS);
+
+	update_remote_title ("urn:cache:1", "a");
+	query = create_title_query ("urn:cache:1");
+	assert_title (query, "a");
+
+	/* The endpoint is not queried again, so changes are not seen */
+	update_remote_title ("urn:cache:1", "b");
+	n_calls = g_atomic_int_get (&n_endpoint_calls);
+	assert_title (query, "a");
+	g_assert_cmpint (g_atomic_int_get (&n_endpoint_calls), ==, n_calls);
+
+	g_free (query);
+	stop_endpoint (thread);
+}
+
+static void
+test_service_cache_expiry (void)
+{
+	GThread *thread;
+	gchar *query;
+
+	thread = start_endpoint (TRACKER_SPARQL_CONNECTION_FLAGS_CACHE_SERVICE_RESULTS);
+	tracker_sparql_connection_set_service_cache_limits (local, 1, 16 * 1024 * 1024);
+
+	update_remote_title ("urn:cache:1", "a");
+	query = create_title_query ("urn:cache:1");
+	assert_title (query, "a");
+
+	update_remote_title ("urn:cache:1", "b");
+	assert_title (query, "a");
+
+	g_usleep (1500 * G_TIME_SPAN_MILLISECOND);
+	assert_title (query, "b");
+
+	g_free (query);
+	stop_endpoint (thread);
+}
+
+static void
+test_service_cache_eviction (void)
+{
+	GThread *thread;
+	gchar *query1, *query2;
+
+	thread = start_endpoint (TRACKER_SPARQL_CONNECTION_FLAGS_CACHE_SERVICE_RESULTS);
+
+	/* Room for a single one row result */
+	tracker_sparql_connection_set_service_cache_limits (local, 60, 24);
+
+	update_remote_title ("urn:cache:1", "a");
+	update_remote_title ("urn:cache:2", "a");
+	query1 = create_title_query ("urn:cache:1");
+	query2 = create_title_query ("urn:cache:2");
+
+	assert_title (query1, "a");
+	assert_title (query2, "a");
+
+	/* The least recently used result was dropped */
+	update_remote_title ("urn:cache:1", "b");
+	update_remote_title ("urn:cache:2", "b");
+	assert_title (query2, "a");
+	assert_title (query1, "b");
+
+	/* Shrinking the cache drops everything that does not fit */
+	update_remote_title ("urn:cache:1", "c");
+	tracker_sparql_connection_set_service_cache_limits (local, 60, 0);
+	assert_title (query1, "c");
+
+	g_free (query1);
+	g_free (query2);
+	stop_endpoint (thread);
 }
 
 static void
@@ -324,6 +657,19 @@ main (int argc, char **argv)
 		g_free (testpath);
 	}
 
+	g_test_add_func ("/core/dbus/service/large-results",
+	                 test_service_large_results);
+	g_test_add_func ("/core/dbus/service/interleaved-cursors",
+	                 test_service_interleaved_cursors);
+	g_test_add_func ("/core/dbus/service/rescans",
+	                 test_service_rescans);
+	g_test_add_func ("/core/dbus/service/cache-hit",
+	                 test_service_cache_hit);
+	g_test_add_func ("/core/dbus/service/cache-expiry",
+	                 test_service_cache_expiry);
+	g_test_add_func ("/core/dbus/service/cache-eviction",
+	                 test_service_cache_eviction);
+
 	/* run tests */
 	result = g_test_run ();
 
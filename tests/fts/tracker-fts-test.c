@@ -25,12 +25,15 @@
 
 #include <tinysparql.h>
 
+#include "direct/tracker-direct.h"
+
 typedef struct _TestInfo TestInfo;
 
 struct _TestInfo {
 	const gchar *test_name;
 	gint number_of_queries;
 	gboolean expect_error;
+	TrackerSparqlConnectionFlags flags;
 };
 
 const TestInfo tests[] = {
@@ -39,6 +42,9 @@ const TestInfo tests[] = {
 	{ "consistency/partial-update", 2 },
 	{ "consistency/insert-or-replace", 2 },
 	{ "prefix/fts3prefix", 3 },
+	{ "prefix-index/fts3prefix", 3, FALSE,
+	  TRACKER_SPARQL_CONNECTION_FLAGS_FTS_ENABLE_PREFIX_INDEX |
+	  TRACKER_SPARQL_CONNECTION_FLAGS_FTS_ENABLE_STEMMER },
 	{ "limits/fts3limits", 4 },
 	{ "input/fts3input", 3 },
 	{ "input/object-variable", 2, TRUE },
@@ -80,7 +86,7 @@ test_sparql_query (gconstpointer test_data)
 
 	data_location = g_file_new_for_path (datadir);
 
-	conn = tracker_sparql_connection_new (TRACKER_SPARQL_CONNECTION_FLAGS_NONE,
+	conn = tracker_sparql_connection_new (test_info->flags,
 	                                      data_location, ontology,
 	                                      NULL, &error);
 	g_assert_no_error (error);
@@ -195,6 +201,89 @@ test_sparql_query (gconstpointer test_data)
 	g_free (path);
 }
 
+static void
+test_fts_rebuild (void)
+{
+	TrackerSparqlConnection *conn;
+	TrackerSparqlCursor *cursor;
+	GFile *ontology, *data_location;
+	GError *error = NULL;
+	TrackerDataManager *data_manager;
+	TrackerDBInterface *iface;
+	GString *update, *filler;
+	gchar *prefix, *path, *rm_command;
+	const gchar *datadir;
+	gint i, n_results = 0;
+
+	prefix = g_build_path (G_DIR_SEPARATOR_S, TOP_SRCDIR, "tests", "fts", NULL);
+	ontology = g_file_new_for_path (prefix);
+	g_free (prefix);
+
+	path = g_build_filename (g_get_tmp_dir (), "tracker-fts-test-XXXXXX", NULL);
+	datadir = g_mkdtemp_full (path, 0700);
+	data_location = g_file_new_for_path (datadir);
+
+	conn = tracker_sparql_connection_new (TRACKER_SPARQL_CONNECTION_FLAGS_NONE,
+	                                      data_location, ontology,
+	                                      NULL, &error);
+	g_assert_no_error (error);
+
+	/* Enough rows to span several rebuild batches, some of them
+	 * with enough text to split batches by size.
+	 */
+	filler = g_string_new (NULL);
+	for (i = 0; i < 1000; i++)
+		g_string_append (filler, " filler");
+
+	update = g_string_new ("INSERT {");
+	for (i = 0; i < 1000; i++) {
+		g_string_append_printf (update, " test:r%d a test:A ; test:p \"item %s%s\" .",
+		                        i, i % 2 == 0 ? "even" : "odd",
+		                        i % 5 == 0 ? filler->str : "");
+	}
+	g_string_append (update, " }");
+	g_string_free (filler, TRUE);
+
+	tracker_sparql_connection_update (conn, update->str, NULL, &error);
+	g_assert_no_error (error);
+	g_string_free (update, TRUE);
+
+	tracker_sparql_connection_close (conn);
+	g_object_unref (conn);
+
+	/* Changing FTS flags rebuilds the FTS index */
+	conn = tracker_sparql_connection_new (TRACKER_SPARQL_CONNECTION_FLAGS_FTS_ENABLE_UNACCENT,
+	                                      data_location, ontology,
+	                                      NULL, &error);
+	g_assert_no_error (error);
+
+	cursor = tracker_sparql_connection_query (conn,
+	                                          "SELECT ?r { ?r fts:match \"even\" }",
+	                                          NULL, &error);
+	g_assert_no_error (error);
+
+	while (tracker_sparql_cursor_next (cursor, NULL, &error))
+		n_results++;
+
+	g_assert_no_error (error);
+	g_assert_cmpint (n_results, ==, 500);
+
+	/* The rebuilt index matches its content */
+	data_manager = tracker_direct_connection_get_data_manager (TRACKER_DIRECT_CONNECTION (conn));
+	iface = tracker_data_manager_get_writable_db_interface (data_manager);
+	g_assert_true (tracker_data_manager_fts_integrity_check (data_manager, iface, NULL));
+
+	g_object_unref (cursor);
+	g_object_unref (conn);
+	g_object_unref (ontology);
+	g_object_unref (data_location);
+
+	rm_command = g_strdup_printf ("rm -R %s", datadir);
+	g_spawn_command_line_sync (rm_command, NULL, NULL, NULL, NULL);
+	g_free (rm_command);
+	g_free (path);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -212,6 +301,8 @@ main (int argc, char **argv)
 		g_free (testpath);
 	}
 
+	g_test_add_func ("/fts/rebuild", test_fts_rebuild);
+
 	/* run tests */
 	result = g_test_run ();
 
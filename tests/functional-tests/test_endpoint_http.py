@@ -120,6 +120,44 @@ class TestEndpointHttp(fixtures.TrackerCommandLineTestCase):
         data = json.loads(text)
         self.validate_ask_query_response(data)
 
+    def get_response_type(self, accept):
+        query = quote(self.example_ask_query())
+        request = Request(f"{self.address}?query={query}")
+        request.add_header("Accept", accept)
+        with urlopen(request) as response:
+            response.read()
+            return response.headers.get_content_type()
+
+    def test_http_accept_order(self):
+        """The format preferred by the client is used."""
+        self.assertEqual(
+            self.get_response_type(
+                "application/sparql-results+json, application/x-tinysparql-results;q=0.5"
+            ),
+            "application/sparql-results+json",
+        )
+        self.assertEqual(
+            self.get_response_type(
+                "application/sparql-results+xml;q=0.9, application/sparql-results+json"
+            ),
+            "application/sparql-results+json",
+        )
+        self.assertEqual(
+            self.get_response_type(
+                "application/sparql-results+json;q=0, application/sparql-results+xml;q=0.1"
+            ),
+            "application/sparql-results+xml",
+        )
+
+    def test_http_accept_binary_tie(self):
+        """The binary format breaks ties between equally preferred formats."""
+        self.assertEqual(
+            self.get_response_type(
+                "application/sparql-results+json, application/x-tinysparql-results"
+            ),
+            "application/x-tinysparql-results",
+        )
+
     def test_missing_accept_header(self):
         """Ensure error code when there is no valid response format specified."""
         query = "ASK { ?u a rdfs:Resource }"
@@ -125,6 +125,100 @@ class TestFTSFunctions(fixtures.TrackerSparqlDirectTest):
         """
         self.tracker.update(delete_sparql)
 
+    def test_fts_update_single_column(self):
+        """
+        1. Insert a Contact with 'abcdefxyz' as fullname and 'ghijklxyz' as nickname
+        2. Replace the nickname with 'mnopqrxyz'
+        3. Query fts:match for each of the terms
+           EXPECTED: The fullname is still indexed, the old nickname is not
+        4. Remove the created resource
+        """
+        self.tracker.update("""
+        INSERT {
+        <contact://test/fts-function/update/1> a nco:PersonContact ;
+                       nco:fullname 'abcdefxyz' ;
+                       nco:nickname 'ghijklxyz' .
+        }
+        """)
+
+        self.tracker.update("""
+        DELETE { <contact://test/fts-function/update/1> nco:nickname ?nick }
+        INSERT { <contact://test/fts-function/update/1> nco:nickname 'mnopqrxyz' }
+        WHERE { <contact://test/fts-function/update/1> nco:nickname ?nick }
+        """)
+
+        query = """
+        SELECT ?contact fts:offsets (?contact) WHERE {
+           ?contact a nco:PersonContact ;
+                fts:match '%s' .
+        }
+        """
+
+        results = self.tracker.query(query % "abcdefxyz")
+        self.assertEqual(len(results), 1)
+        self.assertEqual(results[0][1], "nco:fullname,0")
+
+        results = self.tracker.query(query % "ghijklxyz")
+        self.assertEqual(len(results), 0)
+
+        results = self.tracker.query(query % "mnopqrxyz")
+        self.assertEqual(len(results), 1)
+        self.assertEqual(results[0][1], "nco:nickname,0")
+
+        self.tracker.update("""
+        DELETE {
+        <contact://test/fts-function/update/1> a rdfs:Resource .
+        }
+        """)
+
+    def test_fts_update_shared_term(self):
+        """
+        1. Insert a Contact with 'sharedxyz alphaxyz' as fullname and 'weeklyxyz sharedxyz' as nickname
+        2. Replace the fullname with 'sharedxyz betaxyz'
+        3. Query fts:match for the shared and the replaced terms
+           EXPECTED: The term shared by both columns is still indexed on both
+        4. Remove the created resource
+        """
+        self.tracker.update("""
+        INSERT {
+        <contact://test/fts-function/update/2> a nco:PersonContact ;
+                       nco:fullname 'sharedxyz alphaxyz' ;
+                       nco:nickname 'weeklyxyz sharedxyz' .
+        }
+        """)
+
+        self.tracker.update("""
+        DELETE { <contact://test/fts-function/update/2> nco:fullname ?name }
+        INSERT { <contact://test/fts-function/update/2> nco:fullname 'sharedxyz betaxyz' }
+        WHERE { <contact://test/fts-function/update/2> nco:fullname ?name }
+        """)
+
+        query = """
+        SELECT ?contact fts:offsets (?contact) WHERE {
+           ?contact a nco:PersonContact ;
+                fts:match '%s' .
+        }
+        """
+
+        results = self.tracker.query(query % "sharedxyz")
+        self.assertEqual(len(results), 1)
+        self.assertEqual(results[0][1], "nco:fullname,0,nco:nickname,10")
+
+        results = self.tracker.query(query % "weeklyxyz")
+        self.assertEqual(len(results), 1)
+
+        results = self.tracker.query(query % "alphaxyz")
+        self.assertEqual(len(results), 0)
+
+        results = self.tracker.query(query % "betaxyz")
+        self.assertEqual(len(results), 1)
+
+        self.tracker.update("""
+        DELETE {
+        <contact://test/fts-function/update/2> a rdfs:Resource .
+        }
+        """)
+
 
 if __name__ == "__main__":
     fixtures.tracker_test_main()
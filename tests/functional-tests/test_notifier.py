@@ -185,6 +185,55 @@ class TrackerNotifierTests:
             self.assertNotIn(ev.get_urn(), urns)
             urns[ev.get_urn()] = 1
 
+    def test_06_filter_classes(self):
+        self.notifier.set_filter(["nmm:MusicPiece"], None)
+
+        self.tracker.update(
+            """
+            INSERT DATA {
+                <test://filtered-contact> a nco:PersonContact ; nco:fullname 'contact' .
+                <test://filtered-song> a nmm:MusicPiece ; nie:title 'song' .
+            }
+            """
+        )
+        self.__wait_for_signal()
+
+        # Only the music piece passes the filter
+        self.assertEqual(len(self.results_inserts), 1)
+        self.assertEqual(len(self.results_updates), 0)
+        self.assertEqual(len(self.results_deletes), 0)
+        assert self.results_inserts[0].get_urn() == "test://filtered-song"
+
+    def test_07_coalesce_events(self):
+        self.notifier.set_property("coalesce-interval", 500)
+
+        self.tracker.update(
+            """
+            INSERT DATA {
+                <test://coalesced-contact> a nco:PersonContact ; nco:fullname 'contact' .
+                <test://coalesced-removed> a nco:PersonContact ; nco:fullname 'removed' .
+            }
+            """
+        )
+        self.tracker.update(
+            """
+            DELETE DATA { <test://coalesced-contact> nco:fullname 'contact' } ;
+            INSERT DATA { <test://coalesced-contact> nco:fullname 'renamed' }
+            """
+        )
+        self.tracker.update(
+            """
+            DELETE DATA { <test://coalesced-removed> a rdfs:Resource }
+            """
+        )
+        self.__wait_for_signal()
+
+        # Creation and update are merged, the created and deleted resource is dropped
+        self.assertEqual(len(self.results_inserts), 1)
+        self.assertEqual(len(self.results_updates), 0)
+        self.assertEqual(len(self.results_deletes), 0)
+        assert self.results_inserts[0].get_urn() == "test://coalesced-contact"
+
 
 class TrackerLocalNotifierTest(fixtures.TrackerSparqlDirectTest, TrackerNotifierTests):
     """
@@ -0,0 +1,405 @@
+/*
+ * Copyright (C) 2026, Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <tinysparql.h>
+
+#include "tracker-deserializer.h"
+#include "tracker-serializer.h"
+#include "tracker-serializer-binary.h"
+
+static TrackerSparqlConnection *conn;
+
+static GBytes *
+serialize_query (const gchar *query)
+{
+	TrackerSparqlCursor *cursor;
+	GInputStream *serializer;
+	GOutputStream *ostream;
+	GError *error = NULL;
+
+	cursor = tracker_sparql_connection_query (conn, query, NULL, &error);
+	g_assert_no_error (error);
+
+	serializer = tracker_serializer_new (cursor,
+	                                     tracker_sparql_connection_get_namespace_manager (conn),
+	                                     TRACKER_SERIALIZER_FORMAT_BINARY);
+	ostream = g_memory_output_stream_new_resizable ();
+	g_output_stream_splice (ostream, serializer,
+	                        G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE |
+	                        G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+	                        NULL, &error);
+	g_assert_no_error (error);
+
+	g_object_unref (serializer);
+	g_object_unref (cursor);
+
+	return g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (ostream));
+}
+
+static TrackerSparqlCursor *
+deserialize_bytes (GBytes *bytes)
+{
+	TrackerSparqlCursor *cursor;
+	GInputStream *istream;
+
+	istream = g_memory_input_stream_new_from_bytes (bytes);
+	cursor = tracker_deserializer_new (istream,
+	                                   tracker_sparql_connection_get_namespace_manager (conn),
+	                                   TRACKER_SERIALIZER_FORMAT_BINARY);
+	g_object_unref (istream);
+
+	return cursor;
+}
+
+static TrackerSparqlCursor *
+roundtrip_query (const gchar *query)
+{
+	TrackerSparqlCursor *cursor;
+	GBytes *bytes;
+
+	bytes = serialize_query (query);
+	cursor = deserialize_bytes (bytes);
+	g_bytes_unref (bytes);
+
+	return cursor;
+}
+
+/* Reads the whole cursor, and returns the error it ended with */
+static GError *
+consume_cursor (TrackerSparqlCursor *cursor)
+{
+	GError *error = NULL;
+	gint i;
+
+	while (tracker_sparql_cursor_next (cursor, NULL, &error)) {
+		for (i = 0; i < tracker_sparql_cursor_get_n_columns (cursor); i++)
+			tracker_sparql_cursor_get_string (cursor, i, NULL);
+	}
+
+	return error;
+}
+
+static void
+test_binary_results_empty (void)
+{
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+
+	cursor = roundtrip_query ("SELECT ?a ?b { ?a a nfo:Document ; nie:title ?b }");
+	g_assert_cmpint (tracker_sparql_cursor_get_n_columns (cursor), ==, 2);
+	g_assert_cmpstr (tracker_sparql_cursor_get_variable_name (cursor, 0), ==, "a");
+	g_assert_cmpstr (tracker_sparql_cursor_get_variable_name (cursor, 1), ==, "b");
+
+	g_assert_false (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	g_object_unref (cursor);
+}
+
+static void
+test_binary_results_values (void)
+{
+	TrackerSparqlCursor *cursor;
+	GDateTime *datetime;
+	GError *error = NULL;
+
+	cursor = roundtrip_query ("SELECT (<urn:a> AS ?a) (42 AS ?b) (1.5 AS ?c) (true AS ?d) "
+	                          "       ('2026-01-01T10:00:00+02:00'^^xsd:dateTime AS ?e) "
+	                          "       ('hola' AS ?f) { }");
+
+	g_assert_true (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 0), ==, TRACKER_SPARQL_VALUE_TYPE_URI);
+	g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 0, NULL), ==, "urn:a");
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 1), ==, TRACKER_SPARQL_VALUE_TYPE_INTEGER);
+	g_assert_cmpint (tracker_sparql_cursor_get_integer (cursor, 1), ==, 42);
+	g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 1, NULL), ==, "42");
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 2), ==, TRACKER_SPARQL_VALUE_TYPE_DOUBLE);
+	g_assert_cmpfloat (tracker_sparql_cursor_get_double (cursor, 2), ==, 1.5);
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 3), ==, TRACKER_SPARQL_VALUE_TYPE_BOOLEAN);
+	g_assert_true (tracker_sparql_cursor_get_boolean (cursor, 3));
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 4), ==, TRACKER_SPARQL_VALUE_TYPE_DATETIME);
+
+	datetime = tracker_sparql_cursor_get_datetime (cursor, 4);
+	g_assert_nonnull (datetime);
+	g_assert_cmpint (g_date_time_to_unix (datetime), ==, 1767254400);
+	g_assert_cmpint (g_date_time_get_utc_offset (datetime), ==, 2 * G_TIME_SPAN_HOUR);
+	g_date_time_unref (datetime);
+
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 5), ==, TRACKER_SPARQL_VALUE_TYPE_STRING);
+	g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 5, NULL), ==, "hola");
+
+	g_assert_false (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	g_object_unref (cursor);
+}
+
+static void
+test_binary_results_unbound (void)
+{
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+
+	/* The second column is unbound in all rows, and left
+	 * out of the block entirely.
+	 */
+	cursor = roundtrip_query ("SELECT ?a ?b ?c { "
+	                          "  VALUES (?a ?b ?c) { (1 UNDEF UNDEF) (UNDEF UNDEF 'x') } "
+	                          "}");
+
+	g_assert_true (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	g_assert_cmpint (tracker_sparql_cursor_get_integer (cursor, 0), ==, 1);
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 1), ==, TRACKER_SPARQL_VALUE_TYPE_UNBOUND);
+	g_assert_null (tracker_sparql_cursor_get_string (cursor, 1, NULL));
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 2), ==, TRACKER_SPARQL_VALUE_TYPE_UNBOUND);
+	g_assert_null (tracker_sparql_cursor_get_string (cursor, 2, NULL));
+
+	g_assert_true (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 0), ==, TRACKER_SPARQL_VALUE_TYPE_UNBOUND);
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 1), ==, TRACKER_SPARQL_VALUE_TYPE_UNBOUND);
+	g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 2, NULL), ==, "x");
+
+	g_assert_false (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	g_object_unref (cursor);
+}
+
+static void
+test_binary_results_langstring (void)
+{
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+	const gchar *str, *langtag;
+	glong len;
+
+	cursor = roundtrip_query ("SELECT ('hola'@es AS ?a) ('hello' AS ?b) { }");
+
+	g_assert_true (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+
+	str = tracker_sparql_cursor_get_langstring (cursor, 0, &langtag, &len);
+	g_assert_cmpstr (str, ==, "hola");
+	g_assert_cmpstr (langtag, ==, "es");
+	g_assert_cmpint (len, ==, 4);
+
+	str = tracker_sparql_cursor_get_langstring (cursor, 1, &langtag, &len);
+	g_assert_cmpstr (str, ==, "hello");
+	g_assert_null (langtag);
+
+	g_object_unref (cursor);
+}
+
+static void
+test_binary_results_many_rows (void)
+{
+	TrackerSparqlCursor *cursor, *expected;
+	GError *error = NULL;
+	gint n_rows = 0;
+
+	/* Enough rows to span several blocks, with repeated IRIs */
+#define MANY_ROWS_QUERY \
+	"SELECT ?a ?b { ?a a nfo:Document . ?b a nfo:Document } ORDER BY ?a ?b"
+
+	cursor = roundtrip_query (MANY_ROWS_QUERY);
+	expected = tracker_sparql_connection_query (conn, MANY_ROWS_QUERY, NULL, &error);
+	g_assert_no_error (error);
+
+	while (tracker_sparql_cursor_next (expected, NULL, &error)) {
+		g_assert_no_error (error);
+		g_assert_true (tracker_sparql_cursor_next (cursor, NULL, &error));
+		g_assert_no_error (error);
+
+		g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 0, NULL), ==,
+		                 tracker_sparql_cursor_get_string (expected, 0, NULL));
+		g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 1, NULL), ==,
+		                 tracker_sparql_cursor_get_string (expected, 1, NULL));
+		n_rows++;
+	}
+
+	g_assert_no_error (error);
+	g_assert_false (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	g_assert_cmpint (n_rows, ==, 50 * 50);
+
+	g_object_unref (expected);
+	g_object_unref (cursor);
+}
+
+static void
+test_binary_results_truncated (void)
+{
+	TrackerSparqlCursor *cursor;
+	GBytes *bytes, *truncated;
+	GError *error;
+	gsize i;
+
+	bytes = serialize_query ("SELECT ?a ?b ('x'@en AS ?c) 1.5 { "
+	                         "  ?a a nfo:Document . OPTIONAL { ?a nie:title ?b } "
+	                         "} LIMIT 3");
+
+	/* Every truncation of the stream must end in an error */
+	for (i = 0; i < g_bytes_get_size (bytes); i++) {
+		truncated = g_bytes_new_from_bytes (bytes, 0, i);
+		cursor = deserialize_bytes (truncated);
+
+		error = consume_cursor (cursor);
+		g_assert_error (error, TRACKER_SPARQL_ERROR, TRACKER_SPARQL_ERROR_PARSE);
+		g_error_free (error);
+
+		g_object_unref (cursor);
+		g_bytes_unref (truncated);
+	}
+
+	/* But not the full stream */
+	cursor = deserialize_bytes (bytes);
+	error = consume_cursor (cursor);
+	g_assert_no_error (error);
+	g_object_unref (cursor);
+
+	g_bytes_unref (bytes);
+}
+
+static GByteArray *
+create_header (void)
+{
+	const guint8 header_data[] = { 1, 1, 'a', '\0' };
+	GByteArray *data;
+	guint32 len;
+
+	data = g_byte_array_new ();
+	g_byte_array_append (data,
+	                     (const guint8 *) TRACKER_BINARY_RESULTS_MAGIC,
+	                     TRACKER_BINARY_RESULTS_MAGIC_LEN);
+	g_byte_array_append (data, (const guint8 *) "\1", 1);
+	len = GUINT32_TO_LE (sizeof (header_data));
+	g_byte_array_append (data, (const guint8 *) &len, sizeof (len));
+	g_byte_array_append (data, header_data, sizeof (header_data));
+
+	return data;
+}
+
+static void
+check_corrupted (GByteArray *data)
+{
+	TrackerSparqlCursor *cursor;
+	GBytes *bytes;
+	GError *error;
+
+	bytes = g_byte_array_free_to_bytes (data);
+	cursor = deserialize_bytes (bytes);
+
+	error = consume_cursor (cursor);
+	g_assert_error (error, TRACKER_SPARQL_ERROR, TRACKER_SPARQL_ERROR_PARSE);
+	g_error_free (error);
+
+	g_object_unref (cursor);
+	g_bytes_unref (bytes);
+}
+
+static void
+test_binary_results_oversized (void)
+{
+	const guint8 block_data[] = {
+		/* 65536 rows, first column present, a single value */
+		0x80, 0x80, 0x04, 0x01, TRACKER_BINARY_VALUE_TRUE,
+	};
+	GByteArray *data;
+	guint32 len;
+
+	/* Block lengths over the limit are rejected upfront */
+	data = create_header ();
+	len = GUINT32_TO_LE (G_MAXUINT32);
+	g_byte_array_append (data, (const guint8 *) &len, sizeof (len));
+	check_corrupted (data);
+
+	/* Announcing a large block does not mean it arrives */
+	data = create_header ();
+	len = GUINT32_TO_LE (1000 * 1000 * 1000);
+	g_byte_array_append (data, (const guint8 *) &len, sizeof (len));
+	g_byte_array_append (data, block_data, sizeof (block_data));
+	check_corrupted (data);
+
+	/* Row counts must match the values in the block */
+	data = create_header ();
+	len = GUINT32_TO_LE (sizeof (block_data));
+	g_byte_array_append (data, (const guint8 *) &len, sizeof (len));
+	g_byte_array_append (data, block_data, sizeof (block_data));
+	len = 0;
+	g_byte_array_append (data, (const guint8 *) &len, sizeof (len));
+	check_corrupted (data);
+}
+
+static void
+create_connection (void)
+{
+	GFile *ontology;
+	GString *str;
+	GError *error = NULL;
+	guint i;
+
+	ontology = tracker_sparql_get_ontology_nepomuk ();
+	conn = tracker_sparql_connection_new (0, NULL, ontology, NULL, &error);
+	g_assert_no_error (error);
+	g_object_unref (ontology);
+
+	str = g_string_new ("INSERT DATA { ");
+	for (i = 0; i < 50; i++)
+		g_string_append_printf (str, "<urn:doc:%u> a nfo:Document . ", i);
+	g_string_append (str, "}");
+
+	tracker_sparql_connection_update (conn, str->str, NULL, &error);
+	g_assert_no_error (error);
+	g_string_free (str, TRUE);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	gint retval;
+
+	g_test_init (&argc, &argv, NULL);
+
+	create_connection ();
+
+	g_test_add_func ("/libtracker-sparql/binary-results/empty",
+	                 test_binary_results_empty);
+	g_test_add_func ("/libtracker-sparql/binary-results/values",
+	                 test_binary_results_values);
+	g_test_add_func ("/libtracker-sparql/binary-results/unbound",
+	                 test_binary_results_unbound);
+	g_test_add_func ("/libtracker-sparql/binary-results/langstring",
+	                 test_binary_results_langstring);
+	g_test_add_func ("/libtracker-sparql/binary-results/many-rows",
+	                 test_binary_results_many_rows);
+	g_test_add_func ("/libtracker-sparql/binary-results/truncated",
+	                 test_binary_results_truncated);
+	g_test_add_func ("/libtracker-sparql/binary-results/oversized",
+	                 test_binary_results_oversized);
+
+	retval = g_test_run ();
+
+	g_object_unref (conn);
+
+	return retval;
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2026, Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include <glib-unix.h>
+#include <gio/gunixinputstream.h>
+#include <tinysparql.h>
+
+#include "tracker-deserializer.h"
+#include "bus/tracker-bus-cursor.h"
+
+/* Frames are written by hand in TRACKER_BUS_CURSOR_FORMAT_FRAMES,
+ * with a single row and a single string column each.
+ */
+static void
+write_all (gint           fd,
+           gconstpointer  data,
+           gsize          size)
+{
+	g_assert_cmpint (write (fd, data, size), ==, size);
+}
+
+static void
+write_frame_header (gint         fd,
+                    const gchar *value)
+{
+	TrackerBusFrameHeader header = { 0, };
+
+	if (value) {
+		header.n_rows = 1;
+		header.data_size = strlen (value) + 1;
+	}
+
+	write_all (fd, &header, sizeof (header));
+}
+
+static void
+write_frame (gint         fd,
+             const gchar *value)
+{
+	guint32 offset = strlen (value) + 1;
+	guint8 type = TRACKER_SPARQL_VALUE_TYPE_STRING;
+
+	write_frame_header (fd, value);
+	write_all (fd, &offset, sizeof (offset));
+	write_all (fd, &type, sizeof (type));
+	write_all (fd, value, offset);
+}
+
+static TrackerSparqlCursor *
+create_cursor (gint *write_fd)
+{
+	const gchar *variables[] = { "a", NULL };
+	GInputStream *stream;
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+	gint fds[2];
+
+	g_unix_open_pipe (fds, FD_CLOEXEC, &error);
+	g_assert_no_error (error);
+
+	stream = g_unix_input_stream_new (fds[0], TRUE);
+	cursor = tracker_bus_cursor_new (stream,
+	                                 g_variant_new_strv (variables, -1),
+	                                 TRACKER_BUS_CURSOR_FORMAT_FRAMES);
+	g_object_unref (stream);
+
+	*write_fd = fds[1];
+
+	return cursor;
+}
+
+static void
+assert_next_string (TrackerSparqlCursor *cursor,
+                    const gchar         *value)
+{
+	GError *error = NULL;
+
+	g_assert_true (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 0, NULL), ==, value);
+}
+
+static void
+test_bus_cursor_frames (void)
+{
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+	gint fd;
+
+	cursor = create_cursor (&fd);
+
+	write_frame (fd, "foo");
+	write_frame (fd, "bar");
+	write_frame (fd, "baz");
+	write_frame_header (fd, NULL);
+
+	assert_next_string (cursor, "foo");
+	assert_next_string (cursor, "bar");
+	assert_next_string (cursor, "baz");
+
+	g_assert_false (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+
+	tracker_sparql_cursor_close (cursor);
+	g_object_unref (cursor);
+	close (fd);
+}
+
+static void
+test_bus_cursor_single_frame (void)
+{
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+	gint fd;
+
+	cursor = create_cursor (&fd);
+
+	write_frame (fd, "foo");
+	write_frame_header (fd, NULL);
+
+	assert_next_string (cursor, "foo");
+
+	g_assert_false (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+
+	tracker_sparql_cursor_close (cursor);
+	g_object_unref (cursor);
+	close (fd);
+}
+
+static gpointer
+cancel_thread_func (gpointer user_data)
+{
+	g_usleep (100 * G_TIME_SPAN_MILLISECOND);
+	g_cancellable_cancel (user_data);
+
+	return NULL;
+}
+
+static void
+test_bus_cursor_cancel_read_ahead (void)
+{
+	TrackerSparqlCursor *cursor;
+	GCancellable *cancellable;
+	GThread *thread;
+	GError *error = NULL;
+	gint fd;
+
+	cursor = create_cursor (&fd);
+
+	/* Leave the second frame incomplete, so the read ahead blocks */
+	write_frame (fd, "foo");
+	write_frame_header (fd, "bar");
+
+	assert_next_string (cursor, "foo");
+
+	cancellable = g_cancellable_new ();
+	thread = g_thread_new ("cancel", cancel_thread_func, cancellable);
+
+	g_assert_false (tracker_sparql_cursor_next (cursor, cancellable, &error));
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_clear_error (&error);
+
+	g_thread_join (thread);
+	g_object_unref (cancellable);
+
+	tracker_sparql_cursor_close (cursor);
+	g_object_unref (cursor);
+	close (fd);
+}
+
+static void
+test_bus_cursor_close_read_ahead (void)
+{
+	TrackerSparqlCursor *cursor;
+	gint fd;
+
+	cursor = create_cursor (&fd);
+
+	/* Leave the second frame incomplete, so the read ahead blocks */
+	write_frame (fd, "foo");
+	write_frame_header (fd, "bar");
+
+	assert_next_string (cursor, "foo");
+
+	tracker_sparql_cursor_close (cursor);
+	g_object_unref (cursor);
+	close (fd);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/libtracker-sparql/bus-cursor/frames",
+	                 test_bus_cursor_frames);
+	g_test_add_func ("/libtracker-sparql/bus-cursor/single-frame",
+	                 test_bus_cursor_single_frame);
+	g_test_add_func ("/libtracker-sparql/bus-cursor/cancel-read-ahead",
+	                 test_bus_cursor_cancel_read_ahead);
+	g_test_add_func ("/libtracker-sparql/bus-cursor/close-read-ahead",
+	                 test_bus_cursor_close_read_ahead);
+
+	return g_test_run ();
+}
@@ -38,8 +38,11 @@ static int http_port;
 static TrackerSparqlConnection *direct;
 static TrackerSparqlConnection *dbus;
 static TrackerSparqlConnection *http;
+static TrackerSparqlConnection *p2p;
 static TrackerEndpointDBus *endpoint_bus;
+static TrackerEndpointDBus *endpoint_p2p;
 static TrackerEndpointHttp *endpoint_http;
+static GMainContext *endpoint_context;
 gboolean started = FALSE;
 
 static GMainLoop *main_loop;
@@ -172,6 +175,16 @@ test_tracker_sparql_query_iterate_largerow (gpointer      fixture,
 	query_and_compare_results (conn, "SELECT nao:identifier(?r) WHERE {?r a nmm:Photo}");
 }
 
+static void
+test_tracker_sparql_query_iterate_many_rows (gpointer      fixture,
+                                             gconstpointer user_data)
+{
+	TrackerSparqlConnection *conn = (TrackerSparqlConnection *) user_data;
+
+	/* Spans over several frames on D-Bus connections */
+	query_and_compare_results (conn, "SELECT ?s ?p ?o WHERE { ?s ?p ?o } ORDER BY ?s ?p ?o");
+}
+
 /* Runs an invalid query */
 static void
 test_tracker_sparql_query_iterate_error (gpointer      fixture,
@@ -393,6 +406,7 @@ thread_func (gpointer user_data)
 
 	context = g_main_context_new ();
 	g_main_context_push_thread_default (context);
+	endpoint_context = context;
 
 	main_loop = g_main_loop_new (context, FALSE);
 
@@ -436,6 +450,14 @@ thread_func (gpointer user_data)
 		g_assert_null (tracker_endpoint_get_allowed_graphs (TRACKER_ENDPOINT (endpoint_bus)));
 	}
 
+	endpoint_p2p = g_initable_new (TRACKER_TYPE_ENDPOINT_DBUS, NULL, &error,
+	                               "dbus-connection", dbus_conn,
+	                               "sparql-connection", direct,
+	                               "object-path", "/org/freedesktop/Tracker3/PeerEndpoint",
+	                               "peer-to-peer", TRUE,
+	                               NULL);
+	g_assert_no_error (error);
+
 	endpoint_http = tracker_endpoint_http_new (direct, http_port, NULL, NULL, &error);
 	g_assert_no_error (error);
 
@@ -537,6 +559,11 @@ create_connections (void)
 		g_clear_pointer (&object_dbus_path, g_free);
 	}
 
+	p2p = tracker_sparql_connection_bus_new (g_dbus_connection_get_unique_name (dbus_conn),
+	                                         "/org/freedesktop/Tracker3/PeerEndpoint",
+	                                         dbus_conn, &error);
+	g_assert_no_error (error);
+
 	g_thread_unref (thread);
 }
 
@@ -656,6 +683,145 @@ test_tracker_sparql_cursor_next_async (gpointer      fixture,
 	g_clear_pointer (&main_loop, g_main_loop_unref);
 }
 
+typedef struct {
+	GMainLoop *main_loop;
+	gboolean has_row;
+	GError *error;
+} NextData;
+
+static void
+cursor_next_cb (GObject      *source,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+	NextData *data = user_data;
+
+	data->has_row = tracker_sparql_cursor_next_finish (TRACKER_SPARQL_CURSOR (source),
+	                                                   result, &data->error);
+	g_main_loop_quit (data->main_loop);
+}
+
+static gboolean
+cursor_next_async_and_wait (TrackerSparqlCursor *cursor,
+                            NextData            *data)
+{
+	tracker_sparql_cursor_next_async (cursor, NULL, cursor_next_cb, data);
+	g_main_loop_run (data->main_loop);
+	g_assert_no_error (data->error);
+
+	return data->has_row;
+}
+
+static void
+test_tracker_sparql_cursor_next_async_many_rows (gpointer      fixture,
+                                                 gconstpointer user_data)
+{
+	TrackerSparqlConnection *conn = (TrackerSparqlConnection *) user_data;
+	const gchar *query = "SELECT ?s ?p ?o WHERE { ?s ?p ?o } ORDER BY ?s ?p ?o";
+	TrackerSparqlCursor *cursor_check, *cursor;
+	NextData data = { 0, };
+	GError *error = NULL;
+	gint n_rows = 0, col;
+
+	cursor_check = tracker_sparql_connection_query (direct, query, NULL, &error);
+	g_assert_no_error (error);
+
+	cursor = tracker_sparql_connection_query (conn, query, NULL, &error);
+	g_assert_no_error (error);
+
+	data.main_loop = g_main_loop_new (NULL, FALSE);
+
+	/* Rows must come in order when mixing async and sync iteration */
+	while (TRUE) {
+		gboolean has_row;
+
+		if (n_rows % 100 == 99) {
+			has_row = tracker_sparql_cursor_next (cursor, NULL, &error);
+			g_assert_no_error (error);
+		} else {
+			has_row = cursor_next_async_and_wait (cursor, &data);
+		}
+
+		g_assert_cmpint (has_row, ==, tracker_sparql_cursor_next (cursor_check, NULL, NULL));
+
+		if (!has_row)
+			break;
+
+		for (col = 0; col < 3; col++) {
+			g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, col, NULL),
+			                 ==,
+			                 tracker_sparql_cursor_get_string (cursor_check, col, NULL));
+		}
+
+		n_rows++;
+	}
+
+	g_assert_cmpint (n_rows, >, 0);
+
+	g_main_loop_unref (data.main_loop);
+	g_object_unref (cursor_check);
+	g_object_unref (cursor);
+}
+
+#define FETCH_ROWS 64
+#define FETCH_COLUMNS 4
+
+static void
+test_tracker_sparql_cursor_fetch_rows (gpointer      fixture,
+                                       gconstpointer user_data)
+{
+	TrackerSparqlConnection *conn = (TrackerSparqlConnection *) user_data;
+	const gchar *query = "SELECT ?s ?p ?o (1 AS ?one) WHERE { ?s ?p ?o } ORDER BY ?s ?p ?o";
+	TrackerSparqlValueType types[FETCH_ROWS * FETCH_COLUMNS];
+	gint64 integers[FETCH_ROWS * FETCH_COLUMNS];
+	const gchar *strings[FETCH_ROWS * FETCH_COLUMNS];
+	glong lengths[FETCH_ROWS * FETCH_COLUMNS];
+	TrackerSparqlCursor *cursor_check, *cursor;
+	GError *error = NULL;
+	gint n_rows, total = 0, row, col;
+
+	cursor_check = tracker_sparql_connection_query (direct, query, NULL, &error);
+	g_assert_no_error (error);
+
+	cursor = tracker_sparql_connection_query (conn, query, NULL, &error);
+	g_assert_no_error (error);
+
+	do {
+		n_rows = tracker_sparql_cursor_fetch_rows (cursor, FETCH_ROWS, FETCH_COLUMNS,
+		                                           types, integers, NULL,
+		                                           strings, lengths,
+		                                           NULL, &error);
+		g_assert_no_error (error);
+		g_assert_cmpint (n_rows, >=, 0);
+		g_assert_cmpint (n_rows, <=, FETCH_ROWS);
+
+		for (row = 0; row < n_rows; row++) {
+			g_assert_true (tracker_sparql_cursor_next (cursor_check, NULL, NULL));
+
+			for (col = 0; col < FETCH_COLUMNS; col++) {
+				gint cell = col * FETCH_ROWS + row;
+
+				g_assert_cmpint (types[cell], ==,
+				                 tracker_sparql_cursor_get_value_type (cursor_check, col));
+				g_assert_cmpstr (strings[cell], ==,
+				                 tracker_sparql_cursor_get_string (cursor_check, col, NULL));
+				g_assert_cmpint (lengths[cell], ==,
+				                 strings[cell] ? strlen (strings[cell]) : 0);
+			}
+
+			g_assert_cmpint (integers[3 * FETCH_ROWS + row], ==, 1);
+		}
+
+		total += n_rows;
+	} while (n_rows > 0);
+
+	g_assert_false (tracker_sparql_cursor_next (cursor_check, NULL, NULL));
+	g_assert_cmpint (total, >, FETCH_ROWS);
+
+	g_object_unref (cursor_check);
+	g_object_unref (cursor);
+}
+
 static void
 test_tracker_sparql_cursor_get_variable_name (gpointer      fixture,
                                               gconstpointer user_data)
@@ -862,6 +1028,193 @@ test_tracker_sparql_cursor_after_last_column (gpointer      fixture,
 	g_clear_object (&cursor);
 }
 
+typedef struct {
+	GMutex mutex;
+	GCond cond;
+	gboolean done;
+} RestartData;
+
+static gboolean
+restart_p2p_endpoint_cb (gpointer user_data)
+{
+	RestartData *data = user_data;
+	GDBusConnection *dbus_conn;
+	GError *error = NULL;
+
+	g_object_get (endpoint_p2p, "dbus-connection", &dbus_conn, NULL);
+
+	/* This closes the peer connections of all clients */
+	g_clear_object (&endpoint_p2p);
+
+	endpoint_p2p = g_initable_new (TRACKER_TYPE_ENDPOINT_DBUS, NULL, &error,
+	                               "dbus-connection", dbus_conn,
+	                               "sparql-connection", direct,
+	                               "object-path", "/org/freedesktop/Tracker3/PeerEndpoint",
+	                               "peer-to-peer", TRUE,
+	                               NULL);
+	g_assert_no_error (error);
+	g_object_unref (dbus_conn);
+
+	g_mutex_lock (&data->mutex);
+	data->done = TRUE;
+	g_cond_signal (&data->cond);
+	g_mutex_unlock (&data->mutex);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+test_tracker_sparql_p2p_peer_closed (void)
+{
+	TrackerSparqlCursor *cursor = NULL;
+	RestartData data = { 0, };
+	GError *error = NULL;
+	gboolean has_next;
+
+	g_mutex_init (&data.mutex);
+	g_cond_init (&data.cond);
+
+	g_main_context_invoke (endpoint_context, restart_p2p_endpoint_cb, &data);
+
+	g_mutex_lock (&data.mutex);
+	while (!data.done)
+		g_cond_wait (&data.cond, &data.mutex);
+	g_mutex_unlock (&data.mutex);
+
+	g_mutex_clear (&data.mutex);
+	g_cond_clear (&data.cond);
+
+	/* The first query after the connection is closed must already
+	 * reach the endpoint through the message bus.
+	 */
+	cursor = tracker_sparql_connection_query (p2p,
+	                                          "SELECT ('Hola' AS ?greeting) { }",
+	                                          NULL, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (cursor);
+
+	has_next = tracker_sparql_cursor_next (cursor, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_true (has_next);
+	g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 0, NULL), ==, "Hola");
+
+	tracker_sparql_cursor_close (cursor);
+	g_clear_object (&cursor);
+
+	/* Following queries keep working */
+	cursor = tracker_sparql_connection_query (p2p,
+	                                          "SELECT ('Adios' AS ?greeting) { }",
+	                                          NULL, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (cursor);
+
+	has_next = tracker_sparql_cursor_next (cursor, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_true (has_next);
+	g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 0, NULL), ==, "Adios");
+
+	tracker_sparql_cursor_close (cursor);
+	g_clear_object (&cursor);
+}
+
+static void
+test_tracker_sparql_p2p_unauthorized_peer (void)
+{
+	GDBusConnection *dbus_conn, *peer_conn;
+	GVariant *reply;
+	GError *error = NULL;
+	gchar *address, *token;
+
+	dbus_conn = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+	g_assert_no_error (error);
+
+	reply = g_dbus_connection_call_sync (dbus_conn,
+	                                     g_dbus_connection_get_unique_name (dbus_conn),
+	                                     "/org/freedesktop/Tracker3/PeerEndpoint",
+	                                     "org.freedesktop.Tracker3.Endpoint",
+	                                     "GetPeerAddress",
+	                                     NULL,
+	                                     G_VARIANT_TYPE ("(ss)"),
+	                                     G_DBUS_CALL_FLAGS_NONE,
+	                                     -1, NULL, &error);
+	g_assert_no_error (error);
+	g_variant_get (reply, "(ss)", &address, &token);
+	g_variant_unref (reply);
+	g_assert_cmpstr (address, !=, "");
+	g_assert_cmpstr (token, !=, "");
+
+	peer_conn = g_dbus_connection_new_for_address_sync (address,
+	                                                    G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+	                                                    NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	/* Calls are refused until the peer presents a valid token */
+	reply = g_dbus_connection_call_sync (peer_conn, NULL,
+	                                     "/org/freedesktop/Tracker3/PeerEndpoint",
+	                                     "org.freedesktop.Tracker3.Endpoint",
+	                                     "Prepare",
+	                                     g_variant_new ("(s)", "SELECT ('Hola' AS ?greeting) { }"),
+	                                     NULL,
+	                                     G_DBUS_CALL_FLAGS_NONE,
+	                                     -1, NULL, &error);
+	g_assert_error (error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED);
+	g_assert_null (reply);
+	g_clear_error (&error);
+
+	reply = g_dbus_connection_call_sync (peer_conn, NULL,
+	                                     "/org/freedesktop/Tracker3/PeerEndpoint",
+	                                     "org.freedesktop.Tracker3.Endpoint",
+	                                     "AuthorizePeer",
+	                                     g_variant_new ("(s)", "bogus"),
+	                                     NULL,
+	                                     G_DBUS_CALL_FLAGS_NONE,
+	                                     -1, NULL, &error);
+	g_assert_error (error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED);
+	g_assert_null (reply);
+	g_clear_error (&error);
+
+	reply = g_dbus_connection_call_sync (peer_conn, NULL,
+	                                     "/org/freedesktop/Tracker3/PeerEndpoint",
+	                                     "org.freedesktop.Tracker3.Endpoint",
+	                                     "AuthorizePeer",
+	                                     g_variant_new ("(s)", token),
+	                                     NULL,
+	                                     G_DBUS_CALL_FLAGS_NONE,
+	                                     -1, NULL, &error);
+	g_assert_no_error (error);
+	g_variant_unref (reply);
+
+	reply = g_dbus_connection_call_sync (peer_conn, NULL,
+	                                     "/org/freedesktop/Tracker3/PeerEndpoint",
+	                                     "org.freedesktop.Tracker3.Endpoint",
+	                                     "Prepare",
+	                                     g_variant_new ("(s)", "SELECT ('Hola' AS ?greeting) { }"),
+	                                     NULL,
+	                                     G_DBUS_CALL_FLAGS_NONE,
+	                                     -1, NULL, &error);
+	g_assert_no_error (error);
+	g_variant_unref (reply);
+
+	/* Tokens are single use */
+	reply = g_dbus_connection_call_sync (peer_conn, NULL,
+	                                     "/org/freedesktop/Tracker3/PeerEndpoint",
+	                                     "org.freedesktop.Tracker3.Endpoint",
+	                                     "AuthorizePeer",
+	                                     g_variant_new ("(s)", token),
+	                                     NULL,
+	                                     G_DBUS_CALL_FLAGS_NONE,
+	                                     -1, NULL, &error);
+	g_assert_error (error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED);
+	g_assert_null (reply);
+	g_clear_error (&error);
+
+	g_dbus_connection_close_sync (peer_conn, NULL, NULL);
+	g_object_unref (peer_conn);
+	g_object_unref (dbus_conn);
+	g_free (address);
+	g_free (token);
+}
+
 typedef struct {
 	const gchar *name;
 	GTestFixtureFunc func;
@@ -870,12 +1223,15 @@ typedef struct {
 TestInfo tests[] = {
 	{ "tracker_sparql_query_iterate", test_tracker_sparql_query_iterate },
 	{ "tracker_sparql_query_iterate_largerow", test_tracker_sparql_query_iterate_largerow },
+	{ "tracker_sparql_query_iterate_many_rows", test_tracker_sparql_query_iterate_many_rows },
 	{ "tracker_sparql_query_iterate_error", test_tracker_sparql_query_iterate_error },
 	{ "tracker_sparql_query_iterate_empty", test_tracker_sparql_query_iterate_empty },
 	{ "tracker_sparql_query_iterate_close_early", test_tracker_sparql_query_iterate_close_early },
 	{ "tracker_sparql_query_iterate_async", test_tracker_sparql_query_iterate_async },
 	{ "tracker_sparql_query_iterate_async_cancel", test_tracker_sparql_query_iterate_async_cancel },
 	{ "tracker_sparql_cursor_next_async", test_tracker_sparql_cursor_next_async },
+	{ "tracker_sparql_cursor_next_async_many_rows", test_tracker_sparql_cursor_next_async_many_rows },
+	{ "tracker_sparql_cursor_fetch_rows", test_tracker_sparql_cursor_fetch_rows },
 	{ "tracker_sparql_cursor_get_variable_name", test_tracker_sparql_cursor_get_variable_name },
 	{ "tracker_sparql_cursor_get_value_type", test_tracker_sparql_cursor_get_value_type },
 	{ "tracker_sparql_cursor_get_langstring", test_tracker_sparql_cursor_get_langstring },
@@ -913,6 +1269,12 @@ main (gint argc, gchar **argv)
 	add_tests ("direct", direct);
 	add_tests ("dbus", dbus);
 	add_tests ("http", http);
+	add_tests ("p2p", p2p);
+
+	g_test_add_func ("/libtracker-sparql/cursor/p2p/unauthorized_peer",
+	                 test_tracker_sparql_p2p_unauthorized_peer);
+	g_test_add_func ("/libtracker-sparql/cursor/p2p/peer_closed",
+	                 test_tracker_sparql_p2p_peer_closed);
 
 	return g_test_run ();
 }
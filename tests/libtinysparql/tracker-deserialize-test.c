@@ -62,6 +62,12 @@ TestInfo tests[] = {
 	{ "json-ld/json-ld-langstring-3", "deserialize/json-ld-langstring-3.jsonld", "deserialize/langstring-1.rq", "deserialize/langstring-1.out", TRACKER_RDF_FORMAT_JSON_LD },
 	{ "json-ld/long-graph-1", "deserialize/json-ld-long-graph-1.jsonld", "deserialize/unterminated-1.rq", "deserialize/unterminated-1.out", TRACKER_RDF_FORMAT_JSON_LD, TRUE },
 	{ "json-ld/wrong-graph-1", "deserialize/json-ld-wrong-graph-1.jsonld", "deserialize/unterminated-1.rq", "deserialize/unterminated-1.out", TRACKER_RDF_FORMAT_JSON_LD, TRUE },
+	{ "n-triples/nt-1", "deserialize/nt-1.nt", "deserialize/ttl-1.rq", "deserialize/ttl-1.out", TRACKER_RDF_FORMAT_N_TRIPLES },
+	{ "n-triples/nt-bnode-1", "deserialize/nt-bnode-1.nt", "deserialize/ttl-bnode-1.rq", "deserialize/ttl-bnode-1.out", TRACKER_RDF_FORMAT_N_TRIPLES },
+	{ "n-triples/nt-langstring-1", "deserialize/nt-langstring-1.nt", "deserialize/langstring-1.rq", "deserialize/langstring-1.out", TRACKER_RDF_FORMAT_N_TRIPLES },
+	{ "n-triples/nt-unterminated-1", "deserialize/nt-unterminated-1.nt", "deserialize/unterminated-1.rq", "deserialize/unterminated-1.out", TRACKER_RDF_FORMAT_N_TRIPLES, TRUE },
+	{ "n-triples/nt-unterminated-2", "deserialize/nt-unterminated-2.nt", "deserialize/unterminated-1.rq", "deserialize/unterminated-1.out", TRACKER_RDF_FORMAT_N_TRIPLES, TRUE },
+	{ "n-quads/nq-1", "deserialize/nq-1.nq", "deserialize/trig-1.rq", "deserialize/trig-1.out", TRACKER_RDF_FORMAT_N_QUADS },
 };
 
 typedef struct {
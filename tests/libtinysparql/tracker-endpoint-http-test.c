@@ -0,0 +1,737 @@
+/*
+ * Copyright (C) 2026, Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <libsoup/soup.h>
+#include <tinysparql.h>
+
+#define N_RESOURCES 100
+#define COMMENT_SIZE 65536
+
+/* Quickly produces far more data than fits in socket buffers, the
+ * query is kept running for as long as the client does not read it.
+ */
+#define BLOCKING_QUERY \
+	"SELECT ?a ?c { " \
+	"  ?a a nfo:Document ; rdfs:comment ?c . ?b a nfo:Document " \
+	"}"
+
+#define QUICK_QUERY "ASK { ?u a rdfs:Resource }"
+
+static TrackerSparqlConnection *direct;
+static GMainContext *endpoint_context;
+static guint http_port;
+
+typedef struct {
+	SoupSession *session;
+	SoupMessage *message;
+	GInputStream *stream;
+	const gchar *tag;
+	gboolean done;
+	GPtrArray *order;
+} Response;
+
+typedef struct {
+	GMutex mutex;
+	GCond cond;
+	gboolean done;
+	GSourceFunc func;
+	gpointer data;
+} InvokeData;
+
+static gboolean
+invoke_cb (gpointer user_data)
+{
+	InvokeData *invoke = user_data;
+
+	invoke->func (invoke->data);
+
+	g_mutex_lock (&invoke->mutex);
+	invoke->done = TRUE;
+	g_cond_signal (&invoke->cond);
+	g_mutex_unlock (&invoke->mutex);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Runs a function in the endpoint thread, and waits for it */
+static void
+run_in_endpoint_context (GSourceFunc func,
+                         gpointer    data)
+{
+	InvokeData invoke = { 0, };
+
+	g_mutex_init (&invoke.mutex);
+	g_cond_init (&invoke.cond);
+	invoke.func = func;
+	invoke.data = data;
+
+	g_main_context_invoke (endpoint_context, invoke_cb, &invoke);
+
+	g_mutex_lock (&invoke.mutex);
+	while (!invoke.done)
+		g_cond_wait (&invoke.cond, &invoke.mutex);
+	g_mutex_unlock (&invoke.mutex);
+
+	g_mutex_clear (&invoke.mutex);
+	g_cond_clear (&invoke.cond);
+}
+
+typedef struct {
+	TrackerEndpointHttp *endpoint;
+	guint max_concurrent_queries;
+	guint max_queued_queries;
+	guint query_timeout;
+	GMutex mutex;
+	GCond cond;
+	gboolean finalized;
+} EndpointData;
+
+static gboolean
+create_endpoint_cb (gpointer user_data)
+{
+	EndpointData *data = user_data;
+	GError *error = NULL;
+
+	data->endpoint = g_initable_new (TRACKER_TYPE_ENDPOINT_HTTP, NULL, &error,
+	                                 "sparql-connection", direct,
+	                                 "http-port", http_port,
+	                                 "max-concurrent-queries", data->max_concurrent_queries,
+	                                 "max-queued-queries", data->max_queued_queries,
+	                                 "query-timeout", data->query_timeout,
+	                                 NULL);
+	g_assert_no_error (error);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+endpoint_finalized_cb (gpointer  user_data,
+                       GObject  *object)
+{
+	EndpointData *data = user_data;
+
+	g_mutex_lock (&data->mutex);
+	data->finalized = TRUE;
+	g_cond_signal (&data->cond);
+	g_mutex_unlock (&data->mutex);
+}
+
+static gboolean
+release_endpoint_cb (gpointer user_data)
+{
+	EndpointData *data = user_data;
+
+	g_object_weak_ref (G_OBJECT (data->endpoint),
+	                   endpoint_finalized_cb, data);
+	g_clear_object (&data->endpoint);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+create_endpoint (EndpointData *data)
+{
+	g_mutex_init (&data->mutex);
+	g_cond_init (&data->cond);
+	run_in_endpoint_context (create_endpoint_cb, data);
+}
+
+/* Drops the endpoint, and waits for it to be finalized */
+static void
+release_endpoint (EndpointData *data)
+{
+	gint64 end_time;
+
+	run_in_endpoint_context (release_endpoint_cb, data);
+
+	end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+
+	g_mutex_lock (&data->mutex);
+	while (!data->finalized) {
+		if (!g_cond_wait_until (&data->cond, &data->mutex, end_time))
+			break;
+	}
+	g_mutex_unlock (&data->mutex);
+
+	g_assert_true (data->finalized);
+
+	g_mutex_clear (&data->mutex);
+	g_cond_clear (&data->cond);
+}
+
+static SoupSession *
+create_session (const gchar *local_address)
+{
+	GInetAddress *inet_address;
+	GSocketAddress *address;
+	SoupSession *session;
+
+	inet_address = g_inet_address_new_from_string (local_address);
+	address = g_inet_socket_address_new (inet_address, 0);
+
+	/* Every request is sent on its own connection */
+	session = g_object_new (SOUP_TYPE_SESSION,
+	                        "local-address", address,
+	                        "max-conns", 64,
+	                        "max-conns-per-host", 64,
+	                        NULL);
+
+	g_object_unref (address);
+	g_object_unref (inet_address);
+
+	return session;
+}
+
+static void
+send_cb (GObject      *object,
+         GAsyncResult *res,
+         gpointer      user_data)
+{
+	Response *response = user_data;
+	GError *error = NULL;
+
+	response->stream = soup_session_send_finish (SOUP_SESSION (object),
+	                                             res, &error);
+	g_assert_no_error (error);
+	response->done = TRUE;
+
+	if (response->order)
+		g_ptr_array_add (response->order, response);
+}
+
+static Response *
+send_conditional_query (SoupSession *session,
+                        const gchar *query,
+                        const gchar *if_none_match,
+                        const gchar *tag,
+                        GPtrArray   *order)
+{
+	Response *response;
+	gchar *escaped, *uri;
+
+	escaped = g_uri_escape_string (query, NULL, FALSE);
+	uri = g_strdup_printf ("http://127.0.0.1:%u/sparql?query=%s",
+	                       http_port, escaped);
+
+	response = g_new0 (Response, 1);
+	response->session = session;
+	response->tag = tag;
+	response->order = order;
+	response->message = soup_message_new ("GET", uri);
+	soup_message_headers_append (soup_message_get_request_headers (response->message),
+	                             "Accept", "application/sparql-results+json");
+	if (if_none_match) {
+		soup_message_headers_append (soup_message_get_request_headers (response->message),
+		                             "If-None-Match", if_none_match);
+	}
+
+	soup_session_send_async (session, response->message,
+	                         G_PRIORITY_DEFAULT, NULL,
+	                         send_cb, response);
+	g_free (escaped);
+	g_free (uri);
+
+	return response;
+}
+
+static Response *
+send_query (SoupSession *session,
+            const gchar *query,
+            const gchar *tag,
+            GPtrArray   *order)
+{
+	return send_conditional_query (session, query, NULL, tag, order);
+}
+
+static void
+wait_response (Response *response)
+{
+	while (!response->done)
+		g_main_context_iteration (NULL, TRUE);
+}
+
+static guint
+get_status (Response *response)
+{
+	return soup_message_get_status (response->message);
+}
+
+static void
+response_free (Response *response)
+{
+	if (response->stream) {
+		g_input_stream_close (response->stream, NULL, NULL);
+		g_object_unref (response->stream);
+	}
+
+	g_object_unref (response->message);
+	g_free (response);
+}
+
+static void
+check_retry_after (Response *response)
+{
+	SoupMessageHeaders *headers;
+
+	headers = soup_message_get_response_headers (response->message);
+	g_assert_nonnull (soup_message_headers_get_one (headers, "Retry-After"));
+}
+
+static void
+test_endpoint_http_queue_timeout (void)
+{
+	EndpointData data = { 0, };
+	SoupSession *session;
+	Response *blocking, *queued;
+
+	/* The running query is stuck on writing its results before its
+	 * own budget expires, so it is not interrupted.
+	 */
+	data.max_concurrent_queries = 1;
+	data.query_timeout = 1000;
+	create_endpoint (&data);
+
+	session = create_session ("127.0.0.1");
+
+	blocking = send_query (session, BLOCKING_QUERY, "blocking", NULL);
+	wait_response (blocking);
+	g_assert_cmpuint (get_status (blocking), ==, SOUP_STATUS_OK);
+
+	/* Waiting for the running query takes this one over its budget */
+	queued = send_query (session, QUICK_QUERY, "queued", NULL);
+	wait_response (queued);
+	g_assert_cmpuint (get_status (queued), ==, SOUP_STATUS_TOO_MANY_REQUESTS);
+	check_retry_after (queued);
+
+	response_free (queued);
+	response_free (blocking);
+	g_object_unref (session);
+
+	release_endpoint (&data);
+}
+
+static void
+test_endpoint_http_queue_full (void)
+{
+	EndpointData data = { 0, };
+	SoupSession *session, *other_session;
+	Response *blocking, *first, *second, *other;
+	Response *queued, *rejected;
+
+	/* A single query may be on hold */
+	data.max_concurrent_queries = 1;
+	data.max_queued_queries = 1;
+	create_endpoint (&data);
+
+	session = create_session ("127.0.0.1");
+	other_session = create_session ("127.0.0.2");
+
+	blocking = send_query (session, BLOCKING_QUERY, "blocking", NULL);
+	wait_response (blocking);
+	g_assert_cmpuint (get_status (blocking), ==, SOUP_STATUS_OK);
+
+	/* Only one of these is put on hold, the other is over
+	 * the share of the queue of this address.
+	 */
+	first = send_query (session, QUICK_QUERY, "first", NULL);
+	second = send_query (session, QUICK_QUERY, "second", NULL);
+
+	while (!first->done && !second->done)
+		g_main_context_iteration (NULL, TRUE);
+
+	rejected = first->done ? first : second;
+	queued = first->done ? second : first;
+	g_assert_cmpuint (get_status (rejected), ==, SOUP_STATUS_TOO_MANY_REQUESTS);
+	check_retry_after (rejected);
+
+	/* The queue is full for everyone else */
+	other = send_query (other_session, QUICK_QUERY, "other", NULL);
+	wait_response (other);
+	g_assert_cmpuint (get_status (other), ==, SOUP_STATUS_SERVICE_UNAVAILABLE);
+	check_retry_after (other);
+
+	/* The query on hold runs after the blocking one */
+	response_free (blocking);
+	wait_response (queued);
+	g_assert_cmpuint (get_status (queued), ==, SOUP_STATUS_OK);
+
+	response_free (first);
+	response_free (second);
+	response_free (other);
+	g_object_unref (session);
+	g_object_unref (other_session);
+
+	release_endpoint (&data);
+}
+
+static void
+test_endpoint_http_queue_fairness (void)
+{
+	EndpointData data = { 0, };
+	SoupSession *sessions[2];
+	Response *blocking, *responses[2][4];
+	GPtrArray *order;
+	guint i, j, n_rejected[2] = { 0, };
+
+	/* Each address may hold 3 queries on hold */
+	data.max_concurrent_queries = 1;
+	data.max_queued_queries = 12;
+	create_endpoint (&data);
+
+	sessions[0] = create_session ("127.0.0.1");
+	sessions[1] = create_session ("127.0.0.2");
+	order = g_ptr_array_new ();
+
+	blocking = send_query (sessions[0], BLOCKING_QUERY, "blocking", NULL);
+	wait_response (blocking);
+	g_assert_cmpuint (get_status (blocking), ==, SOUP_STATUS_OK);
+
+	for (i = 0; i < G_N_ELEMENTS (sessions); i++) {
+		for (j = 0; j < G_N_ELEMENTS (responses[i]); j++) {
+			responses[i][j] = send_query (sessions[i], QUICK_QUERY,
+			                              i == 0 ? "first" : "second",
+			                              order);
+		}
+	}
+
+	/* Wait for the query over the share of each address to be
+	 * rejected, all others are on hold then.
+	 */
+	while (order->len < 2)
+		g_main_context_iteration (NULL, TRUE);
+
+	for (i = 0; i < order->len; i++) {
+		Response *response = g_ptr_array_index (order, i);
+
+		g_assert_cmpuint (get_status (response), ==, SOUP_STATUS_TOO_MANY_REQUESTS);
+		n_rejected[response->tag[0] == 'f' ? 0 : 1]++;
+	}
+
+	g_assert_cmpuint (n_rejected[0], ==, 1);
+	g_assert_cmpuint (n_rejected[1], ==, 1);
+
+	/* Queries on hold are taken in turns from each address */
+	g_ptr_array_set_size (order, 0);
+	response_free (blocking);
+
+	while (order->len < 6)
+		g_main_context_iteration (NULL, TRUE);
+
+	for (i = 0; i < order->len; i++) {
+		Response *response = g_ptr_array_index (order, i);
+
+		g_assert_cmpuint (get_status (response), ==, SOUP_STATUS_OK);
+
+		if (i > 0) {
+			Response *prev = g_ptr_array_index (order, i - 1);
+
+			g_assert_cmpstr (response->tag, !=, prev->tag);
+		}
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (sessions); i++) {
+		for (j = 0; j < G_N_ELEMENTS (responses[i]); j++)
+			response_free (responses[i][j]);
+
+		g_object_unref (sessions[i]);
+	}
+
+	g_ptr_array_unref (order);
+
+	release_endpoint (&data);
+}
+
+static void
+test_endpoint_http_release_busy (void)
+{
+	EndpointData data = { 0, };
+	SoupSession *session;
+	Response *blocking, *queued;
+
+	data.max_concurrent_queries = 1;
+	data.max_queued_queries = 4;
+	create_endpoint (&data);
+
+	session = create_session ("127.0.0.1");
+
+	blocking = send_query (session, BLOCKING_QUERY, "blocking", NULL);
+	wait_response (blocking);
+	g_assert_cmpuint (get_status (blocking), ==, SOUP_STATUS_OK);
+
+	queued = send_query (session, QUICK_QUERY, "queued", NULL);
+
+	/* Let the query be put on hold */
+	while (g_main_context_iteration (NULL, FALSE));
+
+	/* Queued queries do not keep the endpoint alive, running ones
+	 * do until they are done.
+	 */
+	run_in_endpoint_context (release_endpoint_cb, &data);
+	response_free (blocking);
+
+	wait_response (queued);
+	g_assert_true (get_status (queued) == SOUP_STATUS_OK ||
+	               get_status (queued) == SOUP_STATUS_SERVICE_UNAVAILABLE);
+
+	response_free (queued);
+	g_object_unref (session);
+
+	g_mutex_lock (&data.mutex);
+	while (!data.finalized)
+		g_cond_wait (&data.cond, &data.mutex);
+	g_mutex_unlock (&data.mutex);
+
+	g_mutex_clear (&data.mutex);
+	g_cond_clear (&data.cond);
+}
+
+static gchar *
+get_etag (Response *response)
+{
+	SoupMessageHeaders *headers;
+
+	headers = soup_message_get_response_headers (response->message);
+	return g_strdup (soup_message_headers_get_one (headers, "ETag"));
+}
+
+/* Sends a query and waits for it, returns its ETag */
+static gchar *
+query_etag (SoupSession *session,
+            const gchar *query,
+            const gchar *if_none_match,
+            guint        expected_status)
+{
+	Response *response;
+	gchar *etag;
+
+	response = send_conditional_query (session, query, if_none_match,
+	                                   NULL, NULL);
+	wait_response (response);
+	g_assert_cmpuint (get_status (response), ==, expected_status);
+	etag = get_etag (response);
+	response_free (response);
+
+	return etag;
+}
+
+static void
+test_endpoint_http_etag (void)
+{
+	EndpointData data = { 0, };
+	SoupSession *session;
+	gchar *etag, *other;
+
+	create_endpoint (&data);
+	session = create_session ("127.0.0.1");
+
+	etag = query_etag (session, QUICK_QUERY, NULL, SOUP_STATUS_OK);
+	g_assert_nonnull (etag);
+
+	/* Unmodified results are not sent again */
+	other = query_etag (session, QUICK_QUERY, etag, SOUP_STATUS_NOT_MODIFIED);
+	g_assert_cmpstr (other, ==, etag);
+	g_free (other);
+
+	other = query_etag (session, QUICK_QUERY, "*", SOUP_STATUS_NOT_MODIFIED);
+	g_assert_cmpstr (other, ==, etag);
+	g_free (other);
+
+	other = query_etag (session, QUICK_QUERY, "W/\"foo\"", SOUP_STATUS_OK);
+	g_assert_cmpstr (other, ==, etag);
+	g_free (other);
+
+	/* Other queries have other tags */
+	other = query_etag (session, "ASK { ?u a nfo:Document }", etag, SOUP_STATUS_OK);
+	g_assert_nonnull (other);
+	g_assert_cmpstr (other, !=, etag);
+	g_free (other);
+
+	g_free (etag);
+	g_object_unref (session);
+
+	release_endpoint (&data);
+}
+
+static void
+test_endpoint_http_etag_update (void)
+{
+	EndpointData data = { 0, };
+	SoupSession *session;
+	GError *error = NULL;
+	gchar *etag, *other;
+
+	create_endpoint (&data);
+	session = create_session ("127.0.0.1");
+
+	etag = query_etag (session, QUICK_QUERY, NULL, SOUP_STATUS_OK);
+	g_assert_nonnull (etag);
+
+	tracker_sparql_connection_update (direct,
+	                                  "INSERT DATA { <urn:etag:update> a rdfs:Resource }",
+	                                  NULL, &error);
+	g_assert_no_error (error);
+
+	/* Results are sent again after any modification */
+	other = query_etag (session, QUICK_QUERY, etag, SOUP_STATUS_OK);
+	g_assert_nonnull (other);
+	g_assert_cmpstr (other, !=, etag);
+	g_free (etag);
+	etag = other;
+
+	other = query_etag (session, QUICK_QUERY, etag, SOUP_STATUS_NOT_MODIFIED);
+	g_assert_cmpstr (other, ==, etag);
+	g_free (other);
+
+	g_free (etag);
+	g_object_unref (session);
+
+	release_endpoint (&data);
+}
+
+static void
+test_endpoint_http_etag_volatile (void)
+{
+	const gchar *volatile_queries[] = {
+		"SELECT (NOW() AS ?n) { }",
+		"SELECT ?u (RAND() AS ?r) { ?u a rdfs:Resource }",
+		"SELECT (UUID() AS ?u) (STRUUID() AS ?s) { }",
+		"SELECT (bnode () AS ?b) { }",
+		"SELECT ?u { SERVICE <http://127.0.0.1:1/sparql> { ?u a rdfs:Resource } }",
+	};
+	const gchar *deterministic_queries[] = {
+		"ASK { ?u rdfs:comment \"NOW() SERVICE RAND()\" }",
+		"SELECT ?now ?rand { ?now a rdfs:Resource ; rdfs:label ?rand }",
+	};
+	EndpointData data = { 0, };
+	SoupSession *session;
+	guint i;
+
+	create_endpoint (&data);
+	session = create_session ("127.0.0.1");
+
+	/* Only the parsed query counts, not its text */
+	for (i = 0; i < G_N_ELEMENTS (volatile_queries); i++) {
+		Response *response;
+		gchar *etag;
+
+		response = send_query (session, volatile_queries[i], NULL, NULL);
+		wait_response (response);
+		etag = get_etag (response);
+		g_assert_null (etag);
+		response_free (response);
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (deterministic_queries); i++) {
+		gchar *etag;
+
+		etag = query_etag (session, deterministic_queries[i], NULL, SOUP_STATUS_OK);
+		g_assert_nonnull (etag);
+		g_free (etag);
+	}
+
+	g_object_unref (session);
+
+	release_endpoint (&data);
+}
+
+static gboolean started = FALSE;
+
+static gpointer
+thread_func (gpointer user_data)
+{
+	GMainContext *context;
+	GMainLoop *main_loop;
+
+	context = g_main_context_new ();
+	g_main_context_push_thread_default (context);
+	endpoint_context = context;
+
+	main_loop = g_main_loop_new (context, FALSE);
+
+	g_atomic_int_set (&started, TRUE);
+	g_main_loop_run (main_loop);
+
+	g_main_context_pop_thread_default (context);
+	g_main_context_unref (context);
+
+	return NULL;
+}
+
+static void
+create_connection (void)
+{
+	GFile *ontology;
+	GString *str;
+	GError *error = NULL;
+	gchar *comment;
+	guint i;
+
+	ontology = tracker_sparql_get_ontology_nepomuk ();
+	direct = tracker_sparql_connection_new (0, NULL, ontology, NULL, &error);
+	g_assert_no_error (error);
+	g_object_unref (ontology);
+
+	comment = g_strnfill (COMMENT_SIZE, 'x');
+	str = g_string_new ("INSERT DATA { ");
+	for (i = 0; i < N_RESOURCES; i++) {
+		g_string_append_printf (str, "<urn:doc:%u> a nfo:Document ; rdfs:comment \"%s\" . ",
+		                        i, comment);
+	}
+	g_string_append (str, "}");
+	g_free (comment);
+
+	tracker_sparql_connection_update (direct, str->str, NULL, &error);
+	g_assert_no_error (error);
+	g_string_free (str, TRUE);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	GThread *thread;
+
+	g_test_init (&argc, &argv, NULL);
+
+	http_port = g_test_rand_int_range (30000, 60000);
+	create_connection ();
+
+	thread = g_thread_new (NULL, thread_func, NULL);
+	while (!g_atomic_int_get (&started))
+		g_usleep (100);
+	g_thread_unref (thread);
+
+	g_test_add_func ("/libtracker-sparql/endpoint-http/queue-timeout",
+	                 test_endpoint_http_queue_timeout);
+	g_test_add_func ("/libtracker-sparql/endpoint-http/queue-full",
+	                 test_endpoint_http_queue_full);
+	g_test_add_func ("/libtracker-sparql/endpoint-http/queue-fairness",
+	                 test_endpoint_http_queue_fairness);
+	g_test_add_func ("/libtracker-sparql/endpoint-http/release-busy",
+	                 test_endpoint_http_release_busy);
+	g_test_add_func ("/libtracker-sparql/endpoint-http/etag",
+	                 test_endpoint_http_etag);
+	g_test_add_func ("/libtracker-sparql/endpoint-http/etag-update",
+	                 test_endpoint_http_etag_update);
+	g_test_add_func ("/libtracker-sparql/endpoint-http/etag-volatile",
+	                 test_endpoint_http_etag_volatile);
+
+	return g_test_run ();
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026, Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <tinysparql.h>
+
+#include "direct/tracker-direct.h"
+
+#define N_RESOURCES 100
+
+/* Cross product of all resources, with a filter that cannot use
+ * indexes. Preparing it is fast, but stepping through it is not.
+ */
+#define SLOW_QUERY \
+	"SELECT ?a ?b ?c { " \
+	"  ?a a nfo:Document . ?b a nfo:Document . ?c a nfo:Document . " \
+	"  FILTER (CONCAT (STR (?a), STR (?b), STR (?c)) = 'none') " \
+	"}"
+
+#define FAST_QUERY \
+	"SELECT ?a { ?a a nfo:Document } LIMIT 1"
+
+static TrackerSparqlConnection *
+create_connection (void)
+{
+	TrackerSparqlConnection *conn;
+	GFile *ontology;
+	GString *str;
+	GError *error = NULL;
+	guint i;
+
+	ontology = tracker_sparql_get_ontology_nepomuk ();
+	conn = tracker_sparql_connection_new (0, NULL, ontology, NULL, &error);
+	g_assert_no_error (error);
+	g_object_unref (ontology);
+
+	str = g_string_new ("INSERT DATA { ");
+	for (i = 0; i < N_RESOURCES; i++)
+		g_string_append_printf (str, "<urn:doc:%u> a nfo:Document . ", i);
+	g_string_append (str, "}");
+
+	tracker_sparql_connection_update (conn, str->str, NULL, &error);
+	g_assert_no_error (error);
+	g_string_free (str, TRUE);
+
+	return conn;
+}
+
+static void
+query_cb (GObject      *source,
+          GAsyncResult *res,
+          gpointer      user_data)
+{
+	TrackerSparqlCursor **cursor = user_data;
+	GError *error = NULL;
+
+	*cursor = tracker_sparql_connection_query_finish (TRACKER_SPARQL_CONNECTION (source),
+	                                                  res, &error);
+	g_assert_no_error (error);
+}
+
+/* Costs are only tracked for queries going through the select pool */
+static void
+run_query (TrackerSparqlConnection *conn,
+           const gchar             *sparql)
+{
+	TrackerSparqlCursor *cursor = NULL;
+	GError *error = NULL;
+
+	tracker_sparql_connection_query_async (conn, sparql, NULL,
+	                                       query_cb, &cursor);
+
+	while (!cursor)
+		g_main_context_iteration (NULL, TRUE);
+
+	while (tracker_sparql_cursor_next (cursor, NULL, &error))
+		;
+
+	g_assert_no_error (error);
+	tracker_sparql_cursor_close (cursor);
+	g_object_unref (cursor);
+}
+
+static void
+test_query_cost_slow_query_demoted (void)
+{
+	TrackerDirectConnection *conn;
+
+	conn = TRACKER_DIRECT_CONNECTION (create_connection ());
+
+	g_assert_false (tracker_direct_connection_is_long_query (conn, SLOW_QUERY));
+	g_assert_false (tracker_direct_connection_is_long_query (conn, FAST_QUERY));
+
+	run_query (TRACKER_SPARQL_CONNECTION (conn), FAST_QUERY);
+	run_query (TRACKER_SPARQL_CONNECTION (conn), SLOW_QUERY);
+
+	/* Time spent stepping the cursor counts towards the cost */
+	g_assert_true (tracker_direct_connection_is_long_query (conn, SLOW_QUERY));
+	g_assert_false (tracker_direct_connection_is_long_query (conn, FAST_QUERY));
+
+	g_object_unref (conn);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/libtinysparql/query-cost/slow-query-demoted",
+	                 test_query_cost_slow_query_demoted);
+
+	return g_test_run ();
+}
@@ -42,6 +42,8 @@ TestInfo tests[] = {
 	{ "trig/single", "serialize/describe-single-trig.rq", "serialize/describe-single-trig.out", TRACKER_RDF_FORMAT_TRIG, NULL },
 	{ "trig/graph", "serialize/describe-graph-trig.rq", "serialize/describe-graph-trig.out", TRACKER_RDF_FORMAT_TRIG, NULL },
 	{ "trig/construct", "serialize/construct-trig.rq", "serialize/construct-trig.out", TRACKER_RDF_FORMAT_TRIG, NULL },
+	{ "n-triples/construct", "serialize/construct-nt.rq", "serialize/construct-nt.out", TRACKER_RDF_FORMAT_N_TRIPLES, NULL },
+	{ "n-quads/construct", "serialize/construct-nq.rq", "serialize/construct-nq.out", TRACKER_RDF_FORMAT_N_QUADS, NULL },
 };
 
 typedef struct {
@@ -79,6 +79,8 @@ typedef struct {
 
 static gboolean started = FALSE;
 static const gchar *bus_name = NULL;
+static TrackerEndpointDBus *endpoint_bus = NULL;
+static GMainContext *endpoint_context = NULL;
 
 static void
 check_result (TrackerSparqlCursor *cursor,
@@ -390,6 +392,101 @@ execute_async (TestFixture   *test_fixture,
 	g_clear_object (&stmt);
 }
 
+static void
+execute_rebind (TestFixture   *test_fixture,
+                gconstpointer  context)
+{
+	TrackerSparqlStatement *stmt;
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+	gint i;
+
+	stmt = tracker_sparql_connection_query_statement (test_fixture->conn,
+	                                                  "SELECT "
+	                                                  "  (~int AS ?int)"
+	                                                  "{ }",
+	                                                  NULL,
+	                                                  &error);
+	g_assert_no_error (error);
+
+	/* Statements are reused across executions */
+	for (i = 0; i < 10; i++) {
+		tracker_sparql_statement_bind_int (stmt, "int", i);
+
+		cursor = tracker_sparql_statement_execute (stmt, NULL, &error);
+		g_assert_no_error (error);
+
+		g_assert_true (tracker_sparql_cursor_next (cursor, NULL, &error));
+		g_assert_no_error (error);
+		g_assert_cmpint (tracker_sparql_cursor_get_integer (cursor, 0), ==, i);
+		g_object_unref (cursor);
+	}
+
+	g_clear_object (&stmt);
+}
+
+static void
+query_batch_cb (GObject      *source,
+                GAsyncResult *res,
+                gpointer      user_data)
+{
+	GPtrArray **cursors = user_data;
+	GError *error = NULL;
+
+	*cursors = tracker_sparql_connection_query_batch_finish (TRACKER_SPARQL_CONNECTION (source),
+	                                                         res, &error);
+	g_assert_no_error (error);
+}
+
+static void
+query_batch (TestFixture   *test_fixture,
+             gconstpointer  context)
+{
+	TrackerSparqlStatement *stmts[3];
+	GPtrArray *cursors = NULL;
+	GError *error = NULL;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (stmts); i++) {
+		stmts[i] = tracker_sparql_connection_query_statement (test_fixture->conn,
+		                                                      "SELECT "
+		                                                      "  (~int AS ?int)"
+		                                                      "{ }",
+		                                                      NULL,
+		                                                      &error);
+		g_assert_no_error (error);
+		tracker_sparql_statement_bind_int (stmts[i], "int", i * 10);
+	}
+
+	tracker_sparql_connection_query_batch_async (test_fixture->conn,
+	                                             stmts,
+	                                             G_N_ELEMENTS (stmts),
+	                                             NULL,
+	                                             query_batch_cb,
+	                                             &cursors);
+
+	while (!cursors)
+		g_main_context_iteration (NULL, TRUE);
+
+	g_assert_cmpuint (cursors->len, ==, G_N_ELEMENTS (stmts));
+
+	/* Cursors are returned in the order of the statements */
+	for (i = 0; i < cursors->len; i++) {
+		TrackerSparqlCursor *cursor = g_ptr_array_index (cursors, i);
+
+		g_assert_true (tracker_sparql_cursor_next (cursor, NULL, &error));
+		g_assert_no_error (error);
+		g_assert_cmpint (tracker_sparql_cursor_get_integer (cursor, 0), ==, i * 10);
+		g_assert_false (tracker_sparql_cursor_next (cursor, NULL, &error));
+		g_assert_no_error (error);
+	}
+
+	g_ptr_array_unref (cursors);
+
+	for (i = 0; i < G_N_ELEMENTS (stmts); i++)
+		g_object_unref (stmts[i]);
+}
+
 static void
 stmt_update (TestFixture   *test_fixture,
              gconstpointer  context)
@@ -587,18 +684,18 @@ static gpointer
 thread_func (gpointer user_data)
 {
 	StartupData *data = user_data;
-	TrackerEndpointDBus *endpoint;
 	TrackerEndpointHttp *endpoint_http;
 	GMainContext *context;
 	GMainLoop *main_loop;
 
 	context = g_main_context_new ();
 	g_main_context_push_thread_default (context);
+	endpoint_context = context;
 
 	main_loop = g_main_loop_new (context, FALSE);
 
-	endpoint = tracker_endpoint_dbus_new (data->direct, data->dbus_conn, NULL, NULL, NULL);
-	if (!endpoint)
+	endpoint_bus = tracker_endpoint_dbus_new (data->direct, data->dbus_conn, NULL, NULL, NULL);
+	if (!endpoint_bus)
 		return NULL;
 
 	endpoint_http = tracker_endpoint_http_new (data->direct, 54321, NULL, NULL, NULL);
@@ -646,6 +743,113 @@ create_connections (TrackerSparqlConnection **dbus,
 	return TRUE;
 }
 
+typedef struct {
+	GMutex mutex;
+	GCond cond;
+	gboolean done;
+} RestartData;
+
+static gboolean
+restart_endpoint_cb (gpointer user_data)
+{
+	RestartData *data = user_data;
+	TrackerSparqlConnection *direct;
+	GDBusConnection *dbus_conn;
+	GError *error = NULL;
+
+	g_object_get (endpoint_bus,
+	              "sparql-connection", &direct,
+	              "dbus-connection", &dbus_conn,
+	              NULL);
+
+	/* Prepared statements are lost with the endpoint */
+	g_clear_object (&endpoint_bus);
+	endpoint_bus = tracker_endpoint_dbus_new (direct, dbus_conn, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	g_object_unref (direct);
+	g_object_unref (dbus_conn);
+
+	g_mutex_lock (&data->mutex);
+	data->done = TRUE;
+	g_cond_signal (&data->cond);
+	g_mutex_unlock (&data->mutex);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+restart_endpoint (void)
+{
+	RestartData data = { 0, };
+
+	g_mutex_init (&data.mutex);
+	g_cond_init (&data.cond);
+
+	g_main_context_invoke (endpoint_context, restart_endpoint_cb, &data);
+
+	g_mutex_lock (&data.mutex);
+	while (!data.done)
+		g_cond_wait (&data.cond, &data.mutex);
+	g_mutex_unlock (&data.mutex);
+
+	g_mutex_clear (&data.mutex);
+	g_cond_clear (&data.cond);
+}
+
+static void
+check_greeting (TrackerSparqlStatement *stmt,
+                const gchar            *greeting)
+{
+	TrackerSparqlCursor *cursor;
+	GError *error = NULL;
+
+	cursor = tracker_sparql_statement_execute (stmt, NULL, &error);
+	g_assert_no_error (error);
+
+	g_assert_true (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 0, NULL), ==, greeting);
+	g_object_unref (cursor);
+}
+
+static void
+execute_endpoint_restart (TestFixture   *test_fixture,
+                          gconstpointer  context)
+{
+	TrackerSparqlStatement *hello, *bye;
+	GError *error = NULL;
+
+	hello = tracker_sparql_connection_query_statement (test_fixture->conn,
+	                                                   "SELECT ('hello' AS ?greeting) { }",
+	                                                   NULL,
+	                                                   &error);
+	g_assert_no_error (error);
+
+	bye = tracker_sparql_connection_query_statement (test_fixture->conn,
+	                                                 "SELECT ('bye' AS ?greeting) { }",
+	                                                 NULL,
+	                                                 &error);
+	g_assert_no_error (error);
+
+	/* Both statements get the first handle of a fresh endpoint */
+	restart_endpoint ();
+	check_greeting (hello, "hello");
+	restart_endpoint ();
+	check_greeting (bye, "bye");
+
+	/* The handle of the first statement now belongs to the second */
+	check_greeting (hello, "hello");
+	check_greeting (bye, "bye");
+
+	/* The first statement is prepared again */
+	check_greeting (hello, "hello");
+	check_greeting (bye, "bye");
+
+	g_clear_object (&hello);
+	g_clear_object (&bye);
+}
+
 typedef void (*TestFunc) (TestFixture   *test_fixture,
                           gconstpointer  context);
 
@@ -657,6 +861,8 @@ typedef struct {
 TestFuncData test_funcs[] = {
 	{ "rdf_types", rdf_types },
 	{ "execute_async", execute_async },
+	{ "execute_rebind", execute_rebind },
+	{ "query_batch", query_batch },
 	{ "update", stmt_update },
 	{ "update_async", stmt_update_async },
 	{ "fts", stmt_fts },
@@ -704,6 +910,8 @@ main (gint argc, gchar **argv)
 
 	add_tests (direct, "direct", TRUE);
 	add_tests (dbus, "dbus", FALSE);
+	g_test_add ("/libtracker-sparql/statement/dbus/endpoint_restart",
+	            TestFixture, dbus, setup, execute_endpoint_restart, NULL);
 	add_tests (remote, "http", FALSE);
 
 	retval = g_test_run ();